@@ -229,7 +229,9 @@ bool QLogValue3DAxisFormatter::showEdgeLabels() const
  */
 QValue3DAxisFormatter *QLogValue3DAxisFormatter::createNewInstance() const
 {
-    return new QLogValue3DAxisFormatter();
+    QLogValue3DAxisFormatter *formatter = new QLogValue3DAxisFormatter();
+    formatter->dptr()->m_builtInPositions = true;
+    return formatter;
 }
 
 /*!
@@ -447,6 +449,17 @@ float QLogValue3DAxisFormatterPrivate::valueAt(float position) const
     return float(qExp(logValue));
 }
 
+void QLogValue3DAxisFormatterPrivate::builtInPositionsAt(const float *values, float *positions,
+                                                         int count) const
+{
+    // SSE2 has no logarithm, and an approximation would not match positionAt(), so the
+    // logarithmic mapping stays scalar
+    const qreal logMin = m_logMin;
+    const qreal logRangeNormalizer = m_logRangeNormalizer;
+    for (int i = 0; i < count; i++)
+        positions[i] = float((qLn(qreal(values[i])) - logMin) / logRangeNormalizer);
+}
+
 QLogValue3DAxisFormatter *QLogValue3DAxisFormatterPrivate::qptr()
 {
     return static_cast<QLogValue3DAxisFormatter *>(q_ptr);
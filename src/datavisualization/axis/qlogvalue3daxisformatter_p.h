@@ -59,6 +59,7 @@ public:
 
     float positionAt(float value) const;
     float valueAt(float position) const;
+    void builtInPositionsAt(const float *values, float *positions, int count) const override;
 
 protected:
     QLogValue3DAxisFormatter *qptr();
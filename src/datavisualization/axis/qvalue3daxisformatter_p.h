@@ -65,6 +65,9 @@ public:
     QString stringForValue(qreal value, const QString &format);
     float positionAt(float value) const;
     float valueAt(float position) const;
+    void positionsAt(const float *values, float *positions, int count) const;
+    virtual void builtInPositionsAt(const float *values, float *positions, int count) const;
+    inline bool hasBuiltInPositions() const { return m_builtInPositions; }
 
     void setAxis(QValue3DAxis *axis);
     void markDirty(bool labelsChange);
@@ -102,6 +105,10 @@ protected:
     char m_formatSpec;
     bool m_cLocaleInUse;
 
+    // Set for the copies made by the built-in formatters, which are known not to reimplement
+    // positionAt(). Their positions are resolved without a virtual call for each value.
+    bool m_builtInPositions;
+
     friend class QValue3DAxisFormatter;
 };
 
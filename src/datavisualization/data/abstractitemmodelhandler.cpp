@@ -29,12 +29,96 @@
 
 #include "abstractitemmodelhandler_p.h"
 
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThreadPool>
+
 QT_BEGIN_NAMESPACE
 
+// Copy of the given roles and the display role headers of an item model. Item models can only be
+// accessed in their own thread, so asynchronous resolves read the data from the snapshot instead.
+// Creating the snapshot still blocks the model thread for one multiData() call per item.
+class ItemModelSnapshot : public QAbstractTableModel
+{
+public:
+    ItemModelSnapshot(const QAbstractItemModel *model, const QList<int> &roles)
+        : m_rowCount(model->rowCount()),
+          m_columnCount(model->columnCount())
+    {
+        foreach (int role, roles) {
+            if (role >= 0 && !m_roles.contains(role))
+                m_roles.append(role);
+        }
+        const int roleCount = m_roles.size();
+        // Fetch all roles of an item with one multiData() call. Roles the model does not set
+        // are left invalid.
+        QList<QModelRoleData> roleData;
+        roleData.reserve(roleCount);
+        foreach (int role, m_roles)
+            roleData.append(QModelRoleData(role));
+        QModelRoleDataSpan roleDataSpan(roleData);
+        m_values.reserve(qsizetype(m_rowCount) * m_columnCount * roleCount);
+        for (int i = 0; i < m_rowCount; i++) {
+            for (int j = 0; j < m_columnCount; j++) {
+                model->multiData(model->index(i, j), roleDataSpan);
+                for (int k = 0; k < roleCount; k++) {
+                    m_values.append(std::move(roleData[k].data()));
+                    roleData[k].clearData();
+                }
+            }
+        }
+        m_verticalHeaders.reserve(m_rowCount);
+        for (int i = 0; i < m_rowCount; i++)
+            m_verticalHeaders.append(model->headerData(i, Qt::Vertical));
+        m_horizontalHeaders.reserve(m_columnCount);
+        for (int i = 0; i < m_columnCount; i++)
+            m_horizontalHeaders.append(model->headerData(i, Qt::Horizontal));
+    }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : m_rowCount;
+    }
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : m_columnCount;
+    }
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override
+    {
+        const int roleIndex = m_roles.indexOf(role);
+        if (!index.isValid() || roleIndex < 0)
+            return QVariant();
+        return m_values.at((qsizetype(index.row()) * m_columnCount + index.column())
+                           * m_roles.size() + roleIndex);
+    }
+
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override
+    {
+        if (role != Qt::DisplayRole)
+            return QVariant();
+        if (orientation == Qt::Horizontal)
+            return m_horizontalHeaders.value(section);
+        return m_verticalHeaders.value(section);
+    }
+
+private:
+    int m_rowCount;
+    int m_columnCount;
+    QList<int> m_roles;
+    QList<QVariant> m_values;
+    QList<QVariant> m_verticalHeaders;
+    QList<QVariant> m_horizontalHeaders;
+};
+
 AbstractItemModelHandler::AbstractItemModelHandler(QObject *parent)
     : QObject(parent),
       resolvePending(0),
-      m_fullReset(true)
+      m_fullReset(true),
+      m_asyncResolve(false),
+      m_resolveRunning(false),
+      m_resolveAgain(false)
 {
     m_resolveTimer.setSingleShot(true);
     QObject::connect(&m_resolveTimer, &QTimer::timeout,
@@ -72,6 +156,26 @@ void AbstractItemModelHandler::setItemModel(QAbstractItemModel *itemModel)
                              this, &AbstractItemModelHandler::handleRowsMoved);
             QObject::connect(m_itemModel.data(), &QAbstractItemModel::rowsRemoved,
                              this, &AbstractItemModelHandler::handleRowsRemoved);
+
+            // Any change invalidates the snapshot of a running asynchronous resolve
+            QObject::connect(m_itemModel.data(), &QAbstractItemModel::columnsInserted,
+                             this, &AbstractItemModelHandler::handleModelChanged);
+            QObject::connect(m_itemModel.data(), &QAbstractItemModel::columnsMoved,
+                             this, &AbstractItemModelHandler::handleModelChanged);
+            QObject::connect(m_itemModel.data(), &QAbstractItemModel::columnsRemoved,
+                             this, &AbstractItemModelHandler::handleModelChanged);
+            QObject::connect(m_itemModel.data(), &QAbstractItemModel::dataChanged,
+                             this, &AbstractItemModelHandler::handleModelChanged);
+            QObject::connect(m_itemModel.data(), &QAbstractItemModel::layoutChanged,
+                             this, &AbstractItemModelHandler::handleModelChanged);
+            QObject::connect(m_itemModel.data(), &QAbstractItemModel::modelReset,
+                             this, &AbstractItemModelHandler::handleModelChanged);
+            QObject::connect(m_itemModel.data(), &QAbstractItemModel::rowsInserted,
+                             this, &AbstractItemModelHandler::handleModelChanged);
+            QObject::connect(m_itemModel.data(), &QAbstractItemModel::rowsMoved,
+                             this, &AbstractItemModelHandler::handleModelChanged);
+            QObject::connect(m_itemModel.data(), &QAbstractItemModel::rowsRemoved,
+                             this, &AbstractItemModelHandler::handleModelChanged);
         }
         if (!m_resolveTimer.isActive())
             m_resolveTimer.start(0);
@@ -85,6 +189,16 @@ QAbstractItemModel *AbstractItemModelHandler::itemModel() const
     return m_itemModel.data();
 }
 
+void AbstractItemModelHandler::setAsyncResolve(bool enable)
+{
+    m_asyncResolve = enable;
+}
+
+bool AbstractItemModelHandler::isAsyncResolve() const
+{
+    return m_asyncResolve;
+}
+
 void AbstractItemModelHandler::handleColumnsInserted(const QModelIndex &parent,
                                                      int start, int end)
 {
@@ -233,8 +347,67 @@ void AbstractItemModelHandler::handleMappingChanged()
 
 void AbstractItemModelHandler::handlePendingResolve()
 {
+    if (m_resolveRunning) {
+        // Resolve again with the latest data once the running resolve finishes
+        m_resolveAgain = true;
+        return;
+    }
+
+    m_resolveTime.start();
     resolveModel();
-    m_fullReset = false;
+    // An asynchronous resolve keeps the full reset pending until its data is applied
+    if (!m_resolveRunning) {
+        m_fullReset = false;
+        emit modelResolved(int(m_resolveTime.elapsed()));
+    }
+}
+
+void AbstractItemModelHandler::handleModelChanged()
+{
+    if (m_resolveRunning)
+        m_resolveAgain = true;
+}
+
+void AbstractItemModelHandler::resolve(const QList<int> &roles, const ModelResolver &resolver)
+{
+    if (!m_asyncResolve) {
+        resolver(m_itemModel.data())();
+        return;
+    }
+
+    // Single item changes cannot be applied to the proxy until the new data replaces it,
+    // so they are left to another full resolve
+    QSharedPointer<ItemModelSnapshot> snapshot(new ItemModelSnapshot(m_itemModel.data(), roles));
+    m_resolveRunning = true;
+    m_fullReset = true;
+    QThreadPool::globalInstance()->start([this, resolver, snapshot]() mutable {
+        std::function<void()> apply = resolver(snapshot.data());
+        // The snapshot is moved to the queued call, so that it is deleted in the handler thread
+        QMetaObject::invokeMethod(this, [this, apply, snapshot = std::move(snapshot)]() {
+            m_resolveDone.acquire();
+            m_resolveRunning = false;
+            apply();
+            emit modelResolved(int(m_resolveTime.elapsed()));
+            if (m_resolveAgain) {
+                m_resolveAgain = false;
+                if (!m_resolveTimer.isActive())
+                    m_resolveTimer.start(0);
+            } else {
+                m_fullReset = false;
+            }
+        }, Qt::QueuedConnection);
+        m_resolveDone.release();
+    });
+}
+
+// Subclasses call this in their destructors, as the resolver of a running asynchronous resolve
+// may use their members.
+void AbstractItemModelHandler::waitForResolve()
+{
+    if (m_resolveRunning) {
+        m_resolveDone.acquire();
+        m_resolveRunning = false;
+    }
 }
 
 QT_END_NAMESPACE
@@ -44,6 +44,9 @@
 #include <QtCore/QAbstractItemModel>
 #include <QtCore/QPointer>
 #include <QtCore/QTimer>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QSemaphore>
+#include <functional>
 
 QT_BEGIN_NAMESPACE
 
@@ -57,6 +60,9 @@ public:
     virtual void setItemModel(QAbstractItemModel *itemModel);
     virtual QAbstractItemModel *itemModel() const;
 
+    void setAsyncResolve(bool enable);
+    bool isAsyncResolve() const;
+
 public Q_SLOTS:
     virtual void handleColumnsInserted(const QModelIndex &parent, int start, int end);
     virtual void handleColumnsMoved(const QModelIndex &sourceParent, int sourceStart,
@@ -78,14 +84,30 @@ public Q_SLOTS:
 
 Q_SIGNALS:
     void itemModelChanged(const QAbstractItemModel *itemModel);
+    void modelResolved(int msecs);
+
+private Q_SLOTS:
+    void handleModelChanged();
 
 protected:
+    // Builds the new proxy data from the model and returns a function applying it to the proxy.
+    // In asynchronous mode the resolver runs in a worker thread on a snapshot of the model,
+    // so it must not access the proxy.
+    typedef std::function<std::function<void()>(const QAbstractItemModel *model)> ModelResolver;
+
     virtual void resolveModel() = 0;
+    void resolve(const QList<int> &roles, const ModelResolver &resolver);
+    void waitForResolve();
 
     QPointer<QAbstractItemModel> m_itemModel;  // Not owned
     bool resolvePending;
     QTimer m_resolveTimer;
     bool m_fullReset;
+    bool m_asyncResolve;
+    bool m_resolveRunning;
+    bool m_resolveAgain;
+    QSemaphore m_resolveDone;
+    QElapsedTimer m_resolveTime;
 
 private:
     Q_DISABLE_COPY(AbstractItemModelHandler)
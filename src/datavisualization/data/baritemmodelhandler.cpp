@@ -47,6 +47,7 @@ BarItemModelHandler::BarItemModelHandler(QItemModelBarDataProxy *proxy, QObject
 
 BarItemModelHandler::~BarItemModelHandler()
 {
+    waitForResolve();
 }
 
 void BarItemModelHandler::handleDataChanged(const QModelIndex &topLeft,
@@ -121,182 +122,197 @@ void BarItemModelHandler::resolveModel()
     m_haveValuePattern = !m_valuePattern.namedCaptureGroups().isEmpty() && m_valuePattern.isValid();
     m_haveRotationPattern = !m_rotationPattern.namedCaptureGroups().isEmpty() && m_rotationPattern.isValid();
 
-    QStringList rowLabels;
-    QStringList columnLabels;
-
     QHash<int, QByteArray> roleHash = m_itemModel->roleNames();
 
     // Default value role to display role if no mapping
     m_valueRole = roleHash.key(m_proxy->valueRole().toLatin1(), Qt::DisplayRole);
     m_rotationRole = roleHash.key(m_proxy->rotationRole().toLatin1(), noRoleIndex);
-    int rowCount = m_itemModel->rowCount();
-    int columnCount = m_itemModel->columnCount();
+    int rowRole = roleHash.key(m_proxy->rowRole().toLatin1());
+    int columnRole = roleHash.key(m_proxy->columnRole().toLatin1());
 
-    if (m_proxy->useModelCategories()) {
-        // If dimensions have changed, recreate the array
-        if (m_proxyArray != m_proxy->array() || columnCount != m_columnCount
-                || rowCount != m_proxyArray->size()) {
-            m_proxyArray = new QBarDataArray;
-            m_proxyArray->reserve(rowCount);
-            for (int i = 0; i < rowCount; i++)
-                m_proxyArray->append(new QBarDataRow(columnCount));
-        }
-        for (int i = 0; i < rowCount; i++) {
-            QBarDataRow &newProxyRow = *m_proxyArray->at(i);
-            for (int j = 0; j < columnCount; j++) {
-                QModelIndex index = m_itemModel->index(i, j);
-                QVariant valueVar = index.data(m_valueRole);
-                float value;
-                if (m_haveValuePattern)
-                    value = valueVar.toString().replace(m_valuePattern, m_valueReplace).toFloat();
-                else
-                    value = valueVar.toFloat();
-                newProxyRow[j].setValue(value);
-                if (m_rotationRole != noRoleIndex) {
-                    QVariant rotationVar = index.data(m_rotationRole);
-                    float rotation;
-                    if (m_haveRotationPattern) {
-                        rotation = rotationVar.toString().replace(m_rotationPattern,
-                                                                  m_rotationReplace).toFloat();
-                    } else {
-                        rotation = rotationVar.toFloat();
+    // The resolver may run in a worker thread, so read the rest of the proxy settings here
+    bool useModelCategories = m_proxy->useModelCategories();
+    bool generateRows = m_proxy->autoRowCategories();
+    bool generateColumns = m_proxy->autoColumnCategories();
+    QStringList rowCategories = m_proxy->rowCategories();
+    QStringList columnCategories = m_proxy->columnCategories();
+    QItemModelBarDataProxy::MultiMatchBehavior multiMatchBehavior = m_proxy->multiMatchBehavior();
+    // Asynchronously resolved data always goes to a new array, as the old one is still in use
+    QBarDataArray *oldArray = (!m_asyncResolve && m_proxyArray == m_proxy->array())
+            ? m_proxyArray : 0;
+
+    resolve({m_valueRole, m_rotationRole, rowRole, columnRole},
+            [=](const QAbstractItemModel *model) -> std::function<void()> {
+        QStringList rowLabels;
+        QStringList columnLabels;
+        QBarDataArray *proxyArray = oldArray;
+        int rowCount = model->rowCount();
+        int columnCount = model->columnCount();
+
+        if (useModelCategories) {
+            // If dimensions have changed, recreate the array
+            if (!proxyArray || columnCount != m_columnCount || rowCount != proxyArray->size()) {
+                proxyArray = new QBarDataArray;
+                proxyArray->reserve(rowCount);
+                for (int i = 0; i < rowCount; i++)
+                    proxyArray->append(new QBarDataRow(columnCount));
+            }
+            for (int i = 0; i < rowCount; i++) {
+                QBarDataRow &newProxyRow = *proxyArray->at(i);
+                for (int j = 0; j < columnCount; j++) {
+                    QModelIndex index = model->index(i, j);
+                    QVariant valueVar = index.data(m_valueRole);
+                    float value;
+                    if (m_haveValuePattern)
+                        value = valueVar.toString().replace(m_valuePattern, m_valueReplace).toFloat();
+                    else
+                        value = valueVar.toFloat();
+                    newProxyRow[j].setValue(value);
+                    if (m_rotationRole != noRoleIndex) {
+                        QVariant rotationVar = index.data(m_rotationRole);
+                        float rotation;
+                        if (m_haveRotationPattern) {
+                            rotation = rotationVar.toString().replace(m_rotationPattern,
+                                                                      m_rotationReplace).toFloat();
+                        } else {
+                            rotation = rotationVar.toFloat();
+                        }
+                        newProxyRow[j].setRotation(rotation);
                     }
-                    newProxyRow[j].setRotation(rotation);
                 }
             }
-        }
-        // Generate labels from headers if using model rows/columns
-        for (int i = 0; i < rowCount; i++)
-            rowLabels << m_itemModel->headerData(i, Qt::Vertical).toString();
-        for (int i = 0; i < columnCount; i++)
-            columnLabels << m_itemModel->headerData(i, Qt::Horizontal).toString();
-        m_columnCount = columnCount;
-    } else {
-        int rowRole = roleHash.key(m_proxy->rowRole().toLatin1());
-        int columnRole = roleHash.key(m_proxy->columnRole().toLatin1());
-
-        bool generateRows = m_proxy->autoRowCategories();
-        bool generateColumns = m_proxy->autoColumnCategories();
-        QStringList rowList;
-        QStringList columnList;
-        // For detecting duplicates in categories generation, using QHashes should be faster than
-        // simple QStringList::contains() check.
-        QHash<QString, bool> rowListHash;
-        QHash<QString, bool> columnListHash;
+            // Generate labels from headers if using model rows/columns
+            for (int i = 0; i < rowCount; i++)
+                rowLabels << model->headerData(i, Qt::Vertical).toString();
+            for (int i = 0; i < columnCount; i++)
+                columnLabels << model->headerData(i, Qt::Horizontal).toString();
+        } else {
+            QStringList rowList;
+            QStringList columnList;
+            // For detecting duplicates in categories generation, using QHashes should be faster than
+            // simple QStringList::contains() check.
+            QHash<QString, bool> rowListHash;
+            QHash<QString, bool> columnListHash;
 
-        // Sort values into rows and columns
-        typedef QHash<QString, float> ColumnValueMap;
-        QHash<QString, ColumnValueMap> itemValueMap;
-        QHash<QString, ColumnValueMap> itemRotationMap;
+            // Sort values into rows and columns
+            typedef QHash<QString, float> ColumnValueMap;
+            QHash<QString, ColumnValueMap> itemValueMap;
+            QHash<QString, ColumnValueMap> itemRotationMap;
 
-        bool cumulative = m_proxy->multiMatchBehavior() == QItemModelBarDataProxy::MMBAverage
-                || m_proxy->multiMatchBehavior() == QItemModelBarDataProxy::MMBCumulative;
-        bool countMatches = m_proxy->multiMatchBehavior() == QItemModelBarDataProxy::MMBAverage;
-        bool takeFirst = m_proxy->multiMatchBehavior() == QItemModelBarDataProxy::MMBFirst;
-        QHash<QString, QHash<QString, int> > *matchCountMap = 0;
-        if (countMatches)
-            matchCountMap = new QHash<QString, QHash<QString, int> >;
+            bool cumulative = multiMatchBehavior == QItemModelBarDataProxy::MMBAverage
+                    || multiMatchBehavior == QItemModelBarDataProxy::MMBCumulative;
+            bool countMatches = multiMatchBehavior == QItemModelBarDataProxy::MMBAverage;
+            bool takeFirst = multiMatchBehavior == QItemModelBarDataProxy::MMBFirst;
+            QHash<QString, QHash<QString, int> > *matchCountMap = 0;
+            if (countMatches)
+                matchCountMap = new QHash<QString, QHash<QString, int> >;
 
-        for (int i = 0; i < rowCount; i++) {
-            for (int j = 0; j < columnCount; j++) {
-                QModelIndex index = m_itemModel->index(i, j);
-                QString rowRoleStr = index.data(rowRole).toString();
-                if (haveRowPattern)
-                    rowRoleStr.replace(rowPattern, rowReplace);
-                QString columnRoleStr = index.data(columnRole).toString();
-                if (haveColPattern)
-                    columnRoleStr.replace(colPattern, colReplace);
-                QVariant valueVar = index.data(m_valueRole);
-                float value;
-                if (m_haveValuePattern)
-                    value = valueVar.toString().replace(m_valuePattern, m_valueReplace).toFloat();
-                else
-                    value = valueVar.toFloat();
-                if (countMatches)
-                    (*matchCountMap)[rowRoleStr][columnRoleStr]++;
+            for (int i = 0; i < rowCount; i++) {
+                for (int j = 0; j < columnCount; j++) {
+                    QModelIndex index = model->index(i, j);
+                    QString rowRoleStr = index.data(rowRole).toString();
+                    if (haveRowPattern)
+                        rowRoleStr.replace(rowPattern, rowReplace);
+                    QString columnRoleStr = index.data(columnRole).toString();
+                    if (haveColPattern)
+                        columnRoleStr.replace(colPattern, colReplace);
+                    QVariant valueVar = index.data(m_valueRole);
+                    float value;
+                    if (m_haveValuePattern)
+                        value = valueVar.toString().replace(m_valuePattern, m_valueReplace).toFloat();
+                    else
+                        value = valueVar.toFloat();
+                    if (countMatches)
+                        (*matchCountMap)[rowRoleStr][columnRoleStr]++;
 
-                if (cumulative) {
-                    itemValueMap[rowRoleStr][columnRoleStr] += value;
-                } else {
-                    if (takeFirst && itemValueMap.contains(rowRoleStr)) {
-                        if (itemValueMap.value(rowRoleStr).contains(columnRoleStr))
-                            continue; // We already have a value for this row/column combo
+                    if (cumulative) {
+                        itemValueMap[rowRoleStr][columnRoleStr] += value;
+                    } else {
+                        if (takeFirst && itemValueMap.contains(rowRoleStr)) {
+                            if (itemValueMap.value(rowRoleStr).contains(columnRoleStr))
+                                continue; // We already have a value for this row/column combo
+                        }
+                        itemValueMap[rowRoleStr][columnRoleStr] = value;
                     }
-                    itemValueMap[rowRoleStr][columnRoleStr] = value;
-                }
 
-                if (m_rotationRole != noRoleIndex) {
-                    QVariant rotationVar = index.data(m_rotationRole);
-                    float rotation;
-                    if (m_haveRotationPattern) {
-                        rotation = rotationVar.toString().replace(m_rotationPattern,
-                                                                  m_rotationReplace).toFloat();
-                    } else {
-                        rotation = rotationVar.toFloat();
+                    if (m_rotationRole != noRoleIndex) {
+                        QVariant rotationVar = index.data(m_rotationRole);
+                        float rotation;
+                        if (m_haveRotationPattern) {
+                            rotation = rotationVar.toString().replace(m_rotationPattern,
+                                                                      m_rotationReplace).toFloat();
+                        } else {
+                            rotation = rotationVar.toFloat();
+                        }
+                        if (cumulative) {
+                            itemRotationMap[rowRoleStr][columnRoleStr] += rotation;
+                        } else {
+                            // We know we are in take last mode if we get here,
+                            // as take first mode skips to next loop already earlier
+                            itemRotationMap[rowRoleStr][columnRoleStr] = rotation;
+                        }
                     }
-                    if (cumulative) {
-                        itemRotationMap[rowRoleStr][columnRoleStr] += rotation;
-                    } else {
-                        // We know we are in take last mode if we get here,
-                        // as take first mode skips to next loop already earlier
-                        itemRotationMap[rowRoleStr][columnRoleStr] = rotation;
+                    if (generateRows && !rowListHash.value(rowRoleStr, false)) {
+                        rowListHash.insert(rowRoleStr, true);
+                        rowList << rowRoleStr;
+                    }
+                    if (generateColumns && !columnListHash.value(columnRoleStr, false)) {
+                        columnListHash.insert(columnRoleStr, true);
+                        columnList << columnRoleStr;
                     }
-                }
-                if (generateRows && !rowListHash.value(rowRoleStr, false)) {
-                    rowListHash.insert(rowRoleStr, true);
-                    rowList << rowRoleStr;
-                }
-                if (generateColumns && !columnListHash.value(columnRoleStr, false)) {
-                    columnListHash.insert(columnRoleStr, true);
-                    columnList << columnRoleStr;
                 }
             }
-        }
-
-        if (generateRows)
-            m_proxy->dptr()->m_rowCategories = rowList;
-        else
-            rowList = m_proxy->rowCategories();
 
-        if (generateColumns)
-            m_proxy->dptr()->m_columnCategories = columnList;
-        else
-            columnList = m_proxy->columnCategories();
+            if (!generateRows)
+                rowList = rowCategories;
+            if (!generateColumns)
+                columnList = columnCategories;
 
-        // If dimensions have changed, recreate the array
-        if (m_proxyArray != m_proxy->array() || columnList.size() != m_columnCount
-                || rowList.size() != m_proxyArray->size()) {
-            m_proxyArray = new QBarDataArray;
-            m_proxyArray->reserve(rowList.size());
-            for (int i = 0; i < rowList.size(); i++)
-                m_proxyArray->append(new QBarDataRow(columnList.size()));
-        }
-        // Create new data array from itemValueMap
-        for (int i = 0; i < rowList.size(); i++) {
-            QString rowKey = rowList.at(i);
-            QBarDataRow &newProxyRow = *m_proxyArray->at(i);
-            for (int j = 0; j < columnList.size(); j++) {
-                float value = itemValueMap[rowKey][columnList.at(j)];
-                if (countMatches)
-                    value /= float((*matchCountMap)[rowKey][columnList.at(j)]);
-                newProxyRow[j].setValue(value);
-                if (m_rotationRole != noRoleIndex) {
-                    float angle = itemRotationMap[rowKey][columnList.at(j)];
+            // If dimensions have changed, recreate the array
+            if (!proxyArray || columnList.size() != m_columnCount
+                    || rowList.size() != proxyArray->size()) {
+                proxyArray = new QBarDataArray;
+                proxyArray->reserve(rowList.size());
+                for (int i = 0; i < rowList.size(); i++)
+                    proxyArray->append(new QBarDataRow(columnList.size()));
+            }
+            // Create new data array from itemValueMap
+            for (int i = 0; i < rowList.size(); i++) {
+                QString rowKey = rowList.at(i);
+                QBarDataRow &newProxyRow = *proxyArray->at(i);
+                for (int j = 0; j < columnList.size(); j++) {
+                    float value = itemValueMap[rowKey][columnList.at(j)];
                     if (countMatches)
-                        angle /= float((*matchCountMap)[rowKey][columnList.at(j)]);
-                    newProxyRow[j].setRotation(angle);
+                        value /= float((*matchCountMap)[rowKey][columnList.at(j)]);
+                    newProxyRow[j].setValue(value);
+                    if (m_rotationRole != noRoleIndex) {
+                        float angle = itemRotationMap[rowKey][columnList.at(j)];
+                        if (countMatches)
+                            angle /= float((*matchCountMap)[rowKey][columnList.at(j)]);
+                        newProxyRow[j].setRotation(angle);
+                    }
                 }
             }
-        }
 
-        rowLabels = rowList;
-        columnLabels = columnList;
-        m_columnCount = columnList.size();
+            rowLabels = rowList;
+            columnLabels = columnList;
+            columnCount = columnList.size();
 
-        delete matchCountMap;
-    }
+            delete matchCountMap;
+        }
 
-    m_proxy->resetArray(m_proxyArray, rowLabels, columnLabels);
+        return [=]() {
+            if (!useModelCategories) {
+                if (generateRows)
+                    m_proxy->dptr()->m_rowCategories = rowLabels;
+                if (generateColumns)
+                    m_proxy->dptr()->m_columnCategories = columnLabels;
+            }
+            m_proxyArray = proxyArray;
+            m_columnCount = columnCount;
+            m_proxy->resetArray(proxyArray, rowLabels, columnLabels);
+        };
+    });
 }
 
 QT_END_NAMESPACE
@@ -28,6 +28,7 @@
 ****************************************************************************/
 
 #include "customrenderitem_p.h"
+#include "volumebrickpool_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -51,6 +52,7 @@ CustomRenderItem::CustomRenderItem()
       m_textureDepth(0),
       m_isVolume(false),
       m_textureFormat(QImage::Format_ARGB32),
+      m_textureValueType(QCustom3DVolume::TextureValueUnsigned),
       m_sliceIndexX(-1),
       m_sliceIndexY(-1),
       m_sliceIndexZ(-1),
@@ -58,7 +60,8 @@ CustomRenderItem::CustomRenderItem()
       m_preserveOpacity(true),
       m_useHighDefShader(true),
       m_drawSlices(false),
-      m_drawSliceFrames(false)
+      m_drawSliceFrames(false),
+      m_volumeBricks(0)
 
 {
 }
@@ -66,6 +69,7 @@ CustomRenderItem::CustomRenderItem()
 CustomRenderItem::~CustomRenderItem()
 {
     ObjectHelper::releaseObjectHelper(m_renderer, m_object);
+    delete m_volumeBricks;
 }
 
 void CustomRenderItem::setMesh(const QString &meshFile)
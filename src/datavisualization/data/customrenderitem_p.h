@@ -42,6 +42,7 @@
 
 #include "abstractrenderitem_p.h"
 #include "objecthelper_p.h"
+#include "qcustom3dvolume.h"
 #include <QtGui/QRgb>
 #include <QtGui/QImage>
 #include <QtGui/QColor>
@@ -50,6 +51,7 @@ QT_BEGIN_NAMESPACE
 
 class QCustom3DItem;
 class Abstract3DRenderer;
+class VolumeBrickPool;
 
 class CustomRenderItem : public AbstractRenderItem
 {
@@ -106,6 +108,14 @@ public:
     inline bool isVolume() const { return m_isVolume; }
     inline void setTextureFormat(QImage::Format format) { m_textureFormat = format; }
     inline QImage::Format textureFormat() const { return m_textureFormat; }
+    inline void setTextureValueType(QCustom3DVolume::TextureValueType type)
+    {
+        m_textureValueType = type;
+    }
+    inline QCustom3DVolume::TextureValueType textureValueType() const
+    {
+        return m_textureValueType;
+    }
     inline void setSliceIndexX(int index)
     {
         m_sliceIndexX = index;
@@ -149,6 +159,8 @@ public:
     inline const QVector3D &sliceFrameGaps() const { return m_sliceFrameGaps; }
     inline void setSliceFrameThicknesses(const QVector3D &thicknesses) { m_sliceFrameThicknesses = thicknesses; }
     inline const QVector3D &sliceFrameThicknesses() const { return m_sliceFrameThicknesses; }
+    inline void setVolumeBricks(VolumeBrickPool *bricks) { m_volumeBricks = bricks; }
+    inline VolumeBrickPool *volumeBricks() const { return m_volumeBricks; }
 
 private:
     Q_DISABLE_COPY(CustomRenderItem)
@@ -178,6 +190,7 @@ private:
     QList<QVector4D> m_colorTable;
     bool m_isVolume;
     QImage::Format m_textureFormat;
+    QCustom3DVolume::TextureValueType m_textureValueType;
     int m_sliceIndexX;
     int m_sliceIndexY;
     int m_sliceIndexZ;
@@ -195,6 +208,7 @@ private:
     QVector3D m_sliceFrameWidths;
     QVector3D m_sliceFrameGaps;
     QVector3D m_sliceFrameThicknesses;
+    VolumeBrickPool *m_volumeBricks;
 };
 typedef QHash<QCustom3DItem *, CustomRenderItem *> CustomRenderItemArray;
 
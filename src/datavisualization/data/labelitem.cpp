@@ -28,12 +28,14 @@
 ****************************************************************************/
 
 #include "labelitem_p.h"
+#include "labelatlas_p.h"
 
 QT_BEGIN_NAMESPACE
 
 LabelItem::LabelItem()
     : m_size(QSize(0, 0)),
-      m_textureId(0)
+      m_textureId(0),
+      m_atlasEntry(-1)
 {
 }
 
@@ -54,21 +56,49 @@ QSize LabelItem::size() const
 
 void LabelItem::setTextureId(GLuint textureId)
 {
+    releaseAtlasEntry();
     QOpenGLContext::currentContext()->functions()->glDeleteTextures(1, &m_textureId);
     m_textureId = textureId;
 }
 
 GLuint LabelItem::textureId() const
 {
+    if (m_atlasEntry >= 0) {
+        QSharedPointer<LabelAtlas> labelAtlas = atlas();
+        return labelAtlas ? labelAtlas->textureId(m_atlasEntry) : 0;
+    }
     return m_textureId;
 }
 
+void LabelItem::setAtlasEntry(const QSharedPointer<LabelAtlas> &atlas, int entry)
+{
+    releaseAtlasEntry();
+    if (m_textureId && QOpenGLContext::currentContext())
+        QOpenGLContext::currentContext()->functions()->glDeleteTextures(1, &m_textureId);
+    m_textureId = 0;
+    m_atlas = atlas;
+    m_atlasEntry = entry;
+}
+
 void LabelItem::clear()
 {
+    releaseAtlasEntry();
     if (m_textureId && QOpenGLContext::currentContext())
         QOpenGLContext::currentContext()->functions()->glDeleteTextures(1, &m_textureId);
     m_textureId = 0;
     m_size = QSize(0, 0);
 }
 
+void LabelItem::releaseAtlasEntry()
+{
+    if (m_atlasEntry >= 0) {
+        // The atlas is gone already if the drawer was destroyed before the label
+        QSharedPointer<LabelAtlas> labelAtlas = atlas();
+        if (labelAtlas)
+            labelAtlas->release(m_atlasEntry);
+        m_atlasEntry = -1;
+    }
+    m_atlas.clear();
+}
+
 QT_END_NAMESPACE
@@ -42,9 +42,12 @@
 
 #include <private/datavisualizationglobal_p.h>
 #include <QtCore/QSize>
+#include <QtCore/QSharedPointer>
 
 QT_BEGIN_NAMESPACE
 
+class LabelAtlas;
+
 class LabelItem
 {
 public:
@@ -55,13 +58,21 @@ public:
     QSize size() const;
     void setTextureId(GLuint textureId);
     GLuint textureId() const;
+    // Takes over one reference to the atlas entry, which replaces the texture
+    void setAtlasEntry(const QSharedPointer<LabelAtlas> &atlas, int entry);
+    inline int atlasEntry() const { return m_atlasEntry; }
+    inline QSharedPointer<LabelAtlas> atlas() const { return m_atlas.toStrongRef(); }
     void clear();
 
 private:
     Q_DISABLE_COPY(LabelItem)
 
+    void releaseAtlasEntry();
+
     QSize m_size;
     GLuint m_textureId;
+    QWeakPointer<LabelAtlas> m_atlas;
+    int m_atlasEntry;
 };
 
 QT_END_NAMESPACE
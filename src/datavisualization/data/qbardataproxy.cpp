@@ -123,6 +123,7 @@ QT_BEGIN_NAMESPACE
 QBarDataProxy::QBarDataProxy(QObject *parent) :
     QAbstractDataProxy(new QBarDataProxyPrivate(this), parent)
 {
+    dptr()->connectRowLimitsCache();
 }
 
 /*!
@@ -131,6 +132,7 @@ QBarDataProxy::QBarDataProxy(QObject *parent) :
 QBarDataProxy::QBarDataProxy(QBarDataProxyPrivate *d, QObject *parent) :
     QAbstractDataProxy(d, parent)
 {
+    dptr()->connectRowLimitsCache();
 }
 
 /*!
@@ -761,23 +763,64 @@ void QBarDataProxyPrivate::fixRowLabels(int startIndex, int count, const QString
 QPair<GLfloat, GLfloat> QBarDataProxyPrivate::limitValues(int startRow, int endRow,
                                                           int startColumn, int endColumn) const
 {
-    QPair<GLfloat, GLfloat> limits = qMakePair(0.0f, 0.0f);
+    m_rowLimits.resize(m_dataArray->size());
+
+    ValueLimits limits;
     endRow = qMin(endRow, m_dataArray->size() - 1);
     for (int i = startRow; i <= endRow; i++) {
-        QBarDataRow *row = m_dataArray->at(i);
+        const QBarDataRow *row = m_dataArray->at(i);
         if (row) {
             int lastColumn = qMin(endColumn, row->size() - 1);
-            for (int j = startColumn; j <= lastColumn; j++) {
-                const QBarDataItem &item = row->at(j);
-                float itemValue = item.value();
-                if (limits.second < itemValue)
-                    limits.second = itemValue;
-                if (limits.first > itemValue)
-                    limits.first = itemValue;
+            if (startColumn <= 0 && lastColumn == row->size() - 1) {
+                // Whole row is within the range, so the cached limits can be used
+                if (m_rowLimits.isDirty(i)) {
+                    ValueLimits rowLimits;
+                    rowLimits.addGathered(row->size(), [row](qsizetype j) {
+                        return row->at(j).value();
+                    });
+                    m_rowLimits.setLimits(i, rowLimits);
+                }
+                limits.add(m_rowLimits.limits(i));
+            } else if (startColumn <= lastColumn) {
+                limits.addGathered(lastColumn - startColumn + 1, [row, startColumn](qsizetype j) {
+                    return row->at(startColumn + j).value();
+                });
             }
         }
     }
-    return limits;
+
+    QPair<GLfloat, GLfloat> result = qMakePair(0.0f, 0.0f);
+    if (!limits.isEmpty()) {
+        result.first = qMin(result.first, limits.min);
+        result.second = qMax(result.second, limits.max);
+    }
+    return result;
+}
+
+void QBarDataProxyPrivate::connectRowLimitsCache()
+{
+    // The signals are also emitted when the application modifies the rows directly.
+    // These connections are made before any graph connects to the proxy, so the cache
+    // is up to date when the graph adjusts its axis ranges.
+    QBarDataProxy *q = qptr();
+    QObject::connect(q, &QBarDataProxy::arrayReset, this, [this]() {
+        m_rowLimits.clear();
+    });
+    QObject::connect(q, &QBarDataProxy::rowsAdded, this, [this](int startIndex, int count) {
+        m_rowLimits.insertRows(startIndex, count);
+    });
+    QObject::connect(q, &QBarDataProxy::rowsInserted, this, [this](int startIndex, int count) {
+        m_rowLimits.insertRows(startIndex, count);
+    });
+    QObject::connect(q, &QBarDataProxy::rowsRemoved, this, [this](int startIndex, int count) {
+        m_rowLimits.removeRows(startIndex, count);
+    });
+    QObject::connect(q, &QBarDataProxy::rowsChanged, this, [this](int startIndex, int count) {
+        m_rowLimits.markDirty(startIndex, count);
+    });
+    QObject::connect(q, &QBarDataProxy::itemChanged, this, [this](int rowIndex, int) {
+        m_rowLimits.markDirty(rowIndex, 1);
+    });
 }
 
 void QBarDataProxyPrivate::setSeries(QAbstract3DSeries *series)
@@ -42,6 +42,7 @@
 
 #include "qbardataproxy.h"
 #include "qabstractdataproxy_p.h"
+#include "valuelimits_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -73,10 +74,12 @@ private:
     void clearRow(int rowIndex);
     void clearArray();
     void fixRowLabels(int startIndex, int count, const QStringList &newLabels, bool isInsert);
+    void connectRowLimitsCache();
 
     QBarDataArray *m_dataArray;
     QStringList m_rowLabels;
     QStringList m_columnLabels;
+    mutable RowLimitsCache m_rowLimits;
 
 private:
     friend class QBarDataProxy;
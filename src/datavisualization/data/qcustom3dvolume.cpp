@@ -30,8 +30,28 @@
 #include "qcustom3dvolume_p.h"
 #include "utils_p.h"
 
+#include <QtCore/QFile>
+
 QT_BEGIN_NAMESPACE
 
+// Lines of an X axis slice that are copied together, so that the lines being written stay in
+// the cache while the texels are read from consecutive frames
+static const int sliceTileLines = 16;
+
+// Copies count texels of type T between buffers with the given strides in bytes
+template <typename T>
+static void copyTexels(const uchar *source, qint64 sourceStride, uchar *target,
+                       qsizetype targetStride, int count)
+{
+    for (int i = 0; i < count; i++) {
+        T texel;
+        memcpy(&texel, source, sizeof(T));
+        memcpy(target, &texel, sizeof(T));
+        source += sourceStride;
+        target += targetStride;
+    }
+}
+
 /*!
  * \class QCustom3DVolume
  * \inmodule QtDataVisualization
@@ -49,6 +69,12 @@ QT_BEGIN_NAMESPACE
  * Similarly, the volume texture dimensions have a large impact on performance.
  * If the frame rate is more important than pixel-perfect rendering of the volume contents, consider
  * turning the high definition shader off by setting the useHighDefShader property to \c{false}.
+ * Regions of the volume that are fully transparent are skipped when the volume is ray-traced,
+ * so sparse volumes render faster than their dimensions would suggest.
+ *
+ * Volumes that are too large for memory or for a single 3D texture can be read from a file with
+ * setTextureDataFile(). They are uploaded to the graphics memory in bricks, within the
+ * textureMemoryLimit.
  *
  * \note Volumetric objects are only supported with orthographic projection.
  *
@@ -262,6 +288,34 @@ QT_BEGIN_NAMESPACE
  * \sa drawSliceFrames
  */
 
+/*!
+ * \qmlproperty int Custom3DVolume::textureMemoryLimit
+ * \since 6.4
+ *
+ * The maximum amount of graphics memory in megabytes used for the texture of a
+ * volume that is uploaded in bricks. This happens when the texture data is read
+ * from a file with QCustom3DVolume::setTextureDataFile(), or when the volume is
+ * larger than the maximum 3D texture size. The value must be positive.
+ *
+ * Defaults to \c{512}.
+ */
+
+/*!
+ * \qmlproperty enumeration Custom3DVolume::textureValueType
+ * \since 6.4
+ *
+ * How the values of single channel texture data are interpreted:
+ *
+ * \value Custom3DVolume.TextureValueUnsigned
+ *        Unsigned 16-bit integers in the QImage::Format_Grayscale16 format. This is the default.
+ * \value Custom3DVolume.TextureValueHalfFloat
+ *        16-bit half precision floating point values in the QImage::Format_Grayscale16 format.
+ * \value Custom3DVolume.TextureValueFloat
+ *        32-bit floating point values. The texture format must be QImage::Format_Invalid.
+ *
+ * See QCustom3DVolume::textureValueType for details.
+ */
+
 /*!
  * Constructs a custom 3D volume with the given \a parent.
  */
@@ -406,8 +460,9 @@ void QCustom3DVolume::setTextureDimensions(int width, int height, int depth)
 
 /*!
  * Returns the actual texture data width. When the texture format is QImage::Format_Indexed8,
- * this value equals textureWidth aligned to a 32-bit boundary. Otherwise, this
- * value equals four times textureWidth.
+ * this value equals textureWidth aligned to a 32-bit boundary. When the texture format is
+ * QImage::Format_Grayscale16, this value equals two times textureWidth aligned to a 32-bit
+ * boundary. Otherwise, this value equals four times textureWidth.
  */
 int QCustom3DVolume::textureDataWidth() const
 {
@@ -415,6 +470,8 @@ int QCustom3DVolume::textureDataWidth() const
 
     if (dptrc()->m_textureFormat == QImage::Format_Indexed8)
         dataWidth += dataWidth % 4;
+    else if (dptrc()->m_textureFormat == QImage::Format_Grayscale16)
+        dataWidth = (dataWidth + dataWidth % 2) * 2;
     else
         dataWidth *= 4;
 
@@ -521,7 +578,13 @@ void QCustom3DVolume::setSliceIndices(int x, int y, int z)
  *
  * \brief The array containing the colors for indexed texture formats.
  *
- * If the texture format is not indexed, this array is not used and can be empty.
+ * If the texture format is QImage::Format_Grayscale16 or the volume holds float values,
+ * this array is used as the transfer function of the volume. The 16-bit values, or the
+ * floating point values between \c{0} and \c{1} depending on textureValueType, are mapped
+ * evenly over the colors of the array, and the colors are interpolated between the array
+ * entries when the volume is drawn. Changing the colors does not upload the texture data again.
+ *
+ * If the texture format is QImage::Format_ARGB32, this array is not used and can be empty.
  *
  * Defaults to \c{0}.
  *
@@ -573,6 +636,7 @@ QList<QRgb> QCustom3DVolume::colorTable() const
  */
 void QCustom3DVolume::setTextureData(QList<uchar> *data)
 {
+    dptr()->clearTextureDataFile();
     if (dptr()->m_textureData != data)
         delete dptr()->m_textureData;
 
@@ -588,17 +652,25 @@ void QCustom3DVolume::setTextureData(QList<uchar> *data)
  * Creates a new texture data array from an array of \a images and sets it as
  * textureData for this volume object. The texture dimensions are also set according to image
  * and array dimensions. All of the images in the array must be the same size. If the images are not
- * all in the QImage::Format_Indexed8 format, all texture data will be converted into the
- * QImage::Format_ARGB32 format. If the images are in the
+ * all in the QImage::Format_Indexed8 format or all in the QImage::Format_Grayscale16 format,
+ * all texture data will be converted into the QImage::Format_ARGB32 format. If the images are in the
  * QImage::Format_Indexed8 format, the colorTable value
  * for the entire volume will be taken from the first image.
  *
+ * Images cannot hold 32-bit floating point values, so this function is not supported when
+ * textureValueType is QCustom3DVolume::TextureValueFloat.
+ *
  * Returns a pointer to the newly created array.
  *
  * \sa textureData, textureWidth, textureHeight, textureDepth, setTextureFormat()
  */
 QList<uchar> *QCustom3DVolume::createTextureData(const QList<QImage *> &images)
 {
+    if (dptr()->m_textureValueType == TextureValueFloat) {
+        qWarning() << __FUNCTION__ << "Images are not supported for float texture values.";
+        return 0;
+    }
+
     int imageCount = images.size();
     if (imageCount) {
         QImage *currentImage = images.at(0);
@@ -606,7 +678,7 @@ QList<uchar> *QCustom3DVolume::createTextureData(const QList<QImage *> &images)
         int imageHeight = currentImage->height();
         QImage::Format imageFormat = currentImage->format();
         bool convert = false;
-        if (imageFormat != QImage::Format_Indexed8 && imageFormat != QImage::Format_ARGB32) {
+        if (!QCustom3DVolumePrivate::isSupportedFormat(imageFormat)) {
             convert = true;
             imageFormat = QImage::Format_ARGB32;
         } else {
@@ -628,24 +700,26 @@ QList<uchar> *QCustom3DVolume::createTextureData(const QList<QImage *> &images)
                 }
             }
         }
-        int colorBytes = (imageFormat == QImage::Format_Indexed8) ? 1 : 4;
-        int imageByteWidth = (imageFormat == QImage::Format_Indexed8)
-                ? currentImage->bytesPerLine() : imageWidth;
+        int colorBytes = QCustom3DVolumePrivate::pixelBytes(imageFormat);
+        int imageByteWidth = (imageFormat != QImage::Format_ARGB32)
+                ? currentImage->bytesPerLine() / colorBytes : imageWidth;
         int frameSize = imageByteWidth * imageHeight * colorBytes;
         QList<uchar> *newTextureData = new QList<uchar>;
-        newTextureData->resize(frameSize * imageCount);
+        newTextureData->resize(qsizetype(frameSize) * imageCount);
         uchar *texturePtr = newTextureData->data();
-        QImage convertedImage;
 
-        for (int i = 0; i < imageCount; i++) {
-            currentImage = images.at(i);
-            if (convert) {
-                convertedImage = currentImage->convertToFormat(imageFormat);
-                currentImage = &convertedImage;
+        // The images are converted and copied concurrently for large volumes
+        Utils::parallelFor(imageCount, [&](int begin, int end) {
+            QImage convertedImage;
+            for (int i = begin; i < end; i++) {
+                const QImage *image = images.at(i);
+                if (convert) {
+                    convertedImage = image->convertToFormat(imageFormat);
+                    image = &convertedImage;
+                }
+                memcpy(texturePtr + qsizetype(frameSize) * i, image->constBits(), frameSize);
             }
-            memcpy(texturePtr, static_cast<void *>(currentImage->bits()), frameSize);
-            texturePtr += frameSize;
-        }
+        }, imageByteWidth * imageHeight);
 
         if (imageFormat == QImage::Format_Indexed8)
             setColorTable(images.at(0)->colorTable());
@@ -679,6 +753,9 @@ QList<uchar> *QCustom3DVolume::textureData() const
  * The \a data is expected to be ordered similarly to the data in images
  * produced by the renderSlice() method along the same axis.
  *
+ * Only the changed subtextures are uploaded to the graphics memory, unless they
+ * add up to more data than the whole texture.
+ *
  * \note Each x-dimension line of the data needs to be 32-bit aligned when
  * targeting the y-axis or z-axis. If textureFormat is QImage::Format_Indexed8
  * and the textureWidth value is not divisible by four, padding bytes might need
@@ -690,11 +767,16 @@ QList<uchar> *QCustom3DVolume::textureData() const
  */
 void QCustom3DVolume::setSubTextureData(Qt::Axis axis, int index, const uchar *data)
 {
+    if (!dptr()->m_textureData) {
+        qWarning() << __FUNCTION__ << "The volume has no texture data array.";
+        return;
+    }
+
     if (data) {
         int lineSize = textureDataWidth();
         int frameSize = lineSize * dptr()->m_textureHeight;
         int dataSize = dptr()->m_textureData->size();
-        int pixelWidth = (dptr()->m_textureFormat == QImage::Format_Indexed8) ? 1 : 4;
+        int pixelWidth = QCustom3DVolumePrivate::pixelBytes(dptr()->m_textureFormat);
         int targetIndex;
         uchar *dataPtr = dptr()->m_textureData->data();
         bool invalid = (index < 0);
@@ -741,7 +823,7 @@ void QCustom3DVolume::setSubTextureData(Qt::Axis axis, int index, const uchar *d
                 void *subTexPtr = dataPtr + targetIndex;
                 memcpy(subTexPtr, static_cast<const void *>(data), frameSize);
             }
-            dptr()->m_dirtyBitsVolume.textureDataDirty = true;
+            dptr()->markSubTextureDirty(axis, index);
             emit textureDataChanged(dptr()->m_textureData);
             emit dptr()->needUpdate();
         }
@@ -767,10 +849,17 @@ void QCustom3DVolume::setSubTextureData(Qt::Axis axis, int index, const uchar *d
  * padding bytes should indicate a fully transparent color to avoid rendering
  * artifacts. It is not guaranteed that QImage will do this automatically.
  *
+ * This function is not supported for float volumes, which have no QImage format.
+ *
  * \sa textureData, renderSlice()
  */
 void QCustom3DVolume::setSubTextureData(Qt::Axis axis, int index, const QImage &image)
 {
+    if (dptr()->m_textureFormat == QImage::Format_Invalid) {
+        qWarning() << __FUNCTION__ << "Images are not supported for float texture values.";
+        return;
+    }
+
     int sourceWidth = image.width();
     int sourceHeight = image.height();
     int targetWidth;
@@ -803,21 +892,127 @@ void QCustom3DVolume::setSubTextureData(Qt::Axis axis, int index, const QImage &
     }
 }
 
+/*!
+ * \since 6.4
+ *
+ * Maps the file \a fileName to memory and uses its contents starting at
+ * \a offset bytes as the texture data of the volume, instead of the textureData
+ * array. Returns \c true if the file could be mapped.
+ *
+ * The file must contain the data in the same layout as the textureData array,
+ * in the format specified by textureFormat. The texture dimensions must be set
+ * to match the data. Raw volume files without a header can be used directly if
+ * their lines are aligned as described for textureDataWidth().
+ *
+ * The volume is uploaded to the graphics memory in bricks within the
+ * textureMemoryLimit, so only the parts of the file that are drawn are read
+ * into memory. This allows volumes that are larger than the available memory or
+ * the maximum 3D texture size. Each brick is checked for full transparency
+ * when it is first read, so the file is never read as a whole.
+ *
+ * Setting the textureData array releases the file. The textureData value is null
+ * while the volume is read from a file, and setSubTextureData() is not supported.
+ *
+ * \sa textureDataFile(), textureMemoryLimit, setTextureFormat()
+ */
+bool QCustom3DVolume::setTextureDataFile(const QString &fileName, qint64 offset)
+{
+    QFile *file = new QFile(fileName);
+    uchar *mappedData = 0;
+    qint64 mappedSize = file->size() - offset;
+    if (offset >= 0 && mappedSize > 0 && file->open(QIODevice::ReadOnly))
+        mappedData = file->map(offset, mappedSize);
+    if (!mappedData) {
+        qWarning() << __FUNCTION__ << "Failed to map texture data file" << fileName;
+        delete file;
+        return false;
+    }
+
+    delete dptr()->m_textureData;
+    dptr()->m_textureData = 0;
+    dptr()->clearTextureDataFile();
+    dptr()->m_textureDataFile = file;
+    dptr()->m_mappedTextureData = mappedData;
+    dptr()->m_mappedTextureDataSize = mappedSize;
+    dptr()->m_dirtyBitsVolume.textureDataDirty = true;
+    emit textureDataChanged(0);
+    emit dptr()->needUpdate();
+    return true;
+}
+
+/*!
+ * \since 6.4
+ *
+ * Returns the name of the file the texture data is read from, or an empty string
+ * if the textureData array is used.
+ *
+ * \sa setTextureDataFile()
+ */
+QString QCustom3DVolume::textureDataFile() const
+{
+    return dptrc()->m_textureDataFile ? dptrc()->m_textureDataFile->fileName() : QString();
+}
+
+/*!
+ * \property QCustom3DVolume::textureMemoryLimit
+ * \since 6.4
+ *
+ * \brief The maximum amount of graphics memory in megabytes used for the
+ * texture of a volume that is uploaded in bricks.
+ *
+ * A volume is uploaded in bricks when its texture data is read from a file with
+ * setTextureDataFile(), or when it is larger than the maximum 3D texture size.
+ * The volume is divided into bricks of 16 texels on each side. The bricks that
+ * are visible with the current colorTable are loaded a few at a time, nearest to
+ * the camera first. If the visible bricks do not all fit within the limit, the
+ * farthest ones are left out and drawn transparent. Changing the limit keeps
+ * the loaded bricks that still fit, so they are not read again.
+ *
+ * The value must be positive. Defaults to \c{512}.
+ *
+ * \sa setTextureDataFile()
+ */
+void QCustom3DVolume::setTextureMemoryLimit(int megabytes)
+{
+    if (megabytes > 0) {
+        if (dptr()->m_textureMemoryLimit != megabytes) {
+            dptr()->m_textureMemoryLimit = megabytes;
+            dptr()->m_dirtyBitsVolume.textureMemoryLimitDirty = true;
+            emit textureMemoryLimitChanged(megabytes);
+            emit dptr()->needUpdate();
+        }
+    } else {
+        qWarning() << __FUNCTION__ << "Attempted to set invalid memory limit.";
+    }
+}
+
+int QCustom3DVolume::textureMemoryLimit() const
+{
+    return dptrc()->m_textureMemoryLimit;
+}
+
 // Note: textureFormat is not a Q_PROPERTY to work around an issue in meta object system that
 // doesn't allow QImage::format to be a property type. Qt 5.2.1 at least has this problem.
 
 /*!
- * Sets the format of the textureData property to \a format. Only two formats
+ * Sets the format of the textureData property to \a format. Only three formats
  * are supported currently:
- * QImage::Format_Indexed8 and QImage::Format_ARGB32. If an indexed format is specified, colorTable
- * must also be set.
+ * QImage::Format_Indexed8, QImage::Format_Grayscale16, and QImage::Format_ARGB32.
+ * If an indexed format or QImage::Format_Grayscale16 is specified, colorTable
+ * must also be set. QImage::Format_Grayscale16 is supported since Qt 6.4.
+ *
+ * QImage has no single channel floating point format, so volumes of 32-bit float values
+ * use QImage::Format_Invalid together with the QCustom3DVolume::TextureValueFloat
+ * textureValueType. Their colors are looked up from colorTable as well. Float volumes are
+ * supported since Qt 6.4.
+ *
  * Defaults to QImage::Format_ARGB32.
  *
- * \sa colorTable, textureData
+ * \sa colorTable, textureData, textureValueType
  */
 void QCustom3DVolume::setTextureFormat(QImage::Format format)
 {
-    if (format == QImage::Format_ARGB32 || format == QImage::Format_Indexed8) {
+    if (QCustom3DVolumePrivate::isSupportedFormat(format) || format == QImage::Format_Invalid) {
         if (dptr()->m_textureFormat != format) {
             dptr()->m_textureFormat = format;
             dptr()->m_dirtyBitsVolume.textureFormatDirty = true;
@@ -839,6 +1034,64 @@ QImage::Format QCustom3DVolume::textureFormat() const
     return dptrc()->m_textureFormat;
 }
 
+/*!
+ * \enum QCustom3DVolume::TextureValueType
+ * \since 6.4
+ *
+ * How the values of single channel texture data are interpreted.
+ *
+ * \value TextureValueUnsigned
+ *        Unsigned 16-bit integers in the QImage::Format_Grayscale16 format. This is the default.
+ * \value TextureValueHalfFloat
+ *        16-bit half precision floating point values, such as qfloat16, in the
+ *        QImage::Format_Grayscale16 format.
+ * \value TextureValueFloat
+ *        32-bit floating point values. The texture format must be QImage::Format_Invalid,
+ *        because QImage has no single channel floating point format.
+ */
+
+/*!
+ * \property QCustom3DVolume::textureValueType
+ * \since 6.4
+ *
+ * \brief How the values of single channel texture data are interpreted.
+ *
+ * The format and the value type form a pair. QImage::Format_Grayscale16 data holds
+ * 16-bit values, either QCustom3DVolume::TextureValueUnsigned or
+ * QCustom3DVolume::TextureValueHalfFloat. Volumes of 32-bit float values use the
+ * QImage::Format_Invalid texture format with QCustom3DVolume::TextureValueFloat, so
+ * textureDataWidth() is four times textureWidth for them. A volume with any other pair
+ * is not drawn. The value type has no effect with the QImage::Format_Indexed8 and
+ * QImage::Format_ARGB32 formats.
+ *
+ * The values of the volume are mapped over the colorTable when the volume is drawn.
+ * Unsigned values cover the whole color table. Floating point values between \c{0} and
+ * \c{1} cover the color table, and values outside that range are clamped to it.
+ *
+ * The image based functions createTextureData(), renderSlice(), and setSubTextureData()
+ * with an image are not supported for float volumes.
+ *
+ * Floating point volumes need OpenGL 3.0 or the ARB_texture_float extension.
+ *
+ * Defaults to QCustom3DVolume::TextureValueUnsigned.
+ *
+ * \sa setTextureFormat(), colorTable
+ */
+void QCustom3DVolume::setTextureValueType(QCustom3DVolume::TextureValueType type)
+{
+    if (dptr()->m_textureValueType != type) {
+        dptr()->m_textureValueType = type;
+        dptr()->m_dirtyBitsVolume.textureFormatDirty = true;
+        emit textureValueTypeChanged(type);
+        emit dptr()->needUpdate();
+    }
+}
+
+QCustom3DVolume::TextureValueType QCustom3DVolume::textureValueType() const
+{
+    return dptrc()->m_textureValueType;
+}
+
 /*!
  * \fn void QCustom3DVolume::textureFormatChanged(QImage::Format format)
  *
@@ -1129,7 +1382,8 @@ QVector3D QCustom3DVolume::sliceFrameThicknesses() const
  * The texture format of this object is used.
  *
  * Returns the rendered image of the slice, or a null image if an invalid index is
- * specified.
+ * specified or the volume holds 32-bit float values. Half float
+ * values are copied as they are into a QImage::Format_Grayscale16 image.
  *
  * \sa setTextureFormat()
  */
@@ -1163,7 +1417,12 @@ QCustom3DVolumePrivate::QCustom3DVolumePrivate(QCustom3DVolume *q) :
     m_sliceIndexY(-1),
     m_sliceIndexZ(-1),
     m_textureFormat(QImage::Format_ARGB32),
+    m_textureValueType(QCustom3DVolume::TextureValueUnsigned),
     m_textureData(0),
+    m_textureDataFile(0),
+    m_mappedTextureData(0),
+    m_mappedTextureDataSize(0),
+    m_textureMemoryLimit(512),
     m_alphaMultiplier(1.0f),
     m_preserveOpacity(true),
     m_useHighDefShader(true),
@@ -1191,8 +1450,13 @@ QCustom3DVolumePrivate::QCustom3DVolumePrivate(
       m_sliceIndexY(-1),
       m_sliceIndexZ(-1),
       m_textureFormat(textureFormat),
+      m_textureValueType(QCustom3DVolume::TextureValueUnsigned),
       m_colorTable(colorTable),
       m_textureData(textureData),
+      m_textureDataFile(0),
+      m_mappedTextureData(0),
+      m_mappedTextureDataSize(0),
+      m_textureMemoryLimit(512),
       m_alphaMultiplier(1.0f),
       m_preserveOpacity(true),
       m_useHighDefShader(true),
@@ -1213,7 +1477,7 @@ QCustom3DVolumePrivate::QCustom3DVolumePrivate(
     if (m_textureDepth < 0)
         m_textureDepth = 0;
 
-    if (m_textureFormat != QImage::Format_Indexed8)
+    if (!isSupportedFormat(m_textureFormat))
         m_textureFormat = QImage::Format_ARGB32;
 
 }
@@ -1221,6 +1485,7 @@ QCustom3DVolumePrivate::QCustom3DVolumePrivate(
 QCustom3DVolumePrivate::~QCustom3DVolumePrivate()
 {
     delete m_textureData;
+    clearTextureDataFile();
 }
 
 void QCustom3DVolumePrivate::resetDirtyBits()
@@ -1231,15 +1496,100 @@ void QCustom3DVolumePrivate::resetDirtyBits()
     m_dirtyBitsVolume.slicesDirty = false;
     m_dirtyBitsVolume.colorTableDirty = false;
     m_dirtyBitsVolume.textureDataDirty = false;
+    m_dirtyBitsVolume.subTextureDataDirty = false;
     m_dirtyBitsVolume.textureFormatDirty = false;
     m_dirtyBitsVolume.alphaDirty = false;
     m_dirtyBitsVolume.shaderDirty = false;
+    m_dirtyBitsVolume.textureMemoryLimitDirty = false;
+    m_dirtySubTextures.clear();
+}
+
+bool QCustom3DVolumePrivate::isSupportedFormat(QImage::Format format)
+{
+    return format == QImage::Format_ARGB32 || format == QImage::Format_Indexed8
+            || format == QImage::Format_Grayscale16;
+}
+
+int QCustom3DVolumePrivate::pixelBytes(QImage::Format format)
+{
+    if (format == QImage::Format_Indexed8)
+        return 1;
+    if (format == QImage::Format_Grayscale16)
+        return 2;
+    return 4;
+}
+
+bool QCustom3DVolumePrivate::hasValidValueType() const
+{
+    if (m_textureFormat == QImage::Format_Invalid)
+        return m_textureValueType == QCustom3DVolume::TextureValueFloat;
+    return m_textureValueType != QCustom3DVolume::TextureValueFloat;
+}
+
+void QCustom3DVolumePrivate::markSubTextureDirty(Qt::Axis axis, int index)
+{
+    // The whole texture is uploaded anyway
+    if (m_dirtyBitsVolume.textureDataDirty)
+        return;
+
+    QPair<Qt::Axis, int> slice(axis, index);
+    if (m_dirtySubTextures.contains(slice))
+        return;
+
+    // Upload the whole texture instead when the changed slices would add up to more data
+    qint64 dirtySize = 0;
+    m_dirtySubTextures.append(slice);
+    for (int i = 0; i < m_dirtySubTextures.size(); i++) {
+        Qt::Axis sliceAxis = m_dirtySubTextures.at(i).first;
+        if (sliceAxis == Qt::XAxis)
+            dirtySize += qint64(m_textureHeight) * m_textureDepth;
+        else if (sliceAxis == Qt::YAxis)
+            dirtySize += qint64(m_textureWidth) * m_textureDepth;
+        else
+            dirtySize += qint64(m_textureWidth) * m_textureHeight;
+    }
+    if (dirtySize >= qint64(m_textureWidth) * m_textureHeight * m_textureDepth) {
+        m_dirtySubTextures.clear();
+        m_dirtyBitsVolume.subTextureDataDirty = false;
+        m_dirtyBitsVolume.textureDataDirty = true;
+    } else {
+        m_dirtyBitsVolume.subTextureDataDirty = true;
+    }
+}
+
+const uchar *QCustom3DVolumePrivate::textureBytes() const
+{
+    if (!hasValidValueType())
+        return 0;
+    const QCustom3DVolume *q = static_cast<const QCustom3DVolume *>(q_ptr);
+    qint64 size = qint64(q->textureDataWidth()) * m_textureHeight * m_textureDepth;
+    if (m_textureData)
+        return (m_textureData->size() >= size) ? m_textureData->constData() : 0;
+    if (m_mappedTextureData && m_mappedTextureDataSize >= size)
+        return m_mappedTextureData;
+    return 0;
+}
+
+void QCustom3DVolumePrivate::clearTextureDataFile()
+{
+    if (m_textureDataFile) {
+        m_textureDataFile->unmap(m_mappedTextureData);
+        delete m_textureDataFile;
+        m_textureDataFile = 0;
+        m_mappedTextureData = 0;
+        m_mappedTextureDataSize = 0;
+    }
 }
 
 QImage QCustom3DVolumePrivate::renderSlice(Qt::Axis axis, int index)
 {
-    if (index < 0)
+    const uchar *textureData = textureBytes();
+    if (index < 0 || !textureData)
         return QImage();
+    if (m_textureFormat == QImage::Format_Invalid) {
+        qWarning() << __FUNCTION__ << "Images are not supported for float texture values.";
+        return QImage();
+    }
 
     int x;
     int y;
@@ -1260,53 +1610,63 @@ QImage QCustom3DVolumePrivate::renderSlice(Qt::Axis axis, int index)
         y = m_textureHeight;
     }
 
-    int padding = 0;
-    int pixelWidth = 4;
-    int dataWidth = qptr()->textureDataWidth();
-    if (m_textureFormat == QImage::Format_Indexed8) {
-        padding = x % 4;
-        pixelWidth = 1;
+    QImage image(x, y, m_textureFormat);
+    if (image.isNull())
+        return QImage();
+
+    const int pixelWidth = pixelBytes(m_textureFormat);
+    const qint64 dataWidth = qptr()->textureDataWidth();
+    const qint64 frameSize = dataWidth * m_textureHeight;
+    const int lineBytes = x * pixelWidth;
+    uchar *sliceBits = image.bits();
+    const qsizetype sliceBytesPerLine = image.bytesPerLine();
+
+    const bool multiplyAlpha = m_textureFormat == QImage::Format_ARGB32
+            && m_alphaMultiplier != 1.0f;
+    uchar alphaValues[256];
+    if (multiplyAlpha) {
+        for (int i = 0; i < 256; i++)
+            alphaValues[i] = static_cast<uchar>(multipliedAlphaValue(i));
     }
-    QList<uchar> data((x + padding) * y * pixelWidth);
-    int frameSize = qptr()->textureDataWidth() * m_textureHeight;
 
-    int dataIndex = 0;
-    if (axis == Qt::XAxis) {
-        for (int i = 0; i < y; i++) {
-            const uchar *p = m_textureData->constData()
-                    + (index * pixelWidth) + (dataWidth * i);
-            for (int j = 0; j < x; j++) {
-                for (int k = 0; k < pixelWidth; k++)
-                    data[dataIndex++] = *(p + k);
-                p += frameSize;
+    // The lines of the slice are copied concurrently for large slices
+    Utils::parallelFor(y, [&](int begin, int end) {
+        if (axis == Qt::XAxis) {
+            // Each texel on a line comes from a different frame, so the lines are copied in
+            // tiles, reading the frames in order
+            for (int tileBegin = begin; tileBegin < end; tileBegin += sliceTileLines) {
+                const int tileLines = qMin(sliceTileLines, end - tileBegin);
+                for (int j = 0; j < x; j++) {
+                    const uchar *p = textureData + (j * frameSize) + (tileBegin * dataWidth)
+                            + (index * pixelWidth);
+                    uchar *q = sliceBits + (tileBegin * sliceBytesPerLine) + (j * pixelWidth);
+                    if (pixelWidth == 1)
+                        copyTexels<quint8>(p, dataWidth, q, sliceBytesPerLine, tileLines);
+                    else if (pixelWidth == 2)
+                        copyTexels<quint16>(p, dataWidth, q, sliceBytesPerLine, tileLines);
+                    else
+                        copyTexels<quint32>(p, dataWidth, q, sliceBytesPerLine, tileLines);
+                }
             }
-        }
-    } else if (axis == Qt::YAxis) {
-        for (int i = y - 1; i >= 0; i--) {
-            const uchar *p = m_textureData->constData() + (index * dataWidth)
-                    + (frameSize * i);
-            for (int j = 0; j < (x * pixelWidth); j++) {
-                data[dataIndex++] = *p;
-                p++;
+        } else {
+            for (int i = begin; i < end; i++) {
+                // The first line of a Y axis slice is taken from the last frame
+                const uchar *p = (axis == Qt::YAxis)
+                        ? textureData + (index * dataWidth) + ((y - 1 - i) * frameSize)
+                        : textureData + (index * frameSize) + (i * dataWidth);
+                memcpy(sliceBits + (i * sliceBytesPerLine), p, lineBytes);
             }
         }
-    } else {
-        for (int i = 0; i < y; i++) {
-            const uchar *p = m_textureData->constData() + (index * frameSize) + (dataWidth * i);
-            for (int j = 0; j < (x * pixelWidth); j++) {
-                data[dataIndex++] = *p;
-                p++;
+
+        if (multiplyAlpha) {
+            for (int i = begin; i < end; i++) {
+                uchar *line = sliceBits + (i * sliceBytesPerLine);
+                for (int j = pixelWidth - 1; j < lineBytes; j += pixelWidth)
+                    line[j] = alphaValues[line[j]];
             }
         }
-    }
-
-    if (m_textureFormat != QImage::Format_Indexed8 && m_alphaMultiplier != 1.0f) {
-        for (int i = pixelWidth - 1; i < data.size(); i += pixelWidth)
-            data[i] = static_cast<uchar>(multipliedAlphaValue(data.at(i)));
-    }
+    }, x);
 
-    QImage image(data.constData(), x, y, x * pixelWidth, m_textureFormat);
-    image.bits(); // Call bits() to detach the new image from local data
     if (m_textureFormat == QImage::Format_Indexed8) {
         QList<QRgb> colorTable = m_colorTable;
         if (m_alphaMultiplier != 1.0f) {
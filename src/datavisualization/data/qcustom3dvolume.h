@@ -60,8 +60,16 @@ class Q_DATAVISUALIZATION_EXPORT QCustom3DVolume : public QCustom3DItem
     Q_PROPERTY(QVector3D sliceFrameWidths READ sliceFrameWidths WRITE setSliceFrameWidths NOTIFY sliceFrameWidthsChanged)
     Q_PROPERTY(QVector3D sliceFrameGaps READ sliceFrameGaps WRITE setSliceFrameGaps NOTIFY sliceFrameGapsChanged)
     Q_PROPERTY(QVector3D sliceFrameThicknesses READ sliceFrameThicknesses WRITE setSliceFrameThicknesses NOTIFY sliceFrameThicknessesChanged)
+    Q_PROPERTY(int textureMemoryLimit READ textureMemoryLimit WRITE setTextureMemoryLimit NOTIFY textureMemoryLimitChanged REVISION(6, 4))
+    Q_PROPERTY(QCustom3DVolume::TextureValueType textureValueType READ textureValueType WRITE setTextureValueType NOTIFY textureValueTypeChanged REVISION(6, 4))
 
 public:
+    enum TextureValueType {
+        TextureValueUnsigned = 0,
+        TextureValueHalfFloat,
+        TextureValueFloat
+    };
+    Q_ENUM(TextureValueType)
 
     explicit QCustom3DVolume(QObject *parent = nullptr);
     explicit QCustom3DVolume(const QVector3D &position, const QVector3D &scaling,
@@ -96,9 +104,15 @@ public:
     QList<uchar> *textureData() const;
     void setSubTextureData(Qt::Axis axis, int index, const uchar *data);
     void setSubTextureData(Qt::Axis axis, int index, const QImage &image);
+    bool setTextureDataFile(const QString &fileName, qint64 offset = 0);
+    QString textureDataFile() const;
+    void setTextureMemoryLimit(int megabytes);
+    int textureMemoryLimit() const;
 
     void setTextureFormat(QImage::Format format);
     QImage::Format textureFormat() const;
+    void setTextureValueType(QCustom3DVolume::TextureValueType type);
+    QCustom3DVolume::TextureValueType textureValueType() const;
 
     void setAlphaMultiplier(float mult);
     float alphaMultiplier() const;
@@ -143,6 +157,8 @@ Q_SIGNALS:
     void sliceFrameWidthsChanged(const QVector3D &values);
     void sliceFrameGapsChanged(const QVector3D &values);
     void sliceFrameThicknessesChanged(const QVector3D &values);
+    Q_REVISION(6, 4) void textureMemoryLimitChanged(int megabytes);
+    Q_REVISION(6, 4) void textureValueTypeChanged(QCustom3DVolume::TextureValueType type);
 
 protected:
     QCustom3DVolumePrivate *dptr();
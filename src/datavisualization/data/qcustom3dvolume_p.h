@@ -43,6 +43,8 @@
 #include "qcustom3dvolume.h"
 #include "qcustom3ditem_p.h"
 
+QT_FORWARD_DECLARE_CLASS(QFile)
+
 QT_BEGIN_NAMESPACE
 
 struct QCustomVolumeDirtyBitField {
@@ -50,18 +52,22 @@ struct QCustomVolumeDirtyBitField {
     bool slicesDirty            : 1;
     bool colorTableDirty        : 1;
     bool textureDataDirty       : 1;
+    bool subTextureDataDirty    : 1;
     bool textureFormatDirty     : 1;
     bool alphaDirty             : 1;
     bool shaderDirty            : 1;
+    bool textureMemoryLimitDirty : 1;
 
     QCustomVolumeDirtyBitField()
         : textureDimensionsDirty(false),
           slicesDirty(false),
           colorTableDirty(false),
           textureDataDirty(false),
+          subTextureDataDirty(false),
           textureFormatDirty(false),
           alphaDirty(false),
-          shaderDirty(false)
+          shaderDirty(false),
+          textureMemoryLimitDirty(false)
     {
     }
 };
@@ -80,6 +86,18 @@ public:
 
     void resetDirtyBits();
     QImage renderSlice(Qt::Axis axis, int index);
+    void markSubTextureDirty(Qt::Axis axis, int index);
+    // Returns the texture data from the array or the mapped file, or null if there is not
+    // enough data for the texture dimensions
+    const uchar *textureBytes() const;
+    void clearTextureDataFile();
+
+    // Returns true if the format and the value type are a valid pair. Float volumes have no
+    // QImage format, so they use QImage::Format_Invalid with TextureValueFloat.
+    bool hasValidValueType() const;
+
+    static bool isSupportedFormat(QImage::Format format);
+    static int pixelBytes(QImage::Format format);
 
     QCustom3DVolume *qptr();
 
@@ -92,8 +110,13 @@ public:
     int m_sliceIndexZ;
 
     QImage::Format m_textureFormat;
+    QCustom3DVolume::TextureValueType m_textureValueType;
     QList<QRgb> m_colorTable;
     QList<uchar> *m_textureData;
+    QFile *m_textureDataFile;
+    uchar *m_mappedTextureData;
+    qint64 m_mappedTextureDataSize;
+    int m_textureMemoryLimit;
 
     float m_alphaMultiplier;
     bool m_preserveOpacity;
@@ -107,6 +130,8 @@ public:
     QVector3D m_sliceFrameThicknesses;
 
     QCustomVolumeDirtyBitField m_dirtyBitsVolume;
+    // Slices changed with setSubTextureData() since the texture was last uploaded
+    QList<QPair<Qt::Axis, int> > m_dirtySubTextures;
 
 private:
     int multipliedAlphaValue(int alpha);
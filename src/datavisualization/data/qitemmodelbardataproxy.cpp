@@ -283,6 +283,34 @@ QT_BEGIN_NAMESPACE
  *         added together and the total is used as the bar value.
  */
 
+/*!
+ * \qmlproperty bool ItemModelBarDataProxy::asynchronousResolve
+ * \since 6.4
+ *
+ * Whether the item model is resolved into proxy data in a worker thread.
+ * Defaults to \c{false}.
+ *
+ * When enabled, the data of the mapped roles is copied from the item model,
+ * and the patterns, categories, and value conversions are resolved in a
+ * worker thread. The resolved data replaces the proxy data in one go when it
+ * is ready, so the user interface stays responsive with large item models.
+ * Changes made to the item model while resolving cause another resolve after
+ * the running one finishes.
+ *
+ * The data is still copied in the thread of the item model, because item
+ * models cannot be accessed from other threads. The copy takes one
+ * QAbstractItemModel::multiData() call per item, so item models that
+ * reimplement multiData() to return all the roles at once copy faster.
+ */
+
+/*!
+ * \qmlsignal ItemModelBarDataProxy::modelResolved(int msecs)
+ * \since 6.4
+ *
+ * This signal is emitted when the item model has been resolved into proxy
+ * data. \a msecs is the time the resolve took in milliseconds.
+ */
+
 /*!
  * Constructs QItemModelBarDataProxy with optional \a parent.
  */
@@ -879,6 +907,51 @@ QItemModelBarDataProxy::MultiMatchBehavior QItemModelBarDataProxy::multiMatchBeh
     return dptrc()->m_multiMatchBehavior;
 }
 
+/*!
+ * \property QItemModelBarDataProxy::asynchronousResolve
+ * \since 6.4
+ *
+ * \brief Whether the item model is resolved into proxy data in a worker thread.
+ *
+ * Defaults to \c{false}.
+ *
+ * When enabled, the data of the mapped roles is copied from the item model,
+ * and the patterns, categories, and value conversions are resolved in a
+ * worker thread. The resolved data replaces the proxy data in one go when it
+ * is ready, so the user interface stays responsive with large item models.
+ * Changes made to the item model while resolving cause another resolve after
+ * the running one finishes.
+ *
+ * The data is still copied in the thread of the item model, because item
+ * models cannot be accessed from other threads. The copy takes one
+ * QAbstractItemModel::multiData() call per item, so item models that
+ * reimplement multiData() to return all the roles at once copy faster.
+ *
+ * \sa modelResolved()
+ */
+void QItemModelBarDataProxy::setAsynchronousResolve(bool enable)
+{
+    if (dptr()->m_itemModelHandler->isAsyncResolve() != enable) {
+        dptr()->m_itemModelHandler->setAsyncResolve(enable);
+        emit asynchronousResolveChanged(enable);
+    }
+}
+
+bool QItemModelBarDataProxy::asynchronousResolve() const
+{
+    return dptrc()->m_itemModelHandler->isAsyncResolve();
+}
+
+/*!
+ * \fn void QItemModelBarDataProxy::modelResolved(int msecs)
+ * \since 6.4
+ *
+ * This signal is emitted when the item model has been resolved into proxy
+ * data. \a msecs is the time the resolve took in milliseconds.
+ *
+ * \sa asynchronousResolve
+ */
+
 /*!
  * \internal
  */
@@ -921,6 +994,8 @@ void QItemModelBarDataProxyPrivate::connectItemModelHandler()
 {
     QObject::connect(m_itemModelHandler, &BarItemModelHandler::itemModelChanged,
                      qptr(), &QItemModelBarDataProxy::itemModelChanged);
+    QObject::connect(m_itemModelHandler, &BarItemModelHandler::modelResolved,
+                     qptr(), &QItemModelBarDataProxy::modelResolved);
     QObject::connect(qptr(), &QItemModelBarDataProxy::rowRoleChanged,
                      m_itemModelHandler, &AbstractItemModelHandler::handleMappingChanged);
     QObject::connect(qptr(), &QItemModelBarDataProxy::columnRoleChanged,
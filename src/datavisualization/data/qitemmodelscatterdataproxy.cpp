@@ -42,9 +42,10 @@ QT_BEGIN_NAMESPACE
  * for Q3DScatter. It maps roles of QAbstractItemModel to the XYZ-values of Q3DScatter points.
  *
  * The data is resolved asynchronously whenever the mapping or the model changes.
- * QScatterDataProxy::arrayReset() is emitted when the data has been resolved. However, inserts,
- * removes, and single data item changes after the model initialization are resolved synchronously,
- * unless the same frame also contains a change that causes the whole model to be resolved.
+ * QScatterDataProxy::arrayReset() is emitted when the data has been resolved. However, row
+ * inserts, removes, and moves, as well as data item changes after the model initialization are
+ * resolved synchronously, unless the same frame also contains a change that causes the whole
+ * model to be resolved. Column changes always cause the whole model to be resolved.
  *
  * Mapping ignores rows and columns of the QAbstractItemModel and treats
  * all items equally. It requires the model to provide roles for the data items
@@ -208,6 +209,34 @@ QT_BEGIN_NAMESPACE
  * \sa rotationRole, rotationRolePattern
  */
 
+/*!
+ * \qmlproperty bool ItemModelScatterDataProxy::asynchronousResolve
+ * \since 6.4
+ *
+ * Whether the item model is resolved into proxy data in a worker thread.
+ * Defaults to \c{false}.
+ *
+ * When enabled, the data of the mapped roles is copied from the item model,
+ * and the patterns, categories, and value conversions are resolved in a
+ * worker thread. The resolved data replaces the proxy data in one go when it
+ * is ready, so the user interface stays responsive with large item models.
+ * Changes made to the item model while resolving cause another resolve after
+ * the running one finishes.
+ *
+ * The data is still copied in the thread of the item model, because item
+ * models cannot be accessed from other threads. The copy takes one
+ * QAbstractItemModel::multiData() call per item, so item models that
+ * reimplement multiData() to return all the roles at once copy faster.
+ */
+
+/*!
+ * \qmlsignal ItemModelScatterDataProxy::modelResolved(int msecs)
+ * \since 6.4
+ *
+ * This signal is emitted when the item model has been resolved into proxy
+ * data. \a msecs is the time the resolve took in milliseconds.
+ */
+
 /*!
  * Constructs QItemModelScatterDataProxy with optional \a parent.
  */
@@ -583,6 +612,51 @@ void QItemModelScatterDataProxy::remap(const QString &xPosRole, const QString &y
     setRotationRole(rotationRole);
 }
 
+/*!
+ * \property QItemModelScatterDataProxy::asynchronousResolve
+ * \since 6.4
+ *
+ * \brief Whether the item model is resolved into proxy data in a worker thread.
+ *
+ * Defaults to \c{false}.
+ *
+ * When enabled, the data of the mapped roles is copied from the item model,
+ * and the patterns, categories, and value conversions are resolved in a
+ * worker thread. The resolved data replaces the proxy data in one go when it
+ * is ready, so the user interface stays responsive with large item models.
+ * Changes made to the item model while resolving cause another resolve after
+ * the running one finishes.
+ *
+ * The data is still copied in the thread of the item model, because item
+ * models cannot be accessed from other threads. The copy takes one
+ * QAbstractItemModel::multiData() call per item, so item models that
+ * reimplement multiData() to return all the roles at once copy faster.
+ *
+ * \sa modelResolved()
+ */
+void QItemModelScatterDataProxy::setAsynchronousResolve(bool enable)
+{
+    if (dptr()->m_itemModelHandler->isAsyncResolve() != enable) {
+        dptr()->m_itemModelHandler->setAsyncResolve(enable);
+        emit asynchronousResolveChanged(enable);
+    }
+}
+
+bool QItemModelScatterDataProxy::asynchronousResolve() const
+{
+    return dptrc()->m_itemModelHandler->isAsyncResolve();
+}
+
+/*!
+ * \fn void QItemModelScatterDataProxy::modelResolved(int msecs)
+ * \since 6.4
+ *
+ * This signal is emitted when the item model has been resolved into proxy
+ * data. \a msecs is the time the resolve took in milliseconds.
+ *
+ * \sa asynchronousResolve
+ */
+
 /*!
  * \internal
  */
@@ -621,6 +695,8 @@ void QItemModelScatterDataProxyPrivate::connectItemModelHandler()
 {
     QObject::connect(m_itemModelHandler, &ScatterItemModelHandler::itemModelChanged,
                      qptr(), &QItemModelScatterDataProxy::itemModelChanged);
+    QObject::connect(m_itemModelHandler, &ScatterItemModelHandler::modelResolved,
+                     qptr(), &QItemModelScatterDataProxy::modelResolved);
     QObject::connect(qptr(), &QItemModelScatterDataProxy::xPosRoleChanged,
                      m_itemModelHandler, &AbstractItemModelHandler::handleMappingChanged);
     QObject::connect(qptr(), &QItemModelScatterDataProxy::yPosRoleChanged,
@@ -55,6 +55,7 @@ class Q_DATAVISUALIZATION_EXPORT QItemModelScatterDataProxy : public QScatterDat
     Q_PROPERTY(QString yPosRoleReplace READ yPosRoleReplace WRITE setYPosRoleReplace NOTIFY yPosRoleReplaceChanged REVISION(1, 1))
     Q_PROPERTY(QString zPosRoleReplace READ zPosRoleReplace WRITE setZPosRoleReplace NOTIFY zPosRoleReplaceChanged REVISION(1, 1))
     Q_PROPERTY(QString rotationRoleReplace READ rotationRoleReplace WRITE setRotationRoleReplace NOTIFY rotationRoleReplaceChanged REVISION(1, 1))
+    Q_PROPERTY(bool asynchronousResolve READ asynchronousResolve WRITE setAsynchronousResolve NOTIFY asynchronousResolveChanged REVISION(6, 4))
 
 public:
     explicit QItemModelScatterDataProxy(QObject *parent = nullptr);
@@ -101,6 +102,9 @@ public:
     void setRotationRoleReplace(const QString &replace);
     QString rotationRoleReplace() const;
 
+    void setAsynchronousResolve(bool enable);
+    bool asynchronousResolve() const;
+
 Q_SIGNALS:
     void itemModelChanged(const QAbstractItemModel* itemModel);
     void xPosRoleChanged(const QString &role);
@@ -115,6 +119,8 @@ Q_SIGNALS:
     Q_REVISION(1, 1) void xPosRoleReplaceChanged(const QString &replace);
     Q_REVISION(1, 1) void yPosRoleReplaceChanged(const QString &replace);
     Q_REVISION(1, 1) void zPosRoleReplaceChanged(const QString &replace);
+    Q_REVISION(6, 4) void asynchronousResolveChanged(bool enable);
+    Q_REVISION(6, 4) void modelResolved(int msecs);
 
 protected:
     QItemModelScatterDataProxyPrivate *dptr();
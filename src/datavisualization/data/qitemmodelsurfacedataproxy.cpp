@@ -44,9 +44,10 @@ QT_BEGIN_NAMESPACE
  *
  * Data is resolved asynchronously whenever the mapping or the model changes.
  * QSurfaceDataProxy::arrayReset() is emitted when the data has been resolved.
- * However, when useModelCategories property is set to \c true, single item changes are resolved
- * synchronously, unless the same frame also contains a change that causes the whole model to be
- * resolved.
+ * However, when useModelCategories property is set to \c true, single item changes and row moves
+ * are resolved synchronously, unless the same frame also contains a change that causes the whole
+ * model to be resolved. Row inserts and removes are also resolved synchronously if the
+ * Z-position is mapped to a role, as the row headers of the rows after the change shift.
  *
  * Mappings can be used in the following ways:
  *
@@ -86,6 +87,12 @@ QT_BEGIN_NAMESPACE
  * using regular expressions has an impact on the performance, so it's more efficient to utilize
  * item models where doing search and replace is not necessary to get the desired values.
  *
+ * When useModelCategories is \c true, the proxy fetches all mapped roles of an item with a single
+ * QAbstractItemModel::multiData() call, and parses the header positions only once per row and
+ * column. Large models resolve fastest when they reimplement multiData() and return the
+ * positions as numeric values, which are converted without going through strings when no
+ * pattern is set for the role.
+ *
  * For example about using the search patterns in conjunction with the roles, see
  * ItemModelBarDataProxy usage in \l{Qt Quick 2 Bars Example}.
  *
@@ -336,6 +343,34 @@ QT_BEGIN_NAMESPACE
  *         instead of averaged and the total is used as the surface point Y position.
  */
 
+/*!
+ * \qmlproperty bool ItemModelSurfaceDataProxy::asynchronousResolve
+ * \since 6.4
+ *
+ * Whether the item model is resolved into proxy data in a worker thread.
+ * Defaults to \c{false}.
+ *
+ * When enabled, the data of the mapped roles is copied from the item model,
+ * and the patterns, categories, and value conversions are resolved in a
+ * worker thread. The resolved data replaces the proxy data in one go when it
+ * is ready, so the user interface stays responsive with large item models.
+ * Changes made to the item model while resolving cause another resolve after
+ * the running one finishes.
+ *
+ * The data is still copied in the thread of the item model, because item
+ * models cannot be accessed from other threads. The copy takes one
+ * QAbstractItemModel::multiData() call per item, so item models that
+ * reimplement multiData() to return all the roles at once copy faster.
+ */
+
+/*!
+ * \qmlsignal ItemModelSurfaceDataProxy::modelResolved(int msecs)
+ * \since 6.4
+ *
+ * This signal is emitted when the item model has been resolved into proxy
+ * data. \a msecs is the time the resolve took in milliseconds.
+ */
+
 /*!
  * Constructs QItemModelSurfaceDataProxy with optional \a parent.
  */
@@ -1038,6 +1073,51 @@ QItemModelSurfaceDataProxy::MultiMatchBehavior QItemModelSurfaceDataProxy::multi
     return dptrc()->m_multiMatchBehavior;
 }
 
+/*!
+ * \property QItemModelSurfaceDataProxy::asynchronousResolve
+ * \since 6.4
+ *
+ * \brief Whether the item model is resolved into proxy data in a worker thread.
+ *
+ * Defaults to \c{false}.
+ *
+ * When enabled, the data of the mapped roles is copied from the item model,
+ * and the patterns, categories, and value conversions are resolved in a
+ * worker thread. The resolved data replaces the proxy data in one go when it
+ * is ready, so the user interface stays responsive with large item models.
+ * Changes made to the item model while resolving cause another resolve after
+ * the running one finishes.
+ *
+ * The data is still copied in the thread of the item model, because item
+ * models cannot be accessed from other threads. The copy takes one
+ * QAbstractItemModel::multiData() call per item, so item models that
+ * reimplement multiData() to return all the roles at once copy faster.
+ *
+ * \sa modelResolved()
+ */
+void QItemModelSurfaceDataProxy::setAsynchronousResolve(bool enable)
+{
+    if (dptr()->m_itemModelHandler->isAsyncResolve() != enable) {
+        dptr()->m_itemModelHandler->setAsyncResolve(enable);
+        emit asynchronousResolveChanged(enable);
+    }
+}
+
+bool QItemModelSurfaceDataProxy::asynchronousResolve() const
+{
+    return dptrc()->m_itemModelHandler->isAsyncResolve();
+}
+
+/*!
+ * \fn void QItemModelSurfaceDataProxy::modelResolved(int msecs)
+ * \since 6.4
+ *
+ * This signal is emitted when the item model has been resolved into proxy
+ * data. \a msecs is the time the resolve took in milliseconds.
+ *
+ * \sa asynchronousResolve
+ */
+
 /*!
  * \internal
  */
@@ -1080,6 +1160,8 @@ void QItemModelSurfaceDataProxyPrivate::connectItemModelHandler()
 {
     QObject::connect(m_itemModelHandler, &SurfaceItemModelHandler::itemModelChanged,
                      qptr(), &QItemModelSurfaceDataProxy::itemModelChanged);
+    QObject::connect(m_itemModelHandler, &SurfaceItemModelHandler::modelResolved,
+                     qptr(), &QItemModelSurfaceDataProxy::modelResolved);
     QObject::connect(qptr(), &QItemModelSurfaceDataProxy::rowRoleChanged,
                      m_itemModelHandler, &AbstractItemModelHandler::handleMappingChanged);
     QObject::connect(qptr(), &QItemModelSurfaceDataProxy::columnRoleChanged,
@@ -65,6 +65,7 @@ class Q_DATAVISUALIZATION_EXPORT QItemModelSurfaceDataProxy : public QSurfaceDat
     Q_PROPERTY(QString yPosRoleReplace READ yPosRoleReplace WRITE setYPosRoleReplace NOTIFY yPosRoleReplaceChanged REVISION(1, 1))
     Q_PROPERTY(QString zPosRoleReplace READ zPosRoleReplace WRITE setZPosRoleReplace NOTIFY zPosRoleReplaceChanged REVISION(1, 1))
     Q_PROPERTY(MultiMatchBehavior multiMatchBehavior READ multiMatchBehavior WRITE setMultiMatchBehavior NOTIFY multiMatchBehaviorChanged REVISION(1, 1))
+    Q_PROPERTY(bool asynchronousResolve READ asynchronousResolve WRITE setAsynchronousResolve NOTIFY asynchronousResolveChanged REVISION(6, 4))
 
 public:
     enum MultiMatchBehavior {
@@ -157,6 +158,9 @@ public:
     void setMultiMatchBehavior(MultiMatchBehavior behavior);
     MultiMatchBehavior multiMatchBehavior() const;
 
+    void setAsynchronousResolve(bool enable);
+    bool asynchronousResolve() const;
+
 Q_SIGNALS:
     void itemModelChanged(const QAbstractItemModel* itemModel);
     void rowRoleChanged(const QString &role);
@@ -180,6 +184,8 @@ Q_SIGNALS:
     Q_REVISION(1, 1) void yPosRoleReplaceChanged(const QString &replace);
     Q_REVISION(1, 1) void zPosRoleReplaceChanged(const QString &replace);
     Q_REVISION(1, 1) void multiMatchBehaviorChanged(MultiMatchBehavior behavior);
+    Q_REVISION(6, 4) void asynchronousResolveChanged(bool enable);
+    Q_REVISION(6, 4) void modelResolved(int msecs);
 
 protected:
     QItemModelSurfaceDataProxyPrivate *dptr();
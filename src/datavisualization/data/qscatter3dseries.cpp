@@ -124,6 +124,50 @@ QT_BEGIN_NAMESPACE
  * The preset default is \c 0.0.
  */
 
+/*!
+ * \qmlproperty bool Scatter3DSeries::spatialIndexEnabled
+ * \since 6.4
+ *
+ * Whether the series maintains a spatial index of its item positions for the
+ * nearestItem(), itemsInBox(), and itemsInSphere() queries. Preset to
+ * \c false by default.
+ *
+ * The index is an octree that holds only item indices, so the data is not
+ * copied. It is kept up to date as items are added or changed, and rebuilt on
+ * the next query after items are removed or inserted, or the array is reset.
+ * When disabled, the queries scan all the items.
+ */
+
+/*!
+ * \qmlmethod int Scatter3DSeries::nearestItem(vector3d position)
+ * \since 6.4
+ *
+ * Returns the index of the item closest to \a position in data coordinates,
+ * or \c -1 if the series has no items.
+ *
+ * \sa spatialIndexEnabled
+ */
+
+/*!
+ * \qmlmethod list<int> Scatter3DSeries::itemsInBox(vector3d minimum, vector3d maximum)
+ * \since 6.4
+ *
+ * Returns the indices of the items within the axis-aligned box from \a minimum
+ * to \a maximum in data coordinates, in ascending order.
+ *
+ * \sa spatialIndexEnabled
+ */
+
+/*!
+ * \qmlmethod list<int> Scatter3DSeries::itemsInSphere(vector3d center, real radius)
+ * \since 6.4
+ *
+ * Returns the indices of the items within \a radius from \a center in data
+ * coordinates, in ascending order.
+ *
+ * \sa spatialIndexEnabled
+ */
+
 /*!
  * \qmlproperty int Scatter3DSeries::invalidSelectionIndex
  * A constant property providing an invalid index for selection. This index is
@@ -249,6 +293,72 @@ float QScatter3DSeries::itemSize() const
     return dptrc()->m_itemSize;
 }
 
+/*!
+ * \property QScatter3DSeries::spatialIndexEnabled
+ * \since 6.4
+ *
+ * \brief Whether the series maintains a spatial index of its item positions.
+ *
+ * Preset to \c false by default.
+ *
+ * The index is used by nearestItem(), itemsInBox(), and itemsInSphere(). It is
+ * an octree that holds only item indices, so the data is not copied. It is kept
+ * up to date as items are added or changed, and rebuilt on the next query after
+ * items are removed or inserted, or the array is reset. When disabled, the
+ * queries scan all the items.
+ */
+void QScatter3DSeries::setSpatialIndexEnabled(bool enabled)
+{
+    if (dptr()->m_spatialIndex.isEnabled() != enabled) {
+        dptr()->setSpatialIndexEnabled(enabled);
+        emit spatialIndexEnabledChanged(enabled);
+    }
+}
+
+bool QScatter3DSeries::isSpatialIndexEnabled() const
+{
+    return dptrc()->m_spatialIndex.isEnabled();
+}
+
+/*!
+ * \since 6.4
+ *
+ * Returns the index of the item closest to \a position in data coordinates,
+ * or \c -1 if the series has no items.
+ *
+ * \sa spatialIndexEnabled
+ */
+int QScatter3DSeries::nearestItem(const QVector3D &position) const
+{
+    return dptrc()->m_spatialIndex.nearestItem(position);
+}
+
+/*!
+ * \since 6.4
+ *
+ * Returns the indices of the items within the axis-aligned box from \a minimum
+ * to \a maximum in data coordinates, in ascending order.
+ *
+ * \sa spatialIndexEnabled
+ */
+QList<int> QScatter3DSeries::itemsInBox(const QVector3D &minimum, const QVector3D &maximum) const
+{
+    return dptrc()->m_spatialIndex.itemsInBox(minimum, maximum);
+}
+
+/*!
+ * \since 6.4
+ *
+ * Returns the indices of the items within \a radius from \a center in data
+ * coordinates, in ascending order.
+ *
+ * \sa spatialIndexEnabled
+ */
+QList<int> QScatter3DSeries::itemsInSphere(const QVector3D &center, float radius) const
+{
+    return dptrc()->m_spatialIndex.itemsInSphere(center, radius);
+}
+
 /*!
  * Returns an invalid index for selection. This index is set to the selectedItem
  * property to clear the selection from this series.
@@ -301,10 +411,35 @@ void QScatter3DSeriesPrivate::setDataProxy(QAbstractDataProxy *proxy)
     Q_ASSERT(proxy->type() == QAbstractDataProxy::DataTypeScatter);
 
     QAbstract3DSeriesPrivate::setDataProxy(proxy);
+    connectSpatialIndex(static_cast<QScatterDataProxy *>(proxy));
 
     emit qptr()->dataProxyChanged(static_cast<QScatterDataProxy *>(proxy));
 }
 
+void QScatter3DSeriesPrivate::connectSpatialIndex(QScatterDataProxy *proxy)
+{
+    // The old proxy has been deleted, which also removed its connections
+    m_spatialIndex.setProxy(proxy->dptrc());
+
+    QObject::connect(proxy, &QScatterDataProxy::arrayReset, this, [this]() {
+        m_spatialIndex.invalidate();
+    });
+    QObject::connect(proxy, &QScatterDataProxy::itemsAdded, this,
+                     [this](int startIndex, int count) {
+        m_spatialIndex.addItems(startIndex, count);
+    });
+    QObject::connect(proxy, &QScatterDataProxy::itemsChanged, this,
+                     [this](int startIndex, int count) {
+        m_spatialIndex.updateItems(startIndex, count);
+    });
+    QObject::connect(proxy, &QScatterDataProxy::itemsRemoved, this, [this]() {
+        m_spatialIndex.invalidate();
+    });
+    QObject::connect(proxy, &QScatterDataProxy::itemsInserted, this, [this]() {
+        m_spatialIndex.invalidate();
+    });
+}
+
 void QScatter3DSeriesPrivate::connectControllerAndProxy(Abstract3DController *newController)
 {
     QScatterDataProxy *scatterDataProxy = static_cast<QScatterDataProxy *>(m_dataProxy);
@@ -392,4 +527,9 @@ void QScatter3DSeriesPrivate::setItemSize(float size)
         m_controller->markSeriesVisualsDirty();
 }
 
+void QScatter3DSeriesPrivate::setSpatialIndexEnabled(bool enabled)
+{
+    m_spatialIndex.setEnabled(enabled);
+}
+
 QT_END_NAMESPACE
@@ -43,6 +43,7 @@ class Q_DATAVISUALIZATION_EXPORT QScatter3DSeries : public QAbstract3DSeries
     Q_PROPERTY(QScatterDataProxy *dataProxy READ dataProxy WRITE setDataProxy NOTIFY dataProxyChanged)
     Q_PROPERTY(int selectedItem READ selectedItem WRITE setSelectedItem NOTIFY selectedItemChanged)
     Q_PROPERTY(float itemSize READ itemSize WRITE setItemSize NOTIFY itemSizeChanged)
+    Q_PROPERTY(bool spatialIndexEnabled READ isSpatialIndexEnabled WRITE setSpatialIndexEnabled NOTIFY spatialIndexEnabledChanged REVISION(6, 4))
 
 public:
     explicit QScatter3DSeries(QObject *parent = nullptr);
@@ -59,10 +60,20 @@ public:
     void setItemSize(float size);
     float itemSize() const;
 
+    void setSpatialIndexEnabled(bool enabled);
+    bool isSpatialIndexEnabled() const;
+
+    Q_REVISION(6, 4) Q_INVOKABLE int nearestItem(const QVector3D &position) const;
+    Q_REVISION(6, 4) Q_INVOKABLE QList<int> itemsInBox(const QVector3D &minimum,
+                                                       const QVector3D &maximum) const;
+    Q_REVISION(6, 4) Q_INVOKABLE QList<int> itemsInSphere(const QVector3D &center,
+                                                          float radius) const;
+
 Q_SIGNALS:
     void dataProxyChanged(QScatterDataProxy *proxy);
     void selectedItemChanged(int index);
     void itemSizeChanged(float size);
+    Q_REVISION(6, 4) void spatialIndexEnabledChanged(bool enable);
 
 protected:
     explicit QScatter3DSeries(QScatter3DSeriesPrivate *d, QObject *parent = nullptr);
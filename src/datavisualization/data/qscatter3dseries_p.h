@@ -42,6 +42,7 @@
 
 #include "qscatter3dseries.h"
 #include "qabstract3dseries_p.h"
+#include "scatterspatialindex_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -58,11 +59,15 @@ public:
 
     void setSelectedItem(int index);
     void setItemSize(float size);
+    void setSpatialIndexEnabled(bool enabled);
 
 private:
     QScatter3DSeries *qptr();
+    void connectSpatialIndex(QScatterDataProxy *proxy);
+
     int m_selectedItem;
     float m_itemSize;
+    ScatterSpatialIndex m_spatialIndex;
 
 private:
     friend class QScatter3DSeries;
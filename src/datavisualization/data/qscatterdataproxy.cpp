@@ -44,7 +44,8 @@ QT_BEGIN_NAMESPACE
  *
  * QScatterDataProxy takes ownership of all
  * QtDataVisualization::QScatterDataArray and QScatterDataItem objects passed to
- * it.
+ * it. Alternatively, the proxy can read the data directly from buffers owned by
+ * the application, see borrowArray().
  *
  * \sa {Qt Data Visualization Data Handling}
  */
@@ -125,13 +126,66 @@ QScatter3DSeries *QScatterDataProxy::series() const
  */
 void QScatterDataProxy::resetArray(QScatterDataArray *newArray)
 {
-    if (dptr()->m_dataArray != newArray)
+    if (dptr()->m_dataArray != newArray || dptr()->isBorrowed())
         dptr()->resetArray(newArray);
 
     emit arrayReset();
     emit itemCountChanged(itemCount());
 }
 
+/*!
+ * \since 6.4
+ *
+ * Makes the proxy read \a count items directly from the buffers owned by the
+ * application, instead of copying them into a QScatterDataArray. The existing
+ * array is cleared.
+ *
+ * The positions are read as three consecutive floats (x, y, z) from
+ * \a positions, with \a positionStride bytes between the starts of consecutive
+ * items. The optional rotations are read as four consecutive floats
+ * (scalar, x, y, z) from \a rotations, with \a rotationStride bytes between the
+ * starts of consecutive items. A stride of zero means tightly packed data.
+ * If \a rotations is null, all the items have identity rotation.
+ *
+ * The buffers must stay valid until the proxy releases them. The proxy calls
+ * \a releaseFunction when it stops using the buffers, that is, when the array is
+ * reset or borrowed again, when the data is modified with the proxy methods, or
+ * when the proxy is destroyed.
+ *
+ * If the application changes the contents of the buffers, it needs to emit
+ * itemsChanged() or arrayReset() to update the graph. Adding, inserting,
+ * changing, or removing items with the proxy methods first copies the borrowed
+ * data into an array owned by the proxy.
+ *
+ * While the data is borrowed, array() returns an empty array. Use itemAt() to
+ * access individual items.
+ *
+ * \sa isArrayBorrowed(), resetArray()
+ */
+void QScatterDataProxy::borrowArray(const float *positions, int count, qsizetype positionStride,
+                                    const float *rotations, qsizetype rotationStride,
+                                    std::function<void()> releaseFunction)
+{
+    dptr()->borrowArray(positions, count, positionStride, rotations, rotationStride,
+                        releaseFunction);
+
+    emit arrayReset();
+    emit itemCountChanged(itemCount());
+}
+
+/*!
+ * \since 6.4
+ *
+ * Returns \c true if the proxy reads its data from buffers owned by the
+ * application.
+ *
+ * \sa borrowArray()
+ */
+bool QScatterDataProxy::isArrayBorrowed() const
+{
+    return dptrc()->isBorrowed();
+}
+
 /*!
  * Replaces the item at the position \a index with the item \a item.
  */
@@ -206,7 +260,7 @@ void QScatterDataProxy::insertItems(int index, const QScatterDataArray &items)
  */
 void QScatterDataProxy::removeItems(int index, int removeCount)
 {
-    if (index >= dptr()->m_dataArray->size())
+    if (index >= itemCount())
         return;
 
     dptr()->removeItems(index, removeCount);
@@ -221,11 +275,14 @@ void QScatterDataProxy::removeItems(int index, int removeCount)
  */
 int QScatterDataProxy::itemCount() const
 {
-    return dptrc()->m_dataArray->size();
+    return dptrc()->itemCount();
 }
 
 /*!
- * Returns the pointer to the data array.
+ * Returns the pointer to the data array. The array is empty while the data is
+ * borrowed.
+ *
+ * \sa borrowArray()
  */
 const QScatterDataArray *QScatterDataProxy::array() const
 {
@@ -235,10 +292,19 @@ const QScatterDataArray *QScatterDataProxy::array() const
 /*!
  * Returns the pointer to the item at the index \a index. It is guaranteed to be
  * valid only until the next call that modifies data.
+ *
+ * If the data is borrowed, the item is a copy that is valid only until the next
+ * call to this method.
  */
 const QScatterDataItem *QScatterDataProxy::itemAt(int index) const
 {
-    return &dptrc()->m_dataArray->at(index);
+    const QScatterDataProxyPrivate *d = dptrc();
+    if (d->isBorrowed()) {
+        d->m_borrowedItem.setPosition(d->itemPosition(index));
+        d->m_borrowedItem.setRotation(d->itemRotation(index));
+        return &d->m_borrowedItem;
+    }
+    return &d->m_dataArray->at(index);
 }
 
 /*!
@@ -306,18 +372,26 @@ const QScatterDataProxyPrivate *QScatterDataProxy::dptrc() const
 
 QScatterDataProxyPrivate::QScatterDataProxyPrivate(QScatterDataProxy *q)
     : QAbstractDataProxyPrivate(q, QAbstractDataProxy::DataTypeScatter),
-      m_dataArray(new QScatterDataArray)
+      m_dataArray(new QScatterDataArray),
+      m_borrowedPositions(0),
+      m_borrowedRotations(0),
+      m_borrowedPositionStride(0),
+      m_borrowedRotationStride(0),
+      m_borrowedCount(0)
 {
 }
 
 QScatterDataProxyPrivate::~QScatterDataProxyPrivate()
 {
+    releaseBorrowedArray();
     m_dataArray->clear();
     delete m_dataArray;
 }
 
 void QScatterDataProxyPrivate::resetArray(QScatterDataArray *newArray)
 {
+    releaseBorrowedArray();
+
     if (!newArray)
         newArray = new QScatterDataArray;
 
@@ -328,14 +402,66 @@ void QScatterDataProxyPrivate::resetArray(QScatterDataArray *newArray)
     }
 }
 
+void QScatterDataProxyPrivate::borrowArray(const float *positions, int count,
+                                           qsizetype positionStride, const float *rotations,
+                                           qsizetype rotationStride,
+                                           std::function<void()> releaseFunction)
+{
+    releaseBorrowedArray();
+    m_dataArray->clear();
+
+    if (!positions || count <= 0) {
+        // Nothing to borrow, so release the buffers right away
+        if (releaseFunction)
+            releaseFunction();
+        return;
+    }
+
+    m_borrowedPositions = positions;
+    m_borrowedRotations = rotations;
+    m_borrowedPositionStride = positionStride ? positionStride : 3 * qsizetype(sizeof(float));
+    m_borrowedRotationStride = rotationStride ? rotationStride : 4 * qsizetype(sizeof(float));
+    m_borrowedCount = count;
+    m_releaseFunction = releaseFunction;
+}
+
+void QScatterDataProxyPrivate::releaseBorrowedArray()
+{
+    if (!isBorrowed())
+        return;
+
+    m_borrowedPositions = 0;
+    m_borrowedRotations = 0;
+    m_borrowedCount = 0;
+    std::function<void()> releaseFunction = m_releaseFunction;
+    m_releaseFunction = std::function<void()>();
+    if (releaseFunction)
+        releaseFunction();
+}
+
+void QScatterDataProxyPrivate::copyBorrowedArray()
+{
+    if (!isBorrowed())
+        return;
+
+    QScatterDataArray *newArray = new QScatterDataArray(m_borrowedCount);
+    for (int i = 0; i < m_borrowedCount; i++) {
+        (*newArray)[i].setPosition(itemPosition(i));
+        (*newArray)[i].setRotation(itemRotation(i));
+    }
+    resetArray(newArray);
+}
+
 void QScatterDataProxyPrivate::setItem(int index, const QScatterDataItem &item)
 {
+    copyBorrowedArray();
     Q_ASSERT(index >= 0 && index < m_dataArray->size());
     (*m_dataArray)[index] = item;
 }
 
 void QScatterDataProxyPrivate::setItems(int index, const QScatterDataArray &items)
 {
+    copyBorrowedArray();
     Q_ASSERT(index >= 0 && (index + items.size()) <= m_dataArray->size());
     for (int i = 0; i < items.size(); i++)
         (*m_dataArray)[index++] = items[i];
@@ -343,6 +469,7 @@ void QScatterDataProxyPrivate::setItems(int index, const QScatterDataArray &item
 
 int QScatterDataProxyPrivate::addItem(const QScatterDataItem &item)
 {
+    copyBorrowedArray();
     int currentSize = m_dataArray->size();
     m_dataArray->append(item);
     return currentSize;
@@ -350,6 +477,7 @@ int QScatterDataProxyPrivate::addItem(const QScatterDataItem &item)
 
 int QScatterDataProxyPrivate::addItems(const QScatterDataArray &items)
 {
+    copyBorrowedArray();
     int currentSize = m_dataArray->size();
     (*m_dataArray) += items;
     return currentSize;
@@ -357,12 +485,14 @@ int QScatterDataProxyPrivate::addItems(const QScatterDataArray &items)
 
 void QScatterDataProxyPrivate::insertItem(int index, const QScatterDataItem &item)
 {
+    copyBorrowedArray();
     Q_ASSERT(index >= 0 && index <= m_dataArray->size());
     m_dataArray->insert(index, item);
 }
 
 void QScatterDataProxyPrivate::insertItems(int index, const QScatterDataArray &items)
 {
+    copyBorrowedArray();
     Q_ASSERT(index >= 0 && index <= m_dataArray->size());
     for (int i = 0; i < items.size(); i++)
         m_dataArray->insert(index++, items.at(i));
@@ -370,6 +500,7 @@ void QScatterDataProxyPrivate::insertItems(int index, const QScatterDataArray &i
 
 void QScatterDataProxyPrivate::removeItems(int index, int removeCount)
 {
+    copyBorrowedArray();
     Q_ASSERT(index >= 0);
     int maxRemoveCount = m_dataArray->size() - index;
     removeCount = qMin(removeCount, maxRemoveCount);
@@ -380,63 +511,48 @@ void QScatterDataProxyPrivate::limitValues(QVector3D &minValues, QVector3D &maxV
                                            QAbstract3DAxis *axisX, QAbstract3DAxis *axisY,
                                            QAbstract3DAxis *axisZ) const
 {
-    if (m_dataArray->isEmpty())
+    const int count = itemCount();
+    if (!count)
         return;
 
-    const QVector3D &firstPos = m_dataArray->at(0).position();
-
-    float minX = firstPos.x();
-    float maxX = minX;
-    float minY = firstPos.y();
-    float maxY = minY;
-    float minZ = firstPos.z();
-    float maxZ = minZ;
-
-    if (m_dataArray->size() > 1) {
-        for (int i = 1; i < m_dataArray->size(); i++) {
-            const QVector3D &pos = m_dataArray->at(i).position();
-
-            float value = pos.x();
-            if (qIsNaN(value) || qIsInf(value))
-                continue;
-            if (isValidValue(minX, value, axisX))
-                minX = value;
-            if (maxX < value)
-                maxX = value;
-
-            value = pos.y();
-            if (qIsNaN(value) || qIsInf(value))
-                continue;
-            if (isValidValue(minY, value, axisY))
-                minY = value;
-            if (maxY < value)
-                maxY = value;
-
-            value = pos.z();
-            if (qIsNaN(value) || qIsInf(value))
-                continue;
-            if (isValidValue(minZ, value, axisZ))
-                minZ = value;
-            if (maxZ < value)
-                maxZ = value;
+    ValueLimits limitsX;
+    ValueLimits limitsY;
+    ValueLimits limitsZ;
+    float blockX[ValueLimits::blockSize];
+    float blockY[ValueLimits::blockSize];
+    float blockZ[ValueLimits::blockSize];
+    for (int i = 0; i < count; i += ValueLimits::blockSize) {
+        const int blockCount = qMin(int(ValueLimits::blockSize), count - i);
+        for (int j = 0; j < blockCount; j++) {
+            const QVector3D pos = itemPosition(i + j);
+            blockX[j] = pos.x();
+            blockY[j] = pos.y();
+            blockZ[j] = pos.z();
         }
+        limitsX.add(blockX, blockCount);
+        limitsY.add(blockY, blockCount);
+        limitsZ.add(blockZ, blockCount);
     }
 
-    minValues.setX(minX);
-    minValues.setY(minY);
-    minValues.setZ(minZ);
+    // Fall back to the first item if there are no valid values
+    const QVector3D firstPos = itemPosition(0);
+    minValues.setX(limitValue(limitsX, axisX, firstPos.x(), true));
+    minValues.setY(limitValue(limitsY, axisY, firstPos.y(), true));
+    minValues.setZ(limitValue(limitsZ, axisZ, firstPos.z(), true));
 
-    maxValues.setX(maxX);
-    maxValues.setY(maxY);
-    maxValues.setZ(maxZ);
+    maxValues.setX(limitValue(limitsX, axisX, firstPos.x(), false));
+    maxValues.setY(limitValue(limitsY, axisY, firstPos.y(), false));
+    maxValues.setZ(limitValue(limitsZ, axisZ, firstPos.z(), false));
 }
 
-bool QScatterDataProxyPrivate::isValidValue(float axisValue, float value,
-                                            QAbstract3DAxis *axis) const
+float QScatterDataProxyPrivate::limitValue(const ValueLimits &limits, QAbstract3DAxis *axis,
+                                           float defaultValue, bool minimum) const
 {
-    return (axisValue > value && (value > 0.0f
-                                  || (value == 0.0f && axis->d_ptr->allowZero())
-                                  || (value < 0.0f && axis->d_ptr->allowNegatives())));
+    if (minimum) {
+        float value = limits.validMin(axis->d_ptr->allowZero(), axis->d_ptr->allowNegatives());
+        return qIsInf(value) ? defaultValue : value;
+    }
+    return limits.isEmpty() ? defaultValue : limits.max;
 }
 
 void QScatterDataProxyPrivate::setSeries(QAbstract3DSeries *series)
@@ -32,6 +32,7 @@
 
 #include <QtDataVisualization/qabstractdataproxy.h>
 #include <QtDataVisualization/qscatterdataitem.h>
+#include <functional>
 
 Q_MOC_INCLUDE(<QtDataVisualization/qscatter3dseries.h>)
 
@@ -59,6 +60,10 @@ public:
     const QScatterDataItem *itemAt(int index) const;
 
     void resetArray(QScatterDataArray *newArray);
+    void borrowArray(const float *positions, int count, qsizetype positionStride = 0,
+                     const float *rotations = nullptr, qsizetype rotationStride = 0,
+                     std::function<void()> releaseFunction = std::function<void()>());
+    bool isArrayBorrowed() const;
 
     void setItem(int index, const QScatterDataItem &item);
     void setItems(int index, const QScatterDataArray &items);
@@ -90,6 +95,8 @@ private:
     Q_DISABLE_COPY(QScatterDataProxy)
 
     friend class Scatter3DController;
+    friend class Scatter3DRenderer;
+    friend class QScatter3DSeriesPrivate;
 };
 
 QT_END_NAMESPACE
@@ -42,6 +42,7 @@
 
 #include "qscatterdataproxy.h"
 #include "qabstractdataproxy_p.h"
+#include "valuelimits_p.h"
 #include "qscatterdataitem.h"
 
 QT_BEGIN_NAMESPACE
@@ -56,6 +57,36 @@ public:
     virtual ~QScatterDataProxyPrivate();
 
     void resetArray(QScatterDataArray *newArray);
+    void borrowArray(const float *positions, int count, qsizetype positionStride,
+                     const float *rotations, qsizetype rotationStride,
+                     std::function<void()> releaseFunction);
+    void releaseBorrowedArray();
+    void copyBorrowedArray();
+    inline bool isBorrowed() const { return m_borrowedPositions; }
+    inline int itemCount() const
+    {
+        return isBorrowed() ? m_borrowedCount : m_dataArray->size();
+    }
+    inline QVector3D itemPosition(int index) const
+    {
+        if (!isBorrowed())
+            return m_dataArray->at(index).position();
+        const float *position = reinterpret_cast<const float *>(
+                    reinterpret_cast<const char *>(m_borrowedPositions)
+                    + index * m_borrowedPositionStride);
+        return QVector3D(position[0], position[1], position[2]);
+    }
+    inline QQuaternion itemRotation(int index) const
+    {
+        if (!isBorrowed())
+            return m_dataArray->at(index).rotation();
+        if (!m_borrowedRotations)
+            return QQuaternion();
+        const float *rotation = reinterpret_cast<const float *>(
+                    reinterpret_cast<const char *>(m_borrowedRotations)
+                    + index * m_borrowedRotationStride);
+        return QQuaternion(rotation[0], rotation[1], rotation[2], rotation[3]);
+    }
     void setItem(int index, const QScatterDataItem &item);
     void setItems(int index, const QScatterDataArray &items);
     int addItem(const QScatterDataItem &item);
@@ -65,13 +96,23 @@ public:
     void removeItems(int index, int removeCount);
     void limitValues(QVector3D &minValues, QVector3D &maxValues, QAbstract3DAxis *axisX,
                      QAbstract3DAxis *axisY, QAbstract3DAxis *axisZ) const;
-    bool isValidValue(float axisValue, float value, QAbstract3DAxis *axis) const;
+    float limitValue(const ValueLimits &limits, QAbstract3DAxis *axis, float defaultValue,
+                     bool minimum) const;
 
     void setSeries(QAbstract3DSeries *series) override;
 private:
     QScatterDataProxy *qptr();
     QScatterDataArray *m_dataArray;
 
+    // Externally owned data, read directly instead of m_dataArray when set
+    const float *m_borrowedPositions;
+    const float *m_borrowedRotations;
+    qsizetype m_borrowedPositionStride;
+    qsizetype m_borrowedRotationStride;
+    int m_borrowedCount;
+    std::function<void()> m_releaseFunction;
+    mutable QScatterDataItem m_borrowedItem; // Returned by itemAt() for borrowed data
+
     friend class QScatterDataProxy;
 };
 
@@ -172,6 +172,21 @@ QT_BEGIN_NAMESPACE
  * The color used to draw the gridlines of the surface wireframe.
  */
 
+/*!
+ * \qmlproperty bool Surface3DSeries::levelOfDetailEnabled
+ * \since 6.4
+ *
+ * Whether the surface is drawn with a reduced level of detail when it covers
+ * only a small area of the screen. Preset to \c false by default.
+ *
+ * When enabled, the graph generates progressively decimated versions of the
+ * surface, where each level has half the rows and columns of the previous one.
+ * The local minimum or maximum of each decimated area is kept, so peaks and
+ * valleys remain visible. The level drawn is chosen from the projected size of
+ * the surface on the screen, so rotating and zooming large height fields stays
+ * interactive. Selection and slicing always use the full resolution data.
+ */
+
 /*!
  * \enum QSurface3DSeries::DrawFlag
  *
@@ -422,6 +437,35 @@ QColor QSurface3DSeries::wireframeColor() const
 {
     return dptrc()->m_wireframeColor;
 }
+
+/*!
+ * \property QSurface3DSeries::levelOfDetailEnabled
+ * \since 6.4
+ *
+ * \brief Whether the surface is drawn with a reduced level of detail when it
+ * covers only a small area of the screen.
+ *
+ * Preset to \c false by default.
+ *
+ * When enabled, the graph generates progressively decimated versions of the
+ * surface, where each level has half the rows and columns of the previous one.
+ * The local minimum or maximum of each decimated area is kept, so peaks and
+ * valleys remain visible. The level drawn is chosen from the projected size of
+ * the surface on the screen, so rotating and zooming large height fields stays
+ * interactive. Selection and slicing always use the full resolution data.
+ */
+void QSurface3DSeries::setLevelOfDetailEnabled(bool enabled)
+{
+    if (dptr()->m_levelOfDetailEnabled != enabled) {
+        dptr()->setLevelOfDetailEnabled(enabled);
+        emit levelOfDetailEnabledChanged(enabled);
+    }
+}
+
+bool QSurface3DSeries::isLevelOfDetailEnabled() const
+{
+    return dptrc()->m_levelOfDetailEnabled;
+}
 /*!
  * \internal
  */
@@ -445,7 +489,8 @@ QSurface3DSeriesPrivate::QSurface3DSeriesPrivate(QSurface3DSeries *q)
       m_selectedPoint(Surface3DController::invalidSelectionPosition()),
       m_flatShadingEnabled(true),
       m_drawMode(QSurface3DSeries::DrawSurfaceAndWireframe),
-      m_wireframeColor(Qt::black)
+      m_wireframeColor(Qt::black),
+      m_levelOfDetailEnabled(false)
 {
     m_itemLabelFormat = QStringLiteral("@xLabel, @yLabel, @zLabel");
     m_mesh = QAbstract3DSeries::MeshSphere;
@@ -494,6 +539,8 @@ void QSurface3DSeriesPrivate::connectControllerAndProxy(Abstract3DController *ne
                          &Surface3DController::handleRowsInserted);
         QObject::connect(surfaceDataProxy, &QSurfaceDataProxy::itemChanged, controller,
                          &Surface3DController::handleItemChanged);
+        QObject::connect(surfaceDataProxy, &QSurfaceDataProxy::rowsScrolled, controller,
+                         &Surface3DController::handleRowsScrolled);
         QObject::connect(qptr(), &QSurface3DSeries::dataProxyChanged, controller,
                          &Surface3DController::handleArrayReset);
     }
@@ -585,4 +632,11 @@ void QSurface3DSeriesPrivate::setWireframeColor(const QColor &color)
         m_controller->markSeriesVisualsDirty();
 }
 
+void QSurface3DSeriesPrivate::setLevelOfDetailEnabled(bool enabled)
+{
+    m_levelOfDetailEnabled = enabled;
+    if (m_controller)
+        m_controller->markSeriesVisualsDirty();
+}
+
 QT_END_NAMESPACE
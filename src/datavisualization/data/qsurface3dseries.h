@@ -49,6 +49,7 @@ class Q_DATAVISUALIZATION_EXPORT QSurface3DSeries : public QAbstract3DSeries
     Q_PROPERTY(QImage texture READ texture WRITE setTexture NOTIFY textureChanged)
     Q_PROPERTY(QString textureFile READ textureFile WRITE setTextureFile NOTIFY textureFileChanged)
     Q_PROPERTY(QColor wireframeColor READ wireframeColor WRITE setWireframeColor NOTIFY wireframeColorChanged REVISION(6, 3))
+    Q_PROPERTY(bool levelOfDetailEnabled READ isLevelOfDetailEnabled WRITE setLevelOfDetailEnabled NOTIFY levelOfDetailEnabledChanged REVISION(6, 4))
 
 public:
     enum DrawFlag {
@@ -85,6 +86,9 @@ public:
     void setWireframeColor(const QColor &color);
     QColor wireframeColor() const;
 
+    void setLevelOfDetailEnabled(bool enabled);
+    bool isLevelOfDetailEnabled() const;
+
 Q_SIGNALS:
     void dataProxyChanged(QSurfaceDataProxy *proxy);
     void selectedPointChanged(const QPoint &position);
@@ -94,6 +98,7 @@ Q_SIGNALS:
     void textureChanged(const QImage &image);
     void textureFileChanged(const QString &filename);
     Q_REVISION(6, 3) void wireframeColorChanged(const QColor &color);
+    Q_REVISION(6, 4) void levelOfDetailEnabledChanged(bool enable);
 
 protected:
     explicit QSurface3DSeries(QSurface3DSeriesPrivate *d, QObject *parent = nullptr);
@@ -61,6 +61,7 @@ public:
     void setDrawMode(QSurface3DSeries::DrawFlags mode);
     void setTexture(const QImage &texture);
     void setWireframeColor(const QColor &color);
+    void setLevelOfDetailEnabled(bool enabled);
 
 private:
     QSurface3DSeries *qptr();
@@ -71,6 +72,7 @@ private:
     QImage m_texture;
     QString m_textureFile;
     QColor m_wireframeColor;
+    bool m_levelOfDetailEnabled;
 
 private:
     friend class QSurface3DSeries;
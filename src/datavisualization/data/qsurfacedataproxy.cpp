@@ -59,6 +59,11 @@ QT_BEGIN_NAMESPACE
  * Similarly, the z-value of each successive item in all columns must be either ascending or
  * descending throughout the column.
  *
+ * Data that is arranged into a regular grid can also be given as a list of
+ * x-values for the columns, a list of z-values for the rows, and a contiguous
+ * list of y-values, see resetGrid(). This avoids allocating a separate row
+ * for each z-value and storing the x-values and z-values for every item.
+ *
  * \note Currently only surfaces with straight rows and columns are fully supported. Any row
  * with items that do not have the exact same z-value or any column with items
  * that do not have the exact same x-value may get clipped incorrectly if the
@@ -130,6 +135,7 @@ QT_BEGIN_NAMESPACE
 QSurfaceDataProxy::QSurfaceDataProxy(QObject *parent) :
     QAbstractDataProxy(new QSurfaceDataProxyPrivate(this), parent)
 {
+    dptr()->connectRowLimitsCache();
 }
 
 /*!
@@ -138,6 +144,7 @@ QSurfaceDataProxy::QSurfaceDataProxy(QObject *parent) :
 QSurfaceDataProxy::QSurfaceDataProxy(QSurfaceDataProxyPrivate *d, QObject *parent) :
     QAbstractDataProxy(d, parent)
 {
+    dptr()->connectRowLimitsCache();
 }
 
 /*!
@@ -167,7 +174,7 @@ QSurface3DSeries *QSurfaceDataProxy::series() const
  */
 void QSurfaceDataProxy::resetArray(QSurfaceDataArray *newArray)
 {
-    if (dptr()->m_dataArray != newArray) {
+    if (dptr()->m_dataArray != newArray || dptr()->isGrid()) {
         dptr()->resetArray(newArray);
     }
     emit arrayReset();
@@ -175,6 +182,46 @@ void QSurfaceDataProxy::resetArray(QSurfaceDataArray *newArray)
     emit columnCountChanged(columnCount());
 }
 
+/*!
+ * \since 6.4
+ *
+ * Replaces the existing data with a regular grid. The x-values of the columns
+ * are given in \a columnValues and the z-values of the rows in \a rowValues.
+ * The y-values of the items are given row by row in \a heights, which must
+ * contain one value for each combination of a row and a column.
+ *
+ * The lists are implicitly shared, so the data is not copied until either the
+ * application or the proxy modifies it.
+ *
+ * Adding, inserting, changing, or removing rows or items with the proxy
+ * methods first converts the grid into a QSurfaceDataArray. While the data is
+ * a grid, array() returns an empty array. Use itemAt() to access individual
+ * items.
+ *
+ * \sa isGrid(), resetArray()
+ */
+void QSurfaceDataProxy::resetGrid(const QList<float> &columnValues,
+                                  const QList<float> &rowValues,
+                                  const QList<float> &heights)
+{
+    dptr()->resetGrid(columnValues, rowValues, heights);
+    emit arrayReset();
+    emit rowCountChanged(rowCount());
+    emit columnCountChanged(columnCount());
+}
+
+/*!
+ * \since 6.4
+ *
+ * Returns \c true if the data is stored as a regular grid.
+ *
+ * \sa resetGrid()
+ */
+bool QSurfaceDataProxy::isGrid() const
+{
+    return dptrc()->isGrid();
+}
+
 /*!
  * Changes an existing row by replacing the row at the position \a rowIndex
  * with the new row specified by \a row. The new row can be the same as the
@@ -289,7 +336,40 @@ void QSurfaceDataProxy::removeRows(int rowIndex, int removeCount)
 }
 
 /*!
- * Returns the pointer to the data array.
+ * \since 6.4
+ *
+ * Scrolls the y-values of the data towards the first row, as in a waterfall
+ * display. The first rows are discarded, and \a heights become the y-values of
+ * the last rows. The list contains the new values row by row, and its size must
+ * be a multiple of the column count. The x- and z-values of the items do not
+ * change, so the row count stays the same and each row keeps its place on the
+ * graph.
+ *
+ * Graphs update only the scrolled values instead of reloading the whole
+ * surface. With grid data set by resetGrid(), the cost of the call is on
+ * average proportional to the size of \a heights, as the heights of the
+ * discarded rows are released from the beginning of the list without moving
+ * the rest. With a data array, the array and its rows stay in place and the
+ * y-values of all items are moved, so the cost is proportional to the size of
+ * the data.
+ *
+ * Returns the number of rows scrolled.
+ *
+ * \sa rowsScrolled(), resetGrid(), array()
+ */
+int QSurfaceDataProxy::scrollRows(const QList<float> &heights)
+{
+    int count = dptr()->scrollRows(heights);
+    if (count)
+        emit rowsScrolled(count);
+    return count;
+}
+
+/*!
+ * Returns the pointer to the data array. The array is empty while the data is
+ * stored as a grid.
+ *
+ * \sa resetGrid()
  */
 const QSurfaceDataArray *QSurfaceDataProxy::array() const
 {
@@ -300,10 +380,21 @@ const QSurfaceDataArray *QSurfaceDataProxy::array() const
  * Returns the pointer to the item at the position specified by \a rowIndex and
  * \a columnIndex. It is guaranteed to be valid only
  * until the next call that modifies data.
+ *
+ * If the data is stored as a grid, the item is a copy that is valid only until
+ * the next call to this method.
  */
 const QSurfaceDataItem *QSurfaceDataProxy::itemAt(int rowIndex, int columnIndex) const
 {
-    const QSurfaceDataArray &dataArray = *dptrc()->m_dataArray;
+    const QSurfaceDataProxyPrivate *d = dptrc();
+    if (d->isGrid()) {
+        Q_ASSERT(rowIndex >= 0 && rowIndex < d->m_dataGrid.rowCount());
+        Q_ASSERT(columnIndex >= 0 && columnIndex < d->m_dataGrid.columnCount());
+        d->m_gridItem.setPosition(d->m_dataGrid.position(rowIndex, columnIndex));
+        return &d->m_gridItem;
+    }
+
+    const QSurfaceDataArray &dataArray = *d->m_dataArray;
     Q_ASSERT(rowIndex >= 0 && rowIndex < dataArray.size());
     const QSurfaceDataRow &dataRow = *dataArray[rowIndex];
     Q_ASSERT(columnIndex >= 0 && columnIndex < dataRow.size());
@@ -327,7 +418,7 @@ const QSurfaceDataItem *QSurfaceDataProxy::itemAt(const QPoint &position) const
  */
 int QSurfaceDataProxy::rowCount() const
 {
-    return dptrc()->m_dataArray->size();
+    return dptrc()->dataView().rowCount();
 }
 
 /*!
@@ -337,10 +428,7 @@ int QSurfaceDataProxy::rowCount() const
  */
 int QSurfaceDataProxy::columnCount() const
 {
-    if (dptrc()->m_dataArray->size() > 0)
-        return dptrc()->m_dataArray->at(0)->size();
-    else
-        return 0;
+    return dptrc()->dataView().columnCount();
 }
 
 /*!
@@ -415,11 +503,20 @@ const QSurfaceDataProxyPrivate *QSurfaceDataProxy::dptrc() const
  * this signal needs to be emitted to update the graph.
  */
 
+/*!
+ * \fn void QSurfaceDataProxy::rowsScrolled(int count)
+ * \since 6.4
+ *
+ * This signal is emitted when scrollRows() scrolls the y-values of the data
+ * by \a count rows.
+ */
+
 //  QSurfaceDataProxyPrivate
 
 QSurfaceDataProxyPrivate::QSurfaceDataProxyPrivate(QSurfaceDataProxy *q)
     : QAbstractDataProxyPrivate(q, QAbstractDataProxy::DataTypeSurface),
-      m_dataArray(new QSurfaceDataArray)
+      m_dataArray(new QSurfaceDataArray),
+      m_scrolledRowCount(0)
 {
 }
 
@@ -430,6 +527,8 @@ QSurfaceDataProxyPrivate::~QSurfaceDataProxyPrivate()
 
 void QSurfaceDataProxyPrivate::resetArray(QSurfaceDataArray *newArray)
 {
+    m_dataGrid = SurfaceDataGrid();
+
     if (!newArray)
         newArray = new QSurfaceDataArray;
 
@@ -439,8 +538,43 @@ void QSurfaceDataProxyPrivate::resetArray(QSurfaceDataArray *newArray)
     }
 }
 
+void QSurfaceDataProxyPrivate::resetGrid(const QList<float> &columnValues,
+                                         const QList<float> &rowValues,
+                                         const QList<float> &heights)
+{
+    Q_ASSERT(heights.size() == columnValues.size() * rowValues.size());
+
+    resetArray(0);
+
+    if (!columnValues.isEmpty() && !rowValues.isEmpty()
+            && heights.size() == columnValues.size() * rowValues.size()) {
+        m_dataGrid.columnValues = columnValues;
+        m_dataGrid.rowValues = rowValues;
+        m_dataGrid.heights = heights;
+    }
+}
+
+void QSurfaceDataProxyPrivate::convertGridToArray()
+{
+    if (!isGrid())
+        return;
+
+    const int rows = m_dataGrid.rowCount();
+    const int columns = m_dataGrid.columnCount();
+    QSurfaceDataArray *newArray = new QSurfaceDataArray;
+    newArray->reserve(rows);
+    for (int i = 0; i < rows; i++) {
+        QSurfaceDataRow *newRow = new QSurfaceDataRow(columns);
+        for (int j = 0; j < columns; j++)
+            (*newRow)[j].setPosition(m_dataGrid.position(i, j));
+        newArray->append(newRow);
+    }
+    resetArray(newArray);
+}
+
 void QSurfaceDataProxyPrivate::setRow(int rowIndex, QSurfaceDataRow *row)
 {
+    convertGridToArray();
     Q_ASSERT(rowIndex >= 0 && rowIndex < m_dataArray->size());
     Q_ASSERT(m_dataArray->at(rowIndex)->size() == row->size());
 
@@ -452,6 +586,7 @@ void QSurfaceDataProxyPrivate::setRow(int rowIndex, QSurfaceDataRow *row)
 
 void QSurfaceDataProxyPrivate::setRows(int rowIndex, const QSurfaceDataArray &rows)
 {
+    convertGridToArray();
     QSurfaceDataArray &dataArray = *m_dataArray;
     Q_ASSERT(rowIndex >= 0 && (rowIndex + rows.size()) <= dataArray.size());
 
@@ -467,6 +602,7 @@ void QSurfaceDataProxyPrivate::setRows(int rowIndex, const QSurfaceDataArray &ro
 
 void QSurfaceDataProxyPrivate::setItem(int rowIndex, int columnIndex, const QSurfaceDataItem &item)
 {
+    convertGridToArray();
     Q_ASSERT(rowIndex >= 0 && rowIndex < m_dataArray->size());
     QSurfaceDataRow &row = *(*m_dataArray)[rowIndex];
     Q_ASSERT(columnIndex < row.size());
@@ -475,6 +611,7 @@ void QSurfaceDataProxyPrivate::setItem(int rowIndex, int columnIndex, const QSur
 
 int QSurfaceDataProxyPrivate::addRow(QSurfaceDataRow *row)
 {
+    convertGridToArray();
     Q_ASSERT(m_dataArray->isEmpty()
              || m_dataArray->at(0)->size() == row->size());
     int currentSize = m_dataArray->size();
@@ -484,6 +621,7 @@ int QSurfaceDataProxyPrivate::addRow(QSurfaceDataRow *row)
 
 int QSurfaceDataProxyPrivate::addRows(const QSurfaceDataArray &rows)
 {
+    convertGridToArray();
     int currentSize = m_dataArray->size();
     for (int i = 0; i < rows.size(); i++) {
         Q_ASSERT(m_dataArray->isEmpty()
@@ -495,6 +633,7 @@ int QSurfaceDataProxyPrivate::addRows(const QSurfaceDataArray &rows)
 
 void QSurfaceDataProxyPrivate::insertRow(int rowIndex, QSurfaceDataRow *row)
 {
+    convertGridToArray();
     Q_ASSERT(rowIndex >= 0 && rowIndex <= m_dataArray->size());
     Q_ASSERT(m_dataArray->isEmpty()
              || m_dataArray->at(0)->size() == row->size());
@@ -503,6 +642,7 @@ void QSurfaceDataProxyPrivate::insertRow(int rowIndex, QSurfaceDataRow *row)
 
 void QSurfaceDataProxyPrivate::insertRows(int rowIndex, const QSurfaceDataArray &rows)
 {
+    convertGridToArray();
     Q_ASSERT(rowIndex >= 0 && rowIndex <= m_dataArray->size());
 
     for (int i = 0; i < rows.size(); i++) {
@@ -512,8 +652,44 @@ void QSurfaceDataProxyPrivate::insertRows(int rowIndex, const QSurfaceDataArray
     }
 }
 
+int QSurfaceDataProxyPrivate::scrollRows(const QList<float> &heights)
+{
+    const SurfaceDataView data = dataView();
+    const int rows = data.rowCount();
+    const int columns = data.columnCount();
+    Q_ASSERT(!columns || heights.size() % columns == 0);
+    if (!rows || !columns || heights.size() < columns)
+        return 0;
+
+    // Only the last rows of heights remain visible if it holds more rows than the data
+    const int count = qMin(int(heights.size() / columns), rows);
+    const float *newHeights = heights.constData() + heights.size() - count * columns;
+    if (isGrid()) {
+        // Removing from the beginning of a list only moves its start
+        QList<float> &gridHeights = m_dataGrid.heights;
+        gridHeights.remove(0, count * columns);
+        gridHeights.append(QList<float>(newHeights, newHeights + count * columns));
+    } else {
+        QSurfaceDataArray &dataArray = *m_dataArray;
+        for (int i = 0; i < rows; i++) {
+            QSurfaceDataRow &row = *dataArray[i];
+            if (i < rows - count) {
+                const QSurfaceDataRow &sourceRow = *dataArray.at(i + count);
+                for (int j = 0; j < columns; j++)
+                    row[j].setY(sourceRow.at(j).y());
+            } else {
+                for (int j = 0; j < columns; j++)
+                    row[j].setY(*newHeights++);
+            }
+        }
+    }
+    m_scrolledRowCount += count;
+    return count;
+}
+
 void QSurfaceDataProxyPrivate::removeRows(int rowIndex, int removeCount)
 {
+    convertGridToArray();
     Q_ASSERT(rowIndex >= 0);
     int maxRemoveCount = m_dataArray->size() - rowIndex;
     removeCount = qMin(removeCount, maxRemoveCount);
@@ -523,6 +699,36 @@ void QSurfaceDataProxyPrivate::removeRows(int rowIndex, int removeCount)
     }
 }
 
+void QSurfaceDataProxyPrivate::connectRowLimitsCache()
+{
+    // The signals are also emitted when the application modifies the rows directly.
+    // These connections are made before any graph connects to the proxy, so the cache
+    // is up to date when the graph adjusts its axis ranges.
+    QSurfaceDataProxy *q = qptr();
+    QObject::connect(q, &QSurfaceDataProxy::arrayReset, this, [this]() {
+        m_rowLimits.clear();
+    });
+    QObject::connect(q, &QSurfaceDataProxy::rowsAdded, this, [this](int startIndex, int count) {
+        m_rowLimits.insertRows(startIndex, count);
+    });
+    QObject::connect(q, &QSurfaceDataProxy::rowsInserted, this, [this](int startIndex, int count) {
+        m_rowLimits.insertRows(startIndex, count);
+    });
+    QObject::connect(q, &QSurfaceDataProxy::rowsRemoved, this, [this](int startIndex, int count) {
+        m_rowLimits.removeRows(startIndex, count);
+    });
+    QObject::connect(q, &QSurfaceDataProxy::rowsChanged, this, [this](int startIndex, int count) {
+        m_rowLimits.markDirty(startIndex, count);
+    });
+    QObject::connect(q, &QSurfaceDataProxy::itemChanged, this, [this](int rowIndex, int) {
+        m_rowLimits.markDirty(rowIndex, 1);
+    });
+    QObject::connect(q, &QSurfaceDataProxy::rowsScrolled, this, [this, q](int count) {
+        m_rowLimits.removeRows(0, count);
+        m_rowLimits.insertRows(q->rowCount() - count, count);
+    });
+}
+
 QSurfaceDataProxy *QSurfaceDataProxyPrivate::qptr()
 {
     return static_cast<QSurfaceDataProxy *>(q_ptr);
@@ -532,38 +738,45 @@ void QSurfaceDataProxyPrivate::limitValues(QVector3D &minValues, QVector3D &maxV
                                            QAbstract3DAxis *axisX, QAbstract3DAxis *axisY,
                                            QAbstract3DAxis *axisZ) const
 {
-    float min = 0.0f;
-    float max = 0.0f;
-
-    int rows = m_dataArray->size();
-    int columns = 0;
-    if (rows)
-        columns = m_dataArray->at(0)->size();
-
-    if (rows && columns) {
-        min = m_dataArray->at(0)->at(0).y();
-        max = m_dataArray->at(0)->at(0).y();
-    }
+    const SurfaceDataView data = dataView();
+    const int rows = data.rowCount();
+    const int columns = data.columnCount();
 
+    // Only the rows changed since the previous call are scanned
+    m_rowLimits.resize(rows);
+    ValueLimits limits;
     for (int i = 0; i < rows; i++) {
-        QSurfaceDataRow *row = m_dataArray->at(i);
-        if (row) {
-            for (int j = 0; j < columns; j++) {
-                float itemValue = m_dataArray->at(i)->at(j).y();
-                if (qIsNaN(itemValue) || qIsInf(itemValue))
-                    continue;
-                if ((min > itemValue || (qIsNaN(min) || qIsInf(min)))
-                        && isValidValue(itemValue, axisY)) {
-                    min = itemValue;
-                }
-                if (max < itemValue  || (qIsNaN(max) || qIsInf(max)))
-                    max = itemValue;
+        if (m_rowLimits.isDirty(i)) {
+            ValueLimits rowLimits;
+            if (isGrid()) {
+                rowLimits.add(m_dataGrid.heights.constData() + i * columns, columns);
+            } else if (const QSurfaceDataRow *row = m_dataArray->at(i)) {
+                rowLimits.addGathered(columns, [row](qsizetype j) { return row->at(j).y(); });
             }
+            m_rowLimits.setLimits(i, rowLimits);
         }
+        limits.add(m_rowLimits.limits(i));
     }
 
+    // Fall back to the first item if there are no valid values
+    const float firstValue = (rows && columns) ? data.position(0, 0).y() : 0.0f;
+    float min = limits.validMin(axisY->d_ptr->allowZero(), axisY->d_ptr->allowNegatives());
+    if (qIsInf(min))
+        min = firstValue;
     minValues.setY(min);
-    maxValues.setY(max);
+    maxValues.setY(limits.isEmpty() ? firstValue : limits.max);
+
+    if (isGrid()) {
+        float low;
+        float high;
+        limitGridValues(m_dataGrid.columnValues, axisX, low, high);
+        minValues.setX(low);
+        maxValues.setX(high);
+        limitGridValues(m_dataGrid.rowValues, axisZ, low, high);
+        minValues.setZ(low);
+        maxValues.setZ(high);
+        return;
+    }
 
     if (columns) {
         // Have some defaults
@@ -637,6 +850,32 @@ void QSurfaceDataProxyPrivate::limitValues(QVector3D &minValues, QVector3D &maxV
     }
 }
 
+void QSurfaceDataProxyPrivate::limitGridValues(const QList<float> &values, QAbstract3DAxis *axis,
+                                               float &low, float &high) const
+{
+    // Grid rows and columns share a single value, so only the first and the last valid
+    // values need to be searched, like for the data array.
+    low = values.first();
+    high = values.last();
+    for (float value : values) {
+        if (qIsNaN(value) || qIsInf(value))
+            continue;
+        else if (isValidValue(value, axis))
+            low = qMin(low, value);
+        if (!qIsNaN(low) && !qIsInf(low))
+            break;
+    }
+    for (int i = values.size() - 1; i >= 0; i--) {
+        float value = values.at(i);
+        if (qIsNaN(value) || qIsInf(value))
+            continue;
+        else if (isValidValue(value, axis))
+            high = (!qIsNaN(high) && !qIsInf(high)) ? qMax(high, value) : value;
+        if (!qIsNaN(high) && !qIsInf(high))
+            break;
+    }
+}
+
 bool QSurfaceDataProxyPrivate::isValidValue(float value, QAbstract3DAxis *axis) const
 {
     return (value > 0.0f || (value == 0.0f && axis->d_ptr->allowZero())
@@ -659,6 +898,25 @@ void QSurfaceDataProxyPrivate::clearArray()
     delete m_dataArray;
 }
 
+SurfaceDataGrid SurfaceDataGrid::subGrid(const QRect &rect) const
+{
+    const int columns = columnCount();
+    if (rect == QRect(0, 0, columns, rowCount()))
+        return *this;
+
+    SurfaceDataGrid grid;
+    grid.columnValues = columnValues.mid(rect.x(), rect.width());
+    grid.rowValues = rowValues.mid(rect.y(), rect.height());
+    grid.heights.resize(rect.width() * rect.height());
+    float *dst = grid.heights.data();
+    for (int i = rect.top(); i <= rect.bottom(); i++) {
+        const float *src = heights.constData() + i * columns + rect.x();
+        std::copy(src, src + rect.width(), dst);
+        dst += rect.width();
+    }
+    return grid;
+}
+
 void QSurfaceDataProxyPrivate::setSeries(QAbstract3DSeries *series)
 {
     QAbstractDataProxyPrivate::setSeries(series);
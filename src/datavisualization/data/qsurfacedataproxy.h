@@ -63,6 +63,9 @@ public:
     const QSurfaceDataItem *itemAt(const QPoint &position) const;
 
     void resetArray(QSurfaceDataArray *newArray);
+    void resetGrid(const QList<float> &columnValues, const QList<float> &rowValues,
+                   const QList<float> &heights);
+    bool isGrid() const;
 
     void setRow(int rowIndex, QSurfaceDataRow *row);
     void setRows(int rowIndex, const QSurfaceDataArray &rows);
@@ -78,6 +81,8 @@ public:
 
     void removeRows(int rowIndex, int removeCount);
 
+    int scrollRows(const QList<float> &heights);
+
 Q_SIGNALS:
     void arrayReset();
     void rowsAdded(int startIndex, int count);
@@ -85,6 +90,7 @@ Q_SIGNALS:
     void rowsRemoved(int startIndex, int count);
     void rowsInserted(int startIndex, int count);
     void itemChanged(int rowIndex, int columnIndex);
+    Q_REVISION(6, 4) void rowsScrolled(int count);
 
     void rowCountChanged(int count);
     void columnCountChanged(int count);
@@ -99,6 +105,7 @@ private:
     Q_DISABLE_COPY(QSurfaceDataProxy)
 
     friend class Surface3DController;
+    friend class Surface3DRenderer;
 };
 
 QT_END_NAMESPACE
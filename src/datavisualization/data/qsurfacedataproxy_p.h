@@ -42,11 +42,60 @@
 
 #include "qsurfacedataproxy.h"
 #include "qabstractdataproxy_p.h"
+#include "valuelimits_p.h"
+
+#include <QtCore/QRect>
+#include <QtGui/QVector3D>
 
 QT_BEGIN_NAMESPACE
 
 class QAbstract3DAxis;
 
+// Regular grid data. Columns share X-values and rows share Z-values,
+// so only the Y-values are stored per item, row by row.
+struct SurfaceDataGrid
+{
+    QList<float> columnValues;
+    QList<float> rowValues;
+    QList<float> heights;
+
+    inline int rowCount() const { return int(rowValues.size()); }
+    inline int columnCount() const { return int(columnValues.size()); }
+    inline bool isEmpty() const { return heights.isEmpty(); }
+    inline QVector3D position(int row, int column) const
+    {
+        return QVector3D(columnValues.at(column), heights.at(row * columnValues.size() + column),
+                         rowValues.at(row));
+    }
+    SurfaceDataGrid subGrid(const QRect &rect) const;
+};
+
+// Read-only access to the item positions of either a data array or a grid
+class SurfaceDataView
+{
+public:
+    inline SurfaceDataView(const QSurfaceDataArray &array) : m_array(&array), m_grid(0) {}
+    inline SurfaceDataView(const SurfaceDataGrid &grid) : m_array(0), m_grid(&grid) {}
+
+    inline int rowCount() const { return m_grid ? m_grid->rowCount() : int(m_array->size()); }
+    inline int columnCount() const
+    {
+        if (m_grid)
+            return m_grid->columnCount();
+        return m_array->isEmpty() ? 0 : int(m_array->at(0)->size());
+    }
+    inline QVector3D position(int row, int column) const
+    {
+        if (m_grid)
+            return m_grid->position(row, column);
+        return m_array->at(row)->at(column).position();
+    }
+
+private:
+    const QSurfaceDataArray *m_array;
+    const SurfaceDataGrid *m_grid;
+};
+
 class QSurfaceDataProxyPrivate : public QAbstractDataProxyPrivate
 {
     Q_OBJECT
@@ -55,6 +104,8 @@ public:
     virtual ~QSurfaceDataProxyPrivate();
 
     void resetArray(QSurfaceDataArray *newArray);
+    void resetGrid(const QList<float> &columnValues, const QList<float> &rowValues,
+                   const QList<float> &heights);
     void setRow(int rowIndex, QSurfaceDataRow *row);
     void setRows(int rowIndex, const QSurfaceDataArray &rows);
     void setItem(int rowIndex, int columnIndex, const QSurfaceDataItem &item);
@@ -63,19 +114,39 @@ public:
     void insertRow(int rowIndex, QSurfaceDataRow *row);
     void insertRows(int rowIndex, const QSurfaceDataArray &rows);
     void removeRows(int rowIndex, int removeCount);
+    int scrollRows(const QList<float> &heights);
     void limitValues(QVector3D &minValues, QVector3D &maxValues, QAbstract3DAxis *axisX,
                      QAbstract3DAxis *axisY, QAbstract3DAxis *axisZ) const;
     bool isValidValue(float value, QAbstract3DAxis *axis) const;
 
     void setSeries(QAbstract3DSeries *series) override;
 
+    inline bool isGrid() const { return !m_dataGrid.isEmpty(); }
+    inline const SurfaceDataGrid &dataGrid() const { return m_dataGrid; }
+    inline qint64 scrolledRowCount() const { return m_scrolledRowCount; }
+    inline SurfaceDataView dataView() const
+    {
+        if (isGrid())
+            return SurfaceDataView(m_dataGrid);
+        return SurfaceDataView(*m_dataArray);
+    }
+
 protected:
     QSurfaceDataArray *m_dataArray;
+    SurfaceDataGrid m_dataGrid;
+    mutable QSurfaceDataItem m_gridItem;
+    mutable RowLimitsCache m_rowLimits;
+    // Total number of rows scrolled, so renderers can tell how far their copy is behind
+    qint64 m_scrolledRowCount;
 
 private:
     QSurfaceDataProxy *qptr();
     void clearRow(int rowIndex);
     void clearArray();
+    void convertGridToArray();
+    void connectRowLimitsCache();
+    void limitGridValues(const QList<float> &values, QAbstract3DAxis *axis,
+                         float &low, float &high) const;
 
     friend class QSurfaceDataProxy;
 };
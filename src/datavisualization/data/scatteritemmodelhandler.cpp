@@ -50,27 +50,39 @@ ScatterItemModelHandler::ScatterItemModelHandler(QItemModelScatterDataProxy *pro
 
 ScatterItemModelHandler::~ScatterItemModelHandler()
 {
+    waitForResolve();
 }
 
+// Each model row maps to consecutive items in the proxy, one item for each model column.
+// Single column models map the model rows directly to the items.
 void ScatterItemModelHandler::handleDataChanged(const QModelIndex &topLeft,
                                                 const QModelIndex &bottomRight,
                                                 const QList<int> &roles)
 {
     // Do nothing if full reset already pending
     if (!m_fullReset) {
-        if (m_itemModel->columnCount() > 1) {
-            // If the data model is multi-column, do full asynchronous reset to simplify things
+        const int columnCount = m_itemModel->columnCount();
+        if (m_proxy->itemCount() != m_itemModel->rowCount() * columnCount) {
+            // The proxy does not match the model layout, so resolve everything
             AbstractItemModelHandler::handleDataChanged(topLeft, bottomRight, roles);
         } else {
-            int start = qMin(topLeft.row(), bottomRight.row());
-            int end = qMax(topLeft.row(), bottomRight.row());
+            int startRow = qMin(topLeft.row(), bottomRight.row());
+            int endRow = qMax(topLeft.row(), bottomRight.row());
+            int startCol = qMin(topLeft.column(), bottomRight.column());
+            int endCol = qMax(topLeft.column(), bottomRight.column());
 
-            QScatterDataArray array(end - start + 1);
-            int count = 0;
-            for (int i = start; i <= end; i++)
-                modelPosToScatterItem(i, 0, array[count++]);
-
-            m_proxy->setItems(start, array);
+            if (startCol == 0 && endCol == columnCount - 1) {
+                // Whole rows changed, so the changed items are consecutive
+                m_proxy->setItems(startRow * columnCount, resolveRows(startRow, endRow));
+            } else {
+                QScatterDataArray array(endCol - startCol + 1);
+                for (int i = startRow; i <= endRow; i++) {
+                    int count = 0;
+                    for (int j = startCol; j <= endCol; j++)
+                        modelPosToScatterItem(m_itemModel->index(i, j), array[count++]);
+                    m_proxy->setItems(i * columnCount + startCol, array);
+                }
+            }
         }
     }
 }
@@ -79,33 +91,48 @@ void ScatterItemModelHandler::handleRowsInserted(const QModelIndex &parent, int
 {
     // Do nothing if full reset already pending
     if (!m_fullReset) {
-        if (!m_proxy->itemCount() || m_itemModel->columnCount() > 1) {
+        const int columnCount = m_itemModel->columnCount();
+        const int oldRowCount = m_itemModel->rowCount() - (end - start + 1);
+        if (!m_proxy->itemCount() || m_proxy->itemCount() != oldRowCount * columnCount) {
             // If inserting into an empty array, do full asynchronous reset to avoid multiple
             // separate inserts when initializing the model.
-            // If the data model is multi-column, do full asynchronous reset to simplify things
             AbstractItemModelHandler::handleRowsInserted(parent, start, end);
         } else {
-            QScatterDataArray array(end - start + 1);
-            int count = 0;
-            for (int i = start; i <= end; i++)
-                modelPosToScatterItem(i, 0, array[count++]);
+            m_proxy->insertItems(start * columnCount, resolveRows(start, end));
+        }
+    }
+}
 
-            m_proxy->insertItems(start, array);
+void ScatterItemModelHandler::handleRowsMoved(const QModelIndex &sourceParent, int sourceStart,
+                                              int sourceEnd, const QModelIndex &destinationParent,
+                                              int destinationRow)
+{
+    // Do nothing if full reset already pending
+    if (!m_fullReset) {
+        const int columnCount = m_itemModel->columnCount();
+        if (sourceParent != destinationParent
+                || m_proxy->itemCount() != m_itemModel->rowCount() * columnCount) {
+            AbstractItemModelHandler::handleRowsMoved(sourceParent, sourceStart, sourceEnd,
+                                                      destinationParent, destinationRow);
+        } else {
+            // Only the rows between the source and the destination change places
+            int start = qMin(sourceStart, destinationRow);
+            int end = qMax(sourceEnd, destinationRow - 1);
+            m_proxy->setItems(start * columnCount, resolveRows(start, end));
         }
     }
 }
 
 void ScatterItemModelHandler::handleRowsRemoved(const QModelIndex &parent, int start, int end)
 {
-    Q_UNUSED(parent);
-
     // Do nothing if full reset already pending
     if (!m_fullReset) {
-        if (m_itemModel->columnCount() > 1) {
-            // If the data model is multi-column, do full asynchronous reset to simplify things
+        const int columnCount = m_itemModel->columnCount();
+        const int removeCount = end - start + 1;
+        if (m_proxy->itemCount() != (m_itemModel->rowCount() + removeCount) * columnCount) {
             AbstractItemModelHandler::handleRowsRemoved(parent, start, end);
         } else {
-            m_proxy->removeItems(start, end - start + 1);
+            m_proxy->removeItems(start * columnCount, removeCount * columnCount);
         }
     }
 }
@@ -145,10 +172,9 @@ static inline QQuaternion toQuaternion(const QVariant &variant)
     return QQuaternion();
 }
 
-void ScatterItemModelHandler::modelPosToScatterItem(int modelRow, int modelColumn,
-                                                    QScatterDataItem &item)
+void ScatterItemModelHandler::modelPosToScatterItem(const QModelIndex &index,
+                                                    QScatterDataItem &item) const
 {
-    QModelIndex index = m_itemModel->index(modelRow, modelColumn);
     float xPos;
     float yPos;
     float zPos;
@@ -194,6 +220,18 @@ void ScatterItemModelHandler::modelPosToScatterItem(int modelRow, int modelColum
     item.setPosition(QVector3D(xPos, yPos, zPos));
 }
 
+QScatterDataArray ScatterItemModelHandler::resolveRows(int startRow, int endRow) const
+{
+    const int columnCount = m_itemModel->columnCount();
+    QScatterDataArray array((endRow - startRow + 1) * columnCount);
+    int count = 0;
+    for (int i = startRow; i <= endRow; i++) {
+        for (int j = 0; j < columnCount; j++)
+            modelPosToScatterItem(m_itemModel->index(i, j), array[count++]);
+    }
+    return array;
+}
+
 // Resolve entire item model into QScatterDataArray.
 void ScatterItemModelHandler::resolveModel()
 {
@@ -221,24 +259,35 @@ void ScatterItemModelHandler::resolveModel()
     m_yPosRole = roleHash.key(m_proxy->yPosRole().toLatin1(), noRoleIndex);
     m_zPosRole = roleHash.key(m_proxy->zPosRole().toLatin1(), noRoleIndex);
     m_rotationRole = roleHash.key(m_proxy->rotationRole().toLatin1(), noRoleIndex);
-    const int columnCount = m_itemModel->columnCount();
-    const int rowCount = m_itemModel->rowCount();
-    const int totalCount = rowCount * columnCount;
-    int runningCount = 0;
-
-    // If dimensions have changed, recreate the array
-    if (m_proxyArray != m_proxy->array() || totalCount != m_proxyArray->size())
-        m_proxyArray = new QScatterDataArray(totalCount);
-
-    // Parse data into newProxyArray
-    for (int i = 0; i < rowCount; i++) {
-        for (int j = 0; j < columnCount; j++) {
-            modelPosToScatterItem(i, j, (*m_proxyArray)[runningCount]);
-            runningCount++;
+    // Asynchronously resolved data always goes to a new array, as the old one is still in use
+    QScatterDataArray *oldArray = (!m_asyncResolve && m_proxyArray == m_proxy->array())
+            ? m_proxyArray : 0;
+
+    resolve({m_xPosRole, m_yPosRole, m_zPosRole, m_rotationRole},
+            [=](const QAbstractItemModel *model) -> std::function<void()> {
+        const int columnCount = model->columnCount();
+        const int rowCount = model->rowCount();
+        const int totalCount = rowCount * columnCount;
+        int runningCount = 0;
+
+        // If dimensions have changed, recreate the array
+        QScatterDataArray *proxyArray = oldArray;
+        if (!proxyArray || totalCount != proxyArray->size())
+            proxyArray = new QScatterDataArray(totalCount);
+
+        // Parse data into newProxyArray
+        for (int i = 0; i < rowCount; i++) {
+            for (int j = 0; j < columnCount; j++) {
+                modelPosToScatterItem(model->index(i, j), (*proxyArray)[runningCount]);
+                runningCount++;
+            }
         }
-    }
 
-    m_proxy->resetArray(m_proxyArray);
+        return [this, proxyArray]() {
+            m_proxyArray = proxyArray;
+            m_proxy->resetArray(proxyArray);
+        };
+    });
 }
 
 QT_END_NAMESPACE
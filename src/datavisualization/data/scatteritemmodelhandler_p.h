@@ -56,13 +56,16 @@ public Q_SLOTS:
     void handleDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
                            const QList<int> &roles = QList<int>()) override;
     void handleRowsInserted(const QModelIndex &parent, int start, int end) override;
+    void handleRowsMoved(const QModelIndex &sourceParent, int sourceStart, int sourceEnd,
+                         const QModelIndex &destinationParent, int destinationRow) override;
     void handleRowsRemoved(const QModelIndex &parent, int start, int end) override;
 
 protected:
     void resolveModel() override;
 
 private:
-    void modelPosToScatterItem(int modelRow, int modelColumn, QScatterDataItem &item);
+    void modelPosToScatterItem(const QModelIndex &index, QScatterDataItem &item) const;
+    QScatterDataArray resolveRows(int startRow, int endRow) const;
 
     QItemModelScatterDataProxy *m_proxy; // Not owned
     QScatterDataArray *m_proxyArray; // Not owned
@@ -0,0 +1,394 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "scatterspatialindex_p.h"
+#include "qscatterdataproxy_p.h"
+
+#include <QtCore/QVarLengthArray>
+
+#include <algorithm>
+#include <limits>
+
+QT_BEGIN_NAMESPACE
+
+static const int maxLeafItems = 16;
+// Limits the splitting of leaves with many items at the same position
+static const int maxDepth = 20;
+
+static inline bool isFinite(const QVector3D &position)
+{
+    return qIsFinite(position.x()) && qIsFinite(position.y()) && qIsFinite(position.z());
+}
+
+ScatterSpatialIndex::ScatterSpatialIndex()
+    : m_proxy(0),
+      m_enabled(false),
+      m_dirty(true)
+{
+}
+
+void ScatterSpatialIndex::setProxy(const QScatterDataProxyPrivate *proxy)
+{
+    m_proxy = proxy;
+    invalidate();
+}
+
+void ScatterSpatialIndex::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+    invalidate();
+}
+
+void ScatterSpatialIndex::invalidate()
+{
+    m_dirty = true;
+    m_nodes.clear();
+    m_itemLeaves.clear();
+}
+
+// Inserts items appended to the proxy. Items outside the bounds of the tree cause a rebuild on
+// the next query.
+void ScatterSpatialIndex::addItems(int startIndex, int count)
+{
+    if (!isUsable() || m_dirty)
+        return;
+
+    m_itemLeaves.resize(startIndex + count);
+    for (int i = startIndex; i < startIndex + count; i++) {
+        m_itemLeaves[i] = -1;
+        const QVector3D position = m_proxy->itemPosition(i);
+        if (isFinite(position) && !insert(i, position)) {
+            invalidate();
+            return;
+        }
+    }
+}
+
+// Moves changed items that left their leaves
+void ScatterSpatialIndex::updateItems(int startIndex, int count)
+{
+    if (!isUsable() || m_dirty)
+        return;
+    if (startIndex + count > m_itemLeaves.size()) {
+        invalidate();
+        return;
+    }
+
+    for (int i = startIndex; i < startIndex + count; i++) {
+        const QVector3D position = m_proxy->itemPosition(i);
+        const int leaf = m_itemLeaves.at(i);
+        if (leaf >= 0) {
+            if (contains(m_nodes.at(leaf), position))
+                continue;
+            m_nodes[leaf].items.removeOne(i);
+            m_itemLeaves[i] = -1;
+        }
+        if (isFinite(position) && !insert(i, position)) {
+            invalidate();
+            return;
+        }
+    }
+}
+
+// Returns the index of the item closest to the position, or -1 if there are no items
+int ScatterSpatialIndex::nearestItem(const QVector3D &position) const
+{
+    int nearest = -1;
+    float nearestDistance = std::numeric_limits<float>::max();
+    if (!m_proxy)
+        return nearest;
+
+    auto testItem = [&](int item) {
+        const float distance = (m_proxy->itemPosition(item) - position).lengthSquared();
+        if (distance < nearestDistance) {
+            nearestDistance = distance;
+            nearest = item;
+        }
+    };
+
+    if (!isUsable()) {
+        for (int i = 0; i < m_proxy->itemCount(); i++)
+            testItem(i);
+        return nearest;
+    }
+
+    if (m_dirty)
+        build();
+    if (m_nodes.isEmpty())
+        return nearest;
+
+    QVarLengthArray<int, 64> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        const Node &node = m_nodes.at(stack.takeLast());
+        if (distanceSquared(node, position) > nearestDistance)
+            continue;
+
+        if (node.firstChild < 0) {
+            for (int item : node.items)
+                testItem(item);
+            continue;
+        }
+
+        // Visit the closest children first by pushing them last
+        int children[8];
+        float distances[8];
+        for (int i = 0; i < 8; i++) {
+            children[i] = node.firstChild + i;
+            distances[i] = distanceSquared(m_nodes.at(children[i]), position);
+        }
+        std::sort(children, children + 8, [&](int a, int b) {
+            return distances[a - node.firstChild] > distances[b - node.firstChild];
+        });
+        for (int child : children)
+            stack.append(child);
+    }
+    return nearest;
+}
+
+// Returns the indices of the items within the box in ascending order
+QList<int> ScatterSpatialIndex::itemsInBox(const QVector3D &minimum,
+                                           const QVector3D &maximum) const
+{
+    QList<int> items;
+    if (!m_proxy)
+        return items;
+
+    auto inBox = [&](const QVector3D &position) {
+        return position.x() >= minimum.x() && position.x() <= maximum.x()
+                && position.y() >= minimum.y() && position.y() <= maximum.y()
+                && position.z() >= minimum.z() && position.z() <= maximum.z();
+    };
+
+    if (!isUsable()) {
+        for (int i = 0; i < m_proxy->itemCount(); i++) {
+            if (inBox(m_proxy->itemPosition(i)))
+                items.append(i);
+        }
+        return items;
+    }
+
+    if (m_dirty)
+        build();
+    if (m_nodes.isEmpty())
+        return items;
+
+    QVarLengthArray<int, 64> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        const Node &node = m_nodes.at(stack.takeLast());
+        if (node.maximum.x() < minimum.x() || node.minimum.x() > maximum.x()
+                || node.maximum.y() < minimum.y() || node.minimum.y() > maximum.y()
+                || node.maximum.z() < minimum.z() || node.minimum.z() > maximum.z()) {
+            continue;
+        }
+
+        if (node.firstChild < 0) {
+            for (int item : node.items) {
+                if (inBox(m_proxy->itemPosition(item)))
+                    items.append(item);
+            }
+        } else {
+            for (int i = 0; i < 8; i++)
+                stack.append(node.firstChild + i);
+        }
+    }
+    std::sort(items.begin(), items.end());
+    return items;
+}
+
+// Returns the indices of the items within the sphere in ascending order
+QList<int> ScatterSpatialIndex::itemsInSphere(const QVector3D &center, float radius) const
+{
+    QList<int> items;
+    if (!m_proxy || radius < 0.0f)
+        return items;
+
+    const float radiusSquared = radius * radius;
+    if (!isUsable()) {
+        for (int i = 0; i < m_proxy->itemCount(); i++) {
+            if ((m_proxy->itemPosition(i) - center).lengthSquared() <= radiusSquared)
+                items.append(i);
+        }
+        return items;
+    }
+
+    if (m_dirty)
+        build();
+    if (m_nodes.isEmpty())
+        return items;
+
+    QVarLengthArray<int, 64> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        const Node &node = m_nodes.at(stack.takeLast());
+        if (distanceSquared(node, center) > radiusSquared)
+            continue;
+
+        if (node.firstChild < 0) {
+            for (int item : node.items) {
+                if ((m_proxy->itemPosition(item) - center).lengthSquared() <= radiusSquared)
+                    items.append(item);
+            }
+        } else {
+            for (int i = 0; i < 8; i++)
+                stack.append(node.firstChild + i);
+        }
+    }
+    std::sort(items.begin(), items.end());
+    return items;
+}
+
+bool ScatterSpatialIndex::isUsable() const
+{
+    return m_enabled && m_proxy;
+}
+
+void ScatterSpatialIndex::build() const
+{
+    m_nodes.clear();
+    const int count = m_proxy->itemCount();
+    m_itemLeaves.fill(-1, count);
+    m_dirty = false;
+
+    Node root;
+    bool empty = true;
+    for (int i = 0; i < count; i++) {
+        const QVector3D position = m_proxy->itemPosition(i);
+        if (!isFinite(position))
+            continue;
+        if (empty) {
+            root.minimum = position;
+            root.maximum = position;
+            empty = false;
+            continue;
+        }
+        for (int axis = 0; axis < 3; axis++) {
+            root.minimum[axis] = qMin(root.minimum[axis], position[axis]);
+            root.maximum[axis] = qMax(root.maximum[axis], position[axis]);
+        }
+    }
+    if (empty)
+        return;
+
+    // Leave some room for items added or moved later
+    const QVector3D extent = root.maximum - root.minimum;
+    const float margin = qMax(qMax(extent.x(), qMax(extent.y(), extent.z())) * 0.05f, 1.0f);
+    root.minimum -= QVector3D(margin, margin, margin);
+    root.maximum += QVector3D(margin, margin, margin);
+    root.firstChild = -1;
+    root.depth = 0;
+    m_nodes.append(root);
+
+    for (int i = 0; i < count; i++) {
+        const QVector3D position = m_proxy->itemPosition(i);
+        if (isFinite(position))
+            insert(i, position);
+    }
+}
+
+// Returns false if the position is outside the tree
+bool ScatterSpatialIndex::insert(int item, const QVector3D &position) const
+{
+    if (m_nodes.isEmpty() || !contains(m_nodes.at(0), position))
+        return false;
+
+    int index = 0;
+    while (m_nodes.at(index).firstChild >= 0) {
+        const Node &node = m_nodes.at(index);
+        const QVector3D center = (node.minimum + node.maximum) * 0.5f;
+        index = node.firstChild + (position.x() >= center.x() ? 1 : 0)
+                + (position.y() >= center.y() ? 2 : 0) + (position.z() >= center.z() ? 4 : 0);
+    }
+
+    m_nodes[index].items.append(item);
+    m_itemLeaves[item] = index;
+    if (m_nodes.at(index).items.size() > maxLeafItems && m_nodes.at(index).depth < maxDepth)
+        split(index);
+    return true;
+}
+
+void ScatterSpatialIndex::split(int index) const
+{
+    const int firstChild = m_nodes.size();
+    const QVector3D minimum = m_nodes.at(index).minimum;
+    const QVector3D maximum = m_nodes.at(index).maximum;
+    const QVector3D center = (minimum + maximum) * 0.5f;
+    for (int i = 0; i < 8; i++) {
+        Node child;
+        child.minimum = QVector3D((i & 1) ? center.x() : minimum.x(),
+                                  (i & 2) ? center.y() : minimum.y(),
+                                  (i & 4) ? center.z() : minimum.z());
+        child.maximum = QVector3D((i & 1) ? maximum.x() : center.x(),
+                                  (i & 2) ? maximum.y() : center.y(),
+                                  (i & 4) ? maximum.z() : center.z());
+        child.firstChild = -1;
+        child.depth = m_nodes.at(index).depth + 1;
+        m_nodes.append(child);
+    }
+
+    const QList<int> items = m_nodes.at(index).items;
+    m_nodes[index].items.clear();
+    m_nodes[index].firstChild = firstChild;
+    for (int item : items) {
+        const QVector3D position = m_proxy->itemPosition(item);
+        const int child = firstChild + (position.x() >= center.x() ? 1 : 0)
+                + (position.y() >= center.y() ? 2 : 0) + (position.z() >= center.z() ? 4 : 0);
+        m_nodes[child].items.append(item);
+        m_itemLeaves[item] = child;
+    }
+
+    for (int child = firstChild; child < firstChild + 8; child++) {
+        if (m_nodes.at(child).items.size() > maxLeafItems
+                && m_nodes.at(child).depth < maxDepth) {
+            split(child);
+        }
+    }
+}
+
+bool ScatterSpatialIndex::contains(const Node &node, const QVector3D &position)
+{
+    return position.x() >= node.minimum.x() && position.x() <= node.maximum.x()
+            && position.y() >= node.minimum.y() && position.y() <= node.maximum.y()
+            && position.z() >= node.minimum.z() && position.z() <= node.maximum.z();
+}
+
+float ScatterSpatialIndex::distanceSquared(const Node &node, const QVector3D &position)
+{
+    float distance = 0.0f;
+    for (int axis = 0; axis < 3; axis++) {
+        const float below = node.minimum[axis] - position[axis];
+        const float above = position[axis] - node.maximum[axis];
+        const float outside = qMax(0.0f, qMax(below, above));
+        distance += outside * outside;
+    }
+    return distance;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,99 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QtDataVisualization API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+#ifndef SCATTERSPATIALINDEX_P_H
+#define SCATTERSPATIALINDEX_P_H
+
+#include "datavisualizationglobal_p.h"
+
+#include <QtCore/QList>
+#include <QtGui/QVector3D>
+
+QT_BEGIN_NAMESPACE
+
+class QScatterDataProxyPrivate;
+
+// Octree over the item positions of a scatter data proxy. The tree stores only item indices,
+// and the positions are read from the proxy when queried, so the data is not copied. When
+// the index is disabled, the queries scan all the items instead.
+class ScatterSpatialIndex
+{
+public:
+    ScatterSpatialIndex();
+
+    void setProxy(const QScatterDataProxyPrivate *proxy);
+    void setEnabled(bool enabled);
+    inline bool isEnabled() const { return m_enabled; }
+
+    void invalidate();
+    void addItems(int startIndex, int count);
+    void updateItems(int startIndex, int count);
+
+    int nearestItem(const QVector3D &position) const;
+    QList<int> itemsInBox(const QVector3D &minimum, const QVector3D &maximum) const;
+    QList<int> itemsInSphere(const QVector3D &center, float radius) const;
+
+private:
+    struct Node
+    {
+        QVector3D minimum;
+        QVector3D maximum;
+        int firstChild; // Eight consecutive children, or -1 for leaves
+        int depth;
+        QList<int> items;
+    };
+
+    bool isUsable() const;
+    void build() const;
+    bool insert(int item, const QVector3D &position) const;
+    void split(int node) const;
+    static bool contains(const Node &node, const QVector3D &position);
+    static float distanceSquared(const Node &node, const QVector3D &position);
+
+    const QScatterDataProxyPrivate *m_proxy;
+    bool m_enabled;
+    // The tree is built lazily on the first query after it has been invalidated
+    mutable bool m_dirty;
+    mutable QList<Node> m_nodes;
+    mutable QList<int> m_itemLeaves; // Leaf node of each item, or -1 if not in the tree
+};
+
+QT_END_NAMESPACE
+
+#endif
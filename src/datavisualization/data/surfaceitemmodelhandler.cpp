@@ -29,10 +29,33 @@
 
 #include "surfaceitemmodelhandler_p.h"
 
+#include <QtCore/QVarLengthArray>
+
 QT_BEGIN_NAMESPACE
 
 static const int noRoleIndex = -1;
 
+// Numeric values are converted directly, strings are parsed after the pattern replacement
+static inline float toPosition(const QVariant &value, bool havePattern,
+                               const QRegularExpression &pattern, const QString &replace)
+{
+    if (havePattern)
+        return value.toString().replace(pattern, replace).toFloat();
+    return value.toFloat();
+}
+
+// Header values are used as positions when they are numbers, otherwise the section index is used
+static inline float headerPosition(const QAbstractItemModel *model, int section,
+                                   Qt::Orientation orientation)
+{
+    QString header = model->headerData(section, orientation).toString();
+    bool ok = false;
+    float headerValue = header.toFloat(&ok);
+    if (ok)
+        return headerValue;
+    return float(section);
+}
+
 SurfaceItemModelHandler::SurfaceItemModelHandler(QItemModelSurfaceDataProxy *proxy, QObject *parent)
     : AbstractItemModelHandler(parent),
       m_proxy(proxy),
@@ -48,6 +71,7 @@ SurfaceItemModelHandler::SurfaceItemModelHandler(QItemModelSurfaceDataProxy *pro
 
 SurfaceItemModelHandler::~SurfaceItemModelHandler()
 {
+    waitForResolve();
 }
 
 void SurfaceItemModelHandler::handleDataChanged(const QModelIndex &topLeft,
@@ -106,6 +130,102 @@ void SurfaceItemModelHandler::handleDataChanged(const QModelIndex &topLeft,
     }
 }
 
+// With model categories, each model row maps to a surface row. Inserting or removing rows
+// shifts the row headers, so it can only be done incrementally if z-positions come from a role.
+void SurfaceItemModelHandler::handleRowsInserted(const QModelIndex &parent, int start, int end)
+{
+    // Do nothing if full reset already pending
+    if (!m_fullReset) {
+        const int oldRowCount = m_itemModel->rowCount() - (end - start + 1);
+        if (!m_proxy->rowCount() || !mapsRowsDirectly(oldRowCount)
+                || m_zPosRole == noRoleIndex) {
+            // If inserting into an empty array, do full asynchronous reset to avoid multiple
+            // separate inserts when initializing the model.
+            AbstractItemModelHandler::handleRowsInserted(parent, start, end);
+        } else {
+            m_proxy->insertRows(start, resolveRows(start, end));
+        }
+    }
+}
+
+void SurfaceItemModelHandler::handleRowsMoved(const QModelIndex &sourceParent, int sourceStart,
+                                              int sourceEnd, const QModelIndex &destinationParent,
+                                              int destinationRow)
+{
+    // Do nothing if full reset already pending
+    if (!m_fullReset) {
+        if (sourceParent != destinationParent || !mapsRowsDirectly(m_itemModel->rowCount())) {
+            AbstractItemModelHandler::handleRowsMoved(sourceParent, sourceStart, sourceEnd,
+                                                      destinationParent, destinationRow);
+        } else {
+            // Only the rows between the source and the destination change places
+            int start = qMin(sourceStart, destinationRow);
+            int end = qMax(sourceEnd, destinationRow - 1);
+            m_proxy->setRows(start, resolveRows(start, end));
+        }
+    }
+}
+
+void SurfaceItemModelHandler::handleRowsRemoved(const QModelIndex &parent, int start, int end)
+{
+    // Do nothing if full reset already pending
+    if (!m_fullReset) {
+        const int removeCount = end - start + 1;
+        if (!mapsRowsDirectly(m_itemModel->rowCount() + removeCount)
+                || m_zPosRole == noRoleIndex) {
+            AbstractItemModelHandler::handleRowsRemoved(parent, start, end);
+        } else {
+            m_proxy->removeRows(start, removeCount);
+        }
+    }
+}
+
+// Returns true if model rows map directly to the proxy rows, and the proxy has the given number
+// of rows.
+bool SurfaceItemModelHandler::mapsRowsDirectly(int rowCount) const
+{
+    return m_proxy->useModelCategories() && m_proxyArray == m_proxy->array()
+            && m_proxy->rowCount() == rowCount
+            && m_proxy->columnCount() == m_itemModel->columnCount();
+}
+
+QSurfaceDataArray SurfaceItemModelHandler::resolveRows(int startRow, int endRow) const
+{
+    const int columnCount = m_itemModel->columnCount();
+    QList<float> headerXPos;
+    if (m_xPosRole == noRoleIndex) {
+        headerXPos.reserve(columnCount);
+        for (int j = 0; j < columnCount; j++)
+            headerXPos.append(headerPosition(m_itemModel, j, Qt::Horizontal));
+    }
+
+    QSurfaceDataArray array;
+    array.reserve(endRow - startRow + 1);
+    for (int i = startRow; i <= endRow; i++) {
+        float zPos = 0.0f;
+        if (m_zPosRole == noRoleIndex)
+            zPos = headerPosition(m_itemModel, i, Qt::Vertical);
+        QSurfaceDataRow *newRow = new QSurfaceDataRow(columnCount);
+        for (int j = 0; j < columnCount; j++) {
+            QModelIndex index = m_itemModel->index(i, j);
+            float xPos;
+            if (m_xPosRole != noRoleIndex)
+                xPos = toPosition(index.data(m_xPosRole), m_haveXPosPattern, m_xPosPattern,
+                                  m_xPosReplace);
+            else
+                xPos = headerXPos.at(j);
+            float yPos = toPosition(index.data(m_yPosRole), m_haveYPosPattern, m_yPosPattern,
+                                    m_yPosReplace);
+            if (m_zPosRole != noRoleIndex)
+                zPos = toPosition(index.data(m_zPosRole), m_haveZPosPattern, m_zPosPattern,
+                                  m_zPosReplace);
+            (*newRow)[j].setPosition(QVector3D(xPos, yPos, zPos));
+        }
+        array.append(newRow);
+    }
+    return array;
+}
+
 // Resolve entire item model into QSurfaceDataArray.
 void SurfaceItemModelHandler::resolveModel()
 {
@@ -145,192 +265,212 @@ void SurfaceItemModelHandler::resolveModel()
     m_xPosRole = roleHash.key(m_proxy->xPosRole().toLatin1(), noRoleIndex);
     m_yPosRole = roleHash.key(m_proxy->yPosRole().toLatin1(), Qt::DisplayRole);
     m_zPosRole = roleHash.key(m_proxy->zPosRole().toLatin1(), noRoleIndex);
-    int rowCount = m_itemModel->rowCount();
-    int columnCount = m_itemModel->columnCount();
-
-    if (m_proxy->useModelCategories()) {
-        // If dimensions have changed, recreate the array
-        if (m_proxyArray != m_proxy->array() || columnCount != m_proxy->columnCount()
-                || rowCount != m_proxyArray->size()) {
-            m_proxyArray = new QSurfaceDataArray;
-            m_proxyArray->reserve(rowCount);
-            for (int i = 0; i < rowCount; i++)
-                m_proxyArray->append(new QSurfaceDataRow(columnCount));
-        }
-        for (int i = 0; i < rowCount; i++) {
-            QSurfaceDataRow &newProxyRow = *m_proxyArray->at(i);
-            for (int j = 0; j < columnCount; j++) {
-                QModelIndex index = m_itemModel->index(i, j);
-                QVariant xValueVar = index.data(m_xPosRole);
-                QVariant yValueVar = index.data(m_yPosRole);
-                QVariant zValueVar = index.data(m_zPosRole);
-                float xPos;
-                float yPos;
-                float zPos;
-                if (m_xPosRole != noRoleIndex) {
+    int rowRole = roleHash.key(m_proxy->rowRole().toLatin1());
+    int columnRole = roleHash.key(m_proxy->columnRole().toLatin1());
+    if (!m_proxy->useModelCategories()) {
+        if (m_xPosRole == noRoleIndex)
+            m_xPosRole = columnRole;
+        if (m_zPosRole == noRoleIndex)
+            m_zPosRole = rowRole;
+    }
+
+    // The resolver may run in a worker thread, so read the rest of the proxy settings here
+    bool useModelCategories = m_proxy->useModelCategories();
+    bool generateRows = m_proxy->autoRowCategories();
+    bool generateColumns = m_proxy->autoColumnCategories();
+    QStringList rowCategories = m_proxy->rowCategories();
+    QStringList columnCategories = m_proxy->columnCategories();
+    QItemModelSurfaceDataProxy::MultiMatchBehavior multiMatchBehavior
+            = m_proxy->multiMatchBehavior();
+    int oldColumnCount = m_proxy->columnCount();
+    // Asynchronously resolved data always goes to a new array, as the old one is still in use
+    QSurfaceDataArray *oldArray = (!m_asyncResolve && m_proxyArray == m_proxy->array())
+            ? m_proxyArray : 0;
+
+    resolve({m_xPosRole, m_yPosRole, m_zPosRole, rowRole, columnRole},
+            [=](const QAbstractItemModel *model) -> std::function<void()> {
+        QSurfaceDataArray *proxyArray = oldArray;
+        QStringList rowList;
+        QStringList columnList;
+        int rowCount = model->rowCount();
+        int columnCount = model->columnCount();
+
+        if (useModelCategories) {
+            // If dimensions have changed, recreate the array
+            if (!proxyArray || columnCount != oldColumnCount || rowCount != proxyArray->size()) {
+                proxyArray = new QSurfaceDataArray;
+                proxyArray->reserve(rowCount);
+                for (int i = 0; i < rowCount; i++)
+                    proxyArray->append(new QSurfaceDataRow(columnCount));
+            }
+            // Unmapped x and z positions come from the headers, so parse them once per
+            // column and row
+            QList<float> headerXPos;
+            QList<float> headerZPos;
+            if (m_xPosRole == noRoleIndex) {
+                headerXPos.reserve(columnCount);
+                for (int j = 0; j < columnCount; j++)
+                    headerXPos.append(headerPosition(model, j, Qt::Horizontal));
+            }
+            if (m_zPosRole == noRoleIndex) {
+                headerZPos.reserve(rowCount);
+                for (int i = 0; i < rowCount; i++)
+                    headerZPos.append(headerPosition(model, i, Qt::Vertical));
+            }
+
+            // Fetch all mapped roles of an item with one multiData() call
+            QVarLengthArray<QModelRoleData, 3> roleData;
+            roleData.append(QModelRoleData(m_yPosRole));
+            const int xPosData = (m_xPosRole != noRoleIndex) ? roleData.size() : -1;
+            if (xPosData >= 0)
+                roleData.append(QModelRoleData(m_xPosRole));
+            const int zPosData = (m_zPosRole != noRoleIndex) ? roleData.size() : -1;
+            if (zPosData >= 0)
+                roleData.append(QModelRoleData(m_zPosRole));
+            QModelRoleDataSpan roleDataSpan(roleData);
+
+            for (int i = 0; i < rowCount; i++) {
+                QSurfaceDataRow &newProxyRow = *proxyArray->at(i);
+                for (int j = 0; j < columnCount; j++) {
+                    model->multiData(model->index(i, j), roleDataSpan);
+                    float xPos;
+                    float yPos;
+                    float zPos;
+                    if (xPosData >= 0)
+                        xPos = toPosition(roleData[xPosData].data(), m_haveXPosPattern,
+                                          m_xPosPattern, m_xPosReplace);
+                    else
+                        xPos = headerXPos.at(j);
+                    yPos = toPosition(roleData[0].data(), m_haveYPosPattern, m_yPosPattern,
+                                      m_yPosReplace);
+                    if (zPosData >= 0)
+                        zPos = toPosition(roleData[zPosData].data(), m_haveZPosPattern,
+                                          m_zPosPattern, m_zPosReplace);
+                    else
+                        zPos = headerZPos.at(i);
+
+                    newProxyRow[j].setPosition(QVector3D(xPos, yPos, zPos));
+                }
+            }
+        } else {
+            // For detecting duplicates in categories generation, using QHashes should be faster than
+            // simple QStringList::contains() check.
+            QHash<QString, bool> rowListHash;
+            QHash<QString, bool> columnListHash;
+
+            bool cumulative = multiMatchBehavior == QItemModelSurfaceDataProxy::MMBAverage
+                    || multiMatchBehavior == QItemModelSurfaceDataProxy::MMBCumulativeY;
+            bool average = multiMatchBehavior == QItemModelSurfaceDataProxy::MMBAverage;
+            bool takeFirst = multiMatchBehavior == QItemModelSurfaceDataProxy::MMBFirst;
+            QHash<QString, QHash<QString, int> > *matchCountMap = 0;
+            if (cumulative)
+                matchCountMap = new QHash<QString, QHash<QString, int> >;
+
+            // Sort values into rows and columns
+            typedef QHash<QString, QVector3D> ColumnValueMap;
+            QHash <QString, ColumnValueMap> itemValueMap;
+            for (int i = 0; i < rowCount; i++) {
+                for (int j = 0; j < columnCount; j++) {
+                    QModelIndex index = model->index(i, j);
+                    QString rowRoleStr = index.data(rowRole).toString();
+                    if (haveRowPattern)
+                        rowRoleStr.replace(rowPattern, rowReplace);
+                    QString columnRoleStr = index.data(columnRole).toString();
+                    if (haveColPattern)
+                        columnRoleStr.replace(colPattern, colReplace);
+                    QVariant xValueVar = index.data(m_xPosRole);
+                    QVariant yValueVar = index.data(m_yPosRole);
+                    QVariant zValueVar = index.data(m_zPosRole);
+                    float xPos;
+                    float yPos;
+                    float zPos;
                     if (m_haveXPosPattern)
                         xPos = xValueVar.toString().replace(m_xPosPattern, m_xPosReplace).toFloat();
                     else
                         xPos = xValueVar.toFloat();
-                } else {
-                    QString header = m_itemModel->headerData(j, Qt::Horizontal).toString();
-                    bool ok = false;
-                    float headerValue = header.toFloat(&ok);
-                    if (ok)
-                        xPos = headerValue;
+                    if (m_haveYPosPattern)
+                        yPos = yValueVar.toString().replace(m_yPosPattern, m_yPosReplace).toFloat();
                     else
-                        xPos = float(j);
-                }
-
-                if (m_haveYPosPattern)
-                    yPos = yValueVar.toString().replace(m_yPosPattern, m_yPosReplace).toFloat();
-                else
-                    yPos = yValueVar.toFloat();
-
-                if (m_zPosRole != noRoleIndex) {
+                        yPos = yValueVar.toFloat();
                     if (m_haveZPosPattern)
                         zPos = zValueVar.toString().replace(m_zPosPattern, m_zPosReplace).toFloat();
                     else
                         zPos = zValueVar.toFloat();
-                } else {
-                    QString header = m_itemModel->headerData(i, Qt::Vertical).toString();
-                    bool ok = false;
-                    float headerValue = header.toFloat(&ok);
-                    if (ok)
-                        zPos = headerValue;
-                    else
-                        zPos = float(i);
-                }
 
-                newProxyRow[j].setPosition(QVector3D(xPos, yPos, zPos));
-            }
-        }
-    } else {
-        int rowRole = roleHash.key(m_proxy->rowRole().toLatin1());
-        int columnRole = roleHash.key(m_proxy->columnRole().toLatin1());
-        if (m_xPosRole == noRoleIndex)
-            m_xPosRole = columnRole;
-        if (m_zPosRole == noRoleIndex)
-            m_zPosRole = rowRole;
+                    QVector3D itemPos(xPos, yPos, zPos);
 
-        bool generateRows = m_proxy->autoRowCategories();
-        bool generateColumns = m_proxy->autoColumnCategories();
+                    if (cumulative)
+                        (*matchCountMap)[rowRoleStr][columnRoleStr]++;
 
-        QStringList rowList;
-        QStringList columnList;
-        // For detecting duplicates in categories generation, using QHashes should be faster than
-        // simple QStringList::contains() check.
-        QHash<QString, bool> rowListHash;
-        QHash<QString, bool> columnListHash;
-
-        bool cumulative = m_proxy->multiMatchBehavior() == QItemModelSurfaceDataProxy::MMBAverage
-                || m_proxy->multiMatchBehavior() == QItemModelSurfaceDataProxy::MMBCumulativeY;
-        bool average = m_proxy->multiMatchBehavior() == QItemModelSurfaceDataProxy::MMBAverage;
-        bool takeFirst = m_proxy->multiMatchBehavior() == QItemModelSurfaceDataProxy::MMBFirst;
-        QHash<QString, QHash<QString, int> > *matchCountMap = 0;
-        if (cumulative)
-            matchCountMap = new QHash<QString, QHash<QString, int> >;
-
-        // Sort values into rows and columns
-        typedef QHash<QString, QVector3D> ColumnValueMap;
-        QHash <QString, ColumnValueMap> itemValueMap;
-        for (int i = 0; i < rowCount; i++) {
-            for (int j = 0; j < columnCount; j++) {
-                QModelIndex index = m_itemModel->index(i, j);
-                QString rowRoleStr = index.data(rowRole).toString();
-                if (haveRowPattern)
-                    rowRoleStr.replace(rowPattern, rowReplace);
-                QString columnRoleStr = index.data(columnRole).toString();
-                if (haveColPattern)
-                    columnRoleStr.replace(colPattern, colReplace);
-                QVariant xValueVar = index.data(m_xPosRole);
-                QVariant yValueVar = index.data(m_yPosRole);
-                QVariant zValueVar = index.data(m_zPosRole);
-                float xPos;
-                float yPos;
-                float zPos;
-                if (m_haveXPosPattern)
-                    xPos = xValueVar.toString().replace(m_xPosPattern, m_xPosReplace).toFloat();
-                else
-                    xPos = xValueVar.toFloat();
-                if (m_haveYPosPattern)
-                    yPos = yValueVar.toString().replace(m_yPosPattern, m_yPosReplace).toFloat();
-                else
-                    yPos = yValueVar.toFloat();
-                if (m_haveZPosPattern)
-                    zPos = zValueVar.toString().replace(m_zPosPattern, m_zPosReplace).toFloat();
-                else
-                    zPos = zValueVar.toFloat();
-
-                QVector3D itemPos(xPos, yPos, zPos);
-
-                if (cumulative)
-                    (*matchCountMap)[rowRoleStr][columnRoleStr]++;
-
-                if (cumulative) {
-                    itemValueMap[rowRoleStr][columnRoleStr] += itemPos;
-                } else {
-                    if (takeFirst && itemValueMap.contains(rowRoleStr)) {
-                        if (itemValueMap.value(rowRoleStr).contains(columnRoleStr))
-                            continue; // We already have a value for this row/column combo
+                    if (cumulative) {
+                        itemValueMap[rowRoleStr][columnRoleStr] += itemPos;
+                    } else {
+                        if (takeFirst && itemValueMap.contains(rowRoleStr)) {
+                            if (itemValueMap.value(rowRoleStr).contains(columnRoleStr))
+                                continue; // We already have a value for this row/column combo
+                        }
+                        itemValueMap[rowRoleStr][columnRoleStr] = itemPos;
                     }
-                    itemValueMap[rowRoleStr][columnRoleStr] = itemPos;
-                }
 
-                if (generateRows && !rowListHash.value(rowRoleStr, false)) {
-                    rowListHash.insert(rowRoleStr, true);
-                    rowList << rowRoleStr;
-                }
-                if (generateColumns && !columnListHash.value(columnRoleStr, false)) {
-                    columnListHash.insert(columnRoleStr, true);
-                    columnList << columnRoleStr;
+                    if (generateRows && !rowListHash.value(rowRoleStr, false)) {
+                        rowListHash.insert(rowRoleStr, true);
+                        rowList << rowRoleStr;
+                    }
+                    if (generateColumns && !columnListHash.value(columnRoleStr, false)) {
+                        columnListHash.insert(columnRoleStr, true);
+                        columnList << columnRoleStr;
+                    }
                 }
             }
-        }
 
-        if (generateRows)
-            m_proxy->dptr()->m_rowCategories = rowList;
-        else
-            rowList = m_proxy->rowCategories();
-
-        if (generateColumns)
-            m_proxy->dptr()->m_columnCategories = columnList;
-        else
-            columnList = m_proxy->columnCategories();
-
-        // If dimensions have changed, recreate the array
-        if (m_proxyArray != m_proxy->array() || columnList.size() != m_proxy->columnCount()
-                || rowList.size() != m_proxyArray->size()) {
-            m_proxyArray = new QSurfaceDataArray;
-            m_proxyArray->reserve(rowList.size());
-            for (int i = 0; i < rowList.size(); i++)
-                m_proxyArray->append(new QSurfaceDataRow(columnList.size()));
-        }
-        // Create data array from itemValueMap
-        for (int i = 0; i < rowList.size(); i++) {
-            QString rowKey = rowList.at(i);
-            QSurfaceDataRow &newProxyRow = *m_proxyArray->at(i);
-            for (int j = 0; j < columnList.size(); j++) {
-                QVector3D &itemPos = itemValueMap[rowKey][columnList.at(j)];
-                if (cumulative) {
-                    float divisor = float((*matchCountMap)[rowKey][columnList.at(j)]);
-                    if (divisor) {
-                        if (average) {
-                            itemPos /= divisor;
-                        } else { // cumulativeY
-                            itemPos.setX(itemPos.x() / divisor);
-                            itemPos.setZ(itemPos.z() / divisor);
+            if (!generateRows)
+                rowList = rowCategories;
+            if (!generateColumns)
+                columnList = columnCategories;
+
+            // If dimensions have changed, recreate the array
+            if (!proxyArray || columnList.size() != oldColumnCount
+                    || rowList.size() != proxyArray->size()) {
+                proxyArray = new QSurfaceDataArray;
+                proxyArray->reserve(rowList.size());
+                for (int i = 0; i < rowList.size(); i++)
+                    proxyArray->append(new QSurfaceDataRow(columnList.size()));
+            }
+            // Create data array from itemValueMap
+            for (int i = 0; i < rowList.size(); i++) {
+                QString rowKey = rowList.at(i);
+                QSurfaceDataRow &newProxyRow = *proxyArray->at(i);
+                for (int j = 0; j < columnList.size(); j++) {
+                    QVector3D &itemPos = itemValueMap[rowKey][columnList.at(j)];
+                    if (cumulative) {
+                        float divisor = float((*matchCountMap)[rowKey][columnList.at(j)]);
+                        if (divisor) {
+                            if (average) {
+                                itemPos /= divisor;
+                            } else { // cumulativeY
+                                itemPos.setX(itemPos.x() / divisor);
+                                itemPos.setZ(itemPos.z() / divisor);
+                            }
                         }
                     }
+                    newProxyRow[j].setPosition(itemPos);
                 }
-                newProxyRow[j].setPosition(itemPos);
             }
-        }
 
-        delete matchCountMap;
-    }
+            delete matchCountMap;
+        }
 
-    m_proxy->resetArray(m_proxyArray);
+        return [=]() {
+            if (!useModelCategories) {
+                if (generateRows)
+                    m_proxy->dptr()->m_rowCategories = rowList;
+                if (generateColumns)
+                    m_proxy->dptr()->m_columnCategories = columnList;
+            }
+            m_proxyArray = proxyArray;
+            m_proxy->resetArray(proxyArray);
+        };
+    });
 }
 
 QT_END_NAMESPACE
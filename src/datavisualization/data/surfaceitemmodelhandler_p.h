@@ -55,6 +55,10 @@ public:
 public Q_SLOTS:
     void handleDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
                            const QList<int> &roles = QList<int>()) override;
+    void handleRowsInserted(const QModelIndex &parent, int start, int end) override;
+    void handleRowsMoved(const QModelIndex &sourceParent, int sourceStart, int sourceEnd,
+                         const QModelIndex &destinationParent, int destinationRow) override;
+    void handleRowsRemoved(const QModelIndex &parent, int start, int end) override;
 
 protected:
     void resolveModel() override;
@@ -73,6 +77,10 @@ protected:
     bool m_haveXPosPattern;
     bool m_haveYPosPattern;
     bool m_haveZPosPattern;
+
+private:
+    bool mapsRowsDirectly(int rowCount) const;
+    QSurfaceDataArray resolveRows(int startRow, int endRow) const;
 };
 
 QT_END_NAMESPACE
@@ -36,6 +36,7 @@
 #include "qcustom3ditem_p.h"
 #include "qcustom3dlabel_p.h"
 #include "qcustom3dvolume_p.h"
+#include "volumebrickpool_p.h"
 #include "scatter3drenderer_p.h"
 
 #include <QtCore/qmath.h>
@@ -52,6 +53,14 @@ const int polarGridRoundness(64);
 const qreal polarGridAngle(doublePi / qreal(polarGridRoundness));
 const float polarGridAngleDegrees(float(360.0 / qreal(polarGridRoundness)));
 const qreal polarGridHalfAngle(polarGridAngle / 2.0);
+// Frames to wait for the GPU before an asynchronous selection readback is forced to complete
+const int maxSelectionReadbackFrames(2);
+
+#if !QT_CONFIG(opengles2) || defined(GL_ES_VERSION_3_0)
+#  define ASYNC_SELECTION_READBACK 1
+#else
+#  define ASYNC_SELECTION_READBACK 0
+#endif
 
 Abstract3DRenderer::Abstract3DRenderer(Abstract3DController *controller)
     : QObject(0),
@@ -122,7 +131,12 @@ Abstract3DRenderer::Abstract3DRenderer(Abstract3DController *controller)
       m_funcs_2_1(0),
 #endif
       m_context(0),
-      m_isOpenGLES(true)
+      m_isOpenGLES(true),
+      m_instancingSupported(false),
+      m_asyncSelectionSupported(false),
+      m_selectionPixelBuffer(0),
+      m_selectionFence(0),
+      m_selectionReadbackFrames(0)
 
 {
     initializeOpenGLFunctions();
@@ -144,10 +158,14 @@ Abstract3DRenderer::Abstract3DRenderer(Abstract3DController *controller)
     }
 #endif
     QObject::connect(m_drawer, &Drawer::drawerChanged, this, &Abstract3DRenderer::updateTextures);
+    QObject::connect(m_drawer, &Drawer::labelMipmapsDeferred, this,
+                     &Abstract3DRenderer::needRender);
     QObject::connect(this, &Abstract3DRenderer::needRender, controller,
                      &Abstract3DController::needRender, Qt::QueuedConnection);
     QObject::connect(this, &Abstract3DRenderer::requestShadowQuality, controller,
                      &Abstract3DController::handleRequestShadowQuality, Qt::QueuedConnection);
+    QObject::connect(this, &Abstract3DRenderer::requestCustomItemUpdate, controller,
+                     &Abstract3DController::updateCustomItem, Qt::QueuedConnection);
 }
 
 Abstract3DRenderer::~Abstract3DRenderer()
@@ -200,14 +218,34 @@ Abstract3DRenderer::~Abstract3DRenderer()
 
 void Abstract3DRenderer::contextCleanup()
 {
-    if (QOpenGLContext::currentContext())
+    if (QOpenGLContext::currentContext()) {
         m_textureHelper->glDeleteFramebuffers(1, &m_cursorPositionFrameBuffer);
+        releaseSelectionReadback();
+        glDeleteBuffers(1, &m_selectionPixelBuffer);
+        m_selectionPixelBuffer = 0;
+    }
 }
 
 void Abstract3DRenderer::initializeOpenGL()
 {
     m_context = QOpenGLContext::currentContext();
 
+    // Instanced drawing needs OpenGL ES 3.0 or desktop OpenGL 3.3
+    const QSurfaceFormat contextFormat = m_context->format();
+    if (m_context->isOpenGLES())
+        m_instancingSupported = contextFormat.majorVersion() >= 3;
+    else
+        m_instancingSupported = contextFormat.version() >= qMakePair(3, 3);
+
+#if ASYNC_SELECTION_READBACK
+    // Asynchronous selection readback needs pixel buffer objects, mapping of buffer ranges,
+    // and fences, which are in OpenGL ES 3.0 and desktop OpenGL 3.2
+    if (m_context->isOpenGLES())
+        m_asyncSelectionSupported = contextFormat.majorVersion() >= 3;
+    else
+        m_asyncSelectionSupported = contextFormat.version() >= qMakePair(3, 2);
+#endif
+
     // Set OpenGL features
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);
@@ -244,6 +282,8 @@ void Abstract3DRenderer::initializeOpenGL()
 
 void Abstract3DRenderer::render(const GLuint defaultFboHandle)
 {
+    m_drawer->beginFrame();
+
     if (defaultFboHandle) {
         glDepthMask(true);
         glEnable(GL_DEPTH_TEST);
@@ -431,8 +471,17 @@ void Abstract3DRenderer::reInitShaders()
 {
     if (!m_isOpenGLES) {
         if (m_cachedShadowQuality > QAbstract3DGraph::ShadowQualityNone) {
-            if (m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic)
-                    && qobject_cast<Scatter3DRenderer *>(this)) {
+            if (m_instancingSupported && qobject_cast<Scatter3DRenderer *>(this)) {
+                initGradientShaders(QStringLiteral(":/shaders/vertexShadowInstanced"),
+                                    QStringLiteral(":/shaders/fragmentShadowNoTexColorOnY"));
+                initStaticSelectedItemShaders(QStringLiteral(":/shaders/vertexShadow"),
+                                              QStringLiteral(":/shaders/fragmentShadowNoTex"),
+                                              QStringLiteral(":/shaders/vertexShadow"),
+                                              QStringLiteral(":/shaders/fragmentShadowNoTexColorOnY"));
+                initShaders(QStringLiteral(":/shaders/vertexShadowInstanced"),
+                            QStringLiteral(":/shaders/fragmentShadowNoTex"));
+            } else if (m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic)
+                       && qobject_cast<Scatter3DRenderer *>(this)) {
                 initGradientShaders(QStringLiteral(":/shaders/vertexShadow"),
                                     QStringLiteral(":/shaders/fragmentShadow"));
                 initStaticSelectedItemShaders(QStringLiteral(":/shaders/vertexShadow"),
@@ -452,8 +501,17 @@ void Abstract3DRenderer::reInitShaders()
             initCustomItemShaders(QStringLiteral(":/shaders/vertexShadow"),
                                   QStringLiteral(":/shaders/fragmentShadow"));
         } else {
-            if (m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic)
-                    && qobject_cast<Scatter3DRenderer *>(this)) {
+            if (m_instancingSupported && qobject_cast<Scatter3DRenderer *>(this)) {
+                initGradientShaders(QStringLiteral(":/shaders/vertexInstanced"),
+                                    QStringLiteral(":/shaders/fragmentColorOnY"));
+                initStaticSelectedItemShaders(QStringLiteral(":/shaders/vertex"),
+                                              QStringLiteral(":/shaders/fragment"),
+                                              QStringLiteral(":/shaders/vertex"),
+                                              QStringLiteral(":/shaders/fragmentColorOnY"));
+                initShaders(QStringLiteral(":/shaders/vertexInstanced"),
+                            QStringLiteral(":/shaders/fragment"));
+            } else if (m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic)
+                       && qobject_cast<Scatter3DRenderer *>(this)) {
                 initGradientShaders(QStringLiteral(":/shaders/vertexTexture"),
                                     QStringLiteral(":/shaders/fragmentTexture"));
                 initStaticSelectedItemShaders(QStringLiteral(":/shaders/vertex"),
@@ -480,8 +538,17 @@ void Abstract3DRenderer::reInitShaders()
                                  QStringLiteral(":/shaders/vertexPosition"),
                                  QStringLiteral(":/shaders/fragment3DSliceFrames"));
     } else  {
-        if (m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic)
-                && qobject_cast<Scatter3DRenderer *>(this)) {
+        if (m_instancingSupported && qobject_cast<Scatter3DRenderer *>(this)) {
+            initGradientShaders(QStringLiteral(":/shaders/vertexInstanced"),
+                                QStringLiteral(":/shaders/fragmentColorOnYES2"));
+            initStaticSelectedItemShaders(QStringLiteral(":/shaders/vertex"),
+                                          QStringLiteral(":/shaders/fragmentES2"),
+                                          QStringLiteral(":/shaders/vertex"),
+                                          QStringLiteral(":/shaders/fragmentColorOnYES2"));
+            initShaders(QStringLiteral(":/shaders/vertexInstanced"),
+                        QStringLiteral(":/shaders/fragmentES2"));
+        } else if (m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic)
+                   && qobject_cast<Scatter3DRenderer *>(this)) {
             initGradientShaders(QStringLiteral(":/shaders/vertexTexture"),
                                 QStringLiteral(":/shaders/fragmentTextureES2"));
             initStaticSelectedItemShaders(QStringLiteral(":/shaders/vertex"),
@@ -1188,16 +1255,13 @@ CustomRenderItem *Abstract3DRenderer::addCustomItem(QCustom3DItem *item)
         newItem->setTextureWidth(volumeItem->textureWidth());
         newItem->setTextureHeight(volumeItem->textureHeight());
         newItem->setTextureDepth(volumeItem->textureDepth());
-        if (volumeItem->textureFormat() == QImage::Format_Indexed8)
+        if (volumeItem->textureFormat() != QImage::Format_ARGB32)
             newItem->setColorTable(volumeItem->colorTable());
         newItem->setTextureFormat(volumeItem->textureFormat());
+        newItem->setTextureValueType(volumeItem->textureValueType());
         newItem->setVolume(true);
         newItem->setBlendNeeded(true);
-        texture = m_textureHelper->create3DTexture(volumeItem->textureData(),
-                                                   volumeItem->textureWidth(),
-                                                   volumeItem->textureHeight(),
-                                                   volumeItem->textureDepth(),
-                                                   volumeItem->textureFormat());
+        texture = createVolumeTexture(volumeItem, newItem);
         newItem->setSliceIndexX(volumeItem->sliceIndexX());
         newItem->setSliceIndexY(volumeItem->sliceIndexY());
         newItem->setSliceIndexZ(volumeItem->sliceIndexZ());
@@ -1230,6 +1294,35 @@ CustomRenderItem *Abstract3DRenderer::addCustomItem(QCustom3DItem *item)
     return newItem;
 }
 
+GLuint Abstract3DRenderer::createVolumeTexture(QCustom3DVolume *volumeItem,
+                                               CustomRenderItem *renderItem)
+{
+    // The brick pool is updated for all volumes to allow skipping empty bricks when drawing,
+    // but only the volumes that are not pooled are uploaded as a single texture.
+    VolumeBrickPool *bricks = renderItem->volumeBricks();
+    if (!bricks) {
+        bricks = new VolumeBrickPool();
+        renderItem->setVolumeBricks(bricks);
+    }
+    if (!volumeItem->dptr()->hasValidValueType())
+        qWarning("The texture value type of a volume does not match its texture format.");
+    const uchar *textureData = volumeItem->dptr()->textureBytes();
+    bricks->setColorTable(renderItem->colorTable());
+    bricks->setMemoryLimit(qint64(volumeItem->textureMemoryLimit()) * 1024 * 1024);
+    bricks->setData(textureData, volumeItem->textureWidth(), volumeItem->textureHeight(),
+                    volumeItem->textureDepth(), volumeItem->textureFormat(),
+                    volumeItem->textureValueType(),
+                    volumeItem->dptr()->m_textureDataFile != 0);
+    if (!textureData || bricks->isPooled())
+        return 0;
+
+    return m_textureHelper->create3DTexture(textureData, volumeItem->textureWidth(),
+                                            volumeItem->textureHeight(),
+                                            volumeItem->textureDepth(),
+                                            volumeItem->textureFormat(),
+                                            volumeItem->textureValueType());
+}
+
 void Abstract3DRenderer::recalculateCustomItemScalingAndPos(CustomRenderItem *item)
 {
     if (!m_polarGraph && !item->isLabel() && !item->isScalingAbsolute()
@@ -1388,26 +1481,53 @@ void Abstract3DRenderer::updateCustomItem(CustomRenderItem *renderItem)
         QCustom3DVolume *volumeItem = static_cast<QCustom3DVolume *>(item);
         if (volumeItem->dptr()->m_dirtyBitsVolume.colorTableDirty) {
             renderItem->setColorTable(volumeItem->colorTable());
+            if (renderItem->volumeBricks())
+                renderItem->volumeBricks()->setColorTable(renderItem->colorTable());
             volumeItem->dptr()->m_dirtyBitsVolume.colorTableDirty = false;
         }
+        if (volumeItem->dptr()->m_dirtyBitsVolume.textureMemoryLimitDirty) {
+            if (renderItem->volumeBricks()) {
+                renderItem->volumeBricks()->setMemoryLimit(
+                            qint64(volumeItem->textureMemoryLimit()) * 1024 * 1024);
+            }
+            volumeItem->dptr()->m_dirtyBitsVolume.textureMemoryLimitDirty = false;
+        }
         if (volumeItem->dptr()->m_dirtyBitsVolume.textureDimensionsDirty
                 || volumeItem->dptr()->m_dirtyBitsVolume.textureDataDirty
                 || volumeItem->dptr()->m_dirtyBitsVolume.textureFormatDirty) {
             GLuint oldTexture = renderItem->texture();
             m_textureHelper->deleteTexture(&oldTexture);
-            GLuint texture = m_textureHelper->create3DTexture(volumeItem->textureData(),
-                                                              volumeItem->textureWidth(),
-                                                              volumeItem->textureHeight(),
-                                                              volumeItem->textureDepth(),
-                                                              volumeItem->textureFormat());
-            renderItem->setTexture(texture);
             renderItem->setTextureWidth(volumeItem->textureWidth());
             renderItem->setTextureHeight(volumeItem->textureHeight());
             renderItem->setTextureDepth(volumeItem->textureDepth());
             renderItem->setTextureFormat(volumeItem->textureFormat());
+            renderItem->setTextureValueType(volumeItem->textureValueType());
+            renderItem->setTexture(createVolumeTexture(volumeItem, renderItem));
             volumeItem->dptr()->m_dirtyBitsVolume.textureDimensionsDirty = false;
             volumeItem->dptr()->m_dirtyBitsVolume.textureDataDirty = false;
+            volumeItem->dptr()->m_dirtyBitsVolume.subTextureDataDirty = false;
             volumeItem->dptr()->m_dirtyBitsVolume.textureFormatDirty = false;
+            volumeItem->dptr()->m_dirtySubTextures.clear();
+        } else if (volumeItem->dptr()->m_dirtyBitsVolume.subTextureDataDirty) {
+            // Only the slices changed with setSubTextureData() need to be uploaded
+            typedef QPair<Qt::Axis, int> DirtySlice;
+            VolumeBrickPool *bricks = renderItem->volumeBricks();
+            foreach (const DirtySlice &slice, volumeItem->dptr()->m_dirtySubTextures) {
+                if (!bricks->isPooled()) {
+                    m_textureHelper->update3DTextureSlice(renderItem->texture(),
+                                                          volumeItem->textureData(),
+                                                          volumeItem->textureWidth(),
+                                                          volumeItem->textureHeight(),
+                                                          volumeItem->textureDepth(),
+                                                          volumeItem->textureFormat(),
+                                                          slice.first, slice.second,
+                                                          volumeItem->textureValueType());
+                }
+                bricks->updateSlice(volumeItem->dptr()->textureBytes(), slice.first,
+                                    slice.second);
+            }
+            volumeItem->dptr()->m_dirtyBitsVolume.subTextureDataDirty = false;
+            volumeItem->dptr()->m_dirtySubTextures.clear();
         }
         if (volumeItem->dptr()->m_dirtyBitsVolume.slicesDirty) {
             renderItem->setDrawSlices(volumeItem->drawSlices());
@@ -1430,6 +1550,8 @@ void Abstract3DRenderer::updateCustomItem(CustomRenderItem *renderItem)
             renderItem->setUseHighDefShader(volumeItem->useHighDefShader());
             volumeItem->dptr()->m_dirtyBitsVolume.shaderDirty = false;
         }
+        // Pooled volumes load some of their missing bricks on each sync
+        renderItem->volumeBricks()->loadBricks(volumeItem->dptr()->textureBytes());
     }
 }
 
@@ -1464,6 +1586,7 @@ void Abstract3DRenderer::drawCustomItems(RenderingState state,
 
     // Draw custom items - first regular and then volumes
     bool volumeDetected = false;
+    bool bricksPending = false;
     int loopCount = 0;
     while (loopCount < 2) {
         for (QCustom3DItem *customItem : qAsConst(m_customItemDrawOrder)) {
@@ -1594,7 +1717,13 @@ void Abstract3DRenderer::drawCustomItems(RenderingState state,
                                       + ((oneVector - cameraPos) * item->minBoundsNormal())
                                       - ((oneVector + cameraPos) * (oneVector - item->maxBoundsNormal())));
                         shader->setUniformValue(shader->cameraPositionRelativeToModel(), cameraPos);
-                        GLint color8Bit = (item->textureFormat() == QImage::Format_Indexed8) ? 1 : 0;
+                        // 1 for indexed colors, 2 for 16-bit and float values mapped over the
+                        // color table
+                        GLint color8Bit = 0;
+                        if (item->textureFormat() == QImage::Format_Indexed8)
+                            color8Bit = 1;
+                        else if (item->textureFormat() != QImage::Format_ARGB32)
+                            color8Bit = 2;
                         if (color8Bit) {
                             shader->setUniformValueArray(shader->colorIndex(),
                                                          item->colorTable().constData(), 256);
@@ -1607,16 +1736,38 @@ void Abstract3DRenderer::drawCustomItems(RenderingState state,
                         shader->setUniformValue(shader->minBounds(), item->minBounds());
                         shader->setUniformValue(shader->maxBounds(), item->maxBounds());
 
+                        // Precalculate texture dimensions so we can optimize
+                        // ray stepping to hit every texture layer.
+                        QVector3D textureDimensions(1.0f / float(item->textureWidth()),
+                                                    1.0f / float(item->textureHeight()),
+                                                    1.0f / float(item->textureDepth()));
+                        shader->setUniformValue(shader->textureDimensions(), textureDimensions);
+
+#if !QT_CONFIG(opengles2)
+                        // Bricks of pooled volumes are loaded nearest to the camera first.
+                        // Y and Z are flipped in texture coordinates.
+                        VolumeBrickPool *bricks = item->volumeBricks();
+                        QVector3D viewPosition(cameraPos.x(), -cameraPos.y(), -cameraPos.z());
+                        if (bricks->setViewPosition(0.5f * (viewPosition + oneVector)))
+                            bricksPending = true;
+                        glActiveTexture(GL_TEXTURE3);
+                        glBindTexture(GL_TEXTURE_3D, bricks->brickTexture());
+                        shader->setUniformValue(shader->brickSampler(), 3);
+                        shader->setUniformValue(shader->brickDimensions(),
+                                                bricks->brickDimensions());
+                        shader->setUniformValue(shader->brickCounts(), bricks->brickCounts());
+                        shader->setUniformValue(shader->poolBrickDimensions(),
+                                                bricks->poolBrickDimensions());
+                        GLuint volumeTexture = bricks->isPooled() ? bricks->poolTexture()
+                                                                  : item->texture();
+#else
+                        GLuint volumeTexture = item->texture();
+#endif
+
                         if (shader == m_volumeTextureSliceShader) {
                             shader->setUniformValue(shader->volumeSliceIndices(),
                                                     item->sliceFractions());
                         } else {
-                            // Precalculate texture dimensions so we can optimize
-                            // ray stepping to hit every texture layer.
-                            QVector3D textureDimensions(1.0f / float(item->textureWidth()),
-                                                        1.0f / float(item->textureHeight()),
-                                                        1.0f / float(item->textureDepth()));
-
                             // Worst case scenario sample count
                             int sampleCount;
                             if (shader == m_volumeTextureLowDefShader) {
@@ -1630,7 +1781,6 @@ void Abstract3DRenderer::drawCustomItems(RenderingState state,
                                 sampleCount = item->textureWidth() + item->textureHeight()
                                         + item->textureDepth();
                             }
-                            shader->setUniformValue(shader->textureDimensions(), textureDimensions);
                             shader->setUniformValue(shader->sampleCount(), sampleCount);
                         }
                         if (item->drawSliceFrames()) {
@@ -1651,7 +1801,12 @@ void Abstract3DRenderer::drawCustomItems(RenderingState state,
                             glEnable(GL_CULL_FACE);
                             shader->bind();
                         }
-                        m_drawer->drawObject(shader, item->mesh(), 0, 0, item->texture());
+                        m_drawer->drawObject(shader, item->mesh(), 0, 0, volumeTexture);
+#if !QT_CONFIG(opengles2)
+                        glActiveTexture(GL_TEXTURE3);
+                        glBindTexture(GL_TEXTURE_3D, 0);
+                        glActiveTexture(GL_TEXTURE0);
+#endif
                     } else {
                         shader->setUniformValue(shader->lightS(), m_cachedTheme->lightStrength());
                         m_drawer->drawObject(shader, item->mesh(), item->texture());
@@ -1676,6 +1831,10 @@ void Abstract3DRenderer::drawCustomItems(RenderingState state,
             loopCount++; // Skip second run if no volumes detected
     }
 
+    // Missing bricks can only be loaded when the volume data is synchronized
+    if (bricksPending)
+        emit requestCustomItemUpdate();
+
     if (RenderingNormal == state) {
         glDisable(GL_BLEND);
         glEnable(GL_CULL_FACE);
@@ -1841,6 +2000,88 @@ void Abstract3DRenderer::queriedGraphPosition(const QMatrix4x4 &projectionViewMa
     m_graphPositionQueryPending = false;
 }
 
+// Reads the selection color at the input position from the bound selection buffer. When
+// supported, the pixel is read asynchronously into a pixel buffer object to avoid stalling
+// the pipeline, and false is returned. The color is then available from
+// finishSelectionReadback() on one of the following frames.
+bool Abstract3DRenderer::readSelection(QVector4D &color)
+{
+    if (!m_asyncSelectionSupported) {
+        color = Utils::getSelection(m_inputPosition, m_viewport.height());
+        return true;
+    }
+
+#if ASYNC_SELECTION_READBACK
+    QOpenGLExtraFunctions *extraFunctions = m_context->extraFunctions();
+    releaseSelectionReadback();
+    if (!m_selectionPixelBuffer)
+        glGenBuffers(1, &m_selectionPixelBuffer);
+
+    // Pixels outside the buffer are not written, so default to the skip color
+    static const GLubyte skipPixel[4] = {255, 255, 255, 255};
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_selectionPixelBuffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(skipPixel), skipPixel, GL_STREAM_READ);
+    glReadPixels(m_inputPosition.x(), m_viewport.height() - m_inputPosition.y(), 1, 1,
+                 GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_selectionFence = extraFunctions->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_selectionReadbackFrames = 0;
+#endif
+    return false;
+}
+
+// Returns true if an asynchronous selection readback is waiting for the GPU. Readbacks of
+// queries that have been cancelled in the meantime are discarded. A readback is allowed to
+// complete even if the input position has moved since, as otherwise a selection query that
+// follows the cursor on every frame would never be resolved. The renderers decode the color
+// against the state they saved when drawing the selection buffer.
+bool Abstract3DRenderer::selectionReadbackPending()
+{
+    if (!m_selectionFence)
+        return false;
+
+    if (m_selectionState != SelectOnScene) {
+        releaseSelectionReadback();
+        return false;
+    }
+    return true;
+}
+
+// Returns true and the selection color once the GPU has written the pixel, or the readback
+// has waited for the maximum number of frames. Mapping the buffer then waits for the GPU.
+bool Abstract3DRenderer::finishSelectionReadback(QVector4D &color)
+{
+    color = QVector4D(255.0f, 255.0f, 255.0f, 255.0f);
+#if ASYNC_SELECTION_READBACK
+    QOpenGLExtraFunctions *extraFunctions = m_context->extraFunctions();
+    GLint status = GL_UNSIGNALED;
+    extraFunctions->glGetSynciv(m_selectionFence, GL_SYNC_STATUS, 1, 0, &status);
+    if (status != GL_SIGNALED && ++m_selectionReadbackFrames < maxSelectionReadbackFrames)
+        return false;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_selectionPixelBuffer);
+    const GLubyte *pixel = static_cast<const GLubyte *>(
+                extraFunctions->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, 4, GL_MAP_READ_BIT));
+    if (pixel) {
+        color = QVector4D(pixel[0], pixel[1], pixel[2], pixel[3]);
+        extraFunctions->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    releaseSelectionReadback();
+#endif
+    return true;
+}
+
+void Abstract3DRenderer::releaseSelectionReadback()
+{
+#if ASYNC_SELECTION_READBACK
+    if (m_selectionFence && m_context)
+        m_context->extraFunctions()->glDeleteSync(m_selectionFence);
+#endif
+    m_selectionFence = 0;
+}
+
 void Abstract3DRenderer::calculatePolarXZ(const QVector3D &dataPos, float &x, float &z) const
 {
     // x is angular, z is radial
@@ -41,6 +41,7 @@
 #define ABSTRACT3DRENDERER_P_H
 
 #include <QtGui/QOpenGLFunctions>
+#include <QtGui/QOpenGLExtraFunctions>
 #if !QT_CONFIG(opengles2)
 #  include <QtOpenGL/QOpenGLFunctions_2_1>
 #endif
@@ -57,6 +58,7 @@ QT_BEGIN_NAMESPACE
 class TextureHelper;
 class Theme;
 class Drawer;
+class QCustom3DVolume;
 
 class Abstract3DRenderer : public QObject, protected QOpenGLFunctions
 {
@@ -148,6 +150,7 @@ public:
 
     virtual CustomRenderItem *addCustomItem(QCustom3DItem *item);
     virtual void updateCustomItem(CustomRenderItem *renderItem);
+    GLuint createVolumeTexture(QCustom3DVolume *volumeItem, CustomRenderItem *renderItem);
 
     virtual void updateAspectRatio(float ratio);
     virtual void updateHorizontalAspectRatio(float ratio);
@@ -187,6 +190,7 @@ public:
 Q_SIGNALS:
     void needRender(); // Emit this if something in renderer causes need for another render pass.
     void requestShadowQuality(QAbstract3DGraph::ShadowQuality quality); // For automatic quality adjustments
+    void requestCustomItemUpdate(); // Emit this if custom items need another sync, e.g. to load volume bricks
 
 protected:
     Abstract3DRenderer(Abstract3DController *controller);
@@ -242,6 +246,10 @@ protected:
                               const QMatrix4x4 &projectionViewMatrix);
     void queriedGraphPosition(const QMatrix4x4 &projectionViewMatrix, const QVector3D &scaling,
                               GLuint defaultFboHandle);
+    bool readSelection(QVector4D &color);
+    bool selectionReadbackPending();
+    bool finishSelectionReadback(QVector4D &color);
+    void releaseSelectionReadback();
 
     bool m_hasNegativeValues;
     Q3DTheme *m_cachedTheme;
@@ -338,6 +346,12 @@ protected:
 #endif
     QPointer<QOpenGLContext> m_context; // Not owned
     bool m_isOpenGLES;
+    bool m_instancingSupported;
+    bool m_asyncSelectionSupported;
+    // Pixel buffer and fence of the pending asynchronous selection readback
+    GLuint m_selectionPixelBuffer;
+    GLsync m_selectionFence;
+    int m_selectionReadbackFrames;
 
 private:
     friend class Abstract3DController;
@@ -28,9 +28,14 @@
 ****************************************************************************/
 
 #include "axisrendercache_p.h"
+#include "qvalue3daxisformatter_p.h"
 
 #include <QtGui/QFontMetrics>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 QT_BEGIN_NAMESPACE
 
 AxisRenderCache::AxisRenderCache()
@@ -194,6 +199,41 @@ void AxisRenderCache::clearLabels()
         m_labelItems[i]->clear();
 }
 
+void AxisRenderCache::positionsAt(const float *values, float *positions, int count) const
+{
+    formatterPositionsAt(values, positions, count);
+
+    // A reversed axis maps position p to 1 - p first
+    const float sign = m_reversed ? -1.0f : 1.0f;
+    const float offset = m_reversed ? 1.0f : 0.0f;
+    int i = 0;
+
+#if defined(__SSE2__)
+    const __m128 signs = _mm_set1_ps(sign);
+    const __m128 offsets = _mm_set1_ps(offset);
+    const __m128 scale = _mm_set1_ps(m_scale);
+    const __m128 translate = _mm_set1_ps(m_translate);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 p = _mm_add_ps(offsets, _mm_mul_ps(signs, _mm_loadu_ps(positions + i)));
+        _mm_storeu_ps(positions + i, _mm_add_ps(_mm_mul_ps(p, scale), translate));
+    }
+#endif
+
+    for (; i < count; i++)
+        positions[i] = (offset + sign * positions[i]) * m_scale + m_translate;
+}
+
+void AxisRenderCache::formatterPositionsAt(const float *values, float *positions,
+                                           int count) const
+{
+    m_formatter->d_ptr->positionsAt(values, positions, count);
+}
+
+bool AxisRenderCache::hasBuiltInFormatter() const
+{
+    return m_formatter && m_formatter->d_ptr->hasBuiltInPositions();
+}
+
 int AxisRenderCache::maxLabelWidth(const QStringList &labels) const
 {
     int labelWidth = 0;
@@ -111,6 +111,11 @@ public:
         else
             return m_formatter->positionAt(value) * m_scale + m_translate;
     }
+    // Resolve positionAt() and the formatter positionAt() for count values at once
+    void positionsAt(const float *values, float *positions, int count) const;
+    void formatterPositionsAt(const float *values, float *positions, int count) const;
+    // Reimplemented formatters may only be called in the rendering thread
+    bool hasBuiltInFormatter() const;
     inline float labelAutoRotation() const { return m_labelAutoRotation; }
     inline void setLabelAutoRotation(float angle) { m_labelAutoRotation = angle; }
     inline bool isTitleVisible() const { return m_titleVisible; }
@@ -33,8 +33,14 @@
 #include "texturehelper_p.h"
 #include "utils_p.h"
 #include "barseriesrendercache_p.h"
+#include "objecthelper_p.h"
+#include "raypicker_p.h"
+#include "viewfrustum_p.h"
 
 #include <QtCore/qmath.h>
+#include <QtCore/QVarLengthArray>
+
+#include <limits>
 
 // You can verify that depth buffer drawing works correctly by uncommenting this.
 // You should see the scene from  where the light is
@@ -91,7 +97,9 @@ Bars3DRenderer::Bars3DRenderer(Bars3DController *controller)
       m_xScaleFactor(1.0f),
       m_zScaleFactor(1.0f),
       m_floorLevel(0.0f),
-      m_actualFloorLevel(0.0f)
+      m_actualFloorLevel(0.0f),
+      m_selectionMinRow(0),
+      m_selectionMinColumn(0)
 {
     m_axisCacheY.setScale(2.0f);
     m_axisCacheY.setTranslate(-1.0f);
@@ -245,15 +253,25 @@ void Bars3DRenderer::updateData()
                 dataRowCount = dataProxy->rowCount();
                 if (maxDataRowCount < dataRowCount)
                     maxDataRowCount = qMin(dataRowCount, newRows);
-                int dataRowIndex = minRow;
-                for (int i = 0; i < newRows; i++) {
-                    BarRenderItemRow &renderRow = renderArray[i];
-                    const QBarDataRow *dataRow = 0;
-                    if (dataRowIndex < dataRowCount)
-                        dataRow = dataProxy->rowAt(dataRowIndex);
-                    updateRenderRow(dataRow, renderRow);
-                    dataRowIndex++;
-                }
+                // Large arrays are updated in parallel, one range of rows per thread, unless
+                // the value axis has a reimplemented formatter
+                BarRenderItemRow *renderRows = renderArray.data();
+                auto updateRows = [this, renderRows, dataProxy, dataRowCount, minRow](int begin,
+                                                                                    int end) {
+                    int dataRowIndex = minRow + begin;
+                    for (int i = begin; i < end; i++) {
+                        const QBarDataRow *dataRow = 0;
+                        if (dataRowIndex < dataRowCount)
+                            dataRow = dataProxy->rowAt(dataRowIndex);
+                        updateRenderRow(dataRow, renderRows[i]);
+                        dataRowIndex++;
+                    }
+                };
+                if (m_axisCacheY.hasBuiltInFormatter())
+                    Utils::parallelFor(newRows, updateRows, newColumns);
+                else
+                    updateRows(0, newRows);
+                cache->setBlockHeightsDirty();
                 cache->setDataDirty(false);
             }
         }
@@ -272,10 +290,16 @@ void Bars3DRenderer::updateRenderRow(const QBarDataRow *dataRow, BarRenderItemRo
 
     if (dataRow) {
         int updateSize = qMin((dataRow->size() - startIndex), renderRowSize);
-        int dataColIndex = startIndex;
-        for (; j < updateSize ; j++) {
-            updateRenderItem(dataRow->at(dataColIndex), renderRow[j]);
-            dataColIndex++;
+        if (updateSize > 0) {
+            // Resolve the heights of the row with one formatter call
+            const QBarDataItem *dataItems = dataRow->constData() + startIndex;
+            QVarLengthArray<float, 256> values(updateSize);
+            QVarLengthArray<float, 256> positions(updateSize);
+            for (int i = 0; i < updateSize; i++)
+                values[i] = dataItems[i].value();
+            m_axisCacheY.formatterPositionsAt(values.constData(), positions.data(), updateSize);
+            for (; j < updateSize ; j++)
+                updateRenderItem(dataItems[j], positions.at(j), renderRow[j]);
         }
     }
     for (; j < renderRowSize; j++) {
@@ -286,9 +310,16 @@ void Bars3DRenderer::updateRenderRow(const QBarDataRow *dataRow, BarRenderItemRo
 }
 
 void Bars3DRenderer::updateRenderItem(const QBarDataItem &dataItem, BarRenderItem &renderItem)
+{
+    updateRenderItem(dataItem, m_axisCacheY.formatter()->positionAt(dataItem.value()),
+                     renderItem);
+}
+
+void Bars3DRenderer::updateRenderItem(const QBarDataItem &dataItem, float position,
+                                      BarRenderItem &renderItem)
 {
     float value = dataItem.value();
-    float heightValue = m_axisCacheY.formatter()->positionAt(value);
+    float heightValue = position;
     if (m_noZeroInRange) {
         if (m_hasNegativeValues) {
             heightValue = -1.0f + heightValue;
@@ -383,6 +414,7 @@ void Bars3DRenderer::updateRows(const QList<Bars3DController::ChangeRow> &rows)
         }
         if (cache->isVisible()) {
             updateRenderRow(dataArray->at(row), cache->renderArray()[row - minRow]);
+            cache->setBlockHeightsDirty();
             if (m_cachedIsSlicingActivated
                     && cache == m_selectedSeriesCache
                     && m_selectedBarPos.x() == row) {
@@ -420,6 +452,7 @@ void Bars3DRenderer::updateItems(const QList<Bars3DController::ChangeItem> &item
         if (cache->isVisible()) {
             updateRenderItem(dataArray->at(row)->at(col),
                              cache->renderArray()[row - minRow][col - minCol]);
+            cache->setBlockHeightsDirty();
             if (m_cachedIsSlicingActivated
                     && cache == m_selectedSeriesCache
                     && m_selectedBarPos == QPoint(row, col)) {
@@ -1045,6 +1078,7 @@ void Bars3DRenderer::drawScene(GLuint defaultFboHandle)
     QMatrix4x4 depthProjectionViewMatrix;
 
     QMatrix4x4 projectionViewMatrix = projectionMatrix * viewMatrix;
+    const ViewFrustum viewFrustum(projectionViewMatrix);
 
     BarRenderItem *selectedBar(0);
 
@@ -1072,6 +1106,7 @@ void Bars3DRenderer::drawScene(GLuint defaultFboHandle)
         // Set the depth projection matrix
         depthProjectionMatrix.perspective(10.0f, viewPortRatio, 3.0f, 100.0f);
         depthProjectionViewMatrix = depthProjectionMatrix * depthViewMatrix;
+        const ViewFrustum depthFrustum(depthProjectionViewMatrix);
 
         // Draw bars to depth buffer
         QVector3D shadowScaler(m_scaleX * m_seriesScaleX * 0.9f, 0.0f,
@@ -1085,9 +1120,14 @@ void Bars3DRenderer::drawScene(GLuint defaultFboHandle)
                 ObjectHelper *barObj = cache->object();
                 QQuaternion seriesRotation(cache->meshRotation());
                 const BarRenderItemArray &renderArray = cache->renderArray();
+                cullBarBlocks(cache, depthFrustum, seriesPos);
                 for (int row = startRow; row != stopRow; row += stepRow) {
                     const BarRenderItemRow &renderRow = renderArray.at(row);
                     for (int bar = startBar; bar != stopBar; bar += stepBar) {
+                        if (!cache->isBlockVisible(row, bar)) {
+                            bar = BarSeriesRenderCache::blockEnd(bar, stepBar, stopBar);
+                            continue;
+                        }
                         const BarRenderItem &item = renderRow.at(bar);
                         if (!item.value())
                             continue;
@@ -1183,10 +1223,22 @@ void Bars3DRenderer::drawScene(GLuint defaultFboHandle)
     }
 
     // Skip selection mode drawing if we're slicing or have no selection mode
-    if (!m_cachedIsSlicingActivated && m_cachedSelectionMode > QAbstract3DGraph::SelectionNone
+    QVector4D clickedColor;
+    if (selectionReadbackPending()) {
+        // Resolve the click when the color read on an earlier frame is available
+        if (finishSelectionReadback(clickedColor)) {
+            m_clickedPosition = selectionColorToArrayPosition(clickedColor);
+            m_clickedSeries = selectionColorToSeries(clickedColor);
+            m_clickResolved = true;
+        }
+        emit needRender();
+    } else if (!m_cachedIsSlicingActivated
+               && m_cachedSelectionMode > QAbstract3DGraph::SelectionNone
             && m_selectionState == SelectOnScene
             && (m_visibleSeriesCount > 0 || !m_customRenderCache.isEmpty())
-            && m_selectionTexture) {
+            && m_selectionTexture && !pickBar(projectionViewMatrix)) {
+        saveSelectionState();
+
         // Bind selection shader
         m_selectionShader->bind();
 
@@ -1209,9 +1261,14 @@ void Bars3DRenderer::drawScene(GLuint defaultFboHandle)
                 ObjectHelper *barObj = cache->object();
                 QQuaternion seriesRotation(cache->meshRotation());
                 const BarRenderItemArray &renderArray = cache->renderArray();
+                cullBarBlocks(cache, viewFrustum, seriesPos);
                 for (int row = startRow; row != stopRow; row += stepRow) {
                     const BarRenderItemRow &renderRow = renderArray.at(row);
                     for (int bar = startBar; bar != stopBar; bar += stepBar) {
+                        if (!cache->isBlockVisible(row, bar)) {
+                            bar = BarSeriesRenderCache::blockEnd(bar, stepBar, stopBar);
+                            continue;
+                        }
                         const BarRenderItem &item = renderRow.at(bar);
                         if (!item.value())
                             continue;
@@ -1262,10 +1319,11 @@ void Bars3DRenderer::drawScene(GLuint defaultFboHandle)
         glEnable(GL_DITHER);
 
         // Read color under cursor
-        QVector4D clickedColor = Utils::getSelection(m_inputPosition, m_viewport.height());
-        m_clickedPosition = selectionColorToArrayPosition(clickedColor);
-        m_clickedSeries = selectionColorToSeries(clickedColor);
-        m_clickResolved = true;
+        if (readSelection(clickedColor)) {
+            m_clickedPosition = selectionColorToArrayPosition(clickedColor);
+            m_clickedSeries = selectionColorToSeries(clickedColor);
+            m_clickResolved = true;
+        }
 
         emit needRender();
 
@@ -1462,6 +1520,9 @@ bool Bars3DRenderer::drawBars(BarRenderItem **selectedBar,
     QVector3D modelScaler(m_scaleX * m_seriesScaleX, 0.0f, m_scaleZ * m_seriesScaleZ);
     bool somethingSelected =
             (m_visualSelectedBarPos != Bars3DController::invalidSelectionPosition());
+    // The slice view is collected from the bars while drawing them, so nothing is culled then
+    const ViewFrustum frustum(projectionViewMatrix);
+    const bool culling = !m_cachedIsSlicingActivated;
     foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
         if (baseCache->isVisible()) {
             BarSeriesRenderCache *cache = static_cast<BarSeriesRenderCache *>(baseCache);
@@ -1501,9 +1562,15 @@ bool Bars3DRenderer::drawBars(BarRenderItem **selectedBar,
             }
 
             previousColorStyle = colorStyle;
+            if (culling)
+                cullBarBlocks(cache, frustum, seriesPos, reflection);
             for (int row = startRow; row != stopRow; row += stepRow) {
                 BarRenderItemRow &renderRow = renderArray[row];
                 for (int bar = startBar; bar != stopBar; bar += stepBar) {
+                    if (culling && !cache->isBlockVisible(row, bar)) {
+                        bar = BarSeriesRenderCache::blockEnd(bar, stepBar, stopBar);
+                        continue;
+                    }
                     BarRenderItem &item = renderRow[bar];
                     float adjustedHeight = reflection * item.height();
                     if (adjustedHeight < 0)
@@ -2062,6 +2129,7 @@ void Bars3DRenderer::drawLabels(bool drawSelection, const Q3DCamera *activeCamer
 
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        m_drawer->beginLabels();
     }
 
     glEnable(GL_POLYGON_OFFSET_FILL);
@@ -2441,6 +2509,8 @@ void Bars3DRenderer::drawLabels(bool drawSelection, const Q3DCamera *activeCamer
                         shader, m_labelObj, activeCamera,
                         true, false, Drawer::LabelMid, Qt::AlignHCenter, false, drawSelection);
 #endif
+    if (!drawSelection)
+        m_drawer->endLabels();
     glDisable(GL_POLYGON_OFFSET_FILL);
 }
 
@@ -2721,8 +2791,8 @@ QPoint Bars3DRenderer::selectionColorToArrayPosition(const QVector4D &selectionC
     m_selectedCustomItemIndex = -1;
     if (selectionColor.w() == itemAlpha) {
         // Normal selection item
-        position = QPoint(int(selectionColor.x() + int(m_axisCacheZ.min())),
-                          int(selectionColor.y()) + int(m_axisCacheX.min()));
+        position = QPoint(int(selectionColor.x()) + m_selectionMinRow,
+                          int(selectionColor.y()) + m_selectionMinColumn);
         // Pass item clicked info to input handler
         m_clickedType = QAbstract3DGraph::ElementSeries;
     } else if (selectionColor.w() == labelRowAlpha) {
@@ -2730,7 +2800,7 @@ QPoint Bars3DRenderer::selectionColorToArrayPosition(const QVector4D &selectionC
         if (m_cachedSelectionMode.testFlag(QAbstract3DGraph::SelectionRow)) {
             // Use column from previous selection in case we have row + column mode
             GLint previousCol = qMax(0, m_selectedBarPos.y()); // Use 0 if previous is invalid
-            position = QPoint(int(selectionColor.x() + int(m_axisCacheZ.min())), previousCol);
+            position = QPoint(int(selectionColor.x()) + m_selectionMinRow, previousCol);
         }
         m_selectedLabelIndex = selectionColor.x();
         // Pass label clicked info to input handler
@@ -2740,7 +2810,7 @@ QPoint Bars3DRenderer::selectionColorToArrayPosition(const QVector4D &selectionC
         if (m_cachedSelectionMode.testFlag(QAbstract3DGraph::SelectionColumn)) {
             // Use row from previous selection in case we have row + column mode
             GLint previousRow = qMax(0, m_selectedBarPos.x()); // Use 0 if previous is invalid
-            position = QPoint(previousRow, int(selectionColor.y()) + int(m_axisCacheX.min()));
+            position = QPoint(previousRow, int(selectionColor.y()) + m_selectionMinColumn);
         }
         m_selectedLabelIndex = selectionColor.y();
         // Pass label clicked info to input handler
@@ -2764,17 +2834,210 @@ QPoint Bars3DRenderer::selectionColorToArrayPosition(const QVector4D &selectionC
 
 QBar3DSeries *Bars3DRenderer::selectionColorToSeries(const QVector4D &selectionColor)
 {
-    if (selectionColor == selectionSkipColor) {
+    if (selectionColor == selectionSkipColor)
         return 0;
-    } else {
-        int seriesIndexFromColor(selectionColor.z());
+    // The series may have been removed after the selection buffer was drawn
+    return m_selectionSeries.value(int(selectionColor.z())).data();
+}
+
+void Bars3DRenderer::saveSelectionState()
+{
+    m_selectionMinRow = int(m_axisCacheZ.min());
+    m_selectionMinColumn = int(m_axisCacheX.min());
+    m_selectionSeries.clear();
+    foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+        BarSeriesRenderCache *cache = static_cast<BarSeriesRenderCache *>(baseCache);
+        m_selectionSeries.insert(cache->visualIndex(), cache->series());
+    }
+}
+
+// Resolves the click by walking the bar grid cells along a ray cast from the selection
+// position. Returns false if the selection buffer needs to be drawn to resolve the click,
+// which is the case when the ray hits nothing, as the click may be on a label, when the bar is
+// behind the floor or an axis label, or when there are custom items.
+bool Bars3DRenderer::pickBar(const QMatrix4x4 &projectionViewMatrix)
+{
+    if (!m_customRenderCache.isEmpty() || !m_cachedRowCount || !m_cachedColumnCount)
+        return false;
+
+    RayPicker::Ray ray;
+    if (!RayPicker::selectionRay(m_inputPosition, m_primarySubViewport.size(),
+                                 m_viewport.height(), projectionViewMatrix, ray)) {
+        return false;
+    }
+
+    // Clip the ray to the area covered by the bars
+    const float infinity = std::numeric_limits<float>::max();
+    float tNear;
+    float tFar;
+    if (!RayPicker::intersectBox(ray,
+                                 QVector3D(-m_rowWidth / m_scaleFactor, -infinity,
+                                           -m_columnDepth / m_scaleFactor),
+                                 QVector3D(m_rowWidth / m_scaleFactor, infinity,
+                                           m_columnDepth / m_scaleFactor),
+                                 tNear, tFar)) {
+        return false;
+    }
+
+    // Walk the cells in grid units, where the columns grow along x and the rows along -z
+    const float columnsPerUnit = m_scaleFactor / float(m_cachedBarSpacing.width());
+    const float rowsPerUnit = m_scaleFactor / float(m_cachedBarSpacing.height());
+    const QVector3D entry = ray.origin + tNear * ray.direction;
+    const float u = (entry.x() + m_rowWidth / m_scaleFactor) * columnsPerUnit;
+    const float v = (m_columnDepth / m_scaleFactor - entry.z()) * rowsPerUnit;
+    const float du = ray.direction.x() * columnsPerUnit;
+    const float dv = -ray.direction.z() * rowsPerUnit;
+    int column = qBound(0, int(u), m_cachedColumnCount - 1);
+    int row = qBound(0, int(v), m_cachedRowCount - 1);
+    const int stepColumn = du < 0.0f ? -1 : 1;
+    const int stepRow = dv < 0.0f ? -1 : 1;
+    float tNextColumn = du != 0.0f ? tNear + (float(column + (du > 0.0f)) - u) / du : infinity;
+    float tNextRow = dv != 0.0f ? tNear + (float(row + (dv > 0.0f)) - v) / dv : infinity;
+    const float tDeltaColumn = du != 0.0f ? qAbs(1.0f / du) : infinity;
+    const float tDeltaRow = dv != 0.0f ? qAbs(1.0f / dv) : infinity;
+
+    float closestDistance = infinity;
+    BarSeriesRenderCache *closestCache = 0;
+    QPoint closestPosition;
+    float tCell = tNear;
+    // Rotated bars may reach the neighboring cells, so those are tested as well. The walk can
+    // stop once the ray enters a cell beyond the closest hit.
+    while (tCell <= tFar && tCell <= closestDistance) {
         foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+            if (!baseCache->isVisible())
+                continue;
             BarSeriesRenderCache *cache = static_cast<BarSeriesRenderCache *>(baseCache);
-            if (cache->visualIndex() == seriesIndexFromColor)
-                return cache->series();
+            const float seriesPos = m_seriesStart + m_seriesStep
+                    * (cache->visualIndex() - (cache->visualIndex()
+                                               * m_cachedBarSeriesMargin.width())) + 0.5f;
+            const ObjectHelper *barObj = cache->object();
+            const QQuaternion seriesRotation(cache->meshRotation());
+            const BarRenderItemArray &renderArray = cache->renderArray();
+            const int lastRow = qMin(row + 1, int(renderArray.size()) - 1);
+            for (int barRow = qMax(row - 1, 0); barRow <= lastRow; barRow++) {
+                const BarRenderItemRow &renderRow = renderArray.at(barRow);
+                const int lastBar = qMin(column + 1, int(renderRow.size()) - 1);
+                for (int bar = qMax(column - 1, 0); bar <= lastBar; bar++) {
+                    const BarRenderItem &item = renderRow.at(bar);
+                    if (!item.value())
+                        continue;
+
+                    const float colPos = (bar + seriesPos) * (m_cachedBarSpacing.width());
+                    const float rowPos = (barRow + 0.5f) * (m_cachedBarSpacing.height());
+                    QMatrix4x4 modelMatrix;
+                    modelMatrix.translate((colPos - m_rowWidth) / m_scaleFactor,
+                                          item.height(),
+                                          (m_columnDepth - rowPos) / m_scaleFactor);
+                    if (!seriesRotation.isIdentity() || !item.rotation().isIdentity())
+                        modelMatrix.rotate(seriesRotation * item.rotation());
+                    modelMatrix.scale(QVector3D(m_scaleX * m_seriesScaleX,
+                                                item.height(),
+                                                m_scaleZ * m_seriesScaleZ));
+
+                    const float t = RayPicker::intersectMesh(ray, modelMatrix, barObj);
+                    if (t >= 0.0f && t < closestDistance) {
+                        closestDistance = t;
+                        closestCache = cache;
+                        closestPosition = QPoint(barRow, bar);
+                    }
+                }
+            }
+        }
+
+        if (tNextColumn < tNextRow) {
+            column += stepColumn;
+            tCell = tNextColumn;
+            tNextColumn += tDeltaColumn;
+        } else {
+            row += stepRow;
+            tCell = tNextRow;
+            tNextRow += tDeltaRow;
+        }
+        if (column < 0 || column >= m_cachedColumnCount || row < 0 || row >= m_cachedRowCount)
+            break;
+    }
+
+    if (!closestCache)
+        return false;
+
+    // The floor is drawn to the selection buffer, and hides the bars on its other side
+    if (m_cachedTheme->isBackgroundEnabled() && ray.direction.y() != 0.0f) {
+        const float tFloor = -ray.origin.y() / ray.direction.y();
+        const QVector3D floorPoint = ray.origin + tFloor * ray.direction;
+        if (tFloor > 0.0f && tFloor < closestDistance
+                && qAbs(floorPoint.x()) <= m_scaleXWithBackground
+                && qAbs(floorPoint.z()) <= m_scaleZWithBackground) {
+            return false;
+        }
+    }
+    // Axis labels are drawn to the selection buffer as well, and hide the bars behind them
+    if (m_drawer->isLabelInFront(ray, projectionViewMatrix, closestDistance))
+        return false;
+
+    m_clickedType = QAbstract3DGraph::ElementSeries;
+    m_selectedLabelIndex = -1;
+    m_selectedCustomItemIndex = -1;
+    m_clickedPosition = QPoint(closestPosition.x() + int(m_axisCacheZ.min()),
+                               closestPosition.y() + int(m_axisCacheX.min()));
+    m_clickedSeries = closestCache->series();
+    m_clickResolved = true;
+
+    emit needRender();
+
+    return true;
+}
+
+// Marks the blocks of bars of the series that are outside the frustum invisible. The block of
+// the selected bar is always kept, so that its label can be positioned.
+void Bars3DRenderer::cullBarBlocks(BarSeriesRenderCache *cache, const ViewFrustum &frustum,
+                                   float seriesPos, float reflection)
+{
+    cache->updateBlockHeights();
+
+    const int blockSize = BarSeriesRenderCache::blockSize;
+    const float radius = cache->object()->boundingRadius();
+    const float horizontalScale = qMax(m_scaleX * m_seriesScaleX, m_scaleZ * m_seriesScaleZ);
+    // Shadows are drawn slightly off the floor
+    const float shadowOffset = 0.015f;
+    int selectedBlock = -1;
+    if (cache == m_selectedSeriesCache
+            && m_visualSelectedBarPos != Bars3DController::invalidSelectionPosition()) {
+        selectedBlock = (m_visualSelectedBarPos.x() / blockSize) * cache->blockColumnCount()
+                + m_visualSelectedBarPos.y() / blockSize;
+    }
+
+    int block = 0;
+    for (int blockRow = 0; blockRow < cache->blockRowCount(); blockRow++) {
+        const int firstRow = blockRow * blockSize;
+        const int lastRow = qMin(firstRow + blockSize, m_cachedRowCount) - 1;
+        const float nearZ = (m_columnDepth - (firstRow + 0.5f) * m_cachedBarSpacing.height())
+                / m_scaleFactor;
+        const float farZ = (m_columnDepth - (lastRow + 0.5f) * m_cachedBarSpacing.height())
+                / m_scaleFactor;
+        for (int blockColumn = 0; blockColumn < cache->blockColumnCount(); blockColumn++) {
+            const int firstColumn = blockColumn * blockSize;
+            const int lastColumn = qMin(firstColumn + blockSize, m_cachedColumnCount) - 1;
+            const float leftX = ((firstColumn + seriesPos) * m_cachedBarSpacing.width()
+                                 - m_rowWidth) / m_scaleFactor;
+            const float rightX = ((lastColumn + seriesPos) * m_cachedBarSpacing.width()
+                                  - m_rowWidth) / m_scaleFactor;
+            float bottom = reflection * cache->blockMinimumHeight(block);
+            float top = reflection * cache->blockMaximumHeight(block);
+            if (bottom > top)
+                qSwap(bottom, top);
+
+            // The bars are translated by their heights, and scaled by their heights and the bar
+            // thickness, so the mesh radius scaled by the largest of these covers any rotation.
+            const float margin = radius * qMax(horizontalScale, qMax(-bottom, top))
+                    + shadowOffset;
+            const QVector3D marginVector(margin, margin, margin);
+            const bool visible = block == selectedBlock
+                    || frustum.intersectsBox(QVector3D(leftX, bottom, farZ) - marginVector,
+                                             QVector3D(rightX, top, nearZ) + marginVector);
+            cache->setBlockVisible(block, visible);
+            block++;
         }
     }
-    return 0;
 }
 
 void Bars3DRenderer::updateSlicingActive(bool isSlicing)
@@ -56,6 +56,7 @@ class ShaderHelper;
 class LabelItem;
 class Q3DScene;
 class BarSeriesRenderCache;
+class ViewFrustum;
 
 class Q_DATAVISUALIZATION_EXPORT Bars3DRenderer : public Abstract3DRenderer
 {
@@ -115,6 +116,11 @@ private:
     float m_zScaleFactor;
     float m_floorLevel;
     float m_actualFloorLevel;
+    // State the selection buffer was drawn with, as the color under the cursor may be read
+    // back on a later frame
+    int m_selectionMinRow;
+    int m_selectionMinColumn;
+    QHash<int, QPointer<QBar3DSeries> > m_selectionSeries; // by visual index
 
 public:
     explicit Bars3DRenderer(Bars3DController *controller);
@@ -191,11 +197,17 @@ private:
     void calculateSeriesStartPosition();
     Abstract3DController::SelectionType isSelected(int row, int bar,
                                                    const BarSeriesRenderCache *cache);
+    void saveSelectionState();
     QPoint selectionColorToArrayPosition(const QVector4D &selectionColor);
     QBar3DSeries *selectionColorToSeries(const QVector4D &selectionColor);
+    bool pickBar(const QMatrix4x4 &projectionViewMatrix);
+    void cullBarBlocks(BarSeriesRenderCache *cache, const ViewFrustum &frustum, float seriesPos,
+                       float reflection = 1.0f);
 
     inline void updateRenderRow(const QBarDataRow *dataRow, BarRenderItemRow &renderRow);
     inline void updateRenderItem(const QBarDataItem &dataItem, BarRenderItem &renderItem);
+    inline void updateRenderItem(const QBarDataItem &dataItem, float position,
+                                 BarRenderItem &renderItem);
 
     Q_DISABLE_COPY(Bars3DRenderer)
 };
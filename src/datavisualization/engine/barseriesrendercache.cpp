@@ -34,7 +34,10 @@ QT_BEGIN_NAMESPACE
 BarSeriesRenderCache::BarSeriesRenderCache(QAbstract3DSeries *series,
                                            Abstract3DRenderer *renderer)
     : SeriesRenderCache(series, renderer),
-      m_visualIndex(-1)
+      m_visualIndex(-1),
+      m_blockRowCount(0),
+      m_blockColumnCount(0),
+      m_blockHeightsDirty(true)
 {
 }
 
@@ -46,8 +49,36 @@ void BarSeriesRenderCache::cleanup(TextureHelper *texHelper)
 {
     m_renderArray.clear();
     m_sliceArray.clear();
+    setBlockHeightsDirty();
 
     SeriesRenderCache::cleanup(texHelper);
 }
 
+// Finds the height range of the bars in each block. All the blocks are visible until culled.
+void BarSeriesRenderCache::updateBlockHeights()
+{
+    if (!m_blockHeightsDirty)
+        return;
+    m_blockHeightsDirty = false;
+
+    const int rowCount = m_renderArray.size();
+    const int columnCount = rowCount ? m_renderArray.at(0).size() : 0;
+    m_blockRowCount = (rowCount + blockSize - 1) / blockSize;
+    m_blockColumnCount = (columnCount + blockSize - 1) / blockSize;
+    const int blockCount = m_blockRowCount * m_blockColumnCount;
+    m_blockMinimumHeights.fill(0.0f, blockCount);
+    m_blockMaximumHeights.fill(0.0f, blockCount);
+    m_visibleBlocks.fill(true, blockCount);
+
+    for (int row = 0; row < rowCount; row++) {
+        const BarRenderItemRow &renderRow = m_renderArray.at(row);
+        for (int column = 0; column < renderRow.size(); column++) {
+            const int block = (row / blockSize) * m_blockColumnCount + column / blockSize;
+            const float height = renderRow.at(column).height();
+            m_blockMinimumHeights[block] = qMin(m_blockMinimumHeights.at(block), height);
+            m_blockMaximumHeights[block] = qMax(m_blockMaximumHeights.at(block), height);
+        }
+    }
+}
+
 QT_END_NAMESPACE
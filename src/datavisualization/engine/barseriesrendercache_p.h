@@ -61,10 +61,37 @@ public:
     inline void setVisualIndex(int index) { m_visualIndex = index; }
     inline int visualIndex() {return m_visualIndex; }
 
+    // Rows and columns of bars that are culled together
+    static const int blockSize = 16;
+    inline void setBlockHeightsDirty() { m_blockHeightsDirty = true; }
+    void updateBlockHeights();
+    inline int blockRowCount() const { return m_blockRowCount; }
+    inline int blockColumnCount() const { return m_blockColumnCount; }
+    inline float blockMinimumHeight(int block) const { return m_blockMinimumHeights.at(block); }
+    inline float blockMaximumHeight(int block) const { return m_blockMaximumHeights.at(block); }
+    inline void setBlockVisible(int block, bool visible) { m_visibleBlocks[block] = visible; }
+    inline bool isBlockVisible(int row, int column) const
+    {
+        return m_visibleBlocks.at((row / blockSize) * m_blockColumnCount + column / blockSize);
+    }
+    // Returns the column where a loop stepping through the columns leaves the block of the column
+    static inline int blockEnd(int column, int step, int stopColumn)
+    {
+        if (step > 0)
+            return qMin((column / blockSize + 1) * blockSize, stopColumn) - 1;
+        return qMax((column / blockSize) * blockSize, stopColumn + 1);
+    }
+
 protected:
     BarRenderItemArray m_renderArray;
     QList<BarRenderSliceItem> m_sliceArray;
     int m_visualIndex; // order of the series is relevant
+    int m_blockRowCount;
+    int m_blockColumnCount;
+    QList<float> m_blockMinimumHeights;
+    QList<float> m_blockMaximumHeights;
+    QList<bool> m_visibleBlocks;
+    bool m_blockHeightsDirty;
 };
 
 QT_END_NAMESPACE
@@ -34,8 +34,11 @@
 #include "texturehelper_p.h"
 #include "abstract3drenderer_p.h"
 #include "scatterpointbufferhelper_p.h"
+#include "scatterinstancebufferhelper_p.h"
+#include "labelatlas_p.h"
 
 #include <QtGui/QMatrix4x4>
+#include <QtGui/QOpenGLExtraFunctions>
 #include <QtCore/qmath.h>
 
 // Resources need to be explicitly initialized when building as static library
@@ -61,21 +64,41 @@ const GLfloat line_data[] = {
     1.0f, 0.0f, 0.0f,
 };
 
+// Vertices of the label quad and the order they are drawn in as two triangles
+const QVector4D labelCorners[] = {
+    QVector4D(-1.0f, -1.0f, 0.0f, 1.0f),
+    QVector4D(1.0f, -1.0f, 0.0f, 1.0f),
+    QVector4D(-1.0f, 1.0f, 0.0f, 1.0f),
+    QVector4D(1.0f, 1.0f, 0.0f, 1.0f)
+};
+const int labelTriangleCorners[] = {0, 1, 2, 2, 1, 3};
+
+// Clip space depth offset between consecutive batched labels. Replaces the growing polygon
+// offset the renderers set for each label, which cannot change within one draw call.
+const GLfloat labelDepthBias = 1.0f / 4194304.0f;
+
 Drawer::Drawer(Q3DTheme *theme)
     : m_theme(theme),
       m_textureHelper(0),
       m_pointbuffer(0),
       m_linebuffer(0),
-      m_scaledFontSize(0.0f)
+      m_scaledFontSize(0.0f),
+      m_labelBatchShader(0),
+      m_labelBatchBuffer(0),
+      m_batchingLabels(false),
+      m_pickLabelsValid(false)
 {
 }
 
 Drawer::~Drawer()
 {
+    m_labelAtlas.reset();
     delete m_textureHelper;
+    delete m_labelBatchShader;
     if (QOpenGLContext::currentContext()) {
         glDeleteBuffers(1, &m_pointbuffer);
         glDeleteBuffers(1, &m_linebuffer);
+        glDeleteBuffers(1, &m_labelBatchBuffer);
     }
 }
 
@@ -84,6 +107,14 @@ void Drawer::initializeOpenGL()
     initializeOpenGLFunctions();
     if (!m_textureHelper)
         m_textureHelper = new TextureHelper();
+    if (!m_labelAtlas)
+        m_labelAtlas.reset(new LabelAtlas());
+}
+
+void Drawer::beginFrame()
+{
+    if (m_labelAtlas)
+        m_labelAtlas->beginFrame();
 }
 
 void Drawer::setTheme(Q3DTheme *theme)
@@ -154,7 +185,8 @@ void Drawer::drawObject(ShaderHelper *shader, AbstractObjectHelper *object, GLui
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object->elementBuf());
 
     // Draw the triangles
-    glDrawElements(GL_TRIANGLES, object->indexCount(), GL_UNSIGNED_INT, (void*)0);
+    glDrawElements(GL_TRIANGLES, object->indexCount(), GL_UNSIGNED_INT,
+                   (void *)(object->indexOffset() * sizeof(GLuint)));
 
     // Free buffers
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -183,18 +215,146 @@ void Drawer::drawObject(ShaderHelper *shader, AbstractObjectHelper *object, GLui
     }
 }
 
+// Draws the given ranges of instances, each a pair of the first instance and the instance count
+void Drawer::drawInstancedObject(ShaderHelper *shader, AbstractObjectHelper *object,
+                                 ScatterInstanceBufferHelper *instances,
+                                 const QList<QPair<int, int>> &ranges, GLuint textureId,
+                                 GLuint depthTextureId)
+{
+    QOpenGLExtraFunctions *extraFunctions = QOpenGLContext::currentContext()->extraFunctions();
+    const GLsizei instanceStride = 2 * sizeof(QVector4D);
+
+    if (textureId) {
+        // Activate texture
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, textureId);
+        shader->setUniformValue(shader->texture(), 0);
+    }
+
+    if (depthTextureId) {
+        // Activate depth texture
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, depthTextureId);
+        shader->setUniformValue(shader->shadow(), 1);
+    }
+
+    // 1st attribute buffer : vertices
+    glEnableVertexAttribArray(shader->posAtt());
+    glBindBuffer(GL_ARRAY_BUFFER, object->vertexBuf());
+    glVertexAttribPointer(shader->posAtt(), 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+    // 2nd attribute buffer : normals
+    if (shader->normalAtt() >= 0) {
+        glEnableVertexAttribArray(shader->normalAtt());
+        glBindBuffer(GL_ARRAY_BUFFER, object->normalBuf());
+        glVertexAttribPointer(shader->normalAtt(), 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    }
+
+    // 3rd attribute buffer : UVs
+    if (shader->uvAtt() >= 0) {
+        glEnableVertexAttribArray(shader->uvAtt());
+        glBindBuffer(GL_ARRAY_BUFFER, object->uvBuf());
+        glVertexAttribPointer(shader->uvAtt(), 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    }
+
+    // Per-instance attribute buffers : translation and scale, rotation
+    glBindBuffer(GL_ARRAY_BUFFER, instances->instanceBuf());
+    glEnableVertexAttribArray(shader->instancePosAtt());
+    extraFunctions->glVertexAttribDivisor(shader->instancePosAtt(), 1);
+    glEnableVertexAttribArray(shader->instanceRotAtt());
+    extraFunctions->glVertexAttribDivisor(shader->instanceRotAtt(), 1);
+
+    // Index buffer
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object->elementBuf());
+
+    // Draw the triangles of the instances. The ranges start from offset attribute pointers, as
+    // a base instance for the draw call is not available on OpenGL ES.
+    foreach (const QPair<int, int> &range, ranges) {
+        const qintptr offset = qintptr(range.first) * instanceStride;
+        glVertexAttribPointer(shader->instancePosAtt(), 4, GL_FLOAT, GL_FALSE, instanceStride,
+                              (void*)offset);
+        glVertexAttribPointer(shader->instanceRotAtt(), 4, GL_FLOAT, GL_FALSE, instanceStride,
+                              (void*)(offset + sizeof(QVector4D)));
+        extraFunctions->glDrawElementsInstanced(GL_TRIANGLES, object->indexCount(),
+                                                GL_UNSIGNED_INT, (void*)0, range.second);
+    }
+
+    // Free buffers
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    extraFunctions->glVertexAttribDivisor(shader->instanceRotAtt(), 0);
+    extraFunctions->glVertexAttribDivisor(shader->instancePosAtt(), 0);
+    glDisableVertexAttribArray(shader->instanceRotAtt());
+    glDisableVertexAttribArray(shader->instancePosAtt());
+    if (shader->uvAtt() >= 0)
+        glDisableVertexAttribArray(shader->uvAtt());
+    if (shader->normalAtt() >= 0)
+        glDisableVertexAttribArray(shader->normalAtt());
+    glDisableVertexAttribArray(shader->posAtt());
+
+    // Release textures
+    if (depthTextureId) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    if (textureId) {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+}
+
 void Drawer::drawSelectionObject(ShaderHelper *shader, AbstractObjectHelper *object)
 {
     glEnableVertexAttribArray(shader->posAtt());
     glBindBuffer(GL_ARRAY_BUFFER, object->vertexBuf());
     glVertexAttribPointer(shader->posAtt(), 3, GL_FLOAT, GL_FALSE, 0, (void *)0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object->elementBuf());
-    glDrawElements(GL_TRIANGLES, object->indexCount(), GL_UNSIGNED_INT, (void *)0);
+    glDrawElements(GL_TRIANGLES, object->indexCount(), GL_UNSIGNED_INT,
+                   (void *)(object->indexOffset() * sizeof(GLuint)));
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glDisableVertexAttribArray(shader->posAtt());
 }
 
+void Drawer::drawLabelObject(ShaderHelper *shader, AbstractObjectHelper *object,
+                             const LabelItem &labelItem)
+{
+    GLuint textureId = 0;
+    if (labelItem.atlasEntry() >= 0 && labelItem.atlas() == m_labelAtlas)
+        textureId = m_labelAtlas->prepareDraw(labelItem.atlasEntry());
+    if (!textureId) {
+        drawObject(shader, object, labelItem.textureId());
+        return;
+    }
+
+    // Draw a quad showing the area of the label in the atlas page
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, textureId);
+    shader->setUniformValue(shader->texture(), 0);
+
+    glEnableVertexAttribArray(shader->posAtt());
+    glBindBuffer(GL_ARRAY_BUFFER, m_labelAtlas->vertexBuf());
+    glVertexAttribPointer(shader->posAtt(), 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+    glEnableVertexAttribArray(shader->uvAtt());
+    glBindBuffer(GL_ARRAY_BUFFER, m_labelAtlas->uvBuf());
+    glVertexAttribPointer(shader->uvAtt(), 2, GL_FLOAT, GL_FALSE, 0,
+                          (void*)m_labelAtlas->uvOffset(labelItem.atlasEntry()));
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDisableVertexAttribArray(shader->uvAtt());
+    glDisableVertexAttribArray(shader->posAtt());
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (m_labelAtlas->takeMipmapsDeferred())
+        emit labelMipmapsDeferred();
+}
+
 void Drawer::drawSurfaceGrid(ShaderHelper *shader, SurfaceObject *object)
 {
     // Get grid line color
@@ -210,7 +370,8 @@ void Drawer::drawSurfaceGrid(ShaderHelper *shader, SurfaceObject *object)
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object->gridElementBuf());
 
     // Draw the lines
-    glDrawElements(GL_LINES, object->gridIndexCount(), GL_UNSIGNED_INT, (void*)0);
+    glDrawElements(GL_LINES, object->gridIndexCount(), GL_UNSIGNED_INT,
+                   (void *)(object->gridIndexOffset() * sizeof(GLuint)));
 
     // Free buffers
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -413,7 +574,22 @@ void Drawer::drawLabel(const AbstractRenderItem &item, const LabelItem &labelIte
                                 m_scaledFontSize,
                                 0.0f));
 
-    MVPMatrix = projectionmatrix * viewmatrix * modelMatrix;
+    const QMatrix4x4 viewProjectionMatrix = projectionmatrix * viewmatrix;
+    MVPMatrix = viewProjectionMatrix * modelMatrix;
+
+    if (!isSelecting && m_batchingLabels) {
+        if (m_pickLabelMatrices.isEmpty())
+            m_pickLabelViewProjection = viewProjectionMatrix;
+        else if (viewProjectionMatrix != m_pickLabelViewProjection)
+            m_pickLabelsValid = false;
+        m_pickLabelMatrices.append(modelMatrix);
+    }
+
+    if (!isSelecting && m_batchingLabels && labelItem.atlasEntry() >= 0
+            && labelItem.atlas() == m_labelAtlas) {
+        queueLabel(labelItem.atlasEntry(), MVPMatrix);
+        return;
+    }
 
     shader->setUniformValue(shader->MVP(), MVPMatrix);
 
@@ -422,10 +598,119 @@ void Drawer::drawLabel(const AbstractRenderItem &item, const LabelItem &labelIte
         drawSelectionObject(shader, object);
     } else {
         // Draw the object
-        drawObject(shader, object, labelItem.textureId());
+        drawLabelObject(shader, object, labelItem);
     }
 }
 
+void Drawer::beginLabels()
+{
+    m_batchingLabels = true;
+    m_pickLabelMatrices.clear();
+    m_pickLabelsValid = true;
+}
+
+void Drawer::endLabels()
+{
+    m_batchingLabels = false;
+    if (m_labelBatchEntries.isEmpty())
+        return;
+
+    if (!m_labelBatchShader) {
+        m_labelBatchShader = new ShaderHelper(this, QStringLiteral(":/shaders/vertexLabelBatch"),
+                                              QStringLiteral(":/shaders/fragmentLabel"));
+        m_labelBatchShader->initialize();
+        glGenBuffers(1, &m_labelBatchBuffer);
+    }
+
+    // The renderers keep using their own label shader after the labels
+    GLint previousProgram = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+
+    m_labelBatchShader->bind();
+    glActiveTexture(GL_TEXTURE0);
+    m_labelBatchShader->setUniformValue(m_labelBatchShader->texture(), 0);
+    glEnableVertexAttribArray(m_labelBatchShader->posAtt());
+    glEnableVertexAttribArray(m_labelBatchShader->uvAtt());
+    glBindBuffer(GL_ARRAY_BUFFER, m_labelBatchBuffer);
+
+    // Texture coordinates are looked up only now, as adding labels may have grown a page
+    const int vertexSize = 6;
+    for (int page = 0; page < m_labelAtlas->pageCount(); page++) {
+        m_labelBatchData.clear();
+        for (int i = 0; i < m_labelBatchEntries.size(); i++) {
+            int entry = m_labelBatchEntries.at(i);
+            if (m_labelAtlas->page(entry) != page)
+                continue;
+            const GLfloat *positions = m_labelBatchVertices.constData() + i * 16;
+            const GLfloat *uvs = m_labelAtlas->uvs(entry);
+            for (int j = 0; j < 6; j++) {
+                int corner = labelTriangleCorners[j];
+                m_labelBatchData.append(positions[corner * 4]);
+                m_labelBatchData.append(positions[corner * 4 + 1]);
+                m_labelBatchData.append(positions[corner * 4 + 2]);
+                m_labelBatchData.append(positions[corner * 4 + 3]);
+                m_labelBatchData.append(uvs[corner * 2]);
+                m_labelBatchData.append(uvs[corner * 2 + 1]);
+            }
+        }
+        if (m_labelBatchData.isEmpty())
+            continue;
+
+        glBindTexture(GL_TEXTURE_2D, m_labelAtlas->preparePage(page));
+        glBufferData(GL_ARRAY_BUFFER, m_labelBatchData.size() * sizeof(GLfloat),
+                     m_labelBatchData.constData(), GL_STREAM_DRAW);
+        glVertexAttribPointer(m_labelBatchShader->posAtt(), 4, GL_FLOAT, GL_FALSE,
+                              vertexSize * sizeof(GLfloat), (void*)0);
+        glVertexAttribPointer(m_labelBatchShader->uvAtt(), 2, GL_FLOAT, GL_FALSE,
+                              vertexSize * sizeof(GLfloat), (void*)(4 * sizeof(GLfloat)));
+        glDrawArrays(GL_TRIANGLES, 0, m_labelBatchData.size() / vertexSize);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDisableVertexAttribArray(m_labelBatchShader->uvAtt());
+    glDisableVertexAttribArray(m_labelBatchShader->posAtt());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(GLuint(previousProgram));
+
+    m_labelBatchEntries.clear();
+    m_labelBatchVertices.clear();
+
+    if (m_labelAtlas->takeMipmapsDeferred())
+        emit labelMipmapsDeferred();
+}
+
+bool Drawer::isLabelInFront(const RayPicker::Ray &ray, const QMatrix4x4 &projectionViewMatrix,
+                            float distance) const
+{
+    if (!m_pickLabelsValid)
+        return true;
+    if (m_pickLabelMatrices.isEmpty())
+        return false;
+    if (projectionViewMatrix != m_pickLabelViewProjection)
+        return true;
+
+    foreach (const QMatrix4x4 &modelMatrix, m_pickLabelMatrices) {
+        const float t = RayPicker::intersectQuad(ray, modelMatrix);
+        if (t >= 0.0f && t < distance)
+            return true;
+    }
+    return false;
+}
+
+void Drawer::queueLabel(int entry, const QMatrix4x4 &MVPMatrix)
+{
+    // Later labels are drawn in front of earlier ones at the same depth
+    GLfloat depthBias = GLfloat(m_labelBatchEntries.size()) * labelDepthBias;
+    for (int i = 0; i < 4; i++) {
+        QVector4D corner = MVPMatrix * labelCorners[i];
+        m_labelBatchVertices.append(corner.x());
+        m_labelBatchVertices.append(corner.y());
+        m_labelBatchVertices.append(corner.z() - depthBias * corner.w());
+        m_labelBatchVertices.append(corner.w());
+    }
+    m_labelBatchEntries.append(entry);
+}
+
 void Drawer::generateSelectionLabelTexture(Abstract3DRenderer *renderer)
 {
     LabelItem &labelItem = renderer->selectionLabelItem();
@@ -439,6 +724,20 @@ void Drawer::generateLabelItem(LabelItem &item, const QString &text, int widestL
     item.clear();
 
     if (!text.isEmpty()) {
+        // Labels with identical text and looks share one image in the label atlas
+        QString key = m_theme->font().toString() + QLatin1Char('|')
+                + m_theme->labelBackgroundColor().name(QColor::HexArgb)
+                + m_theme->labelTextColor().name(QColor::HexArgb)
+                + QString::number(int(m_theme->isLabelBackgroundEnabled()))
+                + QString::number(int(m_theme->isLabelBorderEnabled())) + QLatin1Char('|')
+                + QString::number(widestLabel) + QLatin1Char('|') + text;
+        int entry = m_labelAtlas->acquire(key);
+        if (entry >= 0) {
+            item.setSize(m_labelAtlas->size(entry));
+            item.setAtlasEntry(m_labelAtlas, entry);
+            return;
+        }
+
         // Create labels
         // Print label into a QImage using QPainter
         QImage label = Utils::printTextToImage(m_theme->font(),
@@ -451,8 +750,13 @@ void Drawer::generateLabelItem(LabelItem &item, const QString &text, int widestL
 
         // Set label size
         item.setSize(label.size());
-        // Insert text texture into label (also deletes the old texture)
-        item.setTextureId(m_textureHelper->create2DTexture(label, true, true));
+        entry = m_labelAtlas->insert(key, label);
+        if (entry >= 0) {
+            item.setAtlasEntry(m_labelAtlas, entry);
+        } else {
+            // Insert text texture into label (also deletes the old texture)
+            item.setTextureId(m_textureHelper->create2DTexture(label, true, true));
+        }
     }
 }
 
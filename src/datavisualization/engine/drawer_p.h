@@ -43,6 +43,7 @@
 #include <private/datavisualizationglobal_p.h>
 #include <private/labelitem_p.h>
 #include <private/abstractrenderitem_p.h>
+#include <private/raypicker_p.h>
 
 #include <QtDataVisualization/q3dbars.h>
 #include <QtDataVisualization/q3dtheme.h>
@@ -57,6 +58,8 @@ class TextureHelper;
 class Q3DCamera;
 class Abstract3DRenderer;
 class ScatterPointBufferHelper;
+class ScatterInstanceBufferHelper;
+class LabelAtlas;
 
 class Drawer : public QObject, public QOpenGLFunctions
 {
@@ -80,6 +83,7 @@ public:
     ~Drawer();
 
     void initializeOpenGL();
+    void beginFrame();
 
     void setTheme(Q3DTheme *theme);
     Q3DTheme *theme() const;
@@ -88,7 +92,13 @@ public:
 
     void drawObject(ShaderHelper *shader, AbstractObjectHelper *object, GLuint textureId = 0,
                     GLuint depthTextureId = 0, GLuint textureId3D = 0);
+    void drawInstancedObject(ShaderHelper *shader, AbstractObjectHelper *object,
+                             ScatterInstanceBufferHelper *instances,
+                             const QList<QPair<int, int>> &ranges, GLuint textureId = 0,
+                             GLuint depthTextureId = 0);
     void drawSelectionObject(ShaderHelper *shader, AbstractObjectHelper *object);
+    void drawLabelObject(ShaderHelper *shader, AbstractObjectHelper *object,
+                         const LabelItem &labelItem);
     void drawSurfaceGrid(ShaderHelper *shader, SurfaceObject *object);
     void drawPoint(ShaderHelper *shader);
     void drawPoints(ShaderHelper *shader, ScatterPointBufferHelper *object, GLuint textureId);
@@ -102,11 +112,20 @@ public:
                    Qt::Alignment alignment = Qt::AlignCenter, bool isSlicing = false,
                    bool isSelecting = false);
 
+    // Labels drawn between these are collected and drawn with one draw call per atlas page
+    void beginLabels();
+    void endLabels();
+    // Returns true if a label of the last label batch is hit closer than the given distance
+    // along the ray, or if the labels were not drawn with the given matrix and may be anywhere
+    bool isLabelInFront(const RayPicker::Ray &ray, const QMatrix4x4 &projectionViewMatrix,
+                        float distance) const;
+
     void generateSelectionLabelTexture(Abstract3DRenderer *item);
     void generateLabelItem(LabelItem &item, const QString &text, int widestLabel = 0);
 
 Q_SIGNALS:
     void drawerChanged();
+    void labelMipmapsDeferred();
 
 private:
     Q3DTheme *m_theme;
@@ -114,6 +133,19 @@ private:
     GLuint m_pointbuffer;
     GLuint m_linebuffer;
     GLfloat m_scaledFontSize;
+    QSharedPointer<LabelAtlas> m_labelAtlas;
+    ShaderHelper *m_labelBatchShader;
+    GLuint m_labelBatchBuffer;
+    bool m_batchingLabels;
+    QList<int> m_labelBatchEntries;
+    QList<GLfloat> m_labelBatchVertices;
+    QList<GLfloat> m_labelBatchData;
+    // Model matrices of the labels of the last label batch, for picking on CPU
+    QList<QMatrix4x4> m_pickLabelMatrices;
+    QMatrix4x4 m_pickLabelViewProjection;
+    bool m_pickLabelsValid;
+
+    void queueLabel(int entry, const QMatrix4x4 &MVPMatrix);
 };
 
 QT_END_NAMESPACE
@@ -0,0 +1,531 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "labelatlas_p.h"
+#include "texturehelper_p.h"
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+// Size of new atlas pages. Pages grow by doubling up to the preferred maximum size, which is
+// limited by the maximum texture size.
+static const int initialPageSize = 256;
+static const int preferredMaxPageSize = 2048;
+static const int maxPages = 4;
+// Transparent gap around the labels, so that neighboring labels do not bleed into each other
+// in the smaller mipmap levels
+static const int labelPadding = 8;
+
+// Quad matching the plane object, drawn as a triangle strip
+static const GLfloat quadVertices[] = {
+    -1.0f, -1.0f, 0.0f,
+    1.0f, -1.0f, 0.0f,
+    -1.0f, 1.0f, 0.0f,
+    1.0f, 1.0f, 0.0f
+};
+
+LabelAtlas::LabelAtlas()
+    : m_textureHelper(0),
+      m_maxPageSize(preferredMaxPageSize),
+      m_uvDataDirty(false),
+      m_frame(0),
+      m_mipmapsDeferred(false),
+      m_vertexBuffer(0),
+      m_uvBuffer(0),
+      m_frameBuffer(0)
+{
+    initializeOpenGLFunctions();
+
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    if (maxTextureSize > 0)
+        m_maxPageSize = qMin(m_maxPageSize, int(maxTextureSize));
+
+    glGenBuffers(1, &m_vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+    glGenBuffers(1, &m_uvBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+LabelAtlas::~LabelAtlas()
+{
+    if (QOpenGLContext::currentContext()) {
+        foreach (const Page &page, m_pages)
+            glDeleteTextures(1, &page.textureId);
+        glDeleteBuffers(1, &m_vertexBuffer);
+        glDeleteBuffers(1, &m_uvBuffer);
+        if (m_frameBuffer)
+            glDeleteFramebuffers(1, &m_frameBuffer);
+    }
+    delete m_textureHelper;
+}
+
+int LabelAtlas::acquire(const QString &key)
+{
+    int entry = m_entryIndex.value(key, -1);
+    if (entry >= 0) {
+        m_entries[entry].references++;
+        m_entries[entry].lastUsed = m_frame;
+    }
+    return entry;
+}
+
+int LabelAtlas::insert(const QString &key, const QImage &image)
+{
+    if (image.isNull())
+        return -1;
+
+    QSize paddedSize(image.width() + labelPadding, image.height() + labelPadding);
+    if (paddedSize.width() > m_maxPageSize || paddedSize.height() > m_maxPageSize)
+        return -1;
+
+    // Fill the existing pages before growing them, and grow them before adding new pages
+    int pageIndex = -1;
+    QPoint position;
+    for (int i = 0; pageIndex < 0 && i < m_pages.size(); i++) {
+        if (allocate(m_pages[i], paddedSize, position))
+            pageIndex = i;
+    }
+    for (int i = 0; pageIndex < 0 && i < m_pages.size(); i++) {
+        while (pageIndex < 0 && growPage(i)) {
+            if (allocate(m_pages[i], paddedSize, position))
+                pageIndex = i;
+        }
+    }
+    if (pageIndex < 0) {
+        pageIndex = addPage(paddedSize);
+        if (pageIndex >= 0) {
+            while (!allocate(m_pages[pageIndex], paddedSize, position)) {
+                if (!growPage(pageIndex))
+                    return -1;
+            }
+        } else {
+            pageIndex = reclaimSpace(paddedSize, position);
+            if (pageIndex < 0)
+                return -1;
+        }
+    }
+
+    // Only the area of the label is uploaded, the rest of the page is cleared already
+    Page &page = m_pages[pageIndex];
+    m_textureHelper->update2DTexture(page.textureId, position, image);
+    page.mipmapsDirty = true;
+
+    int entry;
+    if (m_freeEntries.isEmpty()) {
+        entry = m_entries.size();
+        m_entries.append(Entry());
+        m_uvData.resize(m_uvData.size() + 8);
+    } else {
+        entry = m_freeEntries.takeLast();
+    }
+    Entry &newEntry = m_entries[entry];
+    newEntry.key = key;
+    newEntry.page = pageIndex;
+    newEntry.rect = QRect(position, image.size());
+    newEntry.references = 1;
+    newEntry.lastUsed = m_frame;
+    page.entries.append(entry);
+    m_entryIndex.insert(key, entry);
+    updateUvs(entry);
+
+    return entry;
+}
+
+void LabelAtlas::release(int entry)
+{
+    if (entry >= 0 && entry < m_entries.size() && m_entries.at(entry).references > 0) {
+        m_entries[entry].references--;
+        m_entries[entry].lastUsed = m_frame;
+    }
+}
+
+GLuint LabelAtlas::textureId(int entry) const
+{
+    int entryPage = page(entry);
+    if (entryPage < 0)
+        return 0;
+    return m_pages.at(entryPage).textureId;
+}
+
+QSize LabelAtlas::size(int entry) const
+{
+    if (entry < 0 || entry >= m_entries.size())
+        return QSize();
+    return m_entries.at(entry).rect.size();
+}
+
+int LabelAtlas::page(int entry) const
+{
+    if (entry < 0 || entry >= m_entries.size())
+        return -1;
+    return m_entries.at(entry).page;
+}
+
+bool LabelAtlas::takeMipmapsDeferred()
+{
+    bool deferred = m_mipmapsDeferred;
+    m_mipmapsDeferred = false;
+    return deferred;
+}
+
+GLuint LabelAtlas::prepareDraw(int entry)
+{
+    int entryPage = page(entry);
+    if (entryPage < 0)
+        return 0;
+
+    if (m_uvDataDirty) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_uvBuffer);
+        glBufferData(GL_ARRAY_BUFFER, m_uvData.size() * sizeof(GLfloat), m_uvData.constData(),
+                     GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_uvDataDirty = false;
+    }
+
+    return preparePage(entryPage);
+}
+
+GLuint LabelAtlas::preparePage(int page)
+{
+    if (page < 0 || page >= m_pages.size())
+        return 0;
+
+    Page &atlasPage = m_pages[page];
+    updateMipmaps(atlasPage);
+    return atlasPage.textureId;
+}
+
+bool LabelAtlas::allocate(Page &page, const QSize &size, QPoint &position)
+{
+    // Labels are packed on shelves filled from left to right, a new shelf is started on top of
+    // the previous one when the label does not fit in the current one. Growing the page widens
+    // the current shelf and adds room for new shelves.
+    if (page.cursorX + size.width() > page.size) {
+        if (page.shelfY + page.shelfHeight + size.height() > page.size)
+            return false;
+        page.shelfY += page.shelfHeight;
+        page.shelfHeight = 0;
+        page.cursorX = 0;
+    }
+    if (page.shelfY + size.height() > page.size)
+        return false;
+
+    position = QPoint(page.cursorX, page.shelfY);
+    page.cursorX += size.width();
+    page.shelfHeight = qMax(page.shelfHeight, size.height());
+    return true;
+}
+
+int LabelAtlas::addPage(const QSize &minimumSize)
+{
+    if (m_pages.size() >= maxPages)
+        return -1;
+
+    if (!m_textureHelper)
+        m_textureHelper = new TextureHelper();
+
+    int pageSize = qMin(initialPageSize, m_maxPageSize);
+    while (pageSize < minimumSize.width() || pageSize < minimumSize.height())
+        pageSize *= 2;
+    pageSize = qMin(pageSize, m_maxPageSize);
+
+    Page page;
+    page.textureId = createPageTexture(pageSize);
+    page.size = pageSize;
+    page.shelfY = 0;
+    page.shelfHeight = 0;
+    page.cursorX = 0;
+    // The new texture has no mipmaps yet, so they are generated regardless of the frame
+    page.mipmapsDirty = true;
+    page.mipmapFrame = m_frame - 1;
+    m_pages.append(page);
+    return m_pages.size() - 1;
+}
+
+bool LabelAtlas::growPage(int pageIndex)
+{
+    Page &page = m_pages[pageIndex];
+    if (page.size >= m_maxPageSize)
+        return false;
+
+    int newSize = qMin(page.size * 2, m_maxPageSize);
+    GLuint newTexture = createPageTexture(newSize);
+
+    // Copy the labels to the same place in the bigger texture
+    GLint previousFrameBuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFrameBuffer);
+    bool copied = attachTexture(page.textureId);
+    if (copied) {
+        glBindTexture(GL_TEXTURE_2D, newTexture);
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, page.size, page.size);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, GLuint(previousFrameBuffer));
+
+    if (!copied) {
+        glDeleteTextures(1, &newTexture);
+        return false;
+    }
+
+    glDeleteTextures(1, &page.textureId);
+    page.textureId = newTexture;
+    page.size = newSize;
+    page.mipmapsDirty = true;
+    page.mipmapFrame = m_frame - 1;
+    foreach (int entry, page.entries)
+        updateUvs(entry);
+    return true;
+}
+
+int LabelAtlas::reclaimSpace(const QSize &size, QPoint &position)
+{
+    // The pages where unreferenced labels take the most area are compacted first
+    QList<QPair<qint64, int>> candidates;
+    for (int i = 0; i < m_pages.size(); i++) {
+        qint64 unusedArea = 0;
+        foreach (int entry, m_pages.at(i).entries) {
+            const Entry &atlasEntry = m_entries.at(entry);
+            if (!atlasEntry.references) {
+                unusedArea += qint64(atlasEntry.rect.width() + labelPadding)
+                        * (atlasEntry.rect.height() + labelPadding);
+            }
+        }
+        if (unusedArea)
+            candidates.append(qMakePair(-unusedArea, i));
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (int i = 0; i < candidates.size(); i++) {
+        if (compactPage(candidates.at(i).second, size, position))
+            return candidates.at(i).second;
+    }
+    return -1;
+}
+
+bool LabelAtlas::compactPage(int pageIndex, const QSize &reserveSize, QPoint &position)
+{
+    Page &page = m_pages[pageIndex];
+
+    // The labels in use are packed first, tallest first to waste less of the shelves. The
+    // reserved area comes next, and the unreferenced labels are kept in the order of their
+    // last use while they fit. The rest are evicted.
+    QList<int> usedEntries;
+    QList<int> unusedEntries;
+    foreach (int entry, page.entries) {
+        if (m_entries.at(entry).references)
+            usedEntries.append(entry);
+        else
+            unusedEntries.append(entry);
+    }
+    std::sort(usedEntries.begin(), usedEntries.end(), [this](int a, int b) {
+        return m_entries.at(a).rect.height() > m_entries.at(b).rect.height();
+    });
+    std::sort(unusedEntries.begin(), unusedEntries.end(), [this](int a, int b) {
+        return m_entries.at(a).lastUsed > m_entries.at(b).lastUsed;
+    });
+
+    Page packedPage = page;
+    packedPage.shelfY = 0;
+    packedPage.shelfHeight = 0;
+    packedPage.cursorX = 0;
+    packedPage.entries.clear();
+    QList<QPoint> positions;
+    foreach (int entry, usedEntries) {
+        QPoint entryPosition;
+        QSize paddedSize = m_entries.at(entry).rect.size() + QSize(labelPadding, labelPadding);
+        if (!allocate(packedPage, paddedSize, entryPosition))
+            return false;
+        packedPage.entries.append(entry);
+        positions.append(entryPosition);
+    }
+    if (!allocate(packedPage, reserveSize, position))
+        return false;
+    QList<int> evictedEntries;
+    foreach (int entry, unusedEntries) {
+        QPoint entryPosition;
+        QSize paddedSize = m_entries.at(entry).rect.size() + QSize(labelPadding, labelPadding);
+        if (allocate(packedPage, paddedSize, entryPosition)) {
+            packedPage.entries.append(entry);
+            positions.append(entryPosition);
+        } else {
+            evictedEntries.append(entry);
+        }
+    }
+
+    // The kept labels are copied to their new places in a cleared texture of the same size
+    GLuint newTexture = createPageTexture(page.size);
+    GLint previousFrameBuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFrameBuffer);
+    bool copied = attachTexture(page.textureId);
+    if (copied) {
+        glBindTexture(GL_TEXTURE_2D, newTexture);
+        for (int i = 0; i < packedPage.entries.size(); i++) {
+            const QRect &rect = m_entries.at(packedPage.entries.at(i)).rect;
+            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, positions.at(i).x(), positions.at(i).y(),
+                                rect.x(), rect.y(), rect.width(), rect.height());
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, GLuint(previousFrameBuffer));
+
+    if (!copied && !packedPage.entries.isEmpty()) {
+        glDeleteTextures(1, &newTexture);
+        return false;
+    }
+
+    foreach (int entry, evictedEntries)
+        removeEntry(entry);
+    glDeleteTextures(1, &page.textureId);
+    packedPage.textureId = newTexture;
+    // The new texture has no mipmaps yet, so they are generated regardless of the frame
+    packedPage.mipmapsDirty = true;
+    packedPage.mipmapFrame = m_frame - 1;
+    page = packedPage;
+    for (int i = 0; i < page.entries.size(); i++) {
+        m_entries[page.entries.at(i)].rect.moveTopLeft(positions.at(i));
+        updateUvs(page.entries.at(i));
+    }
+    return true;
+}
+
+void LabelAtlas::removeEntry(int entry)
+{
+    Entry &oldEntry = m_entries[entry];
+    m_entryIndex.remove(oldEntry.key);
+    oldEntry.key.clear();
+    oldEntry.page = -1;
+    oldEntry.rect = QRect();
+    m_freeEntries.append(entry);
+}
+
+void LabelAtlas::updateUvs(int entry)
+{
+    const Entry &atlasEntry = m_entries.at(entry);
+    const QRect &rect = atlasEntry.rect;
+
+    // Texture coordinates in the order of the quad vertices. Images are uploaded mirrored, so
+    // the bottom row of the label is at the smallest texture y coordinate.
+    const GLfloat pageSize = GLfloat(m_pages.at(atlasEntry.page).size);
+    const GLfloat left = GLfloat(rect.x()) / pageSize;
+    const GLfloat right = GLfloat(rect.x() + rect.width()) / pageSize;
+    const GLfloat bottom = GLfloat(rect.y()) / pageSize;
+    const GLfloat top = GLfloat(rect.y() + rect.height()) / pageSize;
+    GLfloat *uvs = m_uvData.data() + entry * 8;
+    uvs[0] = left;
+    uvs[1] = bottom;
+    uvs[2] = right;
+    uvs[3] = bottom;
+    uvs[4] = left;
+    uvs[5] = top;
+    uvs[6] = right;
+    uvs[7] = top;
+    m_uvDataDirty = true;
+}
+
+void LabelAtlas::updateMipmaps(Page &page)
+{
+    if (!page.mipmapsDirty)
+        return;
+
+    if (page.mipmapFrame == m_frame) {
+        // Labels added after the page was drawn in this frame are shown with outdated smaller
+        // mipmap levels until the next frame
+        m_mipmapsDeferred = true;
+        return;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, page.textureId);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    page.mipmapsDirty = false;
+    page.mipmapFrame = m_frame;
+}
+
+GLuint LabelAtlas::createPageTexture(int size)
+{
+    GLuint textureId;
+    glGenTextures(1, &textureId);
+    glBindTexture(GL_TEXTURE_2D, textureId);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    clearTexture(textureId, size);
+    return textureId;
+}
+
+void LabelAtlas::clearTexture(GLuint textureId, int size)
+{
+    GLint previousFrameBuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFrameBuffer);
+
+    bool cleared = attachTexture(textureId);
+    if (cleared) {
+        GLfloat clearColor[4];
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+        GLboolean scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+        if (scissorTest)
+            glDisable(GL_SCISSOR_TEST);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+        if (scissorTest)
+            glEnable(GL_SCISSOR_TEST);
+    }
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, GLuint(previousFrameBuffer));
+
+    if (!cleared) {
+        // Without a usable frame buffer the page is cleared by uploading a transparent image
+        qWarning() << "Label atlas frame buffer is not complete, clearing the page on the CPU";
+        QImage emptyImage(size, size, QImage::Format_ARGB32);
+        emptyImage.fill(Qt::transparent);
+        if (!m_textureHelper)
+            m_textureHelper = new TextureHelper();
+        m_textureHelper->update2DTexture(textureId, QPoint(0, 0), emptyImage);
+    }
+}
+
+bool LabelAtlas::attachTexture(GLuint textureId)
+{
+    // Leaves the atlas frame buffer bound, the caller restores the previous binding
+    if (!m_frameBuffer)
+        glGenFramebuffers(1, &m_frameBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureId, 0);
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,145 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QtDataVisualization API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+#ifndef LABELATLAS_P_H
+#define LABELATLAS_P_H
+
+#include "datavisualizationglobal_p.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QRect>
+#include <QtGui/QImage>
+
+QT_BEGIN_NAMESPACE
+
+class TextureHelper;
+
+// Caches rasterized label images in a few texture pages, so that labels with identical
+// text, font and colors are rasterized and uploaded only once and share a texture.
+// Pages start small and grow when labels no longer fit in them.
+// Entries are reference counted; unreferenced entries stay cached until their space is needed
+// for new labels. Then a page is compacted: the labels in use are moved together and the
+// unreferenced ones are evicted, least recently used first.
+// Each Drawer has its own atlas, so the labels are not shared between graphs.
+class LabelAtlas : protected QOpenGLFunctions
+{
+public:
+    LabelAtlas();
+    ~LabelAtlas();
+
+    // Returns the cached entry for the key with its reference count increased, or -1
+    int acquire(const QString &key);
+    // Returns the new entry with one reference, or -1 if the image does not fit in the atlas
+    int insert(const QString &key, const QImage &image);
+    void release(int entry);
+
+    GLuint textureId(int entry) const;
+    QSize size(int entry) const;
+    // Returns the page of the entry, or -1 if the entry has been removed
+    int page(int entry) const;
+    inline int pageCount() const { return m_pages.size(); }
+    // Texture coordinates of the entry in the order of the quad vertices
+    inline const GLfloat *uvs(int entry) const { return m_uvData.constData() + entry * 8; }
+
+    // Mipmaps of a page are generated at most once per frame
+    inline void beginFrame() { m_frame++; }
+    // Returns true once if mipmap updates were postponed to the next frame since the last call
+    bool takeMipmapsDeferred();
+
+    // Updates the mipmaps of the entry page and the texture coordinate buffer if needed.
+    // Returns the page texture.
+    GLuint prepareDraw(int entry);
+    // Updates the mipmaps of the page if needed. Returns the page texture.
+    GLuint preparePage(int page);
+    inline GLuint vertexBuf() const { return m_vertexBuffer; }
+    inline GLuint uvBuf() const { return m_uvBuffer; }
+    // Byte offset of the texture coordinates of the entry in the uv buffer
+    inline GLintptr uvOffset(int entry) const { return entry * 8 * sizeof(GLfloat); }
+
+private:
+    struct Entry {
+        QString key;
+        int page;
+        QRect rect;
+        int references;
+        // Frame of the last acquire or release, for evicting the least recently used entries
+        quint32 lastUsed;
+    };
+
+    struct Page {
+        GLuint textureId;
+        int size;
+        int shelfY;
+        int shelfHeight;
+        int cursorX;
+        bool mipmapsDirty;
+        quint32 mipmapFrame;
+        QList<int> entries;
+    };
+
+    bool allocate(Page &page, const QSize &size, QPoint &position);
+    int addPage(const QSize &minimumSize);
+    bool growPage(int pageIndex);
+    int reclaimSpace(const QSize &size, QPoint &position);
+    bool compactPage(int pageIndex, const QSize &reserveSize, QPoint &position);
+    void removeEntry(int entry);
+    void updateUvs(int entry);
+    void updateMipmaps(Page &page);
+    GLuint createPageTexture(int size);
+    void clearTexture(GLuint textureId, int size);
+    bool attachTexture(GLuint textureId);
+
+    TextureHelper *m_textureHelper;
+    int m_maxPageSize;
+    QList<Page> m_pages;
+    QList<Entry> m_entries;
+    QList<int> m_freeEntries;
+    QHash<QString, int> m_entryIndex;
+    QList<GLfloat> m_uvData;
+    bool m_uvDataDirty;
+    quint32 m_frame;
+    bool m_mipmapsDeferred;
+    GLuint m_vertexBuffer;
+    GLuint m_uvBuffer;
+    GLuint m_frameBuffer;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -714,9 +714,14 @@ qreal QAbstract3DGraph::aspectRatio() const
  * large non-changing data sets. It is slower with dynamic data changes and item rotations.
  * Selection is not optimized, so using the static mode with massive data sets is not advisable.
  * Static optimization works only on scatter graphs.
+ * Scatter graphs draw all the items of a series that uses a mesh with a single instanced
+ * draw call in both modes, if the OpenGL context supports it (OpenGL 3.3 or
+ * OpenGL ES 3.0 is required). In the static mode, the item transformations are then kept in
+ * a compact buffer on the GPU instead of baking a copy of the mesh for each item.
  * Defaults to \l{OptimizationDefault}.
  *
- * \note On some environments, large graphs using static optimization may not render, because
+ * \note On some environments without instanced drawing support, large graphs using static
+ * optimization may not render, because
  * all of the items are rendered using a single draw call, and different graphics drivers
  * support different maximum vertice counts per call.
  * This is mostly an issue on 32bit and OpenGL ES2 platforms.
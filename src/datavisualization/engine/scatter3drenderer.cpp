@@ -35,9 +35,16 @@
 #include "scatterseriesrendercache_p.h"
 #include "scatterobjectbufferhelper_p.h"
 #include "scatterpointbufferhelper_p.h"
+#include "scatterinstancebufferhelper_p.h"
+#include "viewfrustum_p.h"
+#include "qscatterdataproxy_p.h"
+#include "objecthelper_p.h"
+#include "raypicker_p.h"
 
 #include <QtCore/qmath.h>
 
+#include <limits>
+
 // You can verify that depth buffer drawing works correctly by uncommenting this.
 // You should see the scene from  where the light is
 //#define SHOW_DEPTH_TEXTURE_SCENE
@@ -47,6 +54,8 @@ QT_BEGIN_NAMESPACE
 const GLfloat defaultMinSize = 0.01f;
 const GLfloat defaultMaxSize = 0.1f;
 const GLfloat itemScaler = 3.0f;
+// Count of items whose axis positions are resolved together when updating the render items
+const int translationBatchSize = 256;
 
 Scatter3DRenderer::Scatter3DRenderer(Scatter3DController *controller)
     : Abstract3DRenderer(controller),
@@ -58,6 +67,7 @@ Scatter3DRenderer::Scatter3DRenderer(Scatter3DController *controller)
       m_staticSelectedItemShader(0),
       m_pointShader(0),
       m_depthShader(0),
+      m_depthInstancedShader(0),
       m_selectionShader(0),
       m_backgroundShader(0),
       m_staticGradientPointShader(0),
@@ -93,6 +103,7 @@ Scatter3DRenderer::~Scatter3DRenderer()
     delete m_staticSelectedItemShader;
     delete m_dotGradientShader;
     delete m_depthShader;
+    delete m_depthInstancedShader;
     delete m_selectionShader;
     delete m_backgroundShader;
     delete m_staticGradientPointShader;
@@ -192,19 +203,32 @@ void Scatter3DRenderer::updateData()
         if (cache->isVisible()) {
             const QScatter3DSeries *currentSeries = cache->series();
             ScatterRenderItemArray &renderArray = cache->renderArray();
-            QScatterDataProxy *dataProxy = currentSeries->dataProxy();
-            const QScatterDataArray &dataArray = *dataProxy->array();
-            int dataSize = dataArray.size();
+            const QScatterDataProxyPrivate *proxyPrivate = currentSeries->dataProxy()->dptrc();
+            int dataSize = proxyPrivate->itemCount();
             totalDataSize += dataSize;
             if (cache->dataDirty()) {
                 if (dataSize != renderArray.size())
                     renderArray.resize(dataSize);
 
-                for (int i = 0; i < dataSize; i++)
-                    updateRenderItem(dataArray.at(i), renderArray[i]);
+                // Large arrays are updated in parallel, unless an axis has a reimplemented
+                // formatter. Borrowed arrays are read directly from the buffers of the
+                // application.
+                ScatterRenderItem *renderItems = renderArray.data();
+                if (m_axisCacheX.hasBuiltInFormatter() && m_axisCacheY.hasBuiltInFormatter()
+                        && m_axisCacheZ.hasBuiltInFormatter()) {
+                    Utils::parallelFor(dataSize,
+                                       [this, proxyPrivate, renderItems](int begin, int end) {
+                        updateRenderItems(proxyPrivate, renderItems, begin, end);
+                    });
+                } else {
+                    updateRenderItems(proxyPrivate, renderItems, 0, dataSize);
+                }
 
                 if (m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic))
                     cache->setStaticBufferDirty(true);
+                cache->setInstanceBufferDirty(true);
+                cache->setPickTreeDirty();
+                cache->setRenderChunksDirty();
 
                 cache->setDataDirty(false);
             }
@@ -221,9 +245,6 @@ void Scatter3DRenderer::updateData()
         foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
             ScatterSeriesRenderCache *cache = static_cast<ScatterSeriesRenderCache *>(baseCache);
             if (cache->isVisible()) {
-                ScatterRenderItemArray &renderArray = cache->renderArray();
-                const int renderArraySize = renderArray.size();
-
                 if (cache->mesh() == QAbstract3DSeries::MeshPoint) {
                     ScatterPointBufferHelper *points = cache->bufferPoints();
                     if (!points) {
@@ -232,21 +253,24 @@ void Scatter3DRenderer::updateData()
                     }
                     points->setScaleY(m_scaleY);
                     points->load(cache);
-                } else {
+                } else if (!m_instancingSupported) {
+                    // With instancing the items are transformed on GPU, and only the instance
+                    // buffer needs to be reloaded before drawing. Otherwise the mesh is
+                    // replicated for each item.
                     ScatterObjectBufferHelper *object = cache->bufferObject();
                     if (!object) {
                         object = new ScatterObjectBufferHelper();
                         cache->setBufferObject(object);
                     }
-                    if (renderArraySize != cache->oldArraySize()
-                            || cache->object()->objectFile() != cache->oldMeshFileName()
-                            || cache->staticBufferDirty()) {
-                        object->setScaleY(m_scaleY);
+                    // Data, array size, and item visibility changes are patched into
+                    // the existing buffers, unless they run out of spare item slots.
+                    object->setScaleY(m_scaleY);
+                    if (cache->object()->objectFile() != cache->oldMeshFileName()
+                            || !object->update(cache, m_dotSizeScale)) {
                         object->fullLoad(cache, m_dotSizeScale);
-                        cache->setOldArraySize(renderArraySize);
                         cache->setOldMeshFileName(cache->object()->objectFile());
                     } else {
-                        object->update(cache, m_dotSizeScale);
+                        object->updateUVs(cache);
                     }
                 }
 
@@ -322,7 +346,8 @@ void Scatter3DRenderer::updateSeries(const QList<QAbstract3DSeries *> &seriesLis
             if (cache->staticBufferDirty()) {
                 if (cache->mesh() != QAbstract3DSeries::MeshPoint) {
                     ScatterObjectBufferHelper *object = cache->bufferObject();
-                    object->update(cache, m_dotSizeScale);
+                    if (object && !object->update(cache, m_dotSizeScale))
+                        object->fullLoad(cache, m_dotSizeScale);
                 }
                 cache->setStaticBufferDirty(false);
             }
@@ -332,7 +357,8 @@ void Scatter3DRenderer::updateSeries(const QList<QAbstract3DSeries *> &seriesLis
                     object->updateUVs(cache);
                 } else {
                     ScatterObjectBufferHelper *object = cache->bufferObject();
-                    object->updateUVs(cache);
+                    if (object)
+                        object->updateUVs(cache);
                 }
                 cache->setStaticObjectUVDirty(false);
             }
@@ -357,7 +383,7 @@ void Scatter3DRenderer::updateItems(const QList<Scatter3DController::ChangeItem>
 {
     ScatterSeriesRenderCache *cache = 0;
     const QScatter3DSeries *prevSeries = 0;
-    const QScatterDataArray *dataArray = 0;
+    const QScatterDataProxyPrivate *proxyPrivate = 0;
     const bool optimizationStatic = m_cachedOptimizationHint.testFlag(
                 QAbstract3DGraph::OptimizationStatic);
 
@@ -366,7 +392,7 @@ void Scatter3DRenderer::updateItems(const QList<Scatter3DController::ChangeItem>
         if (currentSeries != prevSeries) {
             cache = static_cast<ScatterSeriesRenderCache *>(m_renderCacheList.value(currentSeries));
             prevSeries = currentSeries;
-            dataArray = item.series->dataProxy()->array();
+            proxyPrivate = item.series->dataProxy()->dptrc();
             // Invisible series render caches are not updated, but instead just marked dirty, so that
             // they can be completely recalculated when they are turned visible.
             if (!cache->isVisible() && !cache->dataDirty())
@@ -380,7 +406,12 @@ void Scatter3DRenderer::updateItems(const QList<Scatter3DController::ChangeItem>
             ScatterRenderItem &item = cache->renderArray()[index];
             if (optimizationStatic)
                 oldVisibility = item.isVisible();
-            updateRenderItem(dataArray->at(index), item);
+            updateRenderItem(proxyPrivate->itemPosition(index),
+                             proxyPrivate->itemRotation(index), item);
+            cache->setPickTreeDirty();
+            cache->setRenderChunksDirty();
+            if (!optimizationStatic)
+                cache->setInstanceBufferDirty(true);
             if (optimizationStatic) {
                 if (!cache->visibilityChanged() && oldVisibility != item.isVisible())
                     cache->setVisibilityChanged(true);
@@ -396,16 +427,22 @@ void Scatter3DRenderer::updateItems(const QList<Scatter3DController::ChangeItem>
                     cache->bufferPoints()->update(cache);
                     if (cache->colorStyle() == Q3DTheme::ColorStyleRangeGradient)
                         cache->bufferPoints()->updateUVs(cache);
+                } else if (m_instancingSupported) {
+                    // If any change changes item visibility, the instances need a full load
+                    // before drawing.
+                    if (cache->visibilityChanged() || !cache->bufferInstances())
+                        cache->setInstanceBufferDirty(true);
+                    else
+                        cache->bufferInstances()->update(cache);
                 } else {
-                    if (cache->visibilityChanged()) {
-                        // If any change changes item visibility, full load is needed to
-                        // resize the buffers.
+                    // Items that change visibility are moved in and out of free item slots.
+                    // Full load is needed only if the buffers run out of slots.
+                    if (!cache->bufferObject()->update(cache, m_dotSizeScale)) {
                         cache->updateIndices().clear();
                         cache->bufferObject()->fullLoad(cache, m_dotSizeScale);
-                    } else {
-                        cache->bufferObject()->update(cache, m_dotSizeScale);
-                        if (cache->colorStyle() == Q3DTheme::ColorStyleRangeGradient)
-                            cache->bufferObject()->updateUVs(cache);
+                    } else if (cache->visibilityChanged()
+                               || cache->colorStyle() == Q3DTheme::ColorStyleRangeGradient) {
+                        cache->bufferObject()->updateUVs(cache);
                     }
                 }
                 cache->updateIndices().clear();
@@ -492,6 +529,26 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
     const bool optimizationDefault =
             !m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic);
 
+    // Mesh series are drawn with one instanced draw call per series, if possible
+    const bool drawInstanced = m_instancingSupported;
+    if (drawInstanced && m_haveMeshSeries) {
+        foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+            ScatterSeriesRenderCache *cache = static_cast<ScatterSeriesRenderCache *>(baseCache);
+            if (cache->isVisible() && cache->mesh() != QAbstract3DSeries::MeshPoint) {
+                ScatterInstanceBufferHelper *instances = cache->bufferInstances();
+                if (!instances) {
+                    instances = new ScatterInstanceBufferHelper();
+                    cache->setBufferInstances(instances);
+                }
+                float itemSize = cache->itemSize() / itemScaler;
+                if (itemSize == 0.0f)
+                    itemSize = m_dotSizeScale;
+                if (instances->isLoadNeeded(cache, itemSize))
+                    instances->load(cache, itemSize);
+            }
+        }
+    }
+
     const Q3DCamera *activeCamera = m_cachedScene->activeCamera();
 
     QVector4D lightColor = Utils::vectorFromColor(m_cachedTheme->lightColor());
@@ -518,6 +575,7 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
     // Calculate view matrix
     QMatrix4x4 viewMatrix = activeCamera->d_ptr->viewMatrix();
     QMatrix4x4 projectionViewMatrix = projectionMatrix * viewMatrix;
+    const ViewFrustum viewFrustum(projectionViewMatrix);
 
     // Calculate label flipping
     if (viewMatrix.row(0).x() > 0)
@@ -588,6 +646,7 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
             // Set the depth projection matrix
             depthProjectionMatrix.perspective(15.0f, viewPortRatio, 3.0f, 100.0f);
             depthProjectionViewMatrix = depthProjectionMatrix * depthViewMatrix;
+            const ViewFrustum depthFrustum(depthProjectionViewMatrix);
 
             // Draw dots to depth buffer
             foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
@@ -597,7 +656,6 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                     ObjectHelper *dotObj = cache->object();
                     QQuaternion seriesRotation(cache->meshRotation());
                     const ScatterRenderItemArray &renderArray = cache->renderArray();
-                    const int renderArraySize = renderArray.size();
                     bool drawingPoints = (cache->mesh() == QAbstract3DSeries::MeshPoint);
                     float itemSize = cache->itemSize() / itemScaler;
                     if (itemSize == 0.0f)
@@ -608,6 +666,26 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                     }
                     QVector3D modelScaler(itemSize, itemSize, itemSize);
 
+                    if (drawInstanced && !drawingPoints) {
+                        // Only the instances in the chunks the light sees are drawn
+                        ScatterInstanceBufferHelper *instances = cache->bufferInstances();
+                        if (instances->indexCount() > 0) {
+                            instances->cullInstances(depthFrustum,
+                                                     cullingMargin(cache, itemSize),
+                                                     m_culledInstances);
+                            if (!m_culledInstances.isEmpty()) {
+                                m_depthInstancedShader->bind();
+                                m_depthInstancedShader->setUniformValue(
+                                            m_depthInstancedShader->MVP(),
+                                            depthProjectionViewMatrix);
+                                m_drawer->drawInstancedObject(m_depthInstancedShader, dotObj,
+                                                              instances, m_culledInstances);
+                                m_depthShader->bind();
+                            }
+                        }
+                        continue;
+                    }
+
                     if (!optimizationDefault
                             && ((drawingPoints && cache->bufferPoints()->indexCount() == 0)
                                 || (!drawingPoints && cache->bufferObject()->indexCount() == 0))) {
@@ -615,12 +693,15 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                     }
 
                     int loopCount = 1;
-                    if (optimizationDefault)
-                        loopCount = renderArraySize;
-                    for (int dot = 0; dot < loopCount; dot++) {
-                        const ScatterRenderItem &item = renderArray.at(dot);
-                        if (!item.isVisible() && optimizationDefault)
-                            continue;
+                    if (optimizationDefault) {
+                        // Only the items in the chunks the light sees are drawn
+                        cache->cullItems(depthFrustum, cullingMargin(cache, itemSize),
+                                         m_culledItems);
+                        loopCount = m_culledItems.size();
+                    }
+                    for (int i = 0; i < loopCount; i++) {
+                        const ScatterRenderItem &item =
+                                renderArray.at(optimizationDefault ? m_culledItems.at(i) : 0);
 
                         QMatrix4x4 modelMatrix;
                         QMatrix4x4 MVPMatrix;
@@ -722,10 +803,18 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
     }
 
     // Skip selection mode drawing if we have no selection mode
-    if (m_cachedSelectionMode > QAbstract3DGraph::SelectionNone
+    QVector4D clickedColor;
+    if (selectionReadbackPending()) {
+        // Resolve the click when the color read on an earlier frame is available
+        if (finishSelectionReadback(clickedColor)) {
+            selectionColorToSeriesAndIndex(clickedColor, m_clickedIndex, m_clickedSeries);
+            m_clickResolved = true;
+        }
+        emit needRender();
+    } else if (m_cachedSelectionMode > QAbstract3DGraph::SelectionNone
             && SelectOnScene == m_selectionState
             && (m_visibleSeriesCount > 0 || !m_customRenderCache.isEmpty())
-            && m_selectionTexture) {
+            && m_selectionTexture && !pickItem(projectionViewMatrix)) {
         // Draw dots to selection buffer
         glBindFramebuffer(GL_FRAMEBUFFER, m_selectionFrameBuffer);
         glViewport(0, 0,
@@ -739,6 +828,7 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
 
         bool previousDrawingPoints = false;
         int totalIndex = 0;
+        m_selectionRanges.clear();
         foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
             if (baseCache->isVisible()) {
                 ScatterSeriesRenderCache *cache =
@@ -767,13 +857,14 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
 
                     selectionShader->bind();
                 }
-                cache->setSelectionIndexOffset(totalIndex);
-                for (int dot = 0; dot < renderArraySize; dot++) {
+                const int selectionIndexOffset = totalIndex;
+                SelectionRange range = { cache->series(), selectionIndexOffset, renderArraySize };
+                m_selectionRanges.append(range);
+                totalIndex += renderArraySize;
+                cache->cullItems(viewFrustum, cullingMargin(cache, itemSize), m_culledItems);
+                for (int i = 0; i < m_culledItems.size(); i++) {
+                    const int dot = m_culledItems.at(i);
                     const ScatterRenderItem &item = renderArray.at(dot);
-                    if (!item.isVisible()) {
-                        totalIndex++;
-                        continue;
-                    }
 
                     QMatrix4x4 modelMatrix;
                     QMatrix4x4 MVPMatrix;
@@ -787,7 +878,7 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
 
                     MVPMatrix = projectionViewMatrix * modelMatrix;
 
-                    QVector4D dotColor = indexToSelectionColor(totalIndex++);
+                    QVector4D dotColor = indexToSelectionColor(selectionIndexOffset + dot);
                     dotColor /= 255.0f;
 
                     selectionShader->setUniformValue(selectionShader->MVP(), MVPMatrix);
@@ -811,10 +902,10 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
         glEnable(GL_DITHER);
 
         // Read color under cursor
-        QVector4D clickedColor = Utils::getSelection(m_inputPosition,
-                                                     m_viewport.height());
-        selectionColorToSeriesAndIndex(clickedColor, m_clickedIndex, m_clickedSeries);
-        m_clickResolved = true;
+        if (readSelection(clickedColor)) {
+            selectionColorToSeriesAndIndex(clickedColor, m_clickedIndex, m_clickedSeries);
+            m_clickResolved = true;
+        }
 
         emit needRender();
 
@@ -872,10 +963,11 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
             ObjectHelper *dotObj = cache->object();
             QQuaternion seriesRotation(cache->meshRotation());
             ScatterRenderItemArray &renderArray = cache->renderArray();
-            const int renderArraySize = renderArray.size();
             bool selectedSeries = m_cachedSelectionMode > QAbstract3DGraph::SelectionNone
                     && (m_selectedSeriesCache == cache);
             bool drawingPoints = (cache->mesh() == QAbstract3DSeries::MeshPoint);
+            bool drawingInstances = drawInstanced && !drawingPoints;
+            bool drawPerItem = optimizationDefault && !drawingInstances;
             Q3DTheme::ColorStyle colorStyle = cache->colorStyle();
             bool colorStyleIsUniform = (colorStyle == Q3DTheme::ColorStyleUniform);
             bool useColor = colorStyleIsUniform || drawingPoints;
@@ -892,9 +984,18 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
             int gradientImageHeight = cache->gradientImage().height();
             int maxGradientPositition = gradientImageHeight - 1;
 
-            if (!optimizationDefault
-                    && ((drawingPoints && cache->bufferPoints()->indexCount() == 0)
-                        || (!drawingPoints && cache->bufferObject()->indexCount() == 0))) {
+            if (drawingInstances) {
+                // Only the instances in the chunks inside the view are drawn
+                if (cache->bufferInstances()->indexCount() == 0)
+                    continue;
+                cache->bufferInstances()->cullInstances(viewFrustum,
+                                                        cullingMargin(cache, itemSize),
+                                                        m_culledInstances);
+                if (m_culledInstances.isEmpty())
+                    continue;
+            } else if (!optimizationDefault
+                       && ((drawingPoints && cache->bufferPoints()->indexCount() == 0)
+                           || (!drawingPoints && cache->bufferObject()->indexCount() == 0))) {
                 continue;
             }
 
@@ -938,24 +1039,37 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
             if (!drawingPoints)
                 previousMeshColorStyle = colorStyle;
 
+            if (drawingInstances && !colorStyleIsUniform) {
+                // The gradient position of each instance is resolved in the vertex shader
+                dotShader->setUniformValue(dotShader->gradientMin(), 0.0f);
+                dotShader->setUniformValue(dotShader->gradientHeight(), 0.5f);
+                if (colorStyle == Q3DTheme::ColorStyleRangeGradient) {
+                    dotShader->setUniformValue(dotShader->instanceGradientScale(),
+                                               rangeGradientYScaler);
+                } else {
+                    dotShader->setUniformValue(dotShader->instanceGradientScale(), 0.0f);
+                }
+            }
+
             if (useColor) {
                 baseColor = cache->baseColor();
                 dotColor = baseColor;
             }
             int loopCount = 1;
-            if (optimizationDefault)
-                loopCount = renderArraySize;
+            if (drawPerItem) {
+                cache->cullItems(viewFrustum, cullingMargin(cache, itemSize), m_culledItems);
+                loopCount = m_culledItems.size();
+            }
 
             for (int i = 0; i < loopCount; i++) {
-                ScatterRenderItem &item = renderArray[i];
-                if (!item.isVisible() && optimizationDefault)
-                    continue;
+                const int index = drawPerItem ? m_culledItems.at(i) : 0;
+                ScatterRenderItem &item = renderArray[index];
 
                 QMatrix4x4 modelMatrix;
                 QMatrix4x4 MVPMatrix;
                 QMatrix4x4 itModelMatrix;
 
-                if (optimizationDefault) {
+                if (drawPerItem) {
                     modelMatrix.translate(item.translation());
                     if (!drawingPoints) {
                         if (!seriesRotation.isIdentity() || !item.rotation().isIdentity()) {
@@ -992,7 +1106,7 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                     gradientTexture = cache->baseGradientTexture();
 
                 GLfloat lightStrength = m_cachedTheme->lightStrength();
-                if (optimizationDefault && selectedSeries && (m_selectedItemIndex == i)) {
+                if (drawPerItem && selectedSeries && (m_selectedItemIndex == index)) {
                     if (useColor)
                         dotColor = cache->singleHighlightColor();
                     else
@@ -1016,7 +1130,7 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                 dotShader->setUniformValue(dotShader->MVP(), MVPMatrix);
                 if (useColor) {
                     dotShader->setUniformValue(dotShader->color(), dotColor);
-                } else if (colorStyle == Q3DTheme::ColorStyleRangeGradient) {
+                } else if (colorStyle == Q3DTheme::ColorStyleRangeGradient && !drawingInstances) {
                     dotShader->setUniformValue(dotShader->gradientMin(),
                                                (item.translation().y() + m_scaleY)
                                                * rangeGradientYScaler);
@@ -1030,7 +1144,12 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                         dotShader->setUniformValue(dotShader->lightS(), lightStrength / 10.0f);
 
                         // Draw the object
-                        if (optimizationDefault) {
+                        if (drawingInstances) {
+                            m_drawer->drawInstancedObject(dotShader, dotObj,
+                                                          cache->bufferInstances(),
+                                                          m_culledInstances, gradientTexture,
+                                                          m_depthTexture);
+                        } else if (optimizationDefault) {
                             m_drawer->drawObject(dotShader, dotObj, gradientTexture,
                                                  m_depthTexture);
                         } else {
@@ -1049,10 +1168,15 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                         // Set shadowless shader bindings
                         dotShader->setUniformValue(dotShader->lightS(), lightStrength);
                         // Draw the object
-                        if (optimizationDefault)
+                        if (drawingInstances) {
+                            m_drawer->drawInstancedObject(dotShader, dotObj,
+                                                          cache->bufferInstances(),
+                                                          m_culledInstances, gradientTexture);
+                        } else if (optimizationDefault) {
                             m_drawer->drawObject(dotShader, dotObj, gradientTexture);
-                        else
+                        } else {
                             m_drawer->drawObject(dotShader, cache->bufferObject(), gradientTexture);
+                        }
                     } else {
                         // Draw the object
                         if (optimizationDefault)
@@ -1064,8 +1188,8 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
             }
 
 
-            // Draw the selected item on static optimization
-            if (!optimizationDefault && selectedSeries
+            // Draw the selected item on static optimization and instanced drawing
+            if ((!optimizationDefault || drawingInstances) && selectedSeries
                     && m_selectedItemIndex != Scatter3DController::invalidSelectionIndex()) {
                 ScatterRenderItem &item = renderArray[m_selectedItemIndex];
                 if (item.isVisible()) {
@@ -1666,6 +1790,7 @@ void Scatter3DRenderer::drawLabels(bool drawSelection, const Q3DCamera *activeCa
 
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        m_drawer->beginLabels();
     }
 
     glEnable(GL_POLYGON_OFFSET_FILL);
@@ -2143,6 +2268,8 @@ void Scatter3DRenderer::drawLabels(bool drawSelection, const Q3DCamera *activeCa
                            shader);
         }
     }
+    if (!drawSelection)
+        m_drawer->endLabels();
     glDisable(GL_POLYGON_OFFSET_FILL);
 }
 
@@ -2380,6 +2507,14 @@ void Scatter3DRenderer::initDepthShader()
         m_depthShader = new ShaderHelper(this, QStringLiteral(":/shaders/vertexDepth"),
                                          QStringLiteral(":/shaders/fragmentDepth"));
         m_depthShader->initialize();
+
+        if (m_instancingSupported) {
+            delete m_depthInstancedShader;
+            m_depthInstancedShader = new ShaderHelper(this,
+                                                      QStringLiteral(":/shaders/vertexDepthInstanced"),
+                                                      QStringLiteral(":/shaders/fragmentDepth"));
+            m_depthInstancedShader->initialize();
+        }
     }
 }
 
@@ -2464,19 +2599,16 @@ void Scatter3DRenderer::selectionColorToSeriesAndIndex(const QVector4D &color,
             int totalIndex = int(color.x())
                     + (int(color.y()) << 8)
                     + (int(color.z()) << 16);
-            // Find the series and adjust the index accordingly
-            foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
-                if (baseCache->isVisible()) {
-                    ScatterSeriesRenderCache *cache =
-                            static_cast<ScatterSeriesRenderCache *>(baseCache);
-                    int offset = cache->selectionIndexOffset();
-                    if (totalIndex >= offset
-                            && totalIndex < (offset + cache->renderArray().size())) {
-                        index = totalIndex - offset;
-                        series = cache->series();
-                        m_clickedType = QAbstract3DGraph::ElementSeries;
-                        return;
-                    }
+            // Find the series and adjust the index accordingly. The series are looked up from
+            // the ones the selection buffer was drawn with, and may have been removed since.
+            foreach (const SelectionRange &range, m_selectionRanges) {
+                if (totalIndex >= range.offset && totalIndex < (range.offset + range.count)) {
+                    if (!range.series)
+                        break;
+                    index = totalIndex - range.offset;
+                    series = range.series.data();
+                    m_clickedType = QAbstract3DGraph::ElementSeries;
+                    return;
                 }
             }
         }
@@ -2487,17 +2619,127 @@ void Scatter3DRenderer::selectionColorToSeriesAndIndex(const QVector4D &color,
     series = 0;
 }
 
-void Scatter3DRenderer::updateRenderItem(const QScatterDataItem &dataItem,
+// Resolves the click by casting a ray against the items of the visible series. Returns false
+// if the selection buffer needs to be drawn to resolve the click, which is the case when
+// the ray hits nothing, as the click may be on a label, when an axis label may be in front of
+// the hit, or when there are custom items or point series, as those are not picked on CPU.
+bool Scatter3DRenderer::pickItem(const QMatrix4x4 &projectionViewMatrix)
+{
+    if (!m_customRenderCache.isEmpty())
+        return false;
+
+    RayPicker::Ray ray;
+    if (!RayPicker::selectionRay(m_inputPosition, m_primarySubViewport.size(),
+                                 m_viewport.height(), projectionViewMatrix, ray)) {
+        return false;
+    }
+
+    float closestDistance = std::numeric_limits<float>::max();
+    ScatterSeriesRenderCache *closestCache = 0;
+    int closestIndex = -1;
+    foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+        if (!baseCache->isVisible())
+            continue;
+        ScatterSeriesRenderCache *cache = static_cast<ScatterSeriesRenderCache *>(baseCache);
+        // Point sizes are in pixels, so points do not have a size in the scene
+        if (cache->mesh() == QAbstract3DSeries::MeshPoint)
+            return false;
+
+        const ObjectHelper *dotObj = cache->object();
+        const QQuaternion seriesRotation(cache->meshRotation());
+        const ScatterRenderItemArray &renderArray = cache->renderArray();
+        float itemSize = cache->itemSize() / itemScaler;
+        if (itemSize == 0.0f)
+            itemSize = m_dotSizeScale;
+        const QVector3D modelScaler(itemSize, itemSize, itemSize);
+        const float radius = dotObj->boundingRadius() * itemSize;
+
+        auto hitDistance = [&](int index) -> float {
+            const ScatterRenderItem &item = renderArray.at(index);
+            const QVector3D toItem = item.translation() - ray.origin;
+            const float along = QVector3D::dotProduct(toItem, ray.direction);
+            if ((toItem - along * ray.direction).lengthSquared() > radius * radius)
+                return -1.0f;
+
+            QMatrix4x4 modelMatrix;
+            modelMatrix.translate(item.translation());
+            if (!seriesRotation.isIdentity() || !item.rotation().isIdentity())
+                modelMatrix.rotate(seriesRotation * item.rotation());
+            modelMatrix.scale(modelScaler);
+            return RayPicker::intersectMesh(ray, modelMatrix, dotObj);
+        };
+
+        // Building the tree costs more than scanning the items once, so the first click after
+        // a data change is resolved with a scan. The tree is built if the data stays unchanged
+        // until the next click.
+        int index = -1;
+        float distance = std::numeric_limits<float>::max();
+        if (cache->isPickTreeDirty() && !cache->pickScanned()) {
+            for (int i = 0; i < renderArray.size(); i++) {
+                if (!renderArray.at(i).isVisible())
+                    continue;
+                const float t = hitDistance(i);
+                if (t >= 0.0f && t < distance) {
+                    distance = t;
+                    index = i;
+                }
+            }
+            cache->setPickScanned();
+        } else {
+            if (cache->isPickTreeDirty())
+                cache->updatePickTree();
+            const QList<int> &pickItems = cache->pickItems();
+            const int hit = cache->pickTree().closestHit(ray, radius, [&](int primitive) {
+                return hitDistance(pickItems.at(primitive));
+            }, distance);
+            if (hit >= 0)
+                index = pickItems.at(hit);
+        }
+
+        if (index >= 0 && distance < closestDistance) {
+            closestDistance = distance;
+            closestCache = cache;
+            closestIndex = index;
+        }
+    }
+
+    if (!closestCache)
+        return false;
+    // Axis labels are drawn to the selection buffer as well, and hide the items behind them
+    if (m_drawer->isLabelInFront(ray, projectionViewMatrix, closestDistance))
+        return false;
+
+    m_clickedType = QAbstract3DGraph::ElementSeries;
+    m_selectedLabelIndex = -1;
+    m_selectedCustomItemIndex = -1;
+    m_clickedIndex = closestIndex;
+    m_clickedSeries = closestCache->series();
+    m_clickResolved = true;
+
+    emit needRender();
+
+    return true;
+}
+
+// The distance the drawn items of the series can reach from their translations
+float Scatter3DRenderer::cullingMargin(const ScatterSeriesRenderCache *cache, float itemSize) const
+{
+    // Points are sized in pixels, so leave them a margin of an item
+    if (cache->mesh() == QAbstract3DSeries::MeshPoint || !cache->object())
+        return itemSize;
+    return cache->object()->boundingRadius() * itemSize;
+}
+
+void Scatter3DRenderer::updateRenderItem(const QVector3D &dotPos, const QQuaternion &rotation,
                                          ScatterRenderItem &renderItem)
 {
-    QVector3D dotPos = dataItem.position();
     if ((dotPos.x() >= m_axisCacheX.min() && dotPos.x() <= m_axisCacheX.max() )
             && (dotPos.y() >= m_axisCacheY.min() && dotPos.y() <= m_axisCacheY.max())
             && (dotPos.z() >= m_axisCacheZ.min() && dotPos.z() <= m_axisCacheZ.max())) {
         renderItem.setPosition(dotPos);
         renderItem.setVisible(true);
-        if (!dataItem.rotation().isIdentity())
-            renderItem.setRotation(dataItem.rotation().normalized());
+        if (!rotation.isIdentity())
+            renderItem.setRotation(rotation.normalized());
         else
             renderItem.setRotation(identityQuaternion);
         calculateTranslation(renderItem);
@@ -2506,6 +2748,56 @@ void Scatter3DRenderer::updateRenderItem(const QScatterDataItem &dataItem,
     }
 }
 
+void Scatter3DRenderer::updateRenderItems(const QScatterDataProxyPrivate *proxyPrivate,
+                                          ScatterRenderItem *renderItems, int begin, int end)
+{
+    // Same as updateRenderItem() for each item, but the axis positions of the items are
+    // resolved a batch at a time instead of calling the axis formatters for every value
+    float xValues[translationBatchSize];
+    float yValues[translationBatchSize];
+    float zValues[translationBatchSize];
+    float xTrans[translationBatchSize];
+    float yTrans[translationBatchSize];
+    float zTrans[translationBatchSize];
+
+    for (int batchStart = begin; batchStart < end; batchStart += translationBatchSize) {
+        const int count = qMin(translationBatchSize, end - batchStart);
+        for (int i = 0; i < count; i++) {
+            const QVector3D dotPos = proxyPrivate->itemPosition(batchStart + i);
+            xValues[i] = dotPos.x();
+            yValues[i] = dotPos.y();
+            zValues[i] = dotPos.z();
+        }
+
+        m_axisCacheY.positionsAt(yValues, yTrans, count);
+        if (!m_polarGraph) {
+            m_axisCacheX.positionsAt(xValues, xTrans, count);
+            m_axisCacheZ.positionsAt(zValues, zTrans, count);
+        }
+
+        for (int i = 0; i < count; i++) {
+            const QVector3D dotPos(xValues[i], yValues[i], zValues[i]);
+            ScatterRenderItem &renderItem = renderItems[batchStart + i];
+            if ((dotPos.x() >= m_axisCacheX.min() && dotPos.x() <= m_axisCacheX.max())
+                    && (dotPos.y() >= m_axisCacheY.min() && dotPos.y() <= m_axisCacheY.max())
+                    && (dotPos.z() >= m_axisCacheZ.min() && dotPos.z() <= m_axisCacheZ.max())) {
+                renderItem.setPosition(dotPos);
+                renderItem.setVisible(true);
+                const QQuaternion rotation = proxyPrivate->itemRotation(batchStart + i);
+                if (!rotation.isIdentity())
+                    renderItem.setRotation(rotation.normalized());
+                else
+                    renderItem.setRotation(identityQuaternion);
+                if (m_polarGraph)
+                    calculatePolarXZ(dotPos, xTrans[i], zTrans[i]);
+                renderItem.setTranslation(QVector3D(xTrans[i], yTrans[i], zTrans[i]));
+            } else {
+                renderItem.setVisible(false);
+            }
+        }
+    }
+}
+
 QVector3D Scatter3DRenderer::convertPositionToTranslation(const QVector3D &position,
                                                           bool isAbsolute)
 {
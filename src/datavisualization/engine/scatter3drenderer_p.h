@@ -53,12 +53,20 @@ class ShaderHelper;
 class Q3DScene;
 class ScatterSeriesRenderCache;
 class QScatterDataItem;
+class QScatterDataProxyPrivate;
 
 class Q_DATAVISUALIZATION_EXPORT Scatter3DRenderer : public Abstract3DRenderer
 {
     Q_OBJECT
 
 private:
+    // Selection indices of a series in the selection buffer
+    struct SelectionRange {
+        QPointer<QAbstract3DSeries> series;
+        int offset;
+        int count;
+    };
+
     // Internal state
     ScatterRenderItem *m_selectedItem; // points to renderitem array
     bool m_updateLabels;
@@ -68,6 +76,7 @@ private:
     ShaderHelper *m_staticSelectedItemShader;
     ShaderHelper *m_pointShader;
     ShaderHelper *m_depthShader;
+    ShaderHelper *m_depthInstancedShader;
     ShaderHelper *m_selectionShader;
     ShaderHelper *m_backgroundShader;
     ShaderHelper *m_staticGradientPointShader;
@@ -92,6 +101,11 @@ private:
     bool m_haveMeshSeries;
     bool m_haveUniformColorMeshSeries;
     bool m_haveGradientMeshSeries;
+    QList<int> m_culledItems; // Reused by the draw passes
+    QList<QPair<int, int>> m_culledInstances; // Instance ranges, reused by the draw passes
+    // Series drawn to the selection buffer, as the color under the cursor may be read back on
+    // a later frame
+    QList<SelectionRange> m_selectionRanges;
 
 public:
     explicit Scatter3DRenderer(Scatter3DController *controller);
@@ -153,7 +167,12 @@ private:
 
     void selectionColorToSeriesAndIndex(const QVector4D &color, int &index,
                                         QAbstract3DSeries *&series);
-    inline void updateRenderItem(const QScatterDataItem &dataItem, ScatterRenderItem &renderItem);
+    bool pickItem(const QMatrix4x4 &projectionViewMatrix);
+    float cullingMargin(const ScatterSeriesRenderCache *cache, float itemSize) const;
+    inline void updateRenderItem(const QVector3D &dotPos, const QQuaternion &rotation,
+                                 ScatterRenderItem &renderItem);
+    void updateRenderItems(const QScatterDataProxyPrivate *proxyPrivate,
+                           ScatterRenderItem *renderItems, int begin, int end);
 
     Q_DISABLE_COPY(Scatter3DRenderer)
 };
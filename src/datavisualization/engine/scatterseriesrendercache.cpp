@@ -30,20 +30,29 @@
 #include "scatterseriesrendercache_p.h"
 #include "scatterobjectbufferhelper_p.h"
 #include "scatterpointbufferhelper_p.h"
+#include "scatterinstancebufferhelper_p.h"
+
+#include <QtCore/qmath.h>
 
 QT_BEGIN_NAMESPACE
 
+static const int itemsPerChunk = 512;
+static const int maxChunksPerAxis = 16;
+
 ScatterSeriesRenderCache::ScatterSeriesRenderCache(QAbstract3DSeries *series,
                                                    Abstract3DRenderer *renderer)
     : SeriesRenderCache(series, renderer),
       m_itemSize(0.0f),
-      m_selectionIndexOffset(0),
       m_staticBufferDirty(false),
-      m_oldRenderArraySize(0),
       m_oldMeshFileName(QString()),
       m_scatterBufferObj(0),
       m_scatterBufferPoints(0),
-      m_visibilityChanged(false)
+      m_scatterBufferInstances(0),
+      m_instanceBufferDirty(true),
+      m_visibilityChanged(false),
+      m_pickTreeDirty(true),
+      m_pickScanned(false),
+      m_renderChunksDirty(true)
 {
 }
 
@@ -51,13 +60,145 @@ ScatterSeriesRenderCache::~ScatterSeriesRenderCache()
 {
     delete m_scatterBufferObj;
     delete m_scatterBufferPoints;
+    delete m_scatterBufferInstances;
 }
 
 void ScatterSeriesRenderCache::cleanup(TextureHelper *texHelper)
 {
     m_renderArray.clear();
+    setPickTreeDirty();
+    setRenderChunksDirty();
 
     SeriesRenderCache::cleanup(texHelper);
 }
 
+void ScatterSeriesRenderCache::updatePickTree()
+{
+    QList<QVector3D> translations;
+    translations.reserve(m_renderArray.size());
+    m_pickItems.clear();
+    m_pickItems.reserve(m_renderArray.size());
+    for (int i = 0; i < m_renderArray.size(); i++) {
+        const ScatterRenderItem &item = m_renderArray.at(i);
+        if (item.isVisible()) {
+            translations.append(item.translation());
+            m_pickItems.append(i);
+        }
+    }
+    m_pickTree.build(translations, translations);
+    m_pickTreeDirty = false;
+}
+
+// Collects the visible items of the chunks that are at least partially inside the frustum.
+// The margin is the distance an item can extend from its translation.
+void ScatterSeriesRenderCache::cullItems(const ViewFrustum &frustum, float margin,
+                                         QList<int> &items)
+{
+    if (m_renderChunksDirty)
+        updateRenderChunks();
+
+    const QVector3D marginVector(margin, margin, margin);
+    items.clear();
+    foreach (const RenderChunk &chunk, m_renderChunks) {
+        if (frustum.intersectsBox(chunk.minimum - marginVector, chunk.maximum + marginVector)) {
+            for (int i = chunk.start; i < chunk.start + chunk.count; i++)
+                items.append(m_chunkItems.at(i));
+        }
+    }
+}
+
+const QList<ScatterSeriesRenderCache::RenderChunk> &ScatterSeriesRenderCache::renderChunks()
+{
+    if (m_renderChunksDirty)
+        updateRenderChunks();
+    return m_renderChunks;
+}
+
+const QList<int> &ScatterSeriesRenderCache::chunkItems()
+{
+    if (m_renderChunksDirty)
+        updateRenderChunks();
+    return m_chunkItems;
+}
+
+void ScatterSeriesRenderCache::updateRenderChunks()
+{
+    m_renderChunks.clear();
+    m_chunkItems.clear();
+    m_renderChunksDirty = false;
+
+    const int renderArraySize = m_renderArray.size();
+    int visibleCount = 0;
+    QVector3D minimum;
+    QVector3D maximum;
+    for (int i = 0; i < renderArraySize; i++) {
+        const ScatterRenderItem &item = m_renderArray.at(i);
+        if (!item.isVisible())
+            continue;
+        const QVector3D &translation = item.translation();
+        if (!visibleCount) {
+            minimum = translation;
+            maximum = translation;
+        } else {
+            for (int axis = 0; axis < 3; axis++) {
+                minimum[axis] = qMin(minimum[axis], translation[axis]);
+                maximum[axis] = qMax(maximum[axis], translation[axis]);
+            }
+        }
+        visibleCount++;
+    }
+    if (!visibleCount)
+        return;
+
+    // Sort the items into the cells of the grid by counting the items in each cell first
+    const int chunksPerAxis = qBound(1, int(std::cbrt(float(visibleCount) / itemsPerChunk)),
+                                     maxChunksPerAxis);
+    const QVector3D extent = maximum - minimum;
+    QVector3D cellScale;
+    for (int axis = 0; axis < 3; axis++) {
+        if (extent[axis] > 0.0f)
+            cellScale[axis] = float(chunksPerAxis) / extent[axis];
+    }
+    QList<int> itemCells(renderArraySize, -1);
+    QList<int> cellStarts(chunksPerAxis * chunksPerAxis * chunksPerAxis + 1, 0);
+    for (int i = 0; i < renderArraySize; i++) {
+        const ScatterRenderItem &item = m_renderArray.at(i);
+        if (!item.isVisible())
+            continue;
+        const QVector3D cell = (item.translation() - minimum) * cellScale;
+        const int x = qMin(int(cell.x()), chunksPerAxis - 1);
+        const int y = qMin(int(cell.y()), chunksPerAxis - 1);
+        const int z = qMin(int(cell.z()), chunksPerAxis - 1);
+        itemCells[i] = (z * chunksPerAxis + y) * chunksPerAxis + x;
+        cellStarts[itemCells.at(i) + 1]++;
+    }
+    for (int cell = 1; cell < cellStarts.size(); cell++)
+        cellStarts[cell] += cellStarts.at(cell - 1);
+
+    m_chunkItems.resize(visibleCount);
+    QList<int> cellEnds = cellStarts;
+    for (int i = 0; i < renderArraySize; i++) {
+        if (itemCells.at(i) >= 0)
+            m_chunkItems[cellEnds[itemCells.at(i)]++] = i;
+    }
+
+    for (int cell = 0; cell < cellStarts.size() - 1; cell++) {
+        RenderChunk chunk;
+        chunk.start = cellStarts.at(cell);
+        chunk.count = cellStarts.at(cell + 1) - chunk.start;
+        if (!chunk.count)
+            continue;
+        chunk.minimum = m_renderArray.at(m_chunkItems.at(chunk.start)).translation();
+        chunk.maximum = chunk.minimum;
+        for (int i = chunk.start + 1; i < chunk.start + chunk.count; i++) {
+            const QVector3D &translation = m_renderArray.at(m_chunkItems.at(i)).translation();
+            for (int axis = 0; axis < 3; axis++) {
+                chunk.minimum[axis] = qMin(chunk.minimum[axis], translation[axis]);
+                chunk.maximum[axis] = qMax(chunk.maximum[axis], translation[axis]);
+            }
+        }
+        m_renderChunks.append(chunk);
+    }
+}
+
 QT_END_NAMESPACE
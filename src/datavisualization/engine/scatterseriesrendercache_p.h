@@ -44,11 +44,14 @@
 #include "seriesrendercache_p.h"
 #include "qscatter3dseries_p.h"
 #include "scatterrenderitem_p.h"
+#include "raypicker_p.h"
+#include "viewfrustum_p.h"
 
 QT_BEGIN_NAMESPACE
 
 class ScatterObjectBufferHelper;
 class ScatterPointBufferHelper;
+class ScatterInstanceBufferHelper;
 
 class ScatterSeriesRenderCache : public SeriesRenderCache
 {
@@ -62,35 +65,64 @@ public:
     inline QScatter3DSeries *series() const { return static_cast<QScatter3DSeries *>(m_series); }
     inline void setItemSize(float size) { m_itemSize = size; }
     inline float itemSize() const { return m_itemSize; }
-    inline void setSelectionIndexOffset(int offset) { m_selectionIndexOffset = offset; }
-    inline int selectionIndexOffset() const { return m_selectionIndexOffset; }
     inline void setStaticBufferDirty(bool state) { m_staticBufferDirty = state; }
     inline bool staticBufferDirty() const { return m_staticBufferDirty; }
-    inline int oldArraySize() const { return m_oldRenderArraySize; }
-    inline void setOldArraySize(int size) { m_oldRenderArraySize = size; }
     inline const QString &oldMeshFileName() const { return m_oldMeshFileName; }
     inline void setOldMeshFileName(const QString &meshFileName) { m_oldMeshFileName = meshFileName; }
     inline void setBufferObject(ScatterObjectBufferHelper *object) { m_scatterBufferObj = object; }
     inline ScatterObjectBufferHelper *bufferObject() const { return m_scatterBufferObj; }
     inline void setBufferPoints(ScatterPointBufferHelper *object) { m_scatterBufferPoints = object; }
     inline ScatterPointBufferHelper *bufferPoints() const { return m_scatterBufferPoints; }
+    inline void setBufferInstances(ScatterInstanceBufferHelper *object) { m_scatterBufferInstances = object; }
+    inline ScatterInstanceBufferHelper *bufferInstances() const { return m_scatterBufferInstances; }
+    inline void setInstanceBufferDirty(bool state) { m_instanceBufferDirty = state; }
+    inline bool instanceBufferDirty() const { return m_instanceBufferDirty; }
     inline QList<int> &updateIndices() { return m_updateIndices; }
     inline QList<int> &bufferIndices() { return m_bufferIndices; }
     inline void setVisibilityChanged(bool changed) { m_visibilityChanged = changed; }
     inline bool visibilityChanged() const { return m_visibilityChanged; }
+    inline void setPickTreeDirty() { m_pickTreeDirty = true; m_pickScanned = false; }
+    inline bool isPickTreeDirty() const { return m_pickTreeDirty; }
+    inline bool pickScanned() const { return m_pickScanned; }
+    inline void setPickScanned() { m_pickScanned = true; }
+    inline const BoundingVolumeHierarchy &pickTree() const { return m_pickTree; }
+    inline const QList<int> &pickItems() const { return m_pickItems; }
+    void updatePickTree();
+    inline void setRenderChunksDirty() { m_renderChunksDirty = true; }
+    void cullItems(const ViewFrustum &frustum, float margin, QList<int> &items);
+
+    // Visible items grouped by their location in a regular grid
+    struct RenderChunk
+    {
+        QVector3D minimum;
+        QVector3D maximum;
+        int start; // Offset to chunkItems()
+        int count;
+    };
+    const QList<RenderChunk> &renderChunks();
+    const QList<int> &chunkItems();
 
 protected:
+    void updateRenderChunks();
+
     ScatterRenderItemArray m_renderArray;
     float m_itemSize;
-    int m_selectionIndexOffset; // Temporarily cached value for selection color calculations
     bool m_staticBufferDirty;
-    int m_oldRenderArraySize; // Used to detect if full buffer change needed
     QString m_oldMeshFileName; // Used to detect if full buffer change needed
     ScatterObjectBufferHelper *m_scatterBufferObj;
     ScatterPointBufferHelper *m_scatterBufferPoints;
+    ScatterInstanceBufferHelper *m_scatterBufferInstances;
+    bool m_instanceBufferDirty;
     QList<int> m_updateIndices; // Used as temporary cache during item updates
     QList<int> m_bufferIndices; // Cache for mapping renderarray to mesh buffer
     bool m_visibilityChanged; // Used to detect if full buffer change needed
+    BoundingVolumeHierarchy m_pickTree; // Over the translations of the visible items
+    QList<int> m_pickItems; // Maps pick tree primitives to render array indices
+    bool m_pickTreeDirty;
+    bool m_pickScanned; // Picked without the tree since the last change
+    QList<RenderChunk> m_renderChunks;
+    QList<int> m_chunkItems; // Render array indices of the items, ordered by chunk
+    bool m_renderChunksDirty;
 };
 
 QT_END_NAMESPACE
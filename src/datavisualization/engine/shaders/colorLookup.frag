@@ -0,0 +1,11 @@
+// Looks up the color of a single channel texel from the color table. Included in the volume
+// shaders after the colorIndex and color8Bit uniforms.
+highp vec4 lookupColor(highp vec4 texel) {
+    if (color8Bit == 1)
+        return colorIndex[int(texel.r * 255.0)];
+    // Other single channel values are clamped and interpolated between the color table entries
+    highp float index = clamp(texel.r, 0.0, 1.0) * 255.0;
+    highp float lower = floor(index);
+    highp float upper = min(lower + 1.0, 255.0);
+    return mix(colorIndex[int(lower)], colorIndex[int(upper)], index - lower);
+}
@@ -0,0 +1,16 @@
+uniform highp mat4 MVP;
+
+attribute highp vec3 vertexPosition_mdl;
+attribute highp vec4 instancePosition_wrld;
+attribute highp vec4 instanceRotation;
+
+highp vec3 rotateByQuaternion(highp vec4 q, highp vec3 v) {
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+    highp vec3 position = rotateByQuaternion(instanceRotation,
+                                             vertexPosition_mdl * instancePosition_wrld.w)
+            + instancePosition_wrld.xyz;
+    gl_Position = MVP * vec4(position, 1.0);
+}
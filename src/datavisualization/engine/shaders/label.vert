@@ -1,4 +1,5 @@
 uniform highp mat4 MVP;
+uniform highp vec2 uvOffset;
 
 attribute highp vec3 vertexPosition_mdl;
 attribute highp vec2 vertexUV;
@@ -7,5 +8,5 @@ varying highp vec2 UV;
 
 void main() {
     gl_Position = MVP * vec4(vertexPosition_mdl, 1.0);
-    UV = vertexUV;
+    UV = vertexUV - uvOffset;
 }
@@ -0,0 +1,9 @@
+attribute highp vec4 vertexPosition_mdl;
+attribute highp vec2 vertexUV;
+
+varying highp vec2 UV;
+
+void main() {
+    gl_Position = vertexPosition_mdl;
+    UV = vertexUV;
+}
@@ -11,6 +11,7 @@ uniform highp mat4 V;
 uniform highp mat4 M;
 uniform highp mat4 itM;
 uniform highp vec3 lightPosition_wrld;
+uniform highp vec2 uvOffset;
 
 varying highp vec2 UV;
 varying highp vec3 position_wrld;
@@ -28,5 +29,5 @@ void main() {
     vec3 lightPosition_cmr = vec4(V * vec4(lightPosition_wrld, 1.0)).xyz;
     lightDirection_cmr = lightPosition_cmr + eyeDirection_cmr;
     normal_cmr = vec4(V * itM * vec4(vertexNormal_mdl, 0.0)).xyz;
-    UV = vertexUV;
+    UV = vertexUV - uvOffset;
 }
@@ -8,6 +8,7 @@ uniform highp mat4 M;
 uniform highp mat4 itM;
 uniform highp mat4 depthMVP;
 uniform highp vec3 lightPosition_wrld;
+uniform highp vec2 uvOffset;
 
 attribute highp vec3 vertexPosition_mdl;
 attribute highp vec3 vertexNormal_mdl;
@@ -35,5 +36,5 @@ void main() {
     eyeDirection_cmr = vec3(0.0, 0.0, 0.0) - vertexPosition_cmr;
     lightDirection_cmr = vec4(V * vec4(lightPosition_wrld, 0.0)).xyz;
     normal_cmr = vec4(V * itM * vec4(vertexNormal_mdl, 0.0)).xyz;
-    UV = vertexUV;
+    UV = vertexUV - uvOffset;
 }
@@ -3,6 +3,7 @@ uniform highp mat4 V;
 uniform highp mat4 M;
 uniform highp mat4 itM;
 uniform highp vec3 lightPosition_wrld;
+uniform highp vec2 uvOffset;
 
 attribute highp vec3 vertexPosition_mdl;
 attribute highp vec2 vertexUV;
@@ -23,6 +24,6 @@ void main() {
     vec3 lightPosition_cmr = vec4(V * vec4(lightPosition_wrld, 1.0)).xyz;
     lightDirection_cmr = lightPosition_cmr + eyeDirection_cmr;
     normal_cmr = vec4(V * itM * vec4(vertexNormal_mdl, 0.0)).xyz;
-    UV = vertexUV;
+    UV = vertexUV - uvOffset;
     lightPosition_wrld_frag = lightPosition_wrld;
 }
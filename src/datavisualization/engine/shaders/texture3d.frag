@@ -12,12 +12,20 @@ uniform highp float alphaMultiplier;
 uniform highp int preserveOpacity;
 uniform highp vec3 minBounds;
 uniform highp vec3 maxBounds;
+// Bricks of the volume that are empty have zero alpha in the brick texture. If the volume is
+// pooled, the color of a brick tells the slot of the brick in the pool texture.
+uniform highp sampler3D brickSampler;
+uniform highp vec3 brickDimensions;
+uniform highp vec3 brickCounts;
+uniform highp vec3 poolBrickDimensions;
 
 // Ray traveling straight through a single 'alpha thickness' applies 100% of the encountered alpha.
 // Rays traveling shorter distances apply a fraction. This is used to normalize the alpha over
 // entire volume, regardless of texture dimensions
 const highp float alphaThicknesses = 32.0;
 
+#include ":/shaders/fragmentColorLookup"
+
 void main() {
     vec3 rayStart = pos;
 
@@ -94,11 +102,35 @@ void main() {
         textureSteps.z = -textureDimensions.z;
     }
 
+    highp vec3 rayPositive = vec3(greaterThan(ray, vec3(0.0)));
+    highp vec3 sampleLimit = vec3(1.0) - 0.5 * textureDimensions;
+
     // Raytrace into volume, need to sample pixels along the eye ray until we hit opacity 1
     for (int i = 0; i < sampleCount; i++) {
-        curColor = texture3D(textureSampler, curPos);
+        highp vec3 samplePos = clamp(curPos, vec3(0.0), sampleLimit);
+        highp vec3 brickPos = samplePos / brickDimensions;
+        highp vec4 brick = texture3D(brickSampler, (floor(brickPos) + 0.5) / brickCounts);
+        if (brick.a == 0.0) {
+            // Nothing to accumulate in an empty brick, so jump to where the ray leaves it
+            highp vec3 brickEdges = (floor(brickPos) + rayPositive) * brickDimensions;
+            highp vec3 exitDelta = (abs(brickEdges - curPos) + textureOffset) * invAbsRay;
+            highp float skipSize = min(exitDelta.x, min(exitDelta.y, exitDelta.z));
+            curPos += skipSize * ray;
+            curLen += skipSize;
+            nextEdges = floor(curPos / textureDimensions) * textureDimensions
+                    + rayPositive * textureDimensions + (2.0 * rayPositive - 1.0) * textureOffset;
+            if (curLen >= 1.0)
+                break;
+            continue;
+        }
+        if (poolBrickDimensions.x > 0.0) {
+            samplePos = (floor(brick.rgb * 255.0 + 0.5) + fract(brickPos))
+                    * poolBrickDimensions;
+        }
+
+        curColor = texture3D(textureSampler, samplePos);
         if (color8Bit != 0)
-            curColor = colorIndex[int(curColor.r * 255.0)];
+            curColor = lookupColor(curColor);
 
         // Find which dimension has least to go to figure out the next step distance
         highp vec3 delta = abs(nextEdges - curPos);
@@ -12,6 +12,12 @@ uniform highp float alphaMultiplier;
 uniform highp int preserveOpacity;
 uniform highp vec3 minBounds;
 uniform highp vec3 maxBounds;
+// Bricks of the volume that are empty have zero alpha in the brick texture. If the volume is
+// pooled, the color of a brick tells the slot of the brick in the pool texture.
+uniform highp sampler3D brickSampler;
+uniform highp vec3 brickDimensions;
+uniform highp vec3 brickCounts;
+uniform highp vec3 poolBrickDimensions;
 
 // Ray traveling straight through a single 'alpha thickness' applies 100% of the encountered alpha.
 // Rays traveling shorter distances apply a fraction. This is used to normalize the alpha over
@@ -19,6 +25,8 @@ uniform highp vec3 maxBounds;
 const highp float alphaThicknesses = 32.0;
 const highp float SQRT3 = 1.73205081;
 
+#include ":/shaders/fragmentColorLookup"
+
 void main() {
     vec3 rayStart = pos;
     highp vec3 startBounds = minBounds;
@@ -67,11 +75,35 @@ void main() {
 
     highp float extraAlphaMultiplier = stepSize * alphaThicknesses * alphaMultiplier;
 
+    highp vec3 rayPositive = vec3(greaterThan(step, vec3(0.0)));
+    highp vec3 invAbsStep = 1.0 / abs(step);
+    highp vec3 sampleLimit = vec3(1.0) - 0.5 * textureDimensions;
+
     // Raytrace into volume, need to sample pixels along the eye ray until we hit opacity 1
     for (int i = 0; i < sampleCount; i++) {
-        curColor = texture3D(textureSampler, curPos);
+        highp vec3 samplePos = clamp(curPos, vec3(0.0), sampleLimit);
+        highp vec3 brickPos = samplePos / brickDimensions;
+        highp vec4 brick = texture3D(brickSampler, (floor(brickPos) + 0.5) / brickCounts);
+        if (brick.a == 0.0) {
+            // Nothing to accumulate in an empty brick, so skip the steps that stay inside it
+            highp vec3 brickEdges = (floor(brickPos) + rayPositive) * brickDimensions;
+            highp vec3 exitSteps = abs(brickEdges - curPos) * invAbsStep;
+            highp float skipSteps = max(1.0, ceil(min(exitSteps.x,
+                                                      min(exitSteps.y, exitSteps.z))));
+            curPos += skipSteps * step;
+            curLen += skipSteps * stepSize;
+            if (curLen >= fullDist)
+                break;
+            continue;
+        }
+        if (poolBrickDimensions.x > 0.0) {
+            samplePos = (floor(brick.rgb * 255.0 + 0.5) + fract(brickPos))
+                    * poolBrickDimensions;
+        }
+
+        curColor = texture3D(textureSampler, samplePos);
         if (color8Bit != 0)
-            curColor = colorIndex[int(curColor.r * 255.0)];
+            curColor = lookupColor(curColor);
 
         if (curColor.a >= 0.0) {
             if (curColor.a == 1.0 && (preserveOpacity == 1 || alphaMultiplier >= 1.0))
@@ -9,13 +9,37 @@ uniform highp vec4 colorIndex[256];
 uniform highp int color8Bit;
 uniform highp float alphaMultiplier;
 uniform highp int preserveOpacity;
+uniform highp vec3 textureDimensions;
 uniform highp vec3 minBounds;
 uniform highp vec3 maxBounds;
+// Bricks of the volume that are empty have zero alpha in the brick texture. If the volume is
+// pooled, the color of a brick tells the slot of the brick in the pool texture.
+uniform highp sampler3D brickSampler;
+uniform highp vec3 brickDimensions;
+uniform highp vec3 brickCounts;
+uniform highp vec3 poolBrickDimensions;
 
 const highp vec3 xPlaneNormal = vec3(1.0, 0, 0);
 const highp vec3 yPlaneNormal = vec3(0, 1.0, 0);
 const highp vec3 zPlaneNormal = vec3(0, 0, 1.0);
 
+#include ":/shaders/fragmentColorLookup"
+
+highp vec4 sampleColor(highp vec3 texelPos) {
+    highp vec3 samplePos = clamp(texelPos, vec3(0.0), vec3(1.0) - 0.5 * textureDimensions);
+    highp vec3 brickPos = samplePos / brickDimensions;
+    highp vec4 brick = texture3D(brickSampler, (floor(brickPos) + 0.5) / brickCounts);
+    if (brick.a == 0.0)
+        return vec4(0.0);
+    if (poolBrickDimensions.x > 0.0)
+        samplePos = (floor(brick.rgb * 255.0 + 0.5) + fract(brickPos)) * poolBrickDimensions;
+
+    highp vec4 color = texture3D(textureSampler, samplePos);
+    if (color8Bit != 0)
+        color = lookupColor(color);
+    return color;
+}
+
 void main() {
     // Find out where ray intersects the slice planes
     vec3 normRayDir = normalize(rayDir);
@@ -86,9 +110,7 @@ void main() {
                 && clamp(texelVec.y, maxBounds.y, minBounds.y) == texelVec.y
                 && clamp(texelVec.z, maxBounds.z, minBounds.z) == texelVec.z) {
             texelVec = 0.5 * (texelVec + 1.0);
-            curColor = texture3D(textureSampler, texelVec);
-            if (color8Bit != 0)
-                curColor = colorIndex[int(curColor.r * 255.0)];
+            curColor = sampleColor(texelVec);
 
             if (curColor.a > 0.0) {
                 curAlpha = curColor.a;
@@ -106,9 +128,7 @@ void main() {
                     && clamp(texelVec.y, maxBounds.y, minBounds.y) == texelVec.y
                     && clamp(texelVec.z, maxBounds.z, minBounds.z) == texelVec.z) {
                 texelVec = 0.5 * (texelVec + 1.0);
-                curColor = texture3D(textureSampler, texelVec);
-                if (color8Bit != 0)
-                    curColor = colorIndex[int(curColor.r * 255.0)];
+                curColor = sampleColor(texelVec);
                 if (curColor.a > 0.0) {
                     if (curColor.a == 1.0 && preserveOpacity != 0)
                         curAlpha = 1.0;
@@ -125,10 +145,8 @@ void main() {
                         && clamp(texelVec.y, maxBounds.y, minBounds.y) == texelVec.y
                         && clamp(texelVec.z, maxBounds.z, minBounds.z) == texelVec.z) {
                     texelVec = 0.5 * (texelVec + 1.0);
-                    curColor = texture3D(textureSampler, texelVec);
+                    curColor = sampleColor(texelVec);
                     if (curColor.a > 0.0) {
-                        if (color8Bit != 0)
-                            curColor = colorIndex[int(curColor.r * 255.0)];
                         if (curColor.a == 1.0 && preserveOpacity != 0)
                             curAlpha = 1.0;
                         else
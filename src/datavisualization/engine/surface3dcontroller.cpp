@@ -80,6 +80,13 @@ void Surface3DController::synchDataToRenderer()
     Abstract3DController::synchDataToRenderer();
 
     // Notify changes to renderer
+    // Scrolling goes first, as the pending row and item changes refer to the scrolled data
+    if (m_changeTracker.rowsScrolled) {
+        m_renderer->updateScrolledRows(m_scrolledSeries);
+        m_changeTracker.rowsScrolled = false;
+        m_scrolledSeries.clear();
+    }
+
     if (m_changeTracker.rowsChanged) {
         m_renderer->updateRows(m_changedRows);
         m_changeTracker.rowsChanged = false;
@@ -179,6 +186,8 @@ void Surface3DController::removeSeries(QAbstract3DSeries *series)
 
     Abstract3DController::removeSeries(series);
 
+    m_scrolledSeries.removeAll(static_cast<QSurface3DSeries *>(series));
+
     if (m_selectedSeries == series)
         setSelectedPoint(invalidSelectionPosition(), 0, false);
 
@@ -281,7 +290,7 @@ void Surface3DController::setSelectedPoint(const QPoint &position, QSurface3DSer
             float axisMinZ = m_axisZ->min();
             float axisMaxZ = m_axisZ->max();
 
-            QSurfaceDataItem item = proxy->array()->at(pos.x())->at(pos.y());
+            QSurfaceDataItem item = *proxy->itemAt(pos);
             if (item.x() < axisMinX || item.x() > axisMaxX
                     || item.z() < axisMinZ || item.z() > axisMaxZ) {
                 scene()->setSlicingActive(false);
@@ -414,6 +423,40 @@ void Surface3DController::handleItemChanged(int rowIndex, int columnIndex)
     }
 }
 
+void Surface3DController::handleRowsScrolled(int count)
+{
+    QSurface3DSeries *series = static_cast<QSurfaceDataProxy *>(QObject::sender())->series();
+
+    // Values of pending changes have moved towards the first row
+    for (int i = m_changedRows.size() - 1; i >= 0; i--) {
+        ChangeRow &changeRow = m_changedRows[i];
+        if (changeRow.series == series) {
+            changeRow.row -= count;
+            if (changeRow.row < 0)
+                m_changedRows.removeAt(i);
+        }
+    }
+    for (int i = m_changedItems.size() - 1; i >= 0; i--) {
+        ChangeItem &changeItem = m_changedItems[i];
+        if (changeItem.series == series) {
+            changeItem.point.rx() -= count;
+            if (changeItem.point.x() < 0)
+                m_changedItems.removeAt(i);
+        }
+    }
+
+    if (!m_scrolledSeries.contains(series))
+        m_scrolledSeries.append(series);
+    m_changeTracker.rowsScrolled = true;
+
+    if (series == m_selectedSeries)
+        series->d_ptr->markItemLabelDirty();
+
+    if (series->isVisible())
+        adjustAxisRanges();
+    emitNeedRender();
+}
+
 void Surface3DController::handleRowsAdded(int startIndex, int count)
 {
     Q_UNUSED(startIndex);
@@ -52,6 +52,7 @@ struct Surface3DChangeBitField {
     bool selectedPointChanged      : 1;
     bool rowsChanged               : 1;
     bool itemChanged               : 1;
+    bool rowsScrolled              : 1;
     bool flipHorizontalGridChanged : 1;
     bool surfaceTextureChanged     : 1;
 
@@ -59,6 +60,7 @@ struct Surface3DChangeBitField {
         selectedPointChanged(true),
         rowsChanged(false),
         itemChanged(false),
+        rowsScrolled(false),
         flipHorizontalGridChanged(true),
         surfaceTextureChanged(true)
     {
@@ -88,6 +90,7 @@ private:
     bool m_flatShadingSupported;
     QList<ChangeItem> m_changedItems;
     QList<ChangeRow> m_changedRows;
+    QList<QSurface3DSeries *> m_scrolledSeries;
     bool m_flipHorizontalGrid;
     QList<QSurface3DSeries *> m_changedTextures;
 
@@ -130,6 +133,7 @@ public Q_SLOTS:
     void handleRowsRemoved(int startIndex, int count);
     void handleRowsInserted(int startIndex, int count);
     void handleItemChanged(int rowIndex, int columnIndex);
+    void handleRowsScrolled(int count);
 
     void handleFlatShadingSupportedChange(bool supported);
 
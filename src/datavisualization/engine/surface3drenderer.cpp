@@ -32,8 +32,12 @@
 #include "shaderhelper_p.h"
 #include "texturehelper_p.h"
 #include "utils_p.h"
+#include "raypicker_p.h"
 
 #include <QtCore/qmath.h>
+#include <QtCore/QLineF>
+
+#include <limits>
 
 static const int ID_TO_RGBA_MASK = 0xff;
 
@@ -46,6 +50,8 @@ const GLfloat sliceUnits = 2.5f;
 const uint greenMultiplier = 256;
 const uint blueMultiplier = 65536;
 const uint alphaMultiplier = 16777216;
+// Quads smaller than this do not add visible detail
+const float lodPixelsPerQuad = 2.0f;
 
 Surface3DRenderer::Surface3DRenderer(Surface3DController *controller)
     : Abstract3DRenderer(controller),
@@ -204,14 +210,15 @@ void Surface3DRenderer::updateData()
         SurfaceSeriesRenderCache *cache = static_cast<SurfaceSeriesRenderCache *>(baseCache);
         if (cache->isVisible() && cache->dataDirty()) {
             const QSurface3DSeries *currentSeries = cache->series();
-            QSurfaceDataProxy *dataProxy = currentSeries->dataProxy();
-            const QSurfaceDataArray &array = *dataProxy->array();
+            const QSurfaceDataProxyPrivate *proxyPrivate = currentSeries->dataProxy()->dptrc();
+            const SurfaceDataView data = proxyPrivate->dataView();
             QSurfaceDataArray &dataArray = cache->dataArray();
             QRect sampleSpace;
+            cache->setScrolledRowCount(proxyPrivate->scrolledRowCount());
 
             // Need minimum of 2x2 array to draw a surface
-            if (array.size() >= 2 && array.at(0)->size() >= 2)
-                sampleSpace = calculateSampleRect(array);
+            if (data.rowCount() >= 2 && data.columnCount() >= 2)
+                sampleSpace = calculateSampleRect(data);
 
             bool dimensionsChanged = false;
             if (cache->sampleSpace() != sampleSpace) {
@@ -227,15 +234,25 @@ void Surface3DRenderer::updateData()
             }
 
             if (sampleSpace.width() >= 2 && sampleSpace.height() >= 2) {
-                if (dimensionsChanged) {
-                    dataArray.reserve(sampleSpace.height());
-                    for (int i = 0; i < sampleSpace.height(); i++)
-                        dataArray << new QSurfaceDataRow(sampleSpace.width());
-                }
-                for (int i = 0; i < sampleSpace.height(); i++) {
-                    for (int j = 0; j < sampleSpace.width(); j++) {
-                        (*(dataArray.at(i)))[j] = array.at(i + sampleSpace.y())->at(
-                                    j + sampleSpace.x());
+                if (proxyPrivate->isGrid()) {
+                    // Grid data is sampled as is, without expanding it into items
+                    for (int i = 0; i < dataArray.size(); i++)
+                        delete dataArray.at(i);
+                    dataArray.clear();
+                    cache->dataGrid() = proxyPrivate->dataGrid().subGrid(sampleSpace);
+                } else {
+                    cache->dataGrid() = SurfaceDataGrid();
+                    const QSurfaceDataArray &array = *currentSeries->dataProxy()->array();
+                    if (dataArray.isEmpty()) {
+                        dataArray.reserve(sampleSpace.height());
+                        for (int i = 0; i < sampleSpace.height(); i++)
+                            dataArray << new QSurfaceDataRow(sampleSpace.width());
+                    }
+                    for (int i = 0; i < sampleSpace.height(); i++) {
+                        for (int j = 0; j < sampleSpace.width(); j++) {
+                            (*(dataArray.at(i)))[j] = array.at(i + sampleSpace.y())->at(
+                                        j + sampleSpace.x());
+                        }
                     }
                 }
 
@@ -243,7 +260,9 @@ void Surface3DRenderer::updateData()
                 updateObjects(cache, dimensionsChanged);
                 cache->setFlatStatusDirty(false);
             } else {
+                cache->dataGrid() = SurfaceDataGrid();
                 cache->surfaceObject()->clear();
+                cache->clearLevelsOfDetail();
             }
             cache->setDataDirty(false);
         }
@@ -314,10 +333,10 @@ void Surface3DRenderer::updateSurfaceTextures(QList<QSurface3DSeries *> seriesLi
             GLuint oldTexture = cache->surfaceTexture();
             m_textureHelper->deleteTexture(&oldTexture);
             cache->setSurfaceTexture(0);
+            cache->clearLevelsOfDetail();
 
             const QSurface3DSeries *currentSeries = cache->series();
-            QSurfaceDataProxy *dataProxy = currentSeries->dataProxy();
-            const QSurfaceDataArray &array = *dataProxy->array();
+            const SurfaceDataView data = currentSeries->dataProxy()->dptrc()->dataView();
 
             if (!series->texture().isNull()) {
                 GLuint texId = m_textureHelper->create2DTexture(series->texture(),
@@ -328,9 +347,9 @@ void Surface3DRenderer::updateSurfaceTextures(QList<QSurface3DSeries *> seriesLi
                 cache->setSurfaceTexture(texId);
 
                 if (cache->isFlatShadingEnabled())
-                    cache->surfaceObject()->coarseUVs(array, cache->dataArray());
+                    cache->surfaceObject()->coarseUVs(data, cache->dataView());
                 else
-                    cache->surfaceObject()->smoothUVs(array, cache->dataArray());
+                    cache->surfaceObject()->smoothUVs(data, cache->dataView());
             }
         }
     }
@@ -350,9 +369,16 @@ void Surface3DRenderer::cleanCache(SeriesRenderCache *cache)
 
 void Surface3DRenderer::updateRows(const QList<Surface3DController::ChangeRow> &rows)
 {
+    bool reloadData = false;
     foreach (Surface3DController::ChangeRow item, rows) {
         SurfaceSeriesRenderCache *cache =
                 static_cast<SurfaceSeriesRenderCache *>(m_renderCacheList.value(item.series));
+        if (!cache->dataGrid().isEmpty()) {
+            // Rows of grid data are not cached separately, so reload the whole series
+            cache->setDataDirty(true);
+            reloadData = true;
+            continue;
+        }
         QSurfaceDataArray &dstArray = cache->dataArray();
         const QRect &sampleSpace = cache->sampleSpace();
 
@@ -381,19 +407,30 @@ void Surface3DRenderer::updateRows(const QList<Surface3DController::ChangeRow> &
                                                             m_polarGraph);
                 }
             }
-            if (updateBuffers)
+            if (updateBuffers) {
                 cache->surfaceObject()->uploadBuffers();
+                cache->clearLevelsOfDetail();
+            }
         }
     }
 
-    updateSelectedPoint(m_selectedPoint, m_selectedSeries);
+    if (reloadData)
+        updateData();
+    else
+        updateSelectedPoint(m_selectedPoint, m_selectedSeries);
 }
 
 void Surface3DRenderer::updateItems(const QList<Surface3DController::ChangeItem> &points)
 {
+    bool reloadData = false;
     foreach (Surface3DController::ChangeItem item, points) {
         SurfaceSeriesRenderCache *cache =
                 static_cast<SurfaceSeriesRenderCache *>(m_renderCacheList.value(item.series));
+        if (!cache->dataGrid().isEmpty()) {
+            cache->setDataDirty(true);
+            reloadData = true;
+            continue;
+        }
         QSurfaceDataArray &dstArray = cache->dataArray();
         const QRect &sampleSpace = cache->sampleSpace();
 
@@ -422,13 +459,80 @@ void Surface3DRenderer::updateItems(const QList<Surface3DController::ChangeItem>
                 else
                     cache->surfaceObject()->updateSmoothItem(dstArray, y, x, m_polarGraph);
             }
-            if (updateBuffers)
+            if (updateBuffers) {
                 cache->surfaceObject()->uploadBuffers();
+                cache->clearLevelsOfDetail();
+            }
         }
 
     }
 
-    updateSelectedPoint(m_selectedPoint, m_selectedSeries);
+    if (reloadData)
+        updateData();
+    else
+        updateSelectedPoint(m_selectedPoint, m_selectedSeries);
+}
+
+void Surface3DRenderer::updateScrolledRows(const QList<QSurface3DSeries *> &seriesList)
+{
+    bool reloadData = false;
+    foreach (QSurface3DSeries *series, seriesList) {
+        SurfaceSeriesRenderCache *cache =
+                static_cast<SurfaceSeriesRenderCache *>(m_renderCacheList.value(series));
+        if (!cache || !series->dataProxy())
+            continue;
+
+        // A full reload earlier in this synchronization already includes the scrolled rows
+        const QSurfaceDataProxyPrivate *proxyPrivate = series->dataProxy()->dptrc();
+        const int count = int(proxyPrivate->scrolledRowCount() - cache->scrolledRowCount());
+        cache->setScrolledRowCount(proxyPrivate->scrolledRowCount());
+        if (!count || cache->dataDirty())
+            continue;
+
+        const QRect &sampleSpace = cache->sampleSpace();
+        // Data that changed between a grid and an array since the last load is loaded once more
+        if (!cache->isVisible() || !cache->surfaceObject()->indexCount()
+                || count >= sampleSpace.height()
+                || proxyPrivate->isGrid() == cache->dataGrid().isEmpty()) {
+            cache->setDataDirty(true);
+            reloadData = true;
+            continue;
+        }
+
+        // Rows keep their positions, so only the y-values move towards the first row
+        const SurfaceDataView data = proxyPrivate->dataView();
+        const int firstNewRow = sampleSpace.height() - count;
+        if (!cache->dataGrid().isEmpty()) {
+            QList<float> &heights = cache->dataGrid().heights;
+            heights.remove(0, count * sampleSpace.width());
+            for (int i = firstNewRow; i < sampleSpace.height(); i++) {
+                for (int j = 0; j < sampleSpace.width(); j++)
+                    heights.append(data.position(i + sampleSpace.y(), j + sampleSpace.x()).y());
+            }
+        } else {
+            QSurfaceDataArray &dataArray = cache->dataArray();
+            for (int i = 0; i < sampleSpace.height(); i++) {
+                QSurfaceDataRow &row = *dataArray[i];
+                for (int j = 0; j < sampleSpace.width(); j++) {
+                    if (i < firstNewRow) {
+                        row[j].setY(dataArray.at(i + count)->at(j).y());
+                    } else {
+                        row[j].setY(data.position(i + sampleSpace.y(),
+                                                  j + sampleSpace.x()).y());
+                    }
+                }
+            }
+        }
+
+        cache->surfaceObject()->scrollRows(cache->dataView(), count, m_polarGraph);
+        cache->surfaceObject()->uploadBuffers();
+        cache->clearLevelsOfDetail();
+    }
+
+    if (reloadData)
+        updateData();
+    else
+        updateSelectedPoint(m_selectedPoint, m_selectedSeries);
 }
 
 void Surface3DRenderer::updateSliceDataModel(const QPoint &point)
@@ -440,10 +544,9 @@ void Surface3DRenderer::updateSliceDataModel(const QPoint &point)
         // Find axis coordinates for the selected point
         SeriesRenderCache *selectedCache =
                 m_renderCacheList.value(const_cast<QSurface3DSeries *>(m_selectedSeries));
-        QSurfaceDataArray &dataArray =
-                static_cast<SurfaceSeriesRenderCache *>(selectedCache)->dataArray();
-        QSurfaceDataItem item = dataArray.at(point.x())->at(point.y());
-        QPointF coords(item.x(), item.z());
+        QVector3D position = static_cast<SurfaceSeriesRenderCache *>(selectedCache)->dataView()
+                .position(point.x(), point.y());
+        QPointF coords(position.x(), position.z());
 
         foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
             SurfaceSeriesRenderCache *cache = static_cast<SurfaceSeriesRenderCache *>(baseCache);
@@ -470,11 +573,11 @@ QPoint Surface3DRenderer::mapCoordsToSampleSpace(SurfaceSeriesRenderCache *cache
 {
     QPoint point(-1, -1);
 
-    QSurfaceDataArray &dataArray = cache->dataArray();
-    int top = dataArray.size() - 1;
-    int right = dataArray.at(top)->size() - 1;
-    QSurfaceDataItem itemBottomLeft = dataArray.at(0)->at(0);
-    QSurfaceDataItem itemTopRight = dataArray.at(top)->at(right);
+    const SurfaceDataView data = cache->dataView();
+    int top = data.rowCount() - 1;
+    int right = data.columnCount() - 1;
+    QVector3D itemBottomLeft = data.position(0, 0);
+    QVector3D itemTopRight = data.position(top, right);
 
     if (itemBottomLeft.x() <= coords.x() && itemTopRight.x() >= coords.x()) {
         float modelX = coords.x() - itemBottomLeft.x();
@@ -482,13 +585,13 @@ QPoint Surface3DRenderer::mapCoordsToSampleSpace(SurfaceSeriesRenderCache *cache
         float stepX = spanX / float(right);
         int sampleX = int((modelX + (stepX / 2.0f)) / stepX);
 
-        QSurfaceDataItem item = dataArray.at(0)->at(sampleX);
+        QVector3D item = data.position(0, sampleX);
         if (!::qFuzzyCompare(float(coords.x()), item.x())) {
             int direction = 1;
             if (item.x() > coords.x())
                 direction = -1;
 
-            findMatchingColumn(coords.x(), sampleX, direction, dataArray);
+            findMatchingColumn(coords.x(), sampleX, direction, data);
         }
 
         if (sampleX >= 0 && sampleX <= right)
@@ -501,13 +604,13 @@ QPoint Surface3DRenderer::mapCoordsToSampleSpace(SurfaceSeriesRenderCache *cache
         float stepY = spanY / float(top);
         int sampleY = int((modelY + (stepY / 2.0f)) / stepY);
 
-        QSurfaceDataItem item = dataArray.at(sampleY)->at(0);
+        QVector3D item = data.position(sampleY, 0);
         if (!::qFuzzyCompare(float(coords.y()), item.z())) {
             int direction = 1;
             if (item.z() > coords.y())
                 direction = -1;
 
-            findMatchingRow(coords.y(), sampleY, direction, dataArray);
+            findMatchingRow(coords.y(), sampleY, direction, data);
         }
 
         if (sampleY >= 0 && sampleY <= top)
@@ -518,14 +621,14 @@ QPoint Surface3DRenderer::mapCoordsToSampleSpace(SurfaceSeriesRenderCache *cache
 }
 
 void Surface3DRenderer::findMatchingRow(float z, int &sample, int direction,
-                                        QSurfaceDataArray &dataArray)
+                                        const SurfaceDataView &data)
 {
-    int maxZ = dataArray.size() - 1;
-    QSurfaceDataItem item = dataArray.at(sample)->at(0);
+    int maxZ = data.rowCount() - 1;
+    QVector3D item = data.position(sample, 0);
     float distance = qAbs(z - item.z());
     int newSample = sample + direction;
     while (newSample >= 0 && newSample <= maxZ) {
-        item = dataArray.at(newSample)->at(0);
+        item = data.position(newSample, 0);
         float newDist = qAbs(z - item.z());
         if (newDist < distance) {
             sample = newSample;
@@ -538,14 +641,14 @@ void Surface3DRenderer::findMatchingRow(float z, int &sample, int direction,
 }
 
 void Surface3DRenderer::findMatchingColumn(float x, int &sample, int direction,
-                                           QSurfaceDataArray &dataArray)
+                                           const SurfaceDataView &data)
 {
-    int maxX = dataArray.at(0)->size() - 1;
-    QSurfaceDataItem item = dataArray.at(0)->at(sample);
+    int maxX = data.columnCount() - 1;
+    QVector3D item = data.position(0, sample);
     float distance = qAbs(x - item.x());
     int newSample = sample + direction;
     while (newSample >= 0 && newSample <= maxX) {
-        item = dataArray.at(0)->at(newSample);
+        item = data.position(0, newSample);
         float newDist = qAbs(x - item.x());
         if (newDist < distance) {
             sample = newSample;
@@ -575,19 +678,20 @@ void Surface3DRenderer::updateSliceObject(SurfaceSeriesRenderCache *cache, const
     sliceDataArray.reserve(2);
 
     QSurfaceDataRow *sliceRow;
-    QSurfaceDataArray &dataArray = cache->dataArray();
+    const SurfaceDataView data = cache->dataView();
     float adjust = (0.025f * m_heightNormalizer) / 2.0f;
     float doubleAdjust = 2.0f * adjust;
     bool flipZX = false;
     float zBack;
     float zFront;
     if (m_cachedSelectionMode.testFlag(QAbstract3DGraph::SelectionRow)) {
-        QSurfaceDataRow *src = dataArray.at(row);
-        sliceRow = new QSurfaceDataRow(src->size());
+        sliceRow = new QSurfaceDataRow(data.columnCount());
         zBack = m_axisCacheZ.min();
         zFront = m_axisCacheZ.max();
-        for (int i = 0; i < sliceRow->size(); i++)
-            (*sliceRow)[i].setPosition(QVector3D(src->at(i).x(), src->at(i).y() + adjust, zFront));
+        for (int i = 0; i < sliceRow->size(); i++) {
+            QVector3D position = data.position(row, i);
+            (*sliceRow)[i].setPosition(QVector3D(position.x(), position.y() + adjust, zFront));
+        }
     } else {
         flipZX = true;
         const QRect &sampleSpace = cache->sampleSpace();
@@ -595,9 +699,8 @@ void Surface3DRenderer::updateSliceObject(SurfaceSeriesRenderCache *cache, const
         zBack = m_axisCacheX.min();
         zFront = m_axisCacheX.max();
         for (int i = 0; i < sampleSpace.height(); i++) {
-            (*sliceRow)[i].setPosition(QVector3D(dataArray.at(i)->at(column).z(),
-                                                 dataArray.at(i)->at(column).y() + adjust,
-                                                 zFront));
+            QVector3D position = data.position(i, column);
+            (*sliceRow)[i].setPosition(QVector3D(position.z(), position.y() + adjust, zFront));
         }
     }
     sliceDataArray << sliceRow;
@@ -622,15 +725,15 @@ void Surface3DRenderer::updateSliceObject(SurfaceSeriesRenderCache *cache, const
     }
 }
 
-inline static float getDataValue(const QSurfaceDataArray &array, bool searchRow, int index)
+inline static float getDataValue(const SurfaceDataView &data, bool searchRow, int index)
 {
     if (searchRow)
-        return array.at(0)->at(index).x();
+        return data.position(0, index).x();
     else
-        return array.at(index)->at(0).z();
+        return data.position(index, 0).z();
 }
 
-inline static int binarySearchArray(const QSurfaceDataArray &array, int maxIdx, float limitValue,
+inline static int binarySearchArray(const SurfaceDataView &data, int maxIdx, float limitValue,
                                     bool searchRow, bool lowBound, bool ascending)
 {
     int min = 0;
@@ -639,7 +742,7 @@ inline static int binarySearchArray(const QSurfaceDataArray &array, int maxIdx,
     int retVal;
     while (max >= min) {
         mid = (min + max) / 2;
-        float arrayValue = getDataValue(array, searchRow, mid);
+        float arrayValue = getDataValue(data, searchRow, mid);
         if (arrayValue == limitValue)
             return mid;
         if (ascending) {
@@ -671,28 +774,28 @@ inline static int binarySearchArray(const QSurfaceDataArray &array, int maxIdx,
     if (retVal < 0 || retVal > maxIdx) {
         retVal = -1;
     } else if (lowBound) {
-        if (getDataValue(array, searchRow, retVal) < limitValue)
+        if (getDataValue(data, searchRow, retVal) < limitValue)
             retVal = -1;
     } else {
-        if (getDataValue(array, searchRow, retVal) > limitValue)
+        if (getDataValue(data, searchRow, retVal) > limitValue)
             retVal = -1;
     }
     return retVal;
 }
 
-QRect Surface3DRenderer::calculateSampleRect(const QSurfaceDataArray &array)
+QRect Surface3DRenderer::calculateSampleRect(const SurfaceDataView &data)
 {
     QRect sampleSpace;
 
-    const int maxRow = array.size() - 1;
-    const int maxColumn = array.at(0)->size() - 1;
+    const int maxRow = data.rowCount() - 1;
+    const int maxColumn = data.columnCount() - 1;
 
     // We assume data is ordered sequentially in rows for X-value and in columns for Z-value.
     // Determine if data is ascending or descending in each case.
-    const bool ascendingX = array.at(0)->at(0).x() < array.at(0)->at(maxColumn).x();
-    const bool ascendingZ = array.at(0)->at(0).z() < array.at(maxRow)->at(0).z();
+    const bool ascendingX = data.position(0, 0).x() < data.position(0, maxColumn).x();
+    const bool ascendingZ = data.position(0, 0).z() < data.position(maxRow, 0).z();
 
-    int idx = binarySearchArray(array, maxColumn, m_axisCacheX.min(), true, true, ascendingX);
+    int idx = binarySearchArray(data, maxColumn, m_axisCacheX.min(), true, true, ascendingX);
     if (idx != -1) {
         if (ascendingX)
             sampleSpace.setLeft(idx);
@@ -703,7 +806,7 @@ QRect Surface3DRenderer::calculateSampleRect(const QSurfaceDataArray &array)
         return sampleSpace;
     }
 
-    idx = binarySearchArray(array, maxColumn, m_axisCacheX.max(), true, false, ascendingX);
+    idx = binarySearchArray(data, maxColumn, m_axisCacheX.max(), true, false, ascendingX);
     if (idx != -1) {
         if (ascendingX)
             sampleSpace.setRight(idx);
@@ -714,7 +817,7 @@ QRect Surface3DRenderer::calculateSampleRect(const QSurfaceDataArray &array)
         return sampleSpace;
     }
 
-    idx = binarySearchArray(array, maxRow, m_axisCacheZ.min(), false, true, ascendingZ);
+    idx = binarySearchArray(data, maxRow, m_axisCacheZ.min(), false, true, ascendingZ);
     if (idx != -1) {
         if (ascendingZ)
             sampleSpace.setTop(idx);
@@ -725,7 +828,7 @@ QRect Surface3DRenderer::calculateSampleRect(const QSurfaceDataArray &array)
         return sampleSpace;
     }
 
-    idx = binarySearchArray(array, maxRow, m_axisCacheZ.max(), false, false, ascendingZ);
+    idx = binarySearchArray(data, maxRow, m_axisCacheZ.max(), false, false, ascendingZ);
     if (idx != -1) {
         if (ascendingZ)
             sampleSpace.setBottom(idx);
@@ -1182,6 +1285,11 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
     QMatrix4x4 depthProjectionMatrix;
     QMatrix4x4 depthProjectionViewMatrix;
 
+    foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+        updateLevelOfDetail(static_cast<SurfaceSeriesRenderCache *>(baseCache),
+                            projectionViewMatrix);
+    }
+
     // Draw depth buffer
     GLfloat adjustedLightStrength = m_cachedTheme->lightStrength() / 10.0f;
     if (!m_isOpenGLES && m_cachedShadowQuality > QAbstract3DGraph::ShadowQualityNone &&
@@ -1219,13 +1327,9 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
 
         foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
             SurfaceSeriesRenderCache *cache = static_cast<SurfaceSeriesRenderCache *>(baseCache);
-            SurfaceObject *object = cache->surfaceObject();
+            SurfaceObject *object = cache->levelOfDetailObject();
             if (object->indexCount() && cache->surfaceVisible() && cache->isVisible()
                     && cache->sampleSpace().width() >= 2 && cache->sampleSpace().height() >= 2) {
-                // No translation nor scaling for surfaces, therefore no modelMatrix
-                // Use directly projectionViewMatrix
-                m_depthShader->setUniformValue(m_depthShader->MVP(), depthProjectionViewMatrix);
-
                 // 1st attribute buffer : vertices
                 glEnableVertexAttribArray(m_depthShader->posAtt());
                 glBindBuffer(GL_ARRAY_BUFFER, object->vertexBuf());
@@ -1235,8 +1339,18 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
                 // Index buffer
                 glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object->elementBuf());
 
-                // Draw the triangles
-                glDrawElements(GL_TRIANGLES, object->indexCount(), GL_UNSIGNED_INT, (void *)0);
+                // Scrolled rows are drawn in parts, each translated back in place
+                for (int part = 0; part < object->drawPartCount(); part++) {
+                    object->setDrawPart(part);
+                    QMatrix4x4 modelMatrix;
+                    modelMatrix.translate(object->scrollTranslation());
+                    m_depthShader->setUniformValue(m_depthShader->MVP(),
+                                                   depthProjectionViewMatrix * modelMatrix);
+
+                    // Draw the triangles
+                    glDrawElements(GL_TRIANGLES, object->indexCount(), GL_UNSIGNED_INT,
+                                   (void *)(object->indexOffset() * sizeof(GLuint)));
+                }
             }
         }
 
@@ -1276,11 +1390,21 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
     }
 
     // Draw selection buffer
-    if (!m_cachedIsSlicingActivated && (!m_renderCacheList.isEmpty()
+    QVector4D clickedColor;
+    if (selectionReadbackPending()) {
+        // Resolve the click when the color read on an earlier frame is available
+        if (finishSelectionReadback(clickedColor)) {
+            m_clickedPosition = selectionIdToSurfacePoint(selectionColorToId(clickedColor));
+            m_clickResolved = true;
+        }
+        emit needRender();
+    } else if (!m_cachedIsSlicingActivated && (!m_renderCacheList.isEmpty()
                                         || !m_customRenderCache.isEmpty())
             && m_selectionState == SelectOnScene
             && m_cachedSelectionMode > QAbstract3DGraph::SelectionNone
-            && m_selectionResultTexture) {
+            && m_selectionResultTexture && !pickSurfacePoint(projectionViewMatrix)) {
+        saveSelectionState();
+
         m_selectionShader->bind();
         glBindFramebuffer(GL_FRAMEBUFFER, m_selectionFrameBuffer);
         glViewport(0,
@@ -1297,15 +1421,24 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
 
         foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
             SurfaceSeriesRenderCache *cache = static_cast<SurfaceSeriesRenderCache *>(baseCache);
-            if (cache->surfaceObject()->indexCount() && cache->renderable()) {
-                m_selectionShader->setUniformValue(m_selectionShader->MVP(), projectionViewMatrix);
-
-                cache->surfaceObject()->activateSurfaceTexture(false);
+            SurfaceObject *object = cache->surfaceObject();
+            if (object->indexCount() && cache->renderable()) {
+                object->activateSurfaceTexture(false);
+                for (int part = 0; part < object->drawPartCount(); part++) {
+                    object->setDrawPart(part);
+                    QMatrix4x4 modelMatrix;
+                    modelMatrix.translate(object->scrollTranslation());
+                    m_selectionShader->setUniformValue(m_selectionShader->MVP(),
+                                                       projectionViewMatrix * modelMatrix);
+                    m_selectionShader->setUniformValue(m_selectionShader->uvOffset(),
+                                                       object->uvOffset());
 
-                m_drawer->drawObject(m_selectionShader, cache->surfaceObject(),
-                                     cache->selectionTexture());
+                    m_drawer->drawObject(m_selectionShader, object, cache->selectionTexture());
+                }
             }
         }
+        // The shader is also used for drawing that is not scrolled
+        m_selectionShader->setUniformValue(m_selectionShader->uvOffset(), QVector2D());
         m_surfaceGridShader->bind();
         Abstract3DRenderer::drawCustomItems(RenderingSelection, m_surfaceGridShader,
                                             viewMatrix,
@@ -1315,18 +1448,14 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
 
         glEnable(GL_DITHER);
 
-        QVector4D clickedColor = Utils::getSelection(m_inputPosition, m_viewport.height());
+        const bool colorRead = readSelection(clickedColor);
 
         glBindFramebuffer(GL_FRAMEBUFFER, defaultFboHandle);
 
-        // Put the RGBA value back to uint
-        uint selectionId = uint(clickedColor.x())
-                + uint(clickedColor.y()) * greenMultiplier
-                + uint(clickedColor.z()) * blueMultiplier
-                + uint(clickedColor.w()) * alphaMultiplier;
-
-        m_clickedPosition = selectionIdToSurfacePoint(selectionId);
-        m_clickResolved = true;
+        if (colorRead) {
+            m_clickedPosition = selectionIdToSurfacePoint(selectionColorToId(clickedColor));
+            m_clickResolved = true;
+        }
 
         emit needRender();
 
@@ -1349,7 +1478,7 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
                 int x = m_selectedPoint.x() - sampleSpace.y();
                 int y = m_selectedPoint.y() - sampleSpace.x();
                 if (x >= 0 && y >= 0 && x < sampleSpace.height() && y < sampleSpace.width()
-                        && cache->dataArray().size()) {
+                        && cache->dataView().rowCount()) {
                     visiblePoint = QPoint(x, y);
                 }
             }
@@ -1382,6 +1511,9 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
             QMatrix4x4 MVPMatrix;
             QMatrix4x4 itModelMatrix;
 
+            const QRect &sampleSpace = cache->sampleSpace();
+            SurfaceObject *object = cache->levelOfDetailObject();
+
 #ifdef SHOW_DEPTH_TEXTURE_SCENE
             MVPMatrix = depthProjectionViewMatrix;
 #else
@@ -1389,8 +1521,7 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
 #endif
             cache->setMVPMatrix(MVPMatrix);
 
-            const QRect &sampleSpace = cache->sampleSpace();
-            if (cache->surfaceObject()->indexCount() && cache->isVisible() &&
+            if (object->indexCount() && cache->isVisible() &&
                     sampleSpace.width() >= 2 && sampleSpace.height() >= 2) {
                 noShadows = false;
                 if (!drawGrid && cache->surfaceGridVisible()) {
@@ -1413,20 +1544,18 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
                     // Set shader bindings
                     shader->setUniformValue(shader->lightP(), lightPos);
                     shader->setUniformValue(shader->view(), viewMatrix);
-                    shader->setUniformValue(shader->model(), modelMatrix);
                     shader->setUniformValue(shader->nModel(),
                                             itModelMatrix.inverted().transposed());
-                    shader->setUniformValue(shader->MVP(), MVPMatrix);
                     shader->setUniformValue(shader->ambientS(),
                                             m_cachedTheme->ambientLightStrength());
                     shader->setUniformValue(shader->lightColor(), lightColor);
 
                     // Set the surface texturing
-                    cache->surfaceObject()->activateSurfaceTexture(false);
+                    object->activateSurfaceTexture(false);
                     GLuint texture;
                     if (cache->surfaceTexture()) {
                         texture = cache->surfaceTexture();
-                        cache->surfaceObject()->activateSurfaceTexture(true);
+                        object->activateSurfaceTexture(true);
                     } else {
                         if (cache->colorStyle() == Q3DTheme::ColorStyleUniform) {
                             texture = cache->baseUniformTexture();
@@ -1447,23 +1576,34 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
                             }
                         }
                     }
-
-                    if (!m_isOpenGLES &&
-                            m_cachedShadowQuality > QAbstract3DGraph::ShadowQualityNone) {
+                    const bool shadows = !m_isOpenGLES
+                            && m_cachedShadowQuality > QAbstract3DGraph::ShadowQualityNone;
+                    if (shadows) {
                         // Set shadow shader bindings
-                        QMatrix4x4 depthMVPMatrix = depthProjectionViewMatrix * modelMatrix;
                         shader->setUniformValue(shader->shadowQ(), m_shadowQualityToShader);
-                        shader->setUniformValue(shader->depth(), depthMVPMatrix);
                         shader->setUniformValue(shader->lightS(), adjustedLightStrength);
-
-                        // Draw the objects
-                        m_drawer->drawObject(shader, cache->surfaceObject(), texture,
-                                             m_depthTexture);
                     } else {
                         // Set shadowless shader bindings
                         shader->setUniformValue(shader->lightS(), m_cachedTheme->lightStrength());
+                    }
+
+                    // Scrolled rows are drawn in parts, each translated back in place
+                    for (int part = 0; part < object->drawPartCount(); part++) {
+                        object->setDrawPart(part);
+                        modelMatrix.setToIdentity();
+                        modelMatrix.translate(object->scrollTranslation());
+                        shader->setUniformValue(shader->model(), modelMatrix);
+                        shader->setUniformValue(shader->MVP(), MVPMatrix * modelMatrix);
+                        shader->setUniformValue(shader->uvOffset(), object->uvOffset());
+
                         // Draw the objects
-                        m_drawer->drawObject(shader, cache->surfaceObject(), texture);
+                        if (shadows) {
+                            shader->setUniformValue(shader->depth(),
+                                                    depthProjectionViewMatrix * modelMatrix);
+                            m_drawer->drawObject(shader, object, texture, m_depthTexture);
+                        } else {
+                            m_drawer->drawObject(shader, object, texture);
+                        }
                     }
                 }
             }
@@ -1480,14 +1620,19 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
             foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
                 SurfaceSeriesRenderCache *cache =
                         static_cast<SurfaceSeriesRenderCache *>(baseCache);
-                m_surfaceGridShader->setUniformValue(m_surfaceGridShader->MVP(),
-                                                     cache->MVPMatrix());
-
                 const QRect &sampleSpace = cache->sampleSpace();
-                if (cache->surfaceObject()->indexCount() && cache->surfaceGridVisible()
+                SurfaceObject *object = cache->levelOfDetailObject();
+                if (object->indexCount() && cache->surfaceGridVisible()
                         && cache->isVisible() && sampleSpace.width() >= 2
                         && sampleSpace.height() >= 2) {
-                    m_drawer->drawSurfaceGrid(m_surfaceGridShader, cache->surfaceObject());
+                    for (int part = 0; part < object->drawPartCount(); part++) {
+                        object->setDrawPart(part);
+                        QMatrix4x4 modelMatrix;
+                        modelMatrix.translate(object->scrollTranslation());
+                        m_surfaceGridShader->setUniformValue(m_surfaceGridShader->MVP(),
+                                                             cache->MVPMatrix() * modelMatrix);
+                        m_drawer->drawSurfaceGrid(m_surfaceGridShader, object);
+                    }
                 }
             }
         }
@@ -1949,6 +2094,7 @@ void Surface3DRenderer::drawLabels(bool drawSelection, const Q3DCamera *activeCa
 
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        m_drawer->beginLabels();
     }
 
     glEnable(GL_POLYGON_OFFSET_FILL);
@@ -2437,6 +2583,8 @@ void Surface3DRenderer::drawLabels(bool drawSelection, const Q3DCamera *activeCa
                            shader);
         }
     }
+    if (!drawSelection)
+        m_drawer->endLabels();
     glDisable(GL_POLYGON_OFFSET_FILL);
 
     if (!drawSelection)
@@ -2620,23 +2768,99 @@ void Surface3DRenderer::checkFlatSupport(SurfaceSeriesRenderCache *cache)
 
 void Surface3DRenderer::updateObjects(SurfaceSeriesRenderCache *cache, bool dimensionChanged)
 {
-    QSurfaceDataArray &dataArray = cache->dataArray();
-    const QRect &sampleSpace = cache->sampleSpace();
+    cache->clearLevelsOfDetail();
+    setUpSurfaceObject(cache, cache->surfaceObject(), cache->dataView(), cache->sampleSpace(),
+                       dimensionChanged);
+}
 
+void Surface3DRenderer::setUpSurfaceObject(SurfaceSeriesRenderCache *cache,
+                                           SurfaceObject *object, const SurfaceDataView &dataView,
+                                           const QRect &space, bool changeGeometry)
+{
     const QSurface3DSeries *currentSeries = cache->series();
-    QSurfaceDataProxy *dataProxy = currentSeries->dataProxy();
-    const QSurfaceDataArray &array = *dataProxy->array();
+    const SurfaceDataView data = currentSeries->dataProxy()->dptrc()->dataView();
 
     if (cache->isFlatShadingEnabled()) {
-        cache->surfaceObject()->setUpData(dataArray, sampleSpace, dimensionChanged, m_polarGraph);
+        object->setUpData(dataView, space, changeGeometry, m_polarGraph);
         if (cache->surfaceTexture())
-            cache->surfaceObject()->coarseUVs(array, dataArray);
+            object->coarseUVs(data, dataView);
     } else {
-        cache->surfaceObject()->setUpSmoothData(dataArray, sampleSpace, dimensionChanged,
-                                                m_polarGraph);
+        object->setUpSmoothData(dataView, space, changeGeometry, m_polarGraph);
         if (cache->surfaceTexture())
-            cache->surfaceObject()->smoothUVs(array, dataArray);
+            object->smoothUVs(data, dataView);
+    }
+}
+
+// Picks the coarsest level of detail whose quads still are at most lodPixelsPerQuad pixels
+// along the longest projected edges of the surface, creating missing levels on demand.
+void Surface3DRenderer::updateLevelOfDetail(SurfaceSeriesRenderCache *cache,
+                                            const QMatrix4x4 &projectionViewMatrix)
+{
+    const QRect &sampleSpace = cache->sampleSpace();
+    if (!cache->isLevelOfDetailEnabled() || !cache->surfaceObject()->indexCount()
+            || sampleSpace.width() < 2 || sampleSpace.height() < 2) {
+        cache->setLevelOfDetail(0);
+        return;
+    }
+
+    SurfaceObject *object = cache->surfaceObject();
+    const float halfWidth = m_primarySubViewport.width() / 2.0f;
+    const float halfHeight = m_primarySubViewport.height() / 2.0f;
+    auto projectedLength = [&](int column, int row, int columnStep, int rowStep, int count) {
+        static const int maxSegments = 16;
+        const int step = qMax(1, count / maxSegments);
+        float length = 0.0f;
+        QPointF previous;
+        for (int i = 0; i < count; i += step) {
+            if (i + step >= count)
+                i = count - 1;
+            const QVector4D vertex = projectionViewMatrix
+                    * QVector4D(object->vertexAt(column + i * columnStep, row + i * rowStep),
+                                1.0f);
+            // Parts of the surface behind the camera are close enough for full detail
+            if (vertex.w() <= 0.0f)
+                return std::numeric_limits<float>::max();
+            const QPointF point(vertex.x() / vertex.w() * halfWidth,
+                                vertex.y() / vertex.w() * halfHeight);
+            if (i)
+                length += QLineF(previous, point).length();
+            previous = point;
+        }
+        return length;
+    };
+    const int lastColumn = sampleSpace.width() - 1;
+    const int lastRow = sampleSpace.height() - 1;
+    const float columnPixels = qMax(projectedLength(0, 0, 1, 0, sampleSpace.width()),
+                                    projectedLength(0, lastRow, 1, 0, sampleSpace.width()));
+    const float rowPixels = qMax(projectedLength(0, 0, 0, 1, sampleSpace.height()),
+                                 projectedLength(lastColumn, 0, 0, 1, sampleSpace.height()));
+
+    int level = 0;
+    int columns = sampleSpace.width();
+    int rows = sampleSpace.height();
+    while (columns > 2 || rows > 2) {
+        const int lodColumns = columns > 2 ? columns / 2 + 1 : columns;
+        const int lodRows = rows > 2 ? rows / 2 + 1 : rows;
+        if ((lodColumns - 1) * lodPixelsPerQuad < columnPixels
+                || (lodRows - 1) * lodPixelsPerQuad < rowPixels) {
+            break;
+        }
+        columns = lodColumns;
+        rows = lodRows;
+        level++;
+    }
+
+    while (cache->levelOfDetailCount() <= level) {
+        const int newLevel = cache->levelOfDetailCount();
+        const SurfaceDataGrid grid = (newLevel == 1)
+                ? SurfaceObject::createLevelOfDetail(cache->dataView())
+                : SurfaceObject::createLevelOfDetail(cache->levelOfDetailGrid(newLevel - 1));
+        SurfaceObject *lodObject = new SurfaceObject(this);
+        cache->addLevelOfDetail(grid, lodObject);
+        setUpSurfaceObject(cache, lodObject, cache->levelOfDetailGrid(newLevel),
+                           QRect(0, 0, grid.columnCount(), grid.rowCount()), true);
     }
+    cache->setLevelOfDetail(level);
 }
 
 void Surface3DRenderer::updateSelectedPoint(const QPoint &position, QSurface3DSeries *series)
@@ -2677,9 +2901,8 @@ void Surface3DRenderer::surfacePointSelected(const QPoint &point)
         SurfaceSeriesRenderCache *selectedCache =
                 static_cast<SurfaceSeriesRenderCache *>(
                     m_renderCacheList.value(const_cast<QSurface3DSeries *>(m_selectedSeries)));
-        QSurfaceDataArray &dataArray = selectedCache->dataArray();
-        QSurfaceDataItem item = dataArray.at(point.x())->at(point.y());
-        QPointF coords(item.x(), item.z());
+        QVector3D position = selectedCache->dataView().position(point.x(), point.y());
+        QPointF coords(position.x(), position.z());
 
         foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
             SurfaceSeriesRenderCache *cache =
@@ -2764,6 +2987,69 @@ void Surface3DRenderer::updateSelectionPoint(SurfaceSeriesRenderCache *cache, co
     cache->setMainPointerActivity(true);
 }
 
+// Resolves the click by casting a ray against the surfaces. Returns false if the selection
+// buffer needs to be drawn to resolve the click, which is the case when the ray hits nothing,
+// as the click may be on a label, when an axis label may be in front of the hit, or when there
+// are custom items.
+bool Surface3DRenderer::pickSurfacePoint(const QMatrix4x4 &projectionViewMatrix)
+{
+    if (!m_customRenderCache.isEmpty())
+        return false;
+
+    RayPicker::Ray ray;
+    if (!RayPicker::selectionRay(m_inputPosition, m_primarySubViewport.size(),
+                                 m_viewport.height(), projectionViewMatrix, ray)) {
+        return false;
+    }
+
+    float closestDistance = std::numeric_limits<float>::max();
+    SurfaceSeriesRenderCache *closestCache = 0;
+    QPoint closestPoint;
+    foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+        SurfaceSeriesRenderCache *cache = static_cast<SurfaceSeriesRenderCache *>(baseCache);
+        if (!cache->surfaceObject()->indexCount() || !cache->renderable())
+            continue;
+
+        int row;
+        int column;
+        float distance;
+        if (cache->surfaceObject()->pick(ray, row, column, distance)
+                && distance < closestDistance) {
+            closestDistance = distance;
+            closestCache = cache;
+            closestPoint = QPoint(row, column);
+        }
+    }
+
+    if (!closestCache)
+        return false;
+    // Axis labels are drawn to the selection buffer as well, and hide the surface behind them
+    if (m_drawer->isLabelInFront(ray, projectionViewMatrix, closestDistance))
+        return false;
+
+    const QRect &sampleSpace = closestCache->sampleSpace();
+    m_clickedType = QAbstract3DGraph::ElementSeries;
+    m_selectedLabelIndex = -1;
+    m_selectedCustomItemIndex = -1;
+    m_clickedPosition = QPoint(closestPoint.x() + sampleSpace.y(),
+                               closestPoint.y() + sampleSpace.x());
+    m_clickedSeries = closestCache->series();
+    m_clickResolved = true;
+
+    emit needRender();
+
+    return true;
+}
+
+// Puts the RGBA value back to uint
+uint Surface3DRenderer::selectionColorToId(const QVector4D &color) const
+{
+    return uint(color.x())
+            + uint(color.y()) * greenMultiplier
+            + uint(color.z()) * blueMultiplier
+            + uint(color.w()) * alphaMultiplier;
+}
+
 // Maps selection Id to surface point in data array
 QPoint Surface3DRenderer::selectionIdToSurfacePoint(uint id)
 {
@@ -2790,30 +3076,55 @@ QPoint Surface3DRenderer::selectionIdToSurfacePoint(uint id)
         return Surface3DController::invalidSelectionPosition();
     }
 
-    // Not a label selection
-    SurfaceSeriesRenderCache *selectedCache = 0;
-    foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
-        SurfaceSeriesRenderCache *cache = static_cast<SurfaceSeriesRenderCache *>(baseCache);
-        if (cache->isWithinIdRange(id)) {
-            selectedCache = cache;
+    // Not a label selection. The ids are decoded against the series the selection buffer was
+    // drawn with.
+    const SelectionRange *selectedRange = 0;
+    for (int i = 0; i < m_selectionRanges.size(); i++) {
+        const SelectionRange &range = m_selectionRanges.at(i);
+        if (id >= range.idStart && id <= range.idEnd) {
+            selectedRange = &range;
             break;
         }
     }
+    SurfaceSeriesRenderCache *selectedCache = 0;
+    if (selectedRange && selectedRange->series) {
+        selectedCache = static_cast<SurfaceSeriesRenderCache *>(
+                    m_renderCacheList.value(selectedRange->series.data()));
+    }
     if (!selectedCache) {
         m_clickedSeries = 0;
         return Surface3DController::invalidSelectionPosition();
     }
 
-    uint idInSeries = id - selectedCache->selectionIdStart() + 1;
-    const QRect &sampleSpace = selectedCache->sampleSpace();
+    uint idInSeries = id - selectedRange->idStart + 1;
+    const QRect &sampleSpace = selectedRange->sampleSpace;
     int column = ((idInSeries - 1) % sampleSpace.width()) + sampleSpace.x();
     int row = ((idInSeries - 1) / sampleSpace.width()) +  sampleSpace.y();
 
-    m_clickedSeries = selectedCache->series();
+    // Rows scrolled since then have moved the selected row towards the start of the data
+    row -= int(selectedCache->scrolledRowCount() - selectedRange->scrolledRowCount);
+    if (row < sampleSpace.y()) {
+        m_clickedSeries = 0;
+        return Surface3DController::invalidSelectionPosition();
+    }
+
+    m_clickedSeries = selectedRange->series.data();
     m_clickedType = QAbstract3DGraph::ElementSeries;
     return QPoint(row, column);
 }
 
+void Surface3DRenderer::saveSelectionState()
+{
+    m_selectionRanges.clear();
+    foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+        SurfaceSeriesRenderCache *cache = static_cast<SurfaceSeriesRenderCache *>(baseCache);
+        SelectionRange range = { cache->series(), cache->selectionIdStart(),
+                                 cache->selectionIdEnd(), cache->sampleSpace(),
+                                 cache->scrolledRowCount() };
+        m_selectionRanges.append(range);
+    }
+}
+
 void Surface3DRenderer::updateShadowQuality(QAbstract3DGraph::ShadowQuality quality)
 {
     m_cachedShadowQuality = quality;
@@ -55,6 +55,15 @@ class Q_DATAVISUALIZATION_EXPORT Surface3DRenderer : public Abstract3DRenderer
     Q_OBJECT
 
 private:
+    // Selection ids of a series in the selection buffer
+    struct SelectionRange {
+        QPointer<QSurface3DSeries> series;
+        uint idStart;
+        uint idEnd;
+        QRect sampleSpace;
+        qint64 scrolledRowCount;
+    };
+
     bool m_cachedIsSlicingActivated;
 
     // Internal attributes purely related to how the scene is drawn with GL.
@@ -87,6 +96,9 @@ private:
     bool m_selectionTexturesDirty;
     GLuint m_noShadowTexture;
     bool m_flipHorizontalGrid;
+    // Series drawn to the selection buffer, as the color under the cursor may be read back on
+    // a later frame
+    QList<SelectionRange> m_selectionRanges;
 
 public:
     explicit Surface3DRenderer(Surface3DController *controller);
@@ -100,6 +112,7 @@ public:
     void updateSelectionMode(QAbstract3DGraph::SelectionFlags mode) override;
     void updateRows(const QList<Surface3DController::ChangeRow> &rows);
     void updateItems(const QList<Surface3DController::ChangeItem> &points);
+    void updateScrolledRows(const QList<QSurface3DSeries *> &seriesList);
     void updateScene(Q3DScene *scene) override;
     void updateSlicingActive(bool isSlicing);
     void updateSelectedPoint(const QPoint &position, QSurface3DSeries *series);
@@ -127,15 +140,20 @@ Q_SIGNALS:
 private:
     void checkFlatSupport(SurfaceSeriesRenderCache *cache);
     void updateObjects(SurfaceSeriesRenderCache *cache, bool dimensionChanged);
+    void setUpSurfaceObject(SurfaceSeriesRenderCache *cache, SurfaceObject *object,
+                            const SurfaceDataView &dataView, const QRect &space,
+                            bool changeGeometry);
+    void updateLevelOfDetail(SurfaceSeriesRenderCache *cache,
+                             const QMatrix4x4 &projectionViewMatrix);
     void updateSliceDataModel(const QPoint &point);
     QPoint mapCoordsToSampleSpace(SurfaceSeriesRenderCache *cache, const QPointF &coords);
-    void findMatchingRow(float z, int &sample, int direction, QSurfaceDataArray &dataArray);
-    void findMatchingColumn(float x, int &sample, int direction, QSurfaceDataArray &dataArray);
+    void findMatchingRow(float z, int &sample, int direction, const SurfaceDataView &data);
+    void findMatchingColumn(float x, int &sample, int direction, const SurfaceDataView &data);
     void updateSliceObject(SurfaceSeriesRenderCache *cache, const QPoint &point);
     void updateShadowQuality(QAbstract3DGraph::ShadowQuality quality) override;
     void updateTextures() override;
     void initShaders(const QString &vertexShader, const QString &fragmentShader) override;
-    QRect calculateSampleRect(const QSurfaceDataArray &array);
+    QRect calculateSampleRect(const SurfaceDataView &data);
     void loadBackgroundMesh();
 
     void drawSlicedScene();
@@ -155,7 +173,10 @@ private:
     void fillIdCorner(uchar *p, uchar r, uchar g, uchar b, uchar a);
     void surfacePointSelected(const QPoint &point);
     void updateSelectionPoint(SurfaceSeriesRenderCache *cache, const QPoint &point, bool label);
+    void saveSelectionState();
+    uint selectionColorToId(const QVector4D &color) const;
     QPoint selectionIdToSurfacePoint(uint id);
+    bool pickSurfacePoint(const QMatrix4x4 &projectionViewMatrix);
     void updateDepthBuffer() override;
     void emitSelectedPointChanged(QPoint position);
 
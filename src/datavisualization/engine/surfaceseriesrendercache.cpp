@@ -41,7 +41,10 @@ SurfaceSeriesRenderCache::SurfaceSeriesRenderCache(QAbstract3DSeries *series,
       m_surfaceFlatShading(false),
       m_surfaceObj(new SurfaceObject(renderer)),
       m_sliceSurfaceObj(new SurfaceObject(renderer)),
+      m_levelOfDetailEnabled(false),
+      m_levelOfDetail(0),
       m_sampleSpace(QRect(0, 0, 0, 0)),
+      m_scrolledRowCount(0),
       m_selectionTexture(0),
       m_selectionIdStart(0),
       m_selectionIdEnd(0),
@@ -69,6 +72,12 @@ void SurfaceSeriesRenderCache::populate(bool newSeries)
     QColor lineColor = series()->wireframeColor();
     m_surfaceObj->setLineColor(lineColor);
     m_sliceSurfaceObj->setLineColor(lineColor);
+    for (SurfaceObject *object : qAsConst(m_lodObjects))
+        object->setLineColor(lineColor);
+
+    m_levelOfDetailEnabled = series()->isLevelOfDetailEnabled();
+    if (!m_levelOfDetailEnabled)
+        clearLevelsOfDetail();
 
     if (m_flatChangeAllowed && m_surfaceFlatShading != series()->isFlatShadingEnabled()) {
         m_surfaceFlatShading = series()->isFlatShadingEnabled();
@@ -83,11 +92,13 @@ void SurfaceSeriesRenderCache::cleanup(TextureHelper *texHelper)
         texHelper->deleteTexture(&m_surfaceTexture);
     }
 
+    clearLevelsOfDetail();
     delete m_surfaceObj;
     delete m_sliceSurfaceObj;
     for (int i = 0; i < m_dataArray.size(); i++)
         delete m_dataArray.at(i);
     m_dataArray.clear();
+    m_dataGrid = SurfaceDataGrid();
 
     for (int i = 0; i < m_sliceDataArray.size(); i++)
         delete m_sliceDataArray.at(i);
@@ -99,4 +110,20 @@ void SurfaceSeriesRenderCache::cleanup(TextureHelper *texHelper)
     SeriesRenderCache::cleanup(texHelper);
 }
 
+void SurfaceSeriesRenderCache::addLevelOfDetail(const SurfaceDataGrid &grid,
+                                                SurfaceObject *object)
+{
+    object->setLineColor(m_surfaceObj->wireframeColor());
+    m_lodGrids.append(grid);
+    m_lodObjects.append(object);
+}
+
+void SurfaceSeriesRenderCache::clearLevelsOfDetail()
+{
+    qDeleteAll(m_lodObjects);
+    m_lodObjects.clear();
+    m_lodGrids.clear();
+    m_levelOfDetail = 0;
+}
+
 QT_END_NAMESPACE
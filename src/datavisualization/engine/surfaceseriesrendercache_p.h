@@ -68,11 +68,34 @@ public:
     inline void setFlatChangeAllowed(bool allowed) { m_flatChangeAllowed = allowed; }
     inline SurfaceObject *surfaceObject() { return m_surfaceObj; }
     inline SurfaceObject *sliceSurfaceObject() { return m_sliceSurfaceObj; }
+    inline bool isLevelOfDetailEnabled() const { return m_levelOfDetailEnabled; }
+    inline int levelOfDetailCount() const { return int(m_lodObjects.size()) + 1; }
+    inline int levelOfDetail() const { return m_levelOfDetail; }
+    inline void setLevelOfDetail(int level) { m_levelOfDetail = level; }
+    inline const SurfaceDataGrid &levelOfDetailGrid(int level) const
+    {
+        return m_lodGrids.at(level - 1);
+    }
+    inline SurfaceObject *levelOfDetailObject()
+    {
+        return m_levelOfDetail ? m_lodObjects.at(m_levelOfDetail - 1) : m_surfaceObj;
+    }
+    void addLevelOfDetail(const SurfaceDataGrid &grid, SurfaceObject *object);
+    void clearLevelsOfDetail();
     inline const QRect &sampleSpace() const { return m_sampleSpace; }
     inline void setSampleSpace(const QRect &sampleSpace) { m_sampleSpace = sampleSpace; }
     inline QSurface3DSeries *series() const { return static_cast<QSurface3DSeries *>(m_series); }
     inline QSurfaceDataArray &dataArray() { return m_dataArray; }
+    inline SurfaceDataGrid &dataGrid() { return m_dataGrid; }
+    inline SurfaceDataView dataView() const
+    {
+        if (!m_dataGrid.isEmpty())
+            return SurfaceDataView(m_dataGrid);
+        return SurfaceDataView(m_dataArray);
+    }
     inline QSurfaceDataArray &sliceDataArray() { return m_sliceDataArray; }
+    inline qint64 scrolledRowCount() const { return m_scrolledRowCount; }
+    inline void setScrolledRowCount(qint64 count) { m_scrolledRowCount = count; }
     inline bool renderable() const { return m_visible && (m_surfaceVisible ||
                                                           m_surfaceGridVisible); }
     inline void setSelectionTexture(GLuint texture) { m_selectionTexture = texture; }
@@ -80,6 +103,7 @@ public:
     inline void setSelectionIdRange(uint start, uint end) { m_selectionIdStart = start;
                                                             m_selectionIdEnd = end; }
     inline uint selectionIdStart() const { return m_selectionIdStart; }
+    inline uint selectionIdEnd() const { return m_selectionIdEnd; }
     inline bool isWithinIdRange(uint selection) const { return selection >= m_selectionIdStart &&
                                                         selection <= m_selectionIdEnd; }
     inline bool isFlatStatusDirty() const { return m_flatStatusDirty; }
@@ -105,9 +129,15 @@ protected:
     bool m_surfaceFlatShading;
     SurfaceObject *m_surfaceObj;
     SurfaceObject *m_sliceSurfaceObj;
+    bool m_levelOfDetailEnabled;
+    int m_levelOfDetail;
+    QList<SurfaceDataGrid> m_lodGrids;
+    QList<SurfaceObject *> m_lodObjects;
     QRect m_sampleSpace;
     QSurfaceDataArray m_dataArray;
+    SurfaceDataGrid m_dataGrid;
     QSurfaceDataArray m_sliceDataArray;
+    qint64 m_scrolledRowCount;
     GLuint m_selectionTexture;
     uint m_selectionIdStart;
     uint m_selectionIdEnd;
@@ -0,0 +1,641 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "volumebrickpool_p.h"
+#include "texturehelper_p.h"
+#include "qcustom3dvolume_p.h"
+#include "utils_p.h"
+
+#include <QtCore/QFloat16>
+
+#include <algorithm>
+#include <limits>
+
+QT_BEGIN_NAMESPACE
+
+// Edge length of a brick in voxels
+static const int brickSize = 16;
+// Limits the brick data read and uploaded per frame, so that filling the pool does not stall
+// rendering
+static const qint64 brickLoadBytesPerFrame = 4 * 1024 * 1024;
+// Loading order is recalculated when the view direction turns more than about five degrees
+static const float priorityDirectionLimit = 0.996f;
+// Pool slot coordinates are stored as bytes in the brick texture
+static const int maxSlotsPerAxis = 255;
+// Minimum 3D texture size required by OpenGL 2.1
+static const int defaultMax3DTextureSize = 256;
+
+static void updateRowRange(const uchar *row, QImage::Format format,
+                           QCustom3DVolume::TextureValueType valueType, int begin, int end,
+                           quint16 &minValue, quint16 &maxValue)
+{
+    if (format == QImage::Format_Indexed8) {
+        for (int x = begin; x < end; x++) {
+            const quint16 value = row[x];
+            minValue = qMin(minValue, value);
+            maxValue = qMax(maxValue, value);
+        }
+    } else if (format == QImage::Format_Grayscale16
+               && valueType == QCustom3DVolume::TextureValueUnsigned) {
+        const quint16 *values = reinterpret_cast<const quint16 *>(row);
+        for (int x = begin; x < end; x++) {
+            minValue = qMin(minValue, values[x]);
+            maxValue = qMax(maxValue, values[x]);
+        }
+    } else if (format == QImage::Format_Grayscale16 || format == QImage::Format_Invalid) {
+        // Floating point values are clamped to the color table range by the shaders, so they
+        // are mapped to the same range as the unsigned values. Float volumes use
+        // QImage::Format_Invalid.
+        for (int x = begin; x < end; x++) {
+            float value;
+            if (format == QImage::Format_Grayscale16)
+                value = float(reinterpret_cast<const qfloat16 *>(row)[x]);
+            else
+                value = reinterpret_cast<const float *>(row)[x];
+            const quint16 mapped = quint16(qBound(0.0f, value, 1.0f) * 65535.0f);
+            minValue = qMin(minValue, mapped);
+            maxValue = qMax(maxValue, mapped);
+        }
+    } else {
+        // Only the alpha matters for the visibility of colors
+        const QRgb *colors = reinterpret_cast<const QRgb *>(row);
+        for (int x = begin; x < end; x++) {
+            const quint16 value = quint16(qAlpha(colors[x]));
+            minValue = qMin(minValue, value);
+            maxValue = qMax(maxValue, value);
+        }
+    }
+}
+
+VolumeBrickPool::VolumeBrickPool()
+    : m_textureHelper(new TextureHelper()),
+      m_max3DTextureSize(defaultMax3DTextureSize),
+      m_width(0),
+      m_height(0),
+      m_depth(0),
+      m_dataWidth(0),
+      m_pixelBytes(4),
+      m_format(QImage::Format_ARGB32),
+      m_valueType(QCustom3DVolume::TextureValueUnsigned),
+      m_countX(0),
+      m_countY(0),
+      m_countZ(0),
+      m_pooled(false),
+      m_memoryLimit(0),
+      m_brickTexture(0),
+      m_poolTexture(0),
+      m_slotsX(0),
+      m_slotsY(0),
+      m_slotsZ(0),
+      m_nextWanted(0),
+      m_priorityDirty(false),
+      m_emptyBricksFound(false)
+{
+    initializeOpenGLFunctions();
+
+#if !QT_CONFIG(opengles2)
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxTextureSize);
+    if (maxTextureSize > 0)
+        m_max3DTextureSize = maxTextureSize;
+#endif
+
+    // All colors are visible until a color table is set
+    m_visibleColorSums.resize(257);
+    for (int i = 0; i < m_visibleColorSums.size(); i++)
+        m_visibleColorSums[i] = i;
+}
+
+VolumeBrickPool::~VolumeBrickPool()
+{
+    m_textureHelper->deleteTexture(&m_brickTexture);
+    m_textureHelper->deleteTexture(&m_poolTexture);
+    delete m_textureHelper;
+}
+
+void VolumeBrickPool::setData(const uchar *data, int width, int height, int depth,
+                              QImage::Format format,
+                              QCustom3DVolume::TextureValueType valueType, bool pooled)
+{
+    m_textureHelper->deleteTexture(&m_brickTexture);
+    m_textureHelper->deleteTexture(&m_poolTexture);
+    m_slotBricks.clear();
+    m_freeSlots.clear();
+    m_wanted.clear();
+    m_nextWanted = 0;
+    m_emptyBricksFound = false;
+
+    m_width = width;
+    m_height = height;
+    m_depth = depth;
+    m_format = format;
+    m_valueType = valueType;
+    // Rows are aligned the same way as in the texture data of the volume
+    m_pixelBytes = QCustom3DVolumePrivate::pixelBytes(format);
+    m_dataWidth = TextureHelper::volumeDataWidth(width, format);
+    m_countX = (width + brickSize - 1) / brickSize;
+    m_countY = (height + brickSize - 1) / brickSize;
+    m_countZ = (depth + brickSize - 1) / brickSize;
+    m_pooled = pooled || width > m_max3DTextureSize || height > m_max3DTextureSize
+            || depth > m_max3DTextureSize;
+
+    const int brickCount = m_countX * m_countY * m_countZ;
+    Brick unknownBrick = { 0xffff, 0, -1, false, false };
+    m_bricks.fill(unknownBrick, brickCount);
+    m_brickTable.fill(0, brickCount);
+    if (!brickCount)
+        return;
+
+    m_brickTexture = m_textureHelper->create3DTexture(static_cast<const uchar *>(0), m_countX,
+                                                      m_countY, m_countZ,
+                                                      QImage::Format_ARGB32);
+    if (m_pooled) {
+        // The ranges are calculated brick by brick as the bricks are loaded
+        createPool();
+    } else {
+        // The whole volume is uploaded anyway, so the ranges can be calculated at once
+        calculateRanges(data, 0, m_countX, 0, m_countY, 0, m_countZ);
+        updateVisibility(0, m_countX, 0, m_countY, 0, m_countZ);
+    }
+}
+
+void VolumeBrickPool::setColorTable(const QList<QVector4D> &colors)
+{
+    QList<int> visibleColorSums(257);
+    visibleColorSums[0] = 0;
+    for (int i = 0; i < 256; i++) {
+        bool visible = i < colors.size() && colors.at(i).w() > 0.0f;
+        visibleColorSums[i + 1] = visibleColorSums.at(i) + (visible ? 1 : 0);
+    }
+    if (visibleColorSums == m_visibleColorSums)
+        return;
+
+    m_visibleColorSums = visibleColorSums;
+    if (m_format != QImage::Format_ARGB32)
+        updateVisibility(0, m_countX, 0, m_countY, 0, m_countZ);
+}
+
+void VolumeBrickPool::setMemoryLimit(qint64 bytes)
+{
+    if (m_memoryLimit != bytes) {
+        m_memoryLimit = bytes;
+        if (m_pooled && m_poolTexture)
+            resizePool();
+    }
+}
+
+void VolumeBrickPool::updateSlice(const uchar *data, Qt::Axis axis, int index)
+{
+    int beginX = 0;
+    int endX = m_countX;
+    int beginY = 0;
+    int endY = m_countY;
+    int beginZ = 0;
+    int endZ = m_countZ;
+    if (axis == Qt::XAxis) {
+        beginX = index / brickSize;
+        endX = beginX + 1;
+    } else if (axis == Qt::YAxis) {
+        beginY = index / brickSize;
+        endY = beginY + 1;
+    } else {
+        beginZ = index / brickSize;
+        endZ = beginZ + 1;
+    }
+    if (index < 0 || endX > m_countX || endY > m_countY || endZ > m_countZ)
+        return;
+
+    if (m_pooled) {
+        // Changed bricks are read and loaded again when they are wanted
+        for (int z = beginZ; z < endZ; z++) {
+            for (int y = beginY; y < endY; y++) {
+                for (int x = beginX; x < endX; x++)
+                    evictBrick((z * m_countY + y) * m_countX + x);
+            }
+        }
+        uploadBrickTable(beginX, endX, beginY, endY, beginZ, endZ);
+    } else {
+        calculateRanges(data, beginX, endX, beginY, endY, beginZ, endZ);
+        updateVisibility(beginX, endX, beginY, endY, beginZ, endZ);
+    }
+}
+
+bool VolumeBrickPool::setViewPosition(const QVector3D &position)
+{
+    m_viewPosition = position;
+    if (m_pooled) {
+        QVector3D direction = (position - QVector3D(0.5f, 0.5f, 0.5f)).normalized();
+        if (QVector3D::dotProduct(direction, m_priorityDirection) < priorityDirectionLimit)
+            m_priorityDirty = true;
+    }
+    return isLoadPending();
+}
+
+void VolumeBrickPool::loadBricks(const uchar *data)
+{
+    if (!m_pooled || !m_poolTexture || !data)
+        return;
+
+    if (m_priorityDirty)
+        prioritize();
+
+    const qint64 brickBytes = qint64(brickSize) * brickSize * brickSize * m_pixelBytes;
+    qint64 bytesLeft = brickLoadBytesPerFrame;
+    while (bytesLeft > 0 && m_nextWanted < m_wanted.size()) {
+        const int brick = m_wanted.at(m_nextWanted++);
+        if (m_bricks.at(brick).slot >= 0)
+            continue;
+        if (!m_bricks.at(brick).rangeKnown) {
+            const int x = brick % m_countX;
+            const int y = (brick / m_countX) % m_countY;
+            const int z = brick / (m_countX * m_countY);
+            calculateRanges(data, x, x + 1, y, y + 1, z, z + 1);
+            m_bricks[brick].visible = isVisible(m_bricks.at(brick));
+            bytesLeft -= brickBytes;
+            if (!m_bricks.at(brick).visible) {
+                m_emptyBricksFound = true;
+                continue;
+            }
+        }
+        if (m_freeSlots.isEmpty()) {
+            m_nextWanted = m_wanted.size();
+            break;
+        }
+        loadBrick(data, brick, m_freeSlots.takeLast());
+        bytesLeft -= brickBytes;
+    }
+
+    // The slots meant for empty bricks can be given to the next nearest bricks
+    if (m_nextWanted >= m_wanted.size() && m_emptyBricksFound) {
+        m_emptyBricksFound = false;
+        m_priorityDirty = true;
+    }
+}
+
+bool VolumeBrickPool::isLoadPending() const
+{
+    return m_pooled && m_poolTexture
+            && (m_priorityDirty || m_nextWanted < m_wanted.size());
+}
+
+QVector3D VolumeBrickPool::brickDimensions() const
+{
+    return QVector3D(float(brickSize) / float(qMax(m_width, 1)),
+                     float(brickSize) / float(qMax(m_height, 1)),
+                     float(brickSize) / float(qMax(m_depth, 1)));
+}
+
+QVector3D VolumeBrickPool::brickCounts() const
+{
+    return QVector3D(float(qMax(m_countX, 1)), float(qMax(m_countY, 1)),
+                     float(qMax(m_countZ, 1)));
+}
+
+QVector3D VolumeBrickPool::poolBrickDimensions() const
+{
+    if (!m_pooled || !m_poolTexture)
+        return QVector3D();
+    return QVector3D(1.0f / float(m_slotsX), 1.0f / float(m_slotsY), 1.0f / float(m_slotsZ));
+}
+
+void VolumeBrickPool::calculateRanges(const uchar *data, int beginX, int endX, int beginY,
+                                      int endY, int beginZ, int endZ)
+{
+    Brick *bricks = m_bricks.data();
+    const qint64 lineBytes = qint64(m_dataWidth) * m_pixelBytes;
+    const qint64 layerVoxels = qint64(endX - beginX) * (endY - beginY)
+            * brickSize * brickSize * brickSize;
+
+    // Each range of brick layers is handled by one thread
+    Utils::parallelFor(endZ - beginZ, [&](int begin, int end) {
+        for (int z = beginZ + begin; z < beginZ + end; z++) {
+            for (int y = beginY; y < endY; y++) {
+                for (int x = beginX; x < endX; x++) {
+                    Brick &brick = bricks[(z * m_countY + y) * m_countX + x];
+                    brick.minValue = 0xffff;
+                    brick.maxValue = 0;
+                    brick.rangeKnown = true;
+                }
+            }
+            if (!data)
+                continue;
+
+            const int lastVoxelZ = qMin((z + 1) * brickSize, m_depth);
+            const int lastVoxelY = qMin(endY * brickSize, m_height);
+            for (int voxelZ = z * brickSize; voxelZ < lastVoxelZ; voxelZ++) {
+                for (int voxelY = beginY * brickSize; voxelY < lastVoxelY; voxelY++) {
+                    const uchar *row = data + (qint64(voxelZ) * m_height + voxelY) * lineBytes;
+                    Brick *rowBricks = bricks + (z * m_countY + voxelY / brickSize) * m_countX;
+                    for (int x = beginX; x < endX; x++) {
+                        updateRowRange(row, m_format, m_valueType, x * brickSize,
+                                       qMin((x + 1) * brickSize, m_width),
+                                       rowBricks[x].minValue, rowBricks[x].maxValue);
+                    }
+                }
+            }
+        }
+    }, int(qMin(layerVoxels, qint64(std::numeric_limits<int>::max()))));
+}
+
+void VolumeBrickPool::updateVisibility(int beginX, int endX, int beginY, int endY, int beginZ,
+                                       int endZ)
+{
+    for (int z = beginZ; z < endZ; z++) {
+        for (int y = beginY; y < endY; y++) {
+            for (int x = beginX; x < endX; x++) {
+                const int index = (z * m_countY + y) * m_countX + x;
+                Brick &brick = m_bricks[index];
+                const bool visible = brick.rangeKnown && isVisible(brick);
+                if (brick.visible != visible && m_pooled)
+                    m_priorityDirty = true;
+                brick.visible = visible;
+                m_brickTable[index] = brickTableEntry(index);
+            }
+        }
+    }
+    uploadBrickTable(beginX, endX, beginY, endY, beginZ, endZ);
+}
+
+bool VolumeBrickPool::isVisible(const Brick &brick) const
+{
+    if (brick.minValue > brick.maxValue)
+        return false;
+    if (m_format == QImage::Format_ARGB32)
+        return brick.maxValue > 0;
+
+    // Check the color table entries the shaders can look up for the values in the brick
+    int first = brick.minValue;
+    int last = brick.maxValue;
+    if (m_format != QImage::Format_Indexed8) {
+        first = first * 255 / 65535;
+        last = qMin(last * 255 / 65535 + 1, 255);
+    } else {
+        // The index calculated from a normalized value may round down
+        first = qMax(first - 1, 0);
+    }
+    return m_visibleColorSums.at(last + 1) > m_visibleColorSums.at(first);
+}
+
+float VolumeBrickPool::brickDistance(int brick) const
+{
+    const int x = brick % m_countX;
+    const int y = (brick / m_countX) % m_countY;
+    const int z = brick / (m_countX * m_countY);
+    QVector3D center((float(x) + 0.5f) * brickSize / float(m_width),
+                     (float(y) + 0.5f) * brickSize / float(m_height),
+                     (float(z) + 0.5f) * brickSize / float(m_depth));
+    return (center - m_viewPosition).lengthSquared();
+}
+
+QRgb VolumeBrickPool::brickTableEntry(int brick) const
+{
+    const Brick &entry = m_bricks.at(brick);
+    if (!entry.visible)
+        return 0;
+    if (!m_pooled)
+        return qRgba(0, 0, 0, 255);
+    if (entry.slot < 0)
+        return 0;
+    return qRgba(entry.slot % m_slotsX, (entry.slot / m_slotsX) % m_slotsY,
+                 entry.slot / (m_slotsX * m_slotsY), 255);
+}
+
+void VolumeBrickPool::updateBrickTableEntry(int brick)
+{
+    const int x = brick % m_countX;
+    const int y = (brick / m_countX) % m_countY;
+    const int z = brick / (m_countX * m_countY);
+    m_brickTable[brick] = brickTableEntry(brick);
+    uploadBrickTable(x, x + 1, y, y + 1, z, z + 1);
+}
+
+void VolumeBrickPool::updateBrickTable()
+{
+    for (int i = 0; i < m_bricks.size(); i++)
+        m_brickTable[i] = brickTableEntry(i);
+    uploadBrickTable(0, m_countX, 0, m_countY, 0, m_countZ);
+}
+
+void VolumeBrickPool::uploadBrickTable(int beginX, int endX, int beginY, int endY, int beginZ,
+                                       int endZ)
+{
+    if (!m_brickTexture)
+        return;
+
+    const QRgb *entries = m_brickTable.constData() + (beginZ * m_countY + beginY) * m_countX
+            + beginX;
+    m_textureHelper->update3DTexture(m_brickTexture, reinterpret_cast<const uchar *>(entries),
+                                     m_countX, m_countY, QImage::Format_ARGB32,
+                                     beginX, beginY, beginZ,
+                                     endX - beginX, endY - beginY, endZ - beginZ);
+}
+
+void VolumeBrickPool::calculatePoolSlots(int &slotsX, int &slotsY, int &slotsZ) const
+{
+    const qint64 brickBytes = qint64(brickSize) * brickSize * brickSize * m_pixelBytes;
+    const qint64 slotCount = qBound(qint64(1), m_memoryLimit / brickBytes,
+                                    qint64(m_bricks.size()));
+    const qint64 maxSlots = qMin(maxSlotsPerAxis, m_max3DTextureSize / brickSize);
+    slotsX = int(qMin(slotCount, maxSlots));
+    slotsY = int(qMin(slotCount / slotsX, maxSlots));
+    slotsZ = int(qMin(slotCount / (slotsX * slotsY), maxSlots));
+}
+
+void VolumeBrickPool::createPool()
+{
+    m_textureHelper->deleteTexture(&m_poolTexture);
+    for (int i = 0; i < m_bricks.size(); i++)
+        m_bricks[i].slot = -1;
+
+    calculatePoolSlots(m_slotsX, m_slotsY, m_slotsZ);
+    m_slotBricks.fill(-1, m_slotsX * m_slotsY * m_slotsZ);
+    m_freeSlots.clear();
+    m_wanted.clear();
+    m_nextWanted = 0;
+    m_priorityDirty = true;
+
+    m_poolTexture = m_textureHelper->create3DTexture(static_cast<const uchar *>(0),
+                                                     m_slotsX * brickSize, m_slotsY * brickSize,
+                                                     m_slotsZ * brickSize, m_format,
+                                                     m_valueType);
+    updateBrickTable();
+}
+
+void VolumeBrickPool::resizePool()
+{
+    int slotsX;
+    int slotsY;
+    int slotsZ;
+    calculatePoolSlots(slotsX, slotsY, slotsZ);
+    if (slotsX == m_slotsX && slotsY == m_slotsY && slotsZ == m_slotsZ)
+        return;
+
+    // The nearest loaded bricks are kept
+    QList<int> loadedBricks;
+    foreach (int brick, m_slotBricks) {
+        if (brick >= 0)
+            loadedBricks.append(brick);
+    }
+    std::sort(loadedBricks.begin(), loadedBricks.end(), [this](int a, int b) {
+        return brickDistance(a) < brickDistance(b);
+    });
+    const int slotCount = slotsX * slotsY * slotsZ;
+    const int keptCount = qMin(slotCount, int(loadedBricks.size()));
+
+    // The old pool is read back, so that the kept bricks are copied from it instead of
+    // reading them from the volume data again
+    const int oldWidth = m_slotsX * brickSize;
+    const int oldHeight = m_slotsY * brickSize;
+    QList<uchar> oldPool;
+    if (keptCount) {
+        oldPool.resize(qsizetype(oldWidth) * oldHeight * m_slotsZ * brickSize * m_pixelBytes);
+        m_textureHelper->read3DTexture(m_poolTexture, m_format, oldPool.data(), m_valueType);
+    }
+    GLuint poolTexture = m_textureHelper->create3DTexture(static_cast<const uchar *>(0),
+                                                          slotsX * brickSize,
+                                                          slotsY * brickSize,
+                                                          slotsZ * brickSize, m_format,
+                                                          m_valueType);
+
+    m_slotBricks.fill(-1, slotCount);
+    for (int i = 0; i < loadedBricks.size(); i++) {
+        Brick &brick = m_bricks[loadedBricks.at(i)];
+        if (i < keptCount) {
+            const int oldX = (brick.slot % m_slotsX) * brickSize;
+            const int oldY = ((brick.slot / m_slotsX) % m_slotsY) * brickSize;
+            const int oldZ = (brick.slot / (m_slotsX * m_slotsY)) * brickSize;
+            const uchar *source = oldPool.constData()
+                    + ((qint64(oldZ) * oldHeight + oldY) * oldWidth + oldX) * m_pixelBytes;
+            m_textureHelper->update3DTexture(poolTexture, source, oldWidth, oldHeight, m_format,
+                                             (i % slotsX) * brickSize,
+                                             ((i / slotsX) % slotsY) * brickSize,
+                                             (i / (slotsX * slotsY)) * brickSize,
+                                             brickSize, brickSize, brickSize, m_valueType);
+            brick.slot = i;
+            m_slotBricks[i] = loadedBricks.at(i);
+        } else {
+            brick.slot = -1;
+        }
+    }
+
+    m_textureHelper->deleteTexture(&m_poolTexture);
+    m_poolTexture = poolTexture;
+    m_slotsX = slotsX;
+    m_slotsY = slotsY;
+    m_slotsZ = slotsZ;
+    m_freeSlots.clear();
+    m_wanted.clear();
+    m_nextWanted = 0;
+    m_priorityDirty = true;
+    updateBrickTable();
+}
+
+void VolumeBrickPool::prioritize()
+{
+    const int brickCount = m_bricks.size();
+    QList<float> distances(brickCount);
+    m_wanted.clear();
+    for (int i = 0; i < brickCount; i++) {
+        distances[i] = brickDistance(i);
+        // Bricks that have not been read yet may turn out to be visible
+        if (m_bricks.at(i).visible || !m_bricks.at(i).rangeKnown)
+            m_wanted.append(i);
+    }
+
+    auto nearer = [&distances](int a, int b) { return distances.at(a) < distances.at(b); };
+    const int slotCount = m_slotBricks.size();
+    if (m_wanted.size() > slotCount) {
+        std::nth_element(m_wanted.begin(), m_wanted.begin() + slotCount, m_wanted.end(), nearer);
+        m_wanted.resize(slotCount);
+    }
+    std::sort(m_wanted.begin(), m_wanted.end(), nearer);
+
+    QList<bool> isWanted(brickCount, false);
+    foreach (int brick, m_wanted)
+        isWanted[brick] = true;
+
+    // Empty slots are used first, then the slots of the farthest unwanted bricks
+    QList<int> emptySlots;
+    m_freeSlots.clear();
+    for (int slot = 0; slot < slotCount; slot++) {
+        const int brick = m_slotBricks.at(slot);
+        if (brick < 0)
+            emptySlots.append(slot);
+        else if (!isWanted.at(brick))
+            m_freeSlots.append(slot);
+    }
+    std::sort(m_freeSlots.begin(), m_freeSlots.end(), [&](int a, int b) {
+        return nearer(m_slotBricks.at(a), m_slotBricks.at(b));
+    });
+    m_freeSlots.append(emptySlots);
+
+    m_nextWanted = 0;
+    m_priorityDirty = false;
+    m_emptyBricksFound = false;
+    m_priorityDirection = (m_viewPosition - QVector3D(0.5f, 0.5f, 0.5f)).normalized();
+}
+
+void VolumeBrickPool::loadBrick(const uchar *data, int brick, int slot)
+{
+    const int oldBrick = m_slotBricks.at(slot);
+    if (oldBrick >= 0) {
+        m_bricks[oldBrick].slot = -1;
+        updateBrickTableEntry(oldBrick);
+    }
+    m_slotBricks[slot] = brick;
+    m_bricks[brick].slot = slot;
+
+    const int voxelX = (brick % m_countX) * brickSize;
+    const int voxelY = ((brick / m_countX) % m_countY) * brickSize;
+    const int voxelZ = (brick / (m_countX * m_countY)) * brickSize;
+    const uchar *source = data + ((qint64(voxelZ) * m_height + voxelY) * m_dataWidth + voxelX)
+            * m_pixelBytes;
+    m_textureHelper->update3DTexture(m_poolTexture, source, m_dataWidth, m_height, m_format,
+                                     (slot % m_slotsX) * brickSize,
+                                     ((slot / m_slotsX) % m_slotsY) * brickSize,
+                                     (slot / (m_slotsX * m_slotsY)) * brickSize,
+                                     qMin(brickSize, m_width - voxelX),
+                                     qMin(brickSize, m_height - voxelY),
+                                     qMin(brickSize, m_depth - voxelZ), m_valueType);
+    updateBrickTableEntry(brick);
+}
+
+void VolumeBrickPool::evictBrick(int brick)
+{
+    Brick &entry = m_bricks[brick];
+    if (entry.slot >= 0)
+        m_slotBricks[entry.slot] = -1;
+    entry.slot = -1;
+    entry.visible = false;
+    entry.rangeKnown = false;
+    m_brickTable[brick] = 0;
+    m_priorityDirty = true;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,154 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QtDataVisualization API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+#ifndef VOLUMEBRICKPOOL_P_H
+#define VOLUMEBRICKPOOL_P_H
+
+#include "datavisualizationglobal_p.h"
+#include "qcustom3dvolume.h"
+
+#include <QtGui/QImage>
+#include <QtGui/QVector4D>
+
+QT_BEGIN_NAMESPACE
+
+class TextureHelper;
+
+// Splits a volume into bricks and keeps the range of the values in each brick, so that the
+// volume shaders can skip the bricks that are fully transparent with the current color table.
+// A pooled volume is not uploaded as a whole. Instead, its visible bricks are loaded on demand
+// into a pool texture limited by the memory limit, nearest to the viewer first, and the bricks
+// that are not in the pool are drawn transparent. Volumes read from a file and volumes that do
+// not fit in a single 3D texture are pooled. The value ranges of a pooled volume are found as
+// its bricks are first loaded, so the whole volume is never read at once.
+// The brick texture tells the shaders which bricks are visible and where pooled bricks are in
+// the pool. The volume data is only accessed in the functions that take it as a parameter.
+class VolumeBrickPool : protected QOpenGLFunctions
+{
+public:
+    VolumeBrickPool();
+    ~VolumeBrickPool();
+
+    void setData(const uchar *data, int width, int height, int depth, QImage::Format format,
+                 QCustom3DVolume::TextureValueType valueType, bool pooled);
+    void setColorTable(const QList<QVector4D> &colors);
+    // Resizes the pool, keeping the loaded bricks that still fit
+    void setMemoryLimit(qint64 bytes);
+    // Recalculates the value ranges of the bricks that contain the slice
+    void updateSlice(const uchar *data, Qt::Axis axis, int index);
+
+    // Position of the viewer in volume texture coordinates. Returns true if bricks need loading.
+    bool setViewPosition(const QVector3D &position);
+    void loadBricks(const uchar *data);
+    bool isLoadPending() const;
+
+    inline bool isPooled() const { return m_pooled; }
+    inline GLuint brickTexture() const { return m_brickTexture; }
+    inline GLuint poolTexture() const { return m_poolTexture; }
+    // Size of a brick in volume texture coordinates
+    QVector3D brickDimensions() const;
+    QVector3D brickCounts() const;
+    // Size of a brick in pool texture coordinates, or zero if the volume is not pooled
+    QVector3D poolBrickDimensions() const;
+
+private:
+    struct Brick {
+        quint16 minValue;
+        quint16 maxValue;
+        int slot;
+        bool visible;
+        bool rangeKnown;
+    };
+
+    void calculateRanges(const uchar *data, int beginX, int endX, int beginY, int endY,
+                         int beginZ, int endZ);
+    void updateVisibility(int beginX, int endX, int beginY, int endY, int beginZ, int endZ);
+    bool isVisible(const Brick &brick) const;
+    float brickDistance(int brick) const;
+    QRgb brickTableEntry(int brick) const;
+    void updateBrickTableEntry(int brick);
+    void updateBrickTable();
+    void uploadBrickTable(int beginX, int endX, int beginY, int endY, int beginZ, int endZ);
+    void calculatePoolSlots(int &slotsX, int &slotsY, int &slotsZ) const;
+    void createPool();
+    void resizePool();
+    void prioritize();
+    void loadBrick(const uchar *data, int brick, int slot);
+    void evictBrick(int brick);
+
+    TextureHelper *m_textureHelper;
+    int m_max3DTextureSize;
+
+    int m_width;
+    int m_height;
+    int m_depth;
+    int m_dataWidth;
+    int m_pixelBytes;
+    QImage::Format m_format;
+    QCustom3DVolume::TextureValueType m_valueType;
+    int m_countX;
+    int m_countY;
+    int m_countZ;
+    QList<Brick> m_bricks;
+    QList<QRgb> m_brickTable;
+    // Running count of the visible color table entries
+    QList<int> m_visibleColorSums;
+
+    bool m_pooled;
+    qint64 m_memoryLimit;
+    GLuint m_brickTexture;
+    GLuint m_poolTexture;
+    int m_slotsX;
+    int m_slotsY;
+    int m_slotsZ;
+    QList<int> m_slotBricks;
+    QList<int> m_freeSlots;
+    // Bricks that are visible or not yet read and fit in the pool, nearest to the viewer first
+    QList<int> m_wanted;
+    int m_nextWanted;
+    bool m_priorityDirty;
+    // Set when wanted bricks turn out to be empty, leaving room for other bricks in the pool
+    bool m_emptyBricksFound;
+    QVector3D m_viewPosition;
+    QVector3D m_priorityDirection;
+};
+
+QT_END_NAMESPACE
+
+#endif
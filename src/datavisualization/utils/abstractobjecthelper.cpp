@@ -37,6 +37,7 @@ AbstractObjectHelper::AbstractObjectHelper()
       m_uvbuffer(0),
       m_elementbuffer(0),
       m_indexCount(0),
+      m_indexOffset(0),
       m_meshDataLoaded(false)
 {
     initializeOpenGLFunctions();
@@ -85,4 +86,9 @@ GLuint AbstractObjectHelper::indexCount()
     return m_indexCount;
 }
 
+GLuint AbstractObjectHelper::indexOffset()
+{
+    return m_indexOffset;
+}
+
 QT_END_NAMESPACE
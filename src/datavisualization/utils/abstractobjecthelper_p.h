@@ -56,6 +56,7 @@ public:
     virtual GLuint uvBuf();
     GLuint elementBuf();
     GLuint indexCount();
+    GLuint indexOffset();
 
 public:
     GLuint m_vertexbuffer;
@@ -64,6 +65,8 @@ public:
     GLuint m_elementbuffer;
 
     GLuint m_indexCount;
+    // First index drawn
+    GLuint m_indexOffset;
     GLboolean m_meshDataLoaded;
 };
 
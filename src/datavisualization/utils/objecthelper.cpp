@@ -31,10 +31,13 @@
 #include "vertexindexer_p.h"
 #include "objecthelper_p.h"
 
+#include <QtCore/QMutex>
+
 QT_BEGIN_NAMESPACE
 
-ObjectHelper::ObjectHelper(const QString &objectFile)
-    : m_objectFile(objectFile)
+ObjectHelper::ObjectHelper(const QString &objectFile, ObjectCache *cache)
+    : m_objectFile(objectFile),
+      m_cache(cache)
 {
     load();
 }
@@ -44,81 +47,188 @@ struct ObjectHelperRef {
     ObjectHelper *obj;
 };
 
-// The "Abstract3DRenderer *" key identifies the renderer
-static QHash<const Abstract3DRenderer *, QHash<QString, ObjectHelperRef *> *> cacheTable;
+// Contexts in the same share group can use each other's buffers, so the object helpers are
+// cached per share group of the current context
+struct ObjectCache {
+    // Null once the share group has been destroyed
+    QOpenGLContextGroup *shareGroup;
+    QMetaObject::Connection groupConnection;
+    QHash<QString, ObjectHelperRef *> objects;
+};
+
+static QHash<QOpenGLContextGroup *, ObjectCache *> cacheTable;
+// Mesh data does not depend on the context, so it is kept for as long as any cache uses it
+static QHash<QString, QWeakPointer<const IndexedMesh>> meshTable;
+// Renderers of different windows may run in different threads
+static QMutex cacheMutex;
+
+static QOpenGLContextGroup *currentShareGroup()
+{
+    if (QOpenGLContext *context = QOpenGLContext::currentContext())
+        return context->shareGroup();
+    return 0;
+}
 
 ObjectHelper::~ObjectHelper()
 {
+    // The context that created the buffers may already be gone, so resolve the functions
+    // for deleting them again from the current context of the same share group
+    if (QOpenGLContext::currentContext())
+        initializeOpenGLFunctions();
 }
 
 void ObjectHelper::resetObjectHelper(const Abstract3DRenderer *cacheId, ObjectHelper *&obj,
                                      const QString &meshFile)
 {
     Q_ASSERT(cacheId);
+    Q_UNUSED(cacheId);
 
+    QMutexLocker locker(&cacheMutex);
     if (obj) {
         const QString &oldFile = obj->objectFile();
-        if (meshFile == oldFile)
+        QOpenGLContextGroup *shareGroup = currentShareGroup();
+        ObjectCache *cache = shareGroup ? cacheTable.value(shareGroup, 0) : 0;
+        if (meshFile == oldFile && obj->m_cache == cache && (cache || !shareGroup))
             return; // same file, do nothing
-        releaseObjectHelper(cacheId, obj);
+        release(obj);
     }
-    obj = getObjectHelper(cacheId, meshFile);
+    obj = getObjectHelper(meshFile);
 }
 
 void ObjectHelper::releaseObjectHelper(const Abstract3DRenderer *cacheId, ObjectHelper *&obj)
 {
     Q_ASSERT(cacheId);
+    Q_UNUSED(cacheId);
+
+    QMutexLocker locker(&cacheMutex);
+    release(obj);
+}
 
+void ObjectHelper::release(ObjectHelper *&obj)
+{
     if (obj) {
-        QHash<QString, ObjectHelperRef *> *objectTable = cacheTable.value(cacheId, 0);
-        if (objectTable) {
+        ObjectCache *cache = obj->m_cache;
+        if (cache) {
             // Delete object if last reference is released
-            ObjectHelperRef *objRef = objectTable->value(obj->m_objectFile, 0);
+            ObjectHelperRef *objRef = cache->objects.value(obj->m_objectFile, 0);
             if (objRef) {
                 objRef->refCount--;
                 if (objRef->refCount <= 0) {
-                    objectTable->remove(obj->m_objectFile);
+                    cache->objects.remove(obj->m_objectFile);
                     delete objRef->obj;
                     delete objRef;
                 }
             }
-            if (objectTable->isEmpty()) {
+            if (cache->objects.isEmpty()) {
                 // Remove the entire cache if last object was removed
-                cacheTable.remove(cacheId);
-                delete objectTable;
+                if (cache->shareGroup) {
+                    cacheTable.remove(cache->shareGroup);
+                    QObject::disconnect(cache->groupConnection);
+                }
+                delete cache;
             }
         } else {
-            // Just delete the object if unknown cache
+            // Objects created without a current context are not shared
             delete obj;
         }
         obj = 0;
     }
 }
 
-ObjectHelper *ObjectHelper::getObjectHelper(const Abstract3DRenderer *cacheId,
-                                            const QString &objectFile)
+void ObjectHelper::detachCache(QOpenGLContextGroup *shareGroup)
+{
+    QMutexLocker locker(&cacheMutex);
+    ObjectCache *cache = cacheTable.take(shareGroup);
+    if (!cache)
+        return;
+
+    // The buffers were destroyed with the share group, and a new group may be created at the
+    // same address. The cache is kept until its objects are released, but it is no longer
+    // found for new objects, and its buffer names are not deleted in unrelated contexts.
+    cache->shareGroup = 0;
+    foreach (ObjectHelperRef *objRef, cache->objects) {
+        objRef->obj->m_vertexbuffer = 0;
+        objRef->obj->m_normalbuffer = 0;
+        objRef->obj->m_uvbuffer = 0;
+        objRef->obj->m_elementbuffer = 0;
+    }
+}
+
+ObjectHelper *ObjectHelper::getObjectHelper(const QString &objectFile)
 {
     if (objectFile.isEmpty())
         return 0;
 
-    QHash<QString, ObjectHelperRef *> *objectTable = cacheTable.value(cacheId, 0);
-    if (!objectTable) {
-        objectTable = new QHash<QString, ObjectHelperRef *>;
-        cacheTable.insert(cacheId, objectTable);
+    QOpenGLContextGroup *shareGroup = currentShareGroup();
+    if (!shareGroup)
+        return new ObjectHelper(objectFile, 0);
+
+    ObjectCache *cache = cacheTable.value(shareGroup, 0);
+    if (!cache) {
+        cache = new ObjectCache;
+        cache->shareGroup = shareGroup;
+        cache->groupConnection = QObject::connect(shareGroup, &QObject::destroyed,
+                                                  [shareGroup]() {
+            detachCache(shareGroup);
+        });
+        cacheTable.insert(shareGroup, cache);
     }
 
     // Check if object helper for this mesh already exists
-    ObjectHelperRef *objRef = objectTable->value(objectFile, 0);
+    ObjectHelperRef *objRef = cache->objects.value(objectFile, 0);
     if (!objRef) {
         objRef = new ObjectHelperRef;
         objRef->refCount = 0;
-        objRef->obj = new ObjectHelper(objectFile);
-        objectTable->insert(objectFile, objRef);
+        objRef->obj = new ObjectHelper(objectFile, cache);
+        cache->objects.insert(objectFile, objRef);
     }
     objRef->refCount++;
     return objRef->obj;
 }
 
+QSharedPointer<const IndexedMesh> ObjectHelper::indexedMesh(const QString &objectFile)
+{
+    QSharedPointer<const IndexedMesh> mesh = meshTable.value(objectFile).toStrongRef();
+    if (mesh)
+        return mesh;
+
+    QList<QVector3D> vertices;
+    QList<QVector2D> uvs;
+    QList<QVector3D> normals;
+    bool loadOk = MeshLoader::loadOBJ(objectFile, vertices, uvs, normals);
+    if (!loadOk)
+        qFatal("loading failed");
+
+    // Index vertices
+    IndexedMesh *newMesh = new IndexedMesh;
+    VertexIndexer::indexVBO(vertices, uvs, normals, newMesh->indices, newMesh->vertices,
+                            newMesh->uvs, newMesh->normals);
+    if (!newMesh->vertices.isEmpty()) {
+        newMesh->minimum = newMesh->vertices.at(0);
+        newMesh->maximum = newMesh->minimum;
+        foreach (const QVector3D &vertex, newMesh->vertices) {
+            newMesh->minimum.setX(qMin(newMesh->minimum.x(), vertex.x()));
+            newMesh->minimum.setY(qMin(newMesh->minimum.y(), vertex.y()));
+            newMesh->minimum.setZ(qMin(newMesh->minimum.z(), vertex.z()));
+            newMesh->maximum.setX(qMax(newMesh->maximum.x(), vertex.x()));
+            newMesh->maximum.setY(qMax(newMesh->maximum.y(), vertex.y()));
+            newMesh->maximum.setZ(qMax(newMesh->maximum.z(), vertex.z()));
+            newMesh->radius = qMax(newMesh->radius, vertex.length());
+        }
+    }
+    mesh.reset(newMesh);
+
+    // Drop the entries of meshes no longer in use before adding the new one
+    for (auto it = meshTable.begin(); it != meshTable.end();) {
+        if (it.value().isNull())
+            it = meshTable.erase(it);
+        else
+            ++it;
+    }
+    meshTable.insert(objectFile, mesh);
+    return mesh;
+}
+
 void ObjectHelper::load()
 {
     if (m_meshDataLoaded) {
@@ -127,49 +237,36 @@ void ObjectHelper::load()
         glDeleteBuffers(1, &m_uvbuffer);
         glDeleteBuffers(1, &m_normalbuffer);
         glDeleteBuffers(1, &m_elementbuffer);
-        m_indices.clear();
-        m_indexedVertices.clear();
-        m_indexedUVs.clear();
-        m_indexedNormals.clear();
         m_vertexbuffer = 0;
         m_uvbuffer = 0;
         m_normalbuffer = 0;
         m_elementbuffer = 0;
     }
-    QList<QVector3D> vertices;
-    QList<QVector2D> uvs;
-    QList<QVector3D> normals;
-    bool loadOk = MeshLoader::loadOBJ(m_objectFile, vertices, uvs, normals);
-    if (!loadOk)
-        qFatal("loading failed");
-
-    // Index vertices
-    VertexIndexer::indexVBO(vertices, uvs, normals, m_indices, m_indexedVertices, m_indexedUVs,
-                            m_indexedNormals);
+    m_mesh = indexedMesh(m_objectFile);
 
-    m_indexCount = m_indices.size();
+    m_indexCount = m_mesh->indices.size();
 
     glGenBuffers(1, &m_vertexbuffer);
     glBindBuffer(GL_ARRAY_BUFFER, m_vertexbuffer);
-    glBufferData(GL_ARRAY_BUFFER, m_indexedVertices.size() * sizeof(QVector3D),
-                 &m_indexedVertices.at(0),
+    glBufferData(GL_ARRAY_BUFFER, m_mesh->vertices.size() * sizeof(QVector3D),
+                 &m_mesh->vertices.at(0),
                  GL_STATIC_DRAW);
 
     glGenBuffers(1, &m_normalbuffer);
     glBindBuffer(GL_ARRAY_BUFFER, m_normalbuffer);
-    glBufferData(GL_ARRAY_BUFFER, m_indexedNormals.size() * sizeof(QVector3D),
-                 &m_indexedNormals.at(0),
+    glBufferData(GL_ARRAY_BUFFER, m_mesh->normals.size() * sizeof(QVector3D),
+                 &m_mesh->normals.at(0),
                  GL_STATIC_DRAW);
 
     glGenBuffers(1, &m_uvbuffer);
     glBindBuffer(GL_ARRAY_BUFFER, m_uvbuffer);
-    glBufferData(GL_ARRAY_BUFFER, m_indexedUVs.size() * sizeof(QVector2D),
-                 &m_indexedUVs.at(0), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, m_mesh->uvs.size() * sizeof(QVector2D),
+                 &m_mesh->uvs.at(0), GL_STATIC_DRAW);
 
     glGenBuffers(1, &m_elementbuffer);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_elementbuffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(GLuint),
-                 &m_indices.at(0), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_mesh->indices.size() * sizeof(GLuint),
+                 &m_mesh->indices.at(0), GL_STATIC_DRAW);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
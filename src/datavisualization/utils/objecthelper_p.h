@@ -43,14 +43,32 @@
 #include "datavisualizationglobal_p.h"
 #include "abstractobjecthelper_p.h"
 
+#include <QtCore/QSharedPointer>
+#include <QtGui/QVector2D>
+#include <QtGui/QVector3D>
+
 QT_BEGIN_NAMESPACE
 
 class Abstract3DRenderer;
+struct ObjectCache;
+
+// Parsed and indexed mesh data, shared by all object helpers loading the same mesh file
+struct IndexedMesh
+{
+    QList<GLuint> indices;
+    QList<QVector3D> vertices;
+    QList<QVector2D> uvs;
+    QList<QVector3D> normals;
+    // Bounds of the vertices, used for picking
+    QVector3D minimum;
+    QVector3D maximum;
+    float radius = 0.0f;
+};
 
 class ObjectHelper : public AbstractObjectHelper
 {
 private:
-    ObjectHelper(const QString &objectFile);
+    ObjectHelper(const QString &objectFile, ObjectCache *cache);
 public:
     virtual ~ObjectHelper();
 
@@ -59,21 +77,24 @@ public:
     static void releaseObjectHelper(const Abstract3DRenderer *cacheId, ObjectHelper *&obj);
     inline const QString &objectFile() { return m_objectFile; }
 
-    inline const QList<GLuint> &indices() const { return m_indices; }
-    inline const QList<QVector3D> &indexedvertices() const { return m_indexedVertices; }
-    inline const QList<QVector2D> &indexedUVs() const { return m_indexedUVs; }
-    inline const QList<QVector3D> &indexedNormals() const { return m_indexedNormals; }
+    inline const QList<GLuint> &indices() const { return m_mesh->indices; }
+    inline const QList<QVector3D> &indexedvertices() const { return m_mesh->vertices; }
+    inline const QList<QVector2D> &indexedUVs() const { return m_mesh->uvs; }
+    inline const QList<QVector3D> &indexedNormals() const { return m_mesh->normals; }
+    inline const QVector3D &boundsMinimum() const { return m_mesh->minimum; }
+    inline const QVector3D &boundsMaximum() const { return m_mesh->maximum; }
+    inline float boundingRadius() const { return m_mesh->radius; }
 
 private:
-    static ObjectHelper *getObjectHelper(const Abstract3DRenderer *cacheId,
-                                         const QString &objectFile);
+    static ObjectHelper *getObjectHelper(const QString &objectFile);
+    static void release(ObjectHelper *&obj);
+    static void detachCache(QOpenGLContextGroup *shareGroup);
+    static QSharedPointer<const IndexedMesh> indexedMesh(const QString &objectFile);
     void load();
 
     QString m_objectFile;
-    QList<GLuint> m_indices;
-    QList<QVector3D> m_indexedVertices;
-    QList<QVector2D> m_indexedUVs;
-    QList<QVector3D> m_indexedNormals;
+    ObjectCache *m_cache;
+    QSharedPointer<const IndexedMesh> m_mesh;
 };
 
 QT_END_NAMESPACE
@@ -0,0 +1,285 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "raypicker_p.h"
+#include "objecthelper_p.h"
+
+#include <QtCore/QVarLengthArray>
+
+#include <algorithm>
+#include <limits>
+
+QT_BEGIN_NAMESPACE
+
+static const int leafSize = 4;
+
+// Creates the ray through the center of the selection buffer pixel that would be read for
+// the given position. Returns false if the position is outside the viewport.
+bool RayPicker::selectionRay(const QPoint &position, const QSize &viewportSize, int windowHeight,
+                             const QMatrix4x4 &projectionViewMatrix, Ray &ray)
+{
+    const int x = position.x();
+    const int y = windowHeight - position.y();
+    if (x < 0 || y < 0 || x >= viewportSize.width() || y >= viewportSize.height())
+        return false;
+
+    bool invertible = false;
+    const QMatrix4x4 inverse = projectionViewMatrix.inverted(&invertible);
+    if (!invertible)
+        return false;
+
+    const float ndcX = 2.0f * (float(x) + 0.5f) / float(viewportSize.width()) - 1.0f;
+    const float ndcY = 2.0f * (float(y) + 0.5f) / float(viewportSize.height()) - 1.0f;
+    const QVector3D nearPoint = inverse.map(QVector3D(ndcX, ndcY, -1.0f));
+    const QVector3D farPoint = inverse.map(QVector3D(ndcX, ndcY, 1.0f));
+    ray.origin = nearPoint;
+    ray.direction = (farPoint - nearPoint).normalized();
+    return !ray.direction.isNull();
+}
+
+// Slab test. The returned range is clamped to start at the ray origin.
+bool RayPicker::intersectBox(const Ray &ray, const QVector3D &minimum, const QVector3D &maximum,
+                             float &tNear, float &tFar)
+{
+    tNear = 0.0f;
+    tFar = std::numeric_limits<float>::max();
+    for (int axis = 0; axis < 3; axis++) {
+        const float origin = ray.origin[axis];
+        const float direction = ray.direction[axis];
+        if (direction == 0.0f) {
+            if (origin < minimum[axis] || origin > maximum[axis])
+                return false;
+            continue;
+        }
+        float t1 = (minimum[axis] - origin) / direction;
+        float t2 = (maximum[axis] - origin) / direction;
+        if (t1 > t2)
+            std::swap(t1, t2);
+        tNear = qMax(tNear, t1);
+        tFar = qMin(tFar, t2);
+        if (tNear > tFar)
+            return false;
+    }
+    return true;
+}
+
+// Moller-Trumbore intersection without culling, as the selection pass draws both faces of
+// negative bars and surfaces.
+float RayPicker::intersectTriangle(const Ray &ray, const QVector3D &a, const QVector3D &b,
+                                   const QVector3D &c)
+{
+    const QVector3D edge1 = b - a;
+    const QVector3D edge2 = c - a;
+    const QVector3D p = QVector3D::crossProduct(ray.direction, edge2);
+    const float determinant = QVector3D::dotProduct(edge1, p);
+    if (determinant == 0.0f)
+        return -1.0f;
+
+    const float inverse = 1.0f / determinant;
+    const QVector3D s = ray.origin - a;
+    const float u = QVector3D::dotProduct(s, p) * inverse;
+    if (u < 0.0f || u > 1.0f)
+        return -1.0f;
+
+    const QVector3D q = QVector3D::crossProduct(s, edge1);
+    const float v = QVector3D::dotProduct(ray.direction, q) * inverse;
+    if (v < 0.0f || u + v > 1.0f)
+        return -1.0f;
+
+    return QVector3D::dotProduct(edge2, q) * inverse;
+}
+
+// Returns the distance along the ray to the quad from -1 to 1 on the xy-plane drawn with the
+// given model matrix, such as a label, or a negative value on a miss. Labels are scaled flat,
+// so the corners are transformed instead of the ray.
+float RayPicker::intersectQuad(const Ray &ray, const QMatrix4x4 &modelMatrix)
+{
+    const QVector3D a = modelMatrix.map(QVector3D(-1.0f, -1.0f, 0.0f));
+    const QVector3D b = modelMatrix.map(QVector3D(1.0f, -1.0f, 0.0f));
+    const QVector3D c = modelMatrix.map(QVector3D(-1.0f, 1.0f, 0.0f));
+    const QVector3D d = modelMatrix.map(QVector3D(1.0f, 1.0f, 0.0f));
+    const float t = intersectTriangle(ray, a, b, c);
+    if (t >= 0.0f)
+        return t;
+    return intersectTriangle(ray, c, b, d);
+}
+
+// Returns the distance along the ray to the closest triangle of the object drawn with the given
+// model matrix, or a negative value on a miss. The ray is moved to the object space instead of
+// transforming the vertices. As the transformation is affine, the distance is preserved.
+float RayPicker::intersectMesh(const Ray &ray, const QMatrix4x4 &modelMatrix,
+                               const ObjectHelper *object)
+{
+    bool invertible = false;
+    const QMatrix4x4 inverse = modelMatrix.inverted(&invertible);
+    if (!invertible)
+        return -1.0f;
+
+    Ray objectRay;
+    objectRay.origin = inverse.map(ray.origin);
+    objectRay.direction = inverse.mapVector(ray.direction);
+
+    float tNear;
+    float tFar;
+    if (!intersectBox(objectRay, object->boundsMinimum(), object->boundsMaximum(), tNear, tFar))
+        return -1.0f;
+
+    const QList<GLuint> &indices = object->indices();
+    const QList<QVector3D> &vertices = object->indexedvertices();
+    float closest = -1.0f;
+    for (int i = 0; i + 2 < indices.size(); i += 3) {
+        const float t = intersectTriangle(objectRay, vertices.at(indices.at(i)),
+                                          vertices.at(indices.at(i + 1)),
+                                          vertices.at(indices.at(i + 2)));
+        if (t >= 0.0f && (closest < 0.0f || t < closest))
+            closest = t;
+    }
+    return closest;
+}
+
+void BoundingVolumeHierarchy::build(const QList<QVector3D> &minimums,
+                                    const QList<QVector3D> &maximums)
+{
+    clear();
+    const int count = minimums.size();
+    if (!count)
+        return;
+
+    QList<QVector3D> centers(count);
+    m_primitives.resize(count);
+    for (int i = 0; i < count; i++) {
+        centers[i] = (minimums.at(i) + maximums.at(i)) * 0.5f;
+        m_primitives[i] = i;
+    }
+    m_nodes.reserve(2 * (count / leafSize) + 1);
+    buildNode(0, count, minimums, maximums, centers);
+}
+
+void BoundingVolumeHierarchy::clear()
+{
+    m_nodes.clear();
+    m_primitives.clear();
+}
+
+// Returns the closest primitive accepted by the test, or -1 if there is none. The margin grows
+// the boxes of the hierarchy, so that point primitives can be queried with a radius.
+int BoundingVolumeHierarchy::closestHit(const RayPicker::Ray &ray, float margin,
+                                        const PrimitiveTest &test, float &distance) const
+{
+    int closest = -1;
+    distance = std::numeric_limits<float>::max();
+    if (m_nodes.isEmpty())
+        return closest;
+
+    const QVector3D marginVector(margin, margin, margin);
+    QVarLengthArray<int, 64> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        const Node &node = m_nodes.at(stack.takeLast());
+        float tNear;
+        float tFar;
+        if (!RayPicker::intersectBox(ray, node.minimum - marginVector,
+                                     node.maximum + marginVector, tNear, tFar)
+                || tNear > distance) {
+            continue;
+        }
+
+        if (node.count) {
+            for (int i = node.start; i < node.start + node.count; i++) {
+                const int primitive = m_primitives.at(i);
+                const float t = test(primitive);
+                if (t >= 0.0f && t < distance) {
+                    distance = t;
+                    closest = primitive;
+                }
+            }
+        } else {
+            // Visit the child nearer to the ray origin first
+            const int left = int(&node - m_nodes.constData()) + 1;
+            if (ray.direction[node.axis] < 0.0f) {
+                stack.append(left);
+                stack.append(node.right);
+            } else {
+                stack.append(node.right);
+                stack.append(left);
+            }
+        }
+    }
+    return closest;
+}
+
+int BoundingVolumeHierarchy::buildNode(int start, int end, const QList<QVector3D> &minimums,
+                                       const QList<QVector3D> &maximums,
+                                       const QList<QVector3D> &centers)
+{
+    Node node;
+    node.minimum = minimums.at(m_primitives.at(start));
+    node.maximum = maximums.at(m_primitives.at(start));
+    QVector3D centerMinimum = centers.at(m_primitives.at(start));
+    QVector3D centerMaximum = centerMinimum;
+    for (int i = start + 1; i < end; i++) {
+        const int primitive = m_primitives.at(i);
+        for (int axis = 0; axis < 3; axis++) {
+            node.minimum[axis] = qMin(node.minimum[axis], minimums.at(primitive)[axis]);
+            node.maximum[axis] = qMax(node.maximum[axis], maximums.at(primitive)[axis]);
+            centerMinimum[axis] = qMin(centerMinimum[axis], centers.at(primitive)[axis]);
+            centerMaximum[axis] = qMax(centerMaximum[axis], centers.at(primitive)[axis]);
+        }
+    }
+    node.start = start;
+    node.count = end - start;
+    node.right = -1;
+    node.axis = 0;
+
+    const int index = m_nodes.size();
+    m_nodes.append(node);
+    if (node.count <= leafSize)
+        return index;
+
+    // Split at the median of the longest axis of the centers
+    const QVector3D extent = centerMaximum - centerMinimum;
+    int axis = 0;
+    if (extent.y() > extent[axis])
+        axis = 1;
+    if (extent.z() > extent[axis])
+        axis = 2;
+    const int middle = start + (end - start) / 2;
+    std::nth_element(m_primitives.begin() + start, m_primitives.begin() + middle,
+                     m_primitives.begin() + end, [&centers, axis](int a, int b) {
+        return centers.at(a)[axis] < centers.at(b)[axis];
+    });
+
+    m_nodes[index].count = 0;
+    m_nodes[index].axis = axis;
+    buildNode(start, middle, minimums, maximums, centers);
+    m_nodes[index].right = buildNode(middle, end, minimums, maximums, centers);
+    return index;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,111 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QtDataVisualization API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+#ifndef RAYPICKER_P_H
+#define RAYPICKER_P_H
+
+#include "datavisualizationglobal_p.h"
+
+#include <QtCore/QRect>
+#include <QtGui/QMatrix4x4>
+#include <QtGui/QVector3D>
+
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+
+class ObjectHelper;
+
+// Helpers for resolving clicks by casting a ray into the scene on CPU, instead of rendering
+// the selection buffer and reading it back.
+class Q_AUTOTEST_EXPORT RayPicker
+{
+public:
+    struct Ray
+    {
+        QVector3D origin;
+        QVector3D direction;
+    };
+
+    static bool selectionRay(const QPoint &position, const QSize &viewportSize, int windowHeight,
+                             const QMatrix4x4 &projectionViewMatrix, Ray &ray);
+    static bool intersectBox(const Ray &ray, const QVector3D &minimum, const QVector3D &maximum,
+                             float &tNear, float &tFar);
+    static float intersectTriangle(const Ray &ray, const QVector3D &a, const QVector3D &b,
+                                   const QVector3D &c);
+    static float intersectQuad(const Ray &ray, const QMatrix4x4 &modelMatrix);
+    static float intersectMesh(const Ray &ray, const QMatrix4x4 &modelMatrix,
+                               const ObjectHelper *object);
+};
+
+// Bounding volume hierarchy over axis aligned boxes, built with median splits.
+class Q_AUTOTEST_EXPORT BoundingVolumeHierarchy
+{
+public:
+    // Returns the distance along the ray to the given primitive, or a negative value on a miss
+    typedef std::function<float(int primitive)> PrimitiveTest;
+
+    void build(const QList<QVector3D> &minimums, const QList<QVector3D> &maximums);
+    void clear();
+    inline bool isEmpty() const { return m_nodes.isEmpty(); }
+
+    int closestHit(const RayPicker::Ray &ray, float margin, const PrimitiveTest &test,
+                   float &distance) const;
+
+private:
+    struct Node
+    {
+        QVector3D minimum;
+        QVector3D maximum;
+        int start;
+        int count; // Zero for inner nodes
+        int right; // The left child directly follows its parent
+        int axis;
+    };
+
+    int buildNode(int start, int end, const QList<QVector3D> &minimums,
+                  const QList<QVector3D> &maximums, const QList<QVector3D> &centers);
+
+    QList<Node> m_nodes;
+    QList<int> m_primitives;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,182 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "scatterinstancebufferhelper_p.h"
+#include "utils_p.h"
+
+QT_BEGIN_NAMESPACE
+
+ScatterInstanceBufferHelper::ScatterInstanceBufferHelper()
+    : m_instancebuffer(0),
+      m_itemSize(0.0f)
+{
+}
+
+ScatterInstanceBufferHelper::~ScatterInstanceBufferHelper()
+{
+    if (QOpenGLContext::currentContext())
+        glDeleteBuffers(1, &m_instancebuffer);
+}
+
+GLuint ScatterInstanceBufferHelper::instanceBuf()
+{
+    if (!m_meshDataLoaded)
+        qFatal("No loaded object");
+    return m_instancebuffer;
+}
+
+bool ScatterInstanceBufferHelper::isLoadNeeded(ScatterSeriesRenderCache *cache,
+                                               float itemSize) const
+{
+    return cache->instanceBufferDirty() || m_itemSize != itemSize
+            || m_meshRotation != cache->meshRotation();
+}
+
+void ScatterInstanceBufferHelper::load(ScatterSeriesRenderCache *cache, float itemSize)
+{
+    const ScatterRenderItemArray &renderArray = cache->renderArray();
+    const int renderArraySize = renderArray.size();
+
+    m_itemSize = itemSize;
+    m_meshRotation = cache->meshRotation();
+    cache->setInstanceBufferDirty(false);
+
+    // Hidden items are left out, so the buffer only contains the instances that are drawn.
+    // The instances are stored in the order of the render chunks, so that each chunk can be
+    // drawn as a range of instances. Buffer indices map the render array to the instances for
+    // partial updates.
+    const QList<int> &chunkItems = cache->chunkItems();
+    m_chunks = cache->renderChunks();
+    QList<int> &bufferIndices = cache->bufferIndices();
+    bufferIndices.fill(-1, renderArraySize);
+    const int instanceCount = chunkItems.size();
+    m_instanceChunks.resize(instanceCount);
+    for (int chunk = 0; chunk < m_chunks.size(); chunk++) {
+        const int end = m_chunks.at(chunk).start + m_chunks.at(chunk).count;
+        for (int i = m_chunks.at(chunk).start; i < end; i++) {
+            bufferIndices[chunkItems.at(i)] = i;
+            m_instanceChunks[i] = chunk;
+        }
+    }
+
+    // Large arrays are packed in parallel
+    QList<QVector4D> bufferedInstances;
+    bufferedInstances.resize(instanceCount * 2);
+    const int *instanceIndices = bufferIndices.constData();
+    QVector4D *instances = bufferedInstances.data();
+    Utils::parallelFor(renderArraySize,
+                       [&, instanceIndices, instances](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            if (instanceIndices[i] < 0)
+                continue;
+            const ScatterRenderItem &item = renderArray.at(i);
+            const int offset = instanceIndices[i] * 2;
+            instances[offset] = QVector4D(item.translation(), itemSize);
+            instances[offset + 1] = instanceRotation(item);
+        }
+    });
+
+    m_indexCount = instanceCount;
+
+    if (instanceCount > 0) {
+        if (!m_instancebuffer)
+            glGenBuffers(1, &m_instancebuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, m_instancebuffer);
+        glBufferData(GL_ARRAY_BUFFER, instanceCount * 2 * sizeof(QVector4D),
+                     &bufferedInstances.at(0), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        m_meshDataLoaded = true;
+    }
+}
+
+void ScatterInstanceBufferHelper::update(ScatterSeriesRenderCache *cache)
+{
+    // It may be that the buffer hasn't yet been initialized, in case the entire series was
+    // hidden items. No need to update in that case. Changes in item visibility need a full
+    // load instead, as the hidden items are not stored in the buffer.
+    if (!m_meshDataLoaded)
+        return;
+
+    const ScatterRenderItemArray &renderArray = cache->renderArray();
+    const int updateSize = cache->updateIndices().size();
+    QVector4D instance[2];
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_instancebuffer);
+    for (int i = 0; i < updateSize; i++) {
+        const int index = cache->updateIndices().at(i);
+        const ScatterRenderItem &item = renderArray.at(index);
+        if (!item.isVisible())
+            continue;
+
+        const int bufferIndex = cache->bufferIndices().at(index);
+        instance[0] = QVector4D(item.translation(), m_itemSize);
+        instance[1] = instanceRotation(item);
+        glBufferSubData(GL_ARRAY_BUFFER, bufferIndex * sizeof(instance), sizeof(instance),
+                        instance);
+
+        // The instance stays in its chunk, so the chunk grows to cover the new translation
+        ScatterSeriesRenderCache::RenderChunk &chunk = m_chunks[m_instanceChunks.at(bufferIndex)];
+        for (int axis = 0; axis < 3; axis++) {
+            chunk.minimum[axis] = qMin(chunk.minimum[axis], item.translation()[axis]);
+            chunk.maximum[axis] = qMax(chunk.maximum[axis], item.translation()[axis]);
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Collects the instance ranges of the chunks that are at least partially inside the frustum.
+// The margin is the distance an item can extend from its translation. Consecutive chunks are
+// merged into one range.
+void ScatterInstanceBufferHelper::cullInstances(const ViewFrustum &frustum, float margin,
+                                                QList<QPair<int, int>> &ranges) const
+{
+    const QVector3D marginVector(margin, margin, margin);
+    ranges.clear();
+    foreach (const ScatterSeriesRenderCache::RenderChunk &chunk, m_chunks) {
+        if (!frustum.intersectsBox(chunk.minimum - marginVector, chunk.maximum + marginVector))
+            continue;
+        if (!ranges.isEmpty() && ranges.last().first + ranges.last().second == chunk.start)
+            ranges.last().second += chunk.count;
+        else
+            ranges.append(qMakePair(chunk.start, chunk.count));
+    }
+}
+
+QVector4D ScatterInstanceBufferHelper::instanceRotation(const ScatterRenderItem &item) const
+{
+    if (item.rotation().isIdentity())
+        return m_meshRotation.toVector4D();
+    else if (m_meshRotation.isIdentity())
+        return item.rotation().toVector4D();
+    else
+        return (m_meshRotation * item.rotation()).toVector4D();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,85 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QtDataVisualization API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+
+#ifndef SCATTERINSTANCEBUFFERHELPER_P_H
+#define SCATTERINSTANCEBUFFERHELPER_P_H
+
+#include "datavisualizationglobal_p.h"
+#include "abstractobjecthelper_p.h"
+#include "scatterseriesrendercache_p.h"
+#include <QtCore/QPair>
+#include <QtGui/QVector4D>
+
+QT_BEGIN_NAMESPACE
+
+// Holds the per-item transformations of a mesh series for instanced drawing.
+// Each instance is stored as two vec4 attributes: translation + uniform scale, and rotation.
+class ScatterInstanceBufferHelper : public AbstractObjectHelper
+{
+public:
+    ScatterInstanceBufferHelper();
+    virtual ~ScatterInstanceBufferHelper();
+
+    GLuint instanceBuf();
+
+    void load(ScatterSeriesRenderCache *cache, float itemSize);
+    void update(ScatterSeriesRenderCache *cache);
+    bool isLoadNeeded(ScatterSeriesRenderCache *cache, float itemSize) const;
+    void cullInstances(const ViewFrustum &frustum, float margin,
+                       QList<QPair<int, int>> &ranges) const;
+
+public:
+    GLuint m_instancebuffer;
+
+private:
+    QVector4D instanceRotation(const ScatterRenderItem &item) const;
+
+    float m_itemSize;
+    QQuaternion m_meshRotation;
+    // The render chunks of the series when the instances were loaded. The instances are stored
+    // chunk by chunk, and the chunk bounds grow to cover the instances updated since.
+    QList<ScatterSeriesRenderCache::RenderChunk> m_chunks;
+    QList<int> m_instanceChunks; // Chunk of each instance
+};
+
+QT_END_NAMESPACE
+
+#endif
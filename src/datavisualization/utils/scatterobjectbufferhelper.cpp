@@ -29,16 +29,23 @@
 
 #include "scatterobjectbufferhelper_p.h"
 #include "objecthelper_p.h"
+#include "utils_p.h"
 #include <QtGui/QVector2D>
 #include <QtGui/QMatrix4x4>
+#include <QtCore/QMap>
 #include <QtCore/qmath.h>
 
 QT_BEGIN_NAMESPACE
 
 const GLfloat itemScaler = 3.0f;
+// Spare item slots allocated on full load, so that hidden items can be shown again without
+// reallocating the buffers
+const int minSpareItemSlots = 16;
 
 ScatterObjectBufferHelper::ScatterObjectBufferHelper()
-    : m_scaleY(0.0f)
+    : m_scaleY(0.0f),
+      m_itemCapacity(0),
+      m_itemSlotCount(0)
 {
 }
 
@@ -49,16 +56,20 @@ ScatterObjectBufferHelper::~ScatterObjectBufferHelper()
 void ScatterObjectBufferHelper::fullLoad(ScatterSeriesRenderCache *cache, qreal dotScale)
 {
     m_indexCount = 0;
+    m_itemCapacity = 0;
+    m_itemSlotCount = 0;
+    m_freeSlots.clear();
 
     ObjectHelper *dotObj = cache->object();
     const ScatterRenderItemArray &renderArray = cache->renderArray();
     const uint renderArraySize = renderArray.size();
 
-    if (renderArraySize == 0)
+    if (renderArraySize == 0) {
+        cache->bufferIndices().clear();
         return;  // No use to go forward
+    }
 
     uint itemCount = 0;
-    QQuaternion seriesRotation(cache->meshRotation());
 
     if (m_meshDataLoaded) {
         // Delete old data
@@ -83,109 +94,81 @@ void ScatterObjectBufferHelper::fullLoad(ScatterSeriesRenderCache *cache, qreal
     const int uvsCount = indexed_uvs.count();
     const int normalsCount = indexed_normals.count();
 
-    float itemSize = cache->itemSize() / itemScaler;
-    if (itemSize == 0.0f)
-        itemSize = dotScale;
-    QVector3D modelScaler(itemSize, itemSize, itemSize);
-    QMatrix4x4 modelMatrix;
-    if (!seriesRotation.isIdentity()) {
-        QMatrix4x4 matrix;
-        matrix.rotate(seriesRotation);
-        modelMatrix = matrix.transposed();
-    }
-    modelMatrix.scale(modelScaler);
+    updateItemTransform(cache, dotScale);
 
-    QList<QVector3D> scaled_vertices;
-    scaled_vertices.resize(verticeCount);
-    for (int i = 0; i < verticeCount; i++)
-        scaled_vertices[i] = (QVector4D(indexed_vertices[i]) * modelMatrix).toVector3D();
+    QList<int> &bufferIndices = cache->bufferIndices();
+    bufferIndices.fill(-1, renderArraySize);
+    for (uint i = 0; i < renderArraySize; i++) {
+        if (renderArray.at(i).isVisible())
+            bufferIndices[i] = itemCount++;
+    }
+    const uint itemCapacity = itemCount + qMax(itemCount / 4, uint(minSpareItemSlots));
 
     QList<GLuint> buffered_indices;
     QList<QVector3D> buffered_vertices;
     QList<QVector2D> buffered_uvs;
     QList<QVector3D> buffered_normals;
 
-    buffered_indices.resize(indicesCount * renderArraySize);
-    buffered_vertices.resize(verticeCount * renderArraySize);
-    buffered_normals.resize(normalsCount * renderArraySize);
-    buffered_uvs.resize(uvsCount * renderArraySize);
+    // Spare slots are left degenerate until items are moved into them
+    buffered_indices.resize(indicesCount * itemCapacity);
+    buffered_vertices.resize(verticeCount * itemCapacity);
+    buffered_normals.resize(normalsCount * itemCapacity);
+    buffered_uvs.resize(uvsCount * itemCapacity);
 
     if (cache->colorStyle() == Q3DTheme::ColorStyleRangeGradient)
         createRangeGradientUVs(cache, buffered_uvs);
     else if (cache->colorStyle() == Q3DTheme::ColorStyleObjectGradient)
         createObjectGradientUVs(cache, buffered_uvs, indexed_vertices);
 
-    QVector2D dummyUV(0.0f, 0.0f);
-
-    cache->bufferIndices().resize(renderArraySize);
-
-    for (uint i = 0; i < renderArraySize; i++) {
-        const ScatterRenderItem &item = renderArray.at(i);
-        if (!item.isVisible())
-            continue;
-        else
-            cache->bufferIndices()[i] = itemCount;
-
-        int offset = itemCount * verticeCount;
-        if (item.rotation().isIdentity()) {
-            for (int j = 0; j < verticeCount; j++) {
-                buffered_vertices[j + offset] = scaled_vertices[j] + item.translation();
-                buffered_normals[j + offset] = indexed_normals[j];
-            }
-        } else {
-            QMatrix4x4 matrix;
-            QQuaternion totalRotation = seriesRotation * item.rotation();
-            matrix.rotate(totalRotation);
-            matrix.scale(modelScaler);
-            QMatrix4x4 itModelMatrix = matrix.inverted();
-            modelMatrix = matrix.transposed(); // Because of row-column major difference
-
-            for (int j = 0; j < verticeCount; j++) {
-                buffered_vertices[j + offset]
-                        = (QVector4D(indexed_vertices[j]) * modelMatrix).toVector3D()
-                        + item.translation();
-                buffered_normals[j + offset]
-                        = (QVector4D(indexed_normals[j]) * itModelMatrix).toVector3D();
-            }
-        }
-
-        if (cache->colorStyle() == Q3DTheme::ColorStyleUniform) {
-            offset = itemCount * uvsCount;
-            for (int j = 0; j < uvsCount; j++)
-                buffered_uvs[j + offset] = dummyUV;
+    // Uniform color style uses the zeroed dummy UVs. The items are transformed in parallel for
+    // large arrays, as each item has its own slot in the buffers.
+    const int *itemSlots = bufferIndices.constData();
+    QVector3D *vertices = buffered_vertices.data();
+    QVector3D *normals = buffered_normals.data();
+    Utils::parallelFor(renderArraySize,
+                       [&, itemSlots, vertices, normals](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            if (itemSlots[i] < 0)
+                continue;
+            const int offset = itemSlots[i] * verticeCount;
+            createItemVertices(renderArray.at(i), indexed_vertices, indexed_normals,
+                               vertices + offset, normals + offset);
         }
+    }, verticeCount);
 
-        int offsetVertice = itemCount * verticeCount;
-        offset = itemCount * indicesCount;
+    for (uint i = 0; i < itemCapacity; i++) {
+        const int offsetVertice = i * verticeCount;
+        const int offset = i * indicesCount;
         for (int j = 0; j < indicesCount; j++)
             buffered_indices[j + offset] = GLuint(indices[j] + offsetVertice);
-
-        itemCount++;
     }
 
     m_indexCount = indicesCount * itemCount;
+    m_itemSlotCount = itemCount;
 
     if (itemCount > 0) {
+        m_itemCapacity = itemCapacity;
+
         glGenBuffers(1, &m_vertexbuffer);
         glBindBuffer(GL_ARRAY_BUFFER, m_vertexbuffer);
-        glBufferData(GL_ARRAY_BUFFER, verticeCount * itemCount * sizeof(QVector3D),
+        glBufferData(GL_ARRAY_BUFFER, verticeCount * itemCapacity * sizeof(QVector3D),
                      &buffered_vertices.at(0),
-                     GL_STATIC_DRAW);
+                     GL_DYNAMIC_DRAW);
 
         glGenBuffers(1, &m_normalbuffer);
         glBindBuffer(GL_ARRAY_BUFFER, m_normalbuffer);
-        glBufferData(GL_ARRAY_BUFFER, normalsCount * itemCount * sizeof(QVector3D),
+        glBufferData(GL_ARRAY_BUFFER, normalsCount * itemCapacity * sizeof(QVector3D),
                      &buffered_normals.at(0),
-                     GL_STATIC_DRAW);
+                     GL_DYNAMIC_DRAW);
 
         glGenBuffers(1, &m_uvbuffer);
         glBindBuffer(GL_ARRAY_BUFFER, m_uvbuffer);
-        glBufferData(GL_ARRAY_BUFFER, uvsCount * itemCount * sizeof(QVector2D),
-                     &buffered_uvs.at(0), GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, uvsCount * itemCapacity * sizeof(QVector2D),
+                     &buffered_uvs.at(0), GL_DYNAMIC_DRAW);
 
         glGenBuffers(1, &m_elementbuffer);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_elementbuffer);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicesCount * itemCount * sizeof(GLint),
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicesCount * itemCapacity * sizeof(GLint),
                      &buffered_indices.at(0), GL_STATIC_DRAW);
 
         glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -203,18 +186,19 @@ void ScatterObjectBufferHelper::updateUVs(ScatterSeriesRenderCache *cache)
     const bool updateAll = (cache->updateIndices().size() == 0);
     const int updateSize = updateAll ? renderArray.size() : cache->updateIndices().size();
 
-    if (!updateSize)
+    // Item slots are only valid after the buffers are in sync with the render array
+    if (!updateSize || !m_meshDataLoaded || cache->bufferIndices().size() != renderArray.size())
         return;
 
     QList<QVector2D> buffered_uvs;
     buffered_uvs.resize(uvsCount * updateSize);
 
-    uint itemCount = 0;
+    // Uniform color style uses the zeroed dummy UVs
     if (cache->colorStyle() == Q3DTheme::ColorStyleRangeGradient) {
-        itemCount = createRangeGradientUVs(cache, buffered_uvs);
+        createRangeGradientUVs(cache, buffered_uvs);
     } else if (cache->colorStyle() == Q3DTheme::ColorStyleObjectGradient) {
         const QList<QVector3D> indexed_vertices = dotObj->indexedvertices();
-        itemCount = createObjectGradientUVs(cache, buffered_uvs, indexed_vertices);
+        createObjectGradientUVs(cache, buffered_uvs, indexed_vertices);
     }
 
     glBindBuffer(GL_ARRAY_BUFFER, m_uvbuffer);
@@ -229,8 +213,20 @@ void ScatterObjectBufferHelper::updateUVs(ScatterSeriesRenderCache *cache)
                                 &buffered_uvs.at(uvsCount * pos++));
             }
         }
-    } else {
-        glBufferData(GL_ARRAY_BUFFER, itemSize * itemCount, &buffered_uvs.at(0), GL_STATIC_DRAW);
+    } else if (m_itemSlotCount) {
+        // Arrange the UVs by item slot to write them with a single call
+        QList<QVector2D> slot_uvs;
+        slot_uvs.resize(uvsCount * m_itemSlotCount);
+        int pos = 0;
+        for (int i = 0; i < updateSize; i++) {
+            if (renderArray.at(i).isVisible()) {
+                const int offset = cache->bufferIndices().at(i) * uvsCount;
+                for (int j = 0; j < uvsCount; j++)
+                    slot_uvs[j + offset] = buffered_uvs.at(uvsCount * pos + j);
+                pos++;
+            }
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, 0, itemSize * m_itemSlotCount, &slot_uvs.at(0));
     }
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
@@ -284,13 +280,15 @@ uint ScatterObjectBufferHelper::createObjectGradientUVs(ScatterSeriesRenderCache
     ObjectHelper *dotObj = cache->object();
     const int uvsCount = dotObj->indexedUVs().count();
     const ScatterRenderItemArray &renderArray = cache->renderArray();
-    const uint renderArraySize = renderArray.size();
+    const bool updateAll = (cache->updateIndices().size() == 0);
+    const int updateSize = updateAll ? renderArray.size() : cache->updateIndices().size();
 
     QVector2D uv;
     uv.setX(0.0f);
     uint pos = 0;
-    for (uint i = 0; i < renderArraySize; i++) {
-        const ScatterRenderItem &item = renderArray.at(i);
+    for (int i = 0; i < updateSize; i++) {
+        int index = updateAll ? i : cache->updateIndices().at(i);
+        const ScatterRenderItem &item = renderArray.at(index);
         if (!item.isVisible())
             continue;
 
@@ -306,88 +304,202 @@ uint ScatterObjectBufferHelper::createObjectGradientUVs(ScatterSeriesRenderCache
     return pos;
 }
 
-void ScatterObjectBufferHelper::update(ScatterSeriesRenderCache *cache, qreal dotScale)
+bool ScatterObjectBufferHelper::update(ScatterSeriesRenderCache *cache, qreal dotScale)
 {
+    // Buffers are only allocated on full load
+    if (!m_meshDataLoaded)
+        return false;
+
     ObjectHelper *dotObj = cache->object();
     const ScatterRenderItemArray &renderArray = cache->renderArray();
+    const int renderArraySize = renderArray.size();
     const bool updateAll = (cache->updateIndices().size() == 0);
-    const int updateSize = updateAll ? renderArray.size() : cache->updateIndices().size();
-    QQuaternion seriesRotation(cache->meshRotation());
+    const int updateSize = updateAll ? renderArraySize : cache->updateIndices().size();
+    QList<int> &bufferIndices = cache->bufferIndices();
+    const int bufferIndicesSize = bufferIndices.size();
+
+    if (!updateAll && bufferIndicesSize != renderArraySize)
+        return false;
+
+    // Check that the items becoming visible fit into the free and spare slots
+    int neededSlots = 0;
+    int releasedSlots = 0;
+    for (int i = renderArraySize; i < bufferIndicesSize; i++) {
+        if (bufferIndices.at(i) >= 0)
+            releasedSlots++;
+    }
+    for (int i = 0; i < updateSize; i++) {
+        int index = updateAll ? i : cache->updateIndices().at(i);
+        const bool hasSlot = index < bufferIndicesSize && bufferIndices.at(index) >= 0;
+        if (renderArray.at(index).isVisible() != hasSlot) {
+            if (hasSlot)
+                releasedSlots++;
+            else
+                neededSlots++;
+        }
+    }
+    if (neededSlots > releasedSlots + m_freeSlots.size() + m_itemCapacity - m_itemSlotCount)
+        return false;
+
+    // Map the changed slots to the items drawn in them, released slots map to -1.
+    // Updating all items rewrites all the slots instead.
+    QMap<int, int> dirtySlots;
+    for (int i = renderArraySize; i < bufferIndicesSize; i++) {
+        if (bufferIndices.at(i) >= 0)
+            m_freeSlots.append(bufferIndices.at(i));
+    }
+    bufferIndices.resize(renderArraySize);
+    for (int i = bufferIndicesSize; i < renderArraySize; i++)
+        bufferIndices[i] = -1;
 
-    if (!updateSize)
-        return;
+    for (int i = 0; i < updateSize; i++) {
+        int index = updateAll ? i : cache->updateIndices().at(i);
+        const int slot = bufferIndices.at(index);
+        if (!renderArray.at(index).isVisible() && slot >= 0) {
+            m_freeSlots.append(slot);
+            if (!updateAll)
+                dirtySlots.insert(slot, -1);
+            bufferIndices[index] = -1;
+        }
+    }
+    for (int i = 0; i < updateSize; i++) {
+        int index = updateAll ? i : cache->updateIndices().at(i);
+        if (!renderArray.at(index).isVisible())
+            continue;
+
+        int slot = bufferIndices.at(index);
+        if (slot < 0) {
+            slot = m_freeSlots.isEmpty() ? m_itemSlotCount++ : m_freeSlots.takeLast();
+            bufferIndices[index] = slot;
+        }
+        if (!updateAll)
+            dirtySlots.insert(slot, index);
+    }
+
+    if (updateAll ? !m_itemSlotCount : dirtySlots.isEmpty())
+        return true;
 
     // Index vertices
     const QList<QVector3D> indexed_vertices = dotObj->indexedvertices();
-    int verticeCount = indexed_vertices.count();
+    const QList<QVector3D> indexed_normals = dotObj->indexedNormals();
+    const int verticeCount = indexed_vertices.count();
+
+    updateItemTransform(cache, dotScale);
+
+    // Collect the slots into runs of consecutive slots, so that each run can be written
+    // with a single call. Released slots are left degenerate.
+    QList<QVector3D> buffered_vertices;
+    QList<QVector3D> buffered_normals;
+    QList<QPair<int, int> > runs;
+    int pos = 0;
+    if (updateAll) {
+        buffered_vertices.resize(verticeCount * m_itemSlotCount);
+        buffered_normals.resize(verticeCount * m_itemSlotCount);
+        runs.append(qMakePair(0, m_itemSlotCount));
+
+        const int *itemSlots = bufferIndices.constData();
+        QVector3D *vertices = buffered_vertices.data();
+        QVector3D *normals = buffered_normals.data();
+        Utils::parallelFor(renderArraySize,
+                           [&, itemSlots, vertices, normals](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                if (itemSlots[i] < 0)
+                    continue;
+                const int offset = itemSlots[i] * verticeCount;
+                createItemVertices(renderArray.at(i), indexed_vertices, indexed_normals,
+                                   vertices + offset, normals + offset);
+            }
+        }, verticeCount);
+    } else {
+        buffered_vertices.resize(verticeCount * dirtySlots.size());
+        buffered_normals.resize(verticeCount * dirtySlots.size());
+        for (QMap<int, int>::const_iterator it = dirtySlots.constBegin();
+             it != dirtySlots.constEnd(); ++it) {
+            if (runs.isEmpty() || it.key() != runs.last().first + runs.last().second)
+                runs.append(qMakePair(it.key(), 0));
+            runs.last().second++;
+
+            if (it.value() >= 0) {
+                const int offset = pos * verticeCount;
+                createItemVertices(renderArray.at(it.value()), indexed_vertices,
+                                   indexed_normals, buffered_vertices.data() + offset,
+                                   buffered_normals.data() + offset);
+            }
+            pos++;
+        }
+    }
 
+    const int sizeOfItem = verticeCount * sizeof(QVector3D);
+    const int runCount = runs.size();
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexbuffer);
+    pos = 0;
+    for (int i = 0; i < runCount; i++) {
+        glBufferSubData(GL_ARRAY_BUFFER, runs.at(i).first * sizeOfItem,
+                        runs.at(i).second * sizeOfItem, &buffered_vertices.at(pos));
+        pos += runs.at(i).second * verticeCount;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, m_normalbuffer);
+    pos = 0;
+    for (int i = 0; i < runCount; i++) {
+        glBufferSubData(GL_ARRAY_BUFFER, runs.at(i).first * sizeOfItem,
+                        runs.at(i).second * sizeOfItem, &buffered_normals.at(pos));
+        pos += runs.at(i).second * verticeCount;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_indexCount = dotObj->indices().count() * m_itemSlotCount;
+
+    return true;
+}
+
+void ScatterObjectBufferHelper::updateItemTransform(ScatterSeriesRenderCache *cache,
+                                                    qreal dotScale)
+{
+    const QList<QVector3D> indexed_vertices = cache->object()->indexedvertices();
+    const int verticeCount = indexed_vertices.count();
+
+    m_seriesRotation = cache->meshRotation();
     float itemSize = cache->itemSize() / itemScaler;
     if (itemSize == 0.0f)
         itemSize = dotScale;
-    QVector3D modelScaler(itemSize, itemSize, itemSize);
+    m_modelScaler = QVector3D(itemSize, itemSize, itemSize);
     QMatrix4x4 modelMatrix;
-    if (!seriesRotation.isIdentity()) {
+    if (!m_seriesRotation.isIdentity()) {
         QMatrix4x4 matrix;
-        matrix.rotate(seriesRotation);
+        matrix.rotate(m_seriesRotation);
         modelMatrix = matrix.transposed();
     }
-    modelMatrix.scale(modelScaler);
+    modelMatrix.scale(m_modelScaler);
 
-    QList<QVector3D> scaled_vertices;
-    scaled_vertices.resize(verticeCount);
+    m_scaledVertices.resize(verticeCount);
     for (int i = 0; i < verticeCount; i++)
-        scaled_vertices[i] = (QVector4D(indexed_vertices[i]) * modelMatrix).toVector3D();
-
-    QList<QVector3D> buffered_vertices;
-    buffered_vertices.resize(verticeCount * updateSize);
-
-    int itemCount = 0;
-    for (int i = 0; i < updateSize; i++) {
-        int index = updateAll ? i : cache->updateIndices().at(i);
-        const ScatterRenderItem &item = renderArray.at(index);
-        if (!item.isVisible())
-            continue;
-
-        const int offset = itemCount * verticeCount;
-        if (item.rotation().isIdentity()) {
-            for (int j = 0; j < verticeCount; j++)
-                buffered_vertices[j + offset] = scaled_vertices[j] + item.translation();
-        } else {
-            QMatrix4x4 matrix;
-            matrix.rotate(seriesRotation * item.rotation());
-            modelMatrix = matrix.transposed();
-            modelMatrix.scale(modelScaler);
-
-            for (int j = 0; j < verticeCount; j++) {
-                buffered_vertices[j + offset]
-                        = (QVector4D(indexed_vertices[j]) * modelMatrix).toVector3D()
-                        + item.translation();
-            }
-        }
-        itemCount++;
-    }
+        m_scaledVertices[i] = (QVector4D(indexed_vertices[i]) * modelMatrix).toVector3D();
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexbuffer);
-    int sizeOfItem = verticeCount * sizeof(QVector3D);
-    if (updateAll) {
-        if (itemCount) {
-            glBufferData(GL_ARRAY_BUFFER, itemCount * sizeOfItem,
-                         &buffered_vertices.at(0), GL_STATIC_DRAW);
+void ScatterObjectBufferHelper::createItemVertices(const ScatterRenderItem &item,
+                                                   const QList<QVector3D> &indexed_vertices,
+                                                   const QList<QVector3D> &indexed_normals,
+                                                   QVector3D *vertices, QVector3D *normals) const
+{
+    const int verticeCount = indexed_vertices.count();
+    if (item.rotation().isIdentity()) {
+        for (int j = 0; j < verticeCount; j++) {
+            vertices[j] = m_scaledVertices.at(j) + item.translation();
+            normals[j] = indexed_normals.at(j);
         }
     } else {
-        itemCount = 0;
-        for (int i = 0; i < updateSize; i++) {
-            int index = updateAll ? i : cache->updateIndices().at(i);
-            if (renderArray.at(index).isVisible()) {
-                glBufferSubData(GL_ARRAY_BUFFER, cache->bufferIndices().at(index) * sizeOfItem,
-                                sizeOfItem, &buffered_vertices.at(itemCount * verticeCount));
-                itemCount++;
-            }
+        QMatrix4x4 matrix;
+        matrix.rotate(m_seriesRotation * item.rotation());
+        matrix.scale(m_modelScaler);
+        QMatrix4x4 itModelMatrix = matrix.inverted();
+        QMatrix4x4 modelMatrix = matrix.transposed(); // Because of row-column major difference
+
+        for (int j = 0; j < verticeCount; j++) {
+            vertices[j] = (QVector4D(indexed_vertices.at(j)) * modelMatrix).toVector3D()
+                    + item.translation();
+            normals[j] = (QVector4D(indexed_normals.at(j)) * itModelMatrix).toVector3D();
         }
     }
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    m_meshDataLoaded = true;
 }
 
 QT_END_NAMESPACE
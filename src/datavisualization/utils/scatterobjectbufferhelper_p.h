@@ -53,16 +53,27 @@ public:
     virtual ~ScatterObjectBufferHelper();
 
     void fullLoad(ScatterSeriesRenderCache *cache, qreal dotScale);
-    void update(ScatterSeriesRenderCache *cache, qreal dotScale);
+    bool update(ScatterSeriesRenderCache *cache, qreal dotScale);
     void updateUVs(ScatterSeriesRenderCache *cache);
     void setScaleY(float scale) { m_scaleY = scale; }
 
 private:
+    void updateItemTransform(ScatterSeriesRenderCache *cache, qreal dotScale);
+    void createItemVertices(const ScatterRenderItem &item,
+                            const QList<QVector3D> &indexed_vertices,
+                            const QList<QVector3D> &indexed_normals,
+                            QVector3D *vertices, QVector3D *normals) const;
     uint createRangeGradientUVs(ScatterSeriesRenderCache *cache, QList<QVector2D> &buffered_uvs);
     uint createObjectGradientUVs(ScatterSeriesRenderCache *cache, QList<QVector2D> &buffered_uvs,
                                  const QList<QVector3D> &indexed_vertices);
 
     float m_scaleY;
+    QQuaternion m_seriesRotation;
+    QVector3D m_modelScaler;
+    QList<QVector3D> m_scaledVertices;
+    int m_itemCapacity; // Item slots allocated in the buffers
+    int m_itemSlotCount; // Item slots in use, including the free ones
+    QList<int> m_freeSlots; // Slots released by hidden items, reused before new slots
 };
 
 QT_END_NAMESPACE
@@ -29,14 +29,18 @@
 
 #include "scatterpointbufferhelper_p.h"
 #include <QtGui/QVector2D>
+#include <algorithm>
 
 QT_BEGIN_NAMESPACE
 
 const QVector3D hiddenPos(-1000.0f, -1000.0f, -1000.0f);
+// Spare points allocated with the buffers, so that the array can grow without reallocating them
+const int minSparePoints = 64;
 
 ScatterPointBufferHelper::ScatterPointBufferHelper()
     : m_pointbuffer(0),
-      m_oldRemoveIndex(-1)
+      m_oldRemoveIndex(-1),
+      m_pointCapacity(0)
 {
 }
 
@@ -90,48 +94,48 @@ void ScatterPointBufferHelper::load(ScatterSeriesRenderCache *cache)
     const int renderArraySize = renderArray.size();
     m_indexCount = 0;
 
-    if (m_meshDataLoaded) {
-        // Delete old data
+    if (m_meshDataLoaded && renderArraySize > m_pointCapacity) {
+        // Delete old data, as the points don't fit in
         glDeleteBuffers(1, &m_pointbuffer);
         glDeleteBuffers(1, &m_uvbuffer);
         m_bufferedPoints.clear();
         m_pointbuffer = 0;
         m_uvbuffer = 0;
+        m_pointCapacity = 0;
         m_meshDataLoaded = false;
     }
 
-    bool itemsVisible = false;
+    // Hidden points are kept in the buffer, so visibility changes can be patched in later
     m_bufferedPoints.resize(renderArraySize);
     for (int i = 0; i < renderArraySize; i++) {
         const ScatterRenderItem &item = renderArray.at(i);
-        if (!item.isVisible()) {
+        if (!item.isVisible())
             m_bufferedPoints[i] = hiddenPos;
-        } else {
-            itemsVisible = true;
+        else
             m_bufferedPoints[i] = item.translation();
-        }
     }
 
     QList<QVector2D> buffered_uvs;
-    if (itemsVisible)
-        m_indexCount = renderArraySize;
+    m_indexCount = renderArraySize;
 
     if (m_indexCount > 0) {
         if (cache->colorStyle() == Q3DTheme::ColorStyleRangeGradient)
             createRangeGradientUVs(cache, buffered_uvs);
 
-        glGenBuffers(1, &m_pointbuffer);
-        glBindBuffer(GL_ARRAY_BUFFER, m_pointbuffer);
-        glBufferData(GL_ARRAY_BUFFER, m_bufferedPoints.size() * sizeof(QVector3D),
-                     &m_bufferedPoints.at(0),
-                     GL_DYNAMIC_DRAW);
-
-        if (buffered_uvs.size()) {
-            glGenBuffers(1, &m_uvbuffer);
-            glBindBuffer(GL_ARRAY_BUFFER, m_uvbuffer);
-            glBufferData(GL_ARRAY_BUFFER, buffered_uvs.size() * sizeof(QVector2D),
-                         &buffered_uvs.at(0), GL_STATIC_DRAW);
+        if (!m_meshDataLoaded) {
+            m_pointCapacity = renderArraySize + qMax(renderArraySize / 4, minSparePoints);
+            glGenBuffers(1, &m_pointbuffer);
+            glBindBuffer(GL_ARRAY_BUFFER, m_pointbuffer);
+            glBufferData(GL_ARRAY_BUFFER, m_pointCapacity * sizeof(QVector3D), 0,
+                         GL_DYNAMIC_DRAW);
+        } else {
+            glBindBuffer(GL_ARRAY_BUFFER, m_pointbuffer);
         }
+        glBufferSubData(GL_ARRAY_BUFFER, 0, m_bufferedPoints.size() * sizeof(QVector3D),
+                        &m_bufferedPoints.at(0));
+
+        if (buffered_uvs.size())
+            writeUVs(buffered_uvs);
 
         glBindBuffer(GL_ARRAY_BUFFER, 0);
 
@@ -141,13 +145,14 @@ void ScatterPointBufferHelper::load(ScatterSeriesRenderCache *cache)
 
 void ScatterPointBufferHelper::update(ScatterSeriesRenderCache *cache)
 {
-    // It may be that the buffer hasn't yet been initialized, in case the entire series was
-    // hidden items. No need to update in that case.
+    // It may be that the buffer hasn't yet been initialized, in case the series was empty.
+    // No need to update in that case.
     if (m_indexCount > 0) {
         const ScatterRenderItemArray &renderArray = cache->renderArray();
         const int updateSize = cache->updateIndices().size();
 
-        glBindBuffer(GL_ARRAY_BUFFER, m_pointbuffer);
+        QList<int> dirtyIndices;
+        dirtyIndices.reserve(updateSize);
         for (int i = 0; i < updateSize; i++) {
             int index = cache->updateIndices().at(i);
             const ScatterRenderItem &item = renderArray.at(index);
@@ -156,10 +161,23 @@ void ScatterPointBufferHelper::update(ScatterSeriesRenderCache *cache)
             else
                 m_bufferedPoints[index] = item.translation();
 
-            if (index != m_oldRemoveIndex) {
-                glBufferSubData(GL_ARRAY_BUFFER, index * sizeof(QVector3D),
-                                sizeof(QVector3D), &m_bufferedPoints.at(index));
-            }
+            if (index != m_oldRemoveIndex)
+                dirtyIndices.append(index);
+        }
+
+        // Write each run of consecutive points with a single call
+        std::sort(dirtyIndices.begin(), dirtyIndices.end());
+        const int dirtyCount = dirtyIndices.size();
+        glBindBuffer(GL_ARRAY_BUFFER, m_pointbuffer);
+        int i = 0;
+        while (i < dirtyCount) {
+            const int firstIndex = dirtyIndices.at(i);
+            int lastIndex = firstIndex;
+            while (++i < dirtyCount && dirtyIndices.at(i) <= lastIndex + 1)
+                lastIndex = dirtyIndices.at(i);
+            glBufferSubData(GL_ARRAY_BUFFER, firstIndex * sizeof(QVector3D),
+                            (lastIndex - firstIndex + 1) * sizeof(QVector3D),
+                            &m_bufferedPoints.at(firstIndex));
         }
         glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
@@ -167,19 +185,16 @@ void ScatterPointBufferHelper::update(ScatterSeriesRenderCache *cache)
 
 void ScatterPointBufferHelper::updateUVs(ScatterSeriesRenderCache *cache)
 {
-    // It may be that the buffer hasn't yet been initialized, in case the entire series was
-    // hidden items. No need to update in that case.
+    // It may be that the buffer hasn't yet been initialized, in case the series was empty.
+    // No need to update in that case.
     if (m_indexCount > 0) {
         QList<QVector2D> buffered_uvs;
         createRangeGradientUVs(cache, buffered_uvs);
 
         if (buffered_uvs.size()) {
-            if (!m_uvbuffer)
-                glGenBuffers(1, &m_uvbuffer);
-
             int updateSize = cache->updateIndices().size();
-            glBindBuffer(GL_ARRAY_BUFFER, m_uvbuffer);
             if (updateSize) {
+                glBindBuffer(GL_ARRAY_BUFFER, m_uvbuffer);
                 for (int i = 0; i < updateSize; i++) {
                     int index = cache->updateIndices().at(i);
                     glBufferSubData(GL_ARRAY_BUFFER, index * sizeof(QVector2D),
@@ -187,8 +202,7 @@ void ScatterPointBufferHelper::updateUVs(ScatterSeriesRenderCache *cache)
 
                 }
             } else {
-                glBufferData(GL_ARRAY_BUFFER, buffered_uvs.size() * sizeof(QVector2D),
-                             &buffered_uvs.at(0), GL_STATIC_DRAW);
+                writeUVs(buffered_uvs);
             }
 
             glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -196,6 +210,19 @@ void ScatterPointBufferHelper::updateUVs(ScatterSeriesRenderCache *cache)
     }
 }
 
+void ScatterPointBufferHelper::writeUVs(const QList<QVector2D> &buffered_uvs)
+{
+    if (!m_uvbuffer) {
+        glGenBuffers(1, &m_uvbuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, m_uvbuffer);
+        glBufferData(GL_ARRAY_BUFFER, m_pointCapacity * sizeof(QVector2D), 0, GL_DYNAMIC_DRAW);
+    } else {
+        glBindBuffer(GL_ARRAY_BUFFER, m_uvbuffer);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, buffered_uvs.size() * sizeof(QVector2D),
+                    &buffered_uvs.at(0));
+}
+
 void ScatterPointBufferHelper::createRangeGradientUVs(ScatterSeriesRenderCache *cache,
                                                       QList<QVector2D> &buffered_uvs)
 {
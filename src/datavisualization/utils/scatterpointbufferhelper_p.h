@@ -66,11 +66,13 @@ public:
 
 private:
     void createRangeGradientUVs(ScatterSeriesRenderCache *cache, QList<QVector2D> &buffered_uvs);
+    void writeUVs(const QList<QVector2D> &buffered_uvs);
 
 private:
     QList<QVector3D> m_bufferedPoints;
     int m_oldRemoveIndex;
     float m_scaleY;
+    int m_pointCapacity;
 };
 
 QT_END_NAMESPACE
@@ -29,6 +29,8 @@
 
 #include "shaderhelper_p.h"
 
+#include <QtCore/QFile>
+#include <QtCore/QRegularExpression>
 #include <QtOpenGL/QOpenGLShader>
 
 QT_BEGIN_NAMESPACE
@@ -41,6 +43,33 @@ void discardDebugMsgs(QtMsgType type, const QMessageLogContext &context, const Q
     // Used to discard warnings generated during shader test compilation
 }
 
+// Reads a shader and replaces the #include "<file>" lines in it with the included file, so that
+// the shaders can share functions. Shaders start with a #version line, so shared code cannot
+// simply be prepended.
+static QByteArray loadShaderSource(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Unable to open shader file:" << fileName;
+        return QByteArray();
+    }
+
+    static const QRegularExpression includeLine(
+                QStringLiteral("^\\s*#include\\s+\"([^\"]+)\"\\s*$"));
+    QByteArray source;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        QRegularExpressionMatch match = includeLine.match(QString::fromLatin1(line));
+        if (match.hasMatch()) {
+            source.append(loadShaderSource(match.captured(1)));
+            source.append('\n');
+        } else {
+            source.append(line);
+        }
+    }
+    return source;
+}
+
 ShaderHelper::ShaderHelper(QObject *parent,
                            const QString &vertexShader,
                            const QString &fragmentShader,
@@ -55,6 +84,8 @@ ShaderHelper::ShaderHelper(QObject *parent,
       m_positionAttr(0),
       m_uvAttr(0),
       m_normalAttr(0),
+      m_instancePositionAttr(-1),
+      m_instanceRotationAttr(-1),
       m_colorUniform(0),
       m_viewMatrixUniform(0),
       m_modelMatrixUniform(0),
@@ -81,6 +112,12 @@ ShaderHelper::ShaderHelper(QObject *parent,
       m_minBoundsUniform(0),
       m_maxBoundsUniform(0),
       m_sliceFrameWidthUniform(0),
+      m_instanceGradientScaleUniform(0),
+      m_brickSamplerUniform(0),
+      m_brickDimensionsUniform(0),
+      m_brickCountsUniform(0),
+      m_poolBrickDimensionsUniform(0),
+      m_uvOffsetUniform(0),
       m_initialized(false)
 {
 }
@@ -109,10 +146,14 @@ void ShaderHelper::initialize()
     if (m_program)
         delete m_program;
     m_program = new QOpenGLShaderProgram(m_caller);
-    if (!m_program->addShaderFromSourceFile(QOpenGLShader::Vertex, m_vertexShaderFile))
+    if (!m_program->addShaderFromSourceCode(QOpenGLShader::Vertex,
+                                            loadShaderSource(m_vertexShaderFile))) {
         qFatal("Compiling Vertex shader failed");
-    if (!m_program->addShaderFromSourceFile(QOpenGLShader::Fragment, m_fragmentShaderFile))
+    }
+    if (!m_program->addShaderFromSourceCode(QOpenGLShader::Fragment,
+                                            loadShaderSource(m_fragmentShaderFile))) {
         qFatal("Compiling Fragment shader failed");
+    }
 
     if (!m_program->link()) {
         qWarning() << "Unable to link shader program:" <<
@@ -123,6 +164,8 @@ void ShaderHelper::initialize()
     m_positionAttr = m_program->attributeLocation("vertexPosition_mdl");
     m_normalAttr = m_program->attributeLocation("vertexNormal_mdl");
     m_uvAttr = m_program->attributeLocation("vertexUV");
+    m_instancePositionAttr = m_program->attributeLocation("instancePosition_wrld");
+    m_instanceRotationAttr = m_program->attributeLocation("instanceRotation");
 
     m_mvpMatrixUniform = m_program->uniformLocation("MVP");
     m_viewMatrixUniform = m_program->uniformLocation("V");
@@ -150,6 +193,12 @@ void ShaderHelper::initialize()
     m_minBoundsUniform = m_program->uniformLocation("minBounds");
     m_maxBoundsUniform = m_program->uniformLocation("maxBounds");
     m_sliceFrameWidthUniform = m_program->uniformLocation("sliceFrameWidth");
+    m_instanceGradientScaleUniform = m_program->uniformLocation("instanceGradientScale");
+    m_brickSamplerUniform = m_program->uniformLocation("brickSampler");
+    m_brickDimensionsUniform = m_program->uniformLocation("brickDimensions");
+    m_brickCountsUniform = m_program->uniformLocation("brickCounts");
+    m_poolBrickDimensionsUniform = m_program->uniformLocation("poolBrickDimensions");
+    m_uvOffsetUniform = m_program->uniformLocation("uvOffset");
     m_initialized = true;
 }
 
@@ -162,10 +211,14 @@ bool ShaderHelper::testCompile()
     if (m_program)
         delete m_program;
     m_program = new QOpenGLShaderProgram();
-    if (!m_program->addShaderFromSourceFile(QOpenGLShader::Vertex, m_vertexShaderFile))
+    if (!m_program->addShaderFromSourceCode(QOpenGLShader::Vertex,
+                                            loadShaderSource(m_vertexShaderFile))) {
         result = false;
-    if (!m_program->addShaderFromSourceFile(QOpenGLShader::Fragment, m_fragmentShaderFile))
+    }
+    if (!m_program->addShaderFromSourceCode(QOpenGLShader::Fragment,
+                                            loadShaderSource(m_fragmentShaderFile))) {
         result = false;
+    }
 
     // Restore actual message handler
     qInstallMessageHandler(handler);
@@ -400,6 +453,48 @@ GLint ShaderHelper::sliceFrameWidth()
     return m_sliceFrameWidthUniform;
 }
 
+GLint ShaderHelper::instanceGradientScale()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_instanceGradientScaleUniform;
+}
+
+GLint ShaderHelper::brickSampler()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_brickSamplerUniform;
+}
+
+GLint ShaderHelper::brickDimensions()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_brickDimensionsUniform;
+}
+
+GLint ShaderHelper::brickCounts()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_brickCountsUniform;
+}
+
+GLint ShaderHelper::poolBrickDimensions()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_poolBrickDimensionsUniform;
+}
+
+GLint ShaderHelper::uvOffset()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_uvOffsetUniform;
+}
+
 GLint ShaderHelper::posAtt()
 {
     if (!m_initialized)
@@ -421,4 +516,18 @@ GLint ShaderHelper::normalAtt()
     return m_normalAttr;
 }
 
+GLint ShaderHelper::instancePosAtt()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_instancePositionAttr;
+}
+
+GLint ShaderHelper::instanceRotAtt()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_instanceRotationAttr;
+}
+
 QT_END_NAMESPACE
@@ -97,10 +97,18 @@ class ShaderHelper
     GLint maxBounds();
     GLint minBounds();
     GLint sliceFrameWidth();
+    GLint instanceGradientScale();
+    GLint brickSampler();
+    GLint brickDimensions();
+    GLint brickCounts();
+    GLint poolBrickDimensions();
+    GLint uvOffset();
 
     GLint posAtt();
     GLint uvAtt();
     GLint normalAtt();
+    GLint instancePosAtt();
+    GLint instanceRotAtt();
 
     private:
     QObject *m_caller;
@@ -115,6 +123,8 @@ class ShaderHelper
     GLint m_positionAttr;
     GLint m_uvAttr;
     GLint m_normalAttr;
+    GLint m_instancePositionAttr;
+    GLint m_instanceRotationAttr;
 
     GLint m_colorUniform;
     GLint m_viewMatrixUniform;
@@ -142,6 +152,12 @@ class ShaderHelper
     GLint m_minBoundsUniform;
     GLint m_maxBoundsUniform;
     GLint m_sliceFrameWidthUniform;
+    GLint m_instanceGradientScaleUniform;
+    GLint m_brickSamplerUniform;
+    GLint m_brickDimensionsUniform;
+    GLint m_brickCountsUniform;
+    GLint m_poolBrickDimensionsUniform;
+    GLint m_uvOffsetUniform;
 
     GLboolean m_initialized;
 };
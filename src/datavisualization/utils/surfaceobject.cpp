@@ -29,9 +29,14 @@
 
 #include "surfaceobject_p.h"
 #include "surface3drenderer_p.h"
+#include "utils_p.h"
 
+#include <QtCore/QVarLengthArray>
 #include <QtGui/QVector2D>
 
+#include <algorithm>
+#include <limits>
+
 QT_BEGIN_NAMESPACE
 
 SurfaceObject::SurfaceObject(Surface3DRenderer *renderer)
@@ -56,9 +61,19 @@ SurfaceObject::~SurfaceObject()
     }
 }
 
-void SurfaceObject::setUpSmoothData(const QSurfaceDataArray &dataArray, const QRect &space,
+void SurfaceObject::setUpSmoothData(const SurfaceDataView &data, const QRect &space,
                                     bool changeGeometry, bool polar, bool flipXZ)
 {
+    if (m_windowed) {
+        // The buffers are laid out for scrolling, so they are created again
+        m_windowed = false;
+        m_windowStart = 0;
+        m_partRowOffset = 0;
+        m_indexOffset = 0;
+        m_gridIndexOffset = 0;
+        changeGeometry = true;
+    }
+    m_textureUvs.clear();
     m_columns = space.width();
     m_rows = space.height();
     int totalSize = m_rows * m_columns;
@@ -67,7 +82,7 @@ void SurfaceObject::setUpSmoothData(const QSurfaceDataArray &dataArray, const QR
 
     m_surfaceType = SurfaceSmooth;
 
-    checkDirections(dataArray);
+    checkDirections(data);
     bool indicesDirty = false;
     if (m_dataDimension != m_oldDataDimension)
         indicesDirty = true;
@@ -87,13 +102,12 @@ void SurfaceObject::setUpSmoothData(const QSurfaceDataArray &dataArray, const QR
     m_maxY = -10000000.0f;
 
     for (int i = 0; i < m_rows; i++) {
-        const QSurfaceDataRow &p = *dataArray.at(i);
-        for (int j = 0; j < m_columns; j++) {
-            getNormalizedVertex(p.at(j), m_vertices[totalIndex], polar, flipXZ);
-            if (changeGeometry)
-                uvs[totalIndex] = QVector2D(GLfloat(j) * uvX, GLfloat(i) * uvY);
-            totalIndex++;
+        getNormalizedRow(data, i, m_vertices.data() + totalIndex, polar, flipXZ);
+        if (changeGeometry) {
+            for (int j = 0; j < m_columns; j++)
+                uvs[totalIndex + j] = QVector2D(GLfloat(j) * uvX, GLfloat(i) * uvY);
         }
+        totalIndex += m_columns;
     }
 
     if (flipXZ) {
@@ -109,17 +123,7 @@ void SurfaceObject::setUpSmoothData(const QSurfaceDataArray &dataArray, const QR
     if (changeGeometry)
         m_normals.resize(totalSize);
 
-    totalIndex = 0;
-
-    if ((m_dataDimension == BothAscending) || (m_dataDimension == XDescending)) {
-        for (int row = 0; row < rowLimit; row++)
-            createSmoothNormalBodyLine(totalIndex, row * m_columns);
-        createSmoothNormalUpperLine(totalIndex);
-    } else { // BothDescending || ZDescending
-        createSmoothNormalUpperLine(totalIndex);
-        for (int row = 1; row < m_rows; row++)
-            createSmoothNormalBodyLine(totalIndex, row * m_columns);
-    }
+    createSmoothNormals();
 
     // Create indices table
     if (changeGeometry || indicesDirty)
@@ -132,6 +136,21 @@ void SurfaceObject::setUpSmoothData(const QSurfaceDataArray &dataArray, const QR
     createBuffers(m_vertices, uvs, m_normals, 0);
 }
 
+void SurfaceObject::createSmoothNormals()
+{
+    int totalIndex = 0;
+
+    if ((m_dataDimension == BothAscending) || (m_dataDimension == XDescending)) {
+        for (int row = 0; row < m_rows - 1; row++)
+            createSmoothNormalBodyLine(totalIndex, row * m_columns);
+        createSmoothNormalUpperLine(totalIndex);
+    } else { // BothDescending || ZDescending
+        createSmoothNormalUpperLine(totalIndex);
+        for (int row = 1; row < m_rows; row++)
+            createSmoothNormalBodyLine(totalIndex, row * m_columns);
+    }
+}
+
 void SurfaceObject::createSmoothNormalBodyLine(int &totalIndex, int column)
 {
     int colLimit = m_columns - 1;
@@ -291,8 +310,8 @@ QVector3D SurfaceObject::createSmoothNormalUpperLineItem(int x, int y)
         }
     } else { // BothDescending
         if (x == 0) {
-            return normal(m_vertices.at(0), m_vertices.at(1),
-                          m_vertices.at(m_columns));
+            return normal(m_vertices.at(p), m_vertices.at(p + 1),
+                          m_vertices.at(p + m_columns));
         } else {
             return normal(m_vertices.at(p), m_vertices.at(p + m_columns),
                           m_vertices.at(p - 1));
@@ -300,18 +319,19 @@ QVector3D SurfaceObject::createSmoothNormalUpperLineItem(int x, int y)
     }
 }
 
-void SurfaceObject::smoothUVs(const QSurfaceDataArray &dataArray,
-                              const QSurfaceDataArray &modelArray)
+void SurfaceObject::smoothUVs(const SurfaceDataView &data, const SurfaceDataView &model)
 {
-    if (dataArray.size() == 0 || modelArray.size() == 0)
+    if (data.rowCount() == 0 || model.rowCount() == 0)
         return;
 
-    int columns = dataArray.at(0)->size();
-    int rows = dataArray.size();
-    float xRangeNormalizer = dataArray.at(0)->at(columns - 1).x() - dataArray.at(0)->at(0).x();
-    float zRangeNormalizer = dataArray.at(rows - 1)->at(0).z() - dataArray.at(0)->at(0).z();
-    float xMin = dataArray.at(0)->at(0).x();
-    float zMin = dataArray.at(0)->at(0).z();
+    resetScrollWindow();
+
+    int columns = data.columnCount();
+    int rows = data.rowCount();
+    float xRangeNormalizer = data.position(0, columns - 1).x() - data.position(0, 0).x();
+    float zRangeNormalizer = data.position(rows - 1, 0).z() - data.position(0, 0).z();
+    float xMin = data.position(0, 0).x();
+    float zMin = data.position(0, 0).z();
     const bool zDescending = m_dataDimension.testFlag(SurfaceObject::ZDescending);
     const bool xDescending = m_dataDimension.testFlag(SurfaceObject::XDescending);
 
@@ -319,12 +339,11 @@ void SurfaceObject::smoothUVs(const QSurfaceDataArray &dataArray,
     uvs.resize(m_rows * m_columns);
     int index = 0;
     for (int i = 0; i < m_rows; i++) {
-        float y = (modelArray.at(i)->at(0).z() - zMin) / zRangeNormalizer;
+        float y = (model.position(i, 0).z() - zMin) / zRangeNormalizer;
         if (zDescending)
             y = 1.0f - y;
-        const QSurfaceDataRow &p = *modelArray.at(i);
         for (int j = 0; j < m_columns; j++) {
-            float x = (p.at(j).x() - xMin) / xRangeNormalizer;
+            float x = (model.position(i, j).x() - xMin) / xRangeNormalizer;
             if (xDescending)
                 x = 1.0f - x;
             uvs[index] = QVector2D(x, y);
@@ -332,24 +351,19 @@ void SurfaceObject::smoothUVs(const QSurfaceDataArray &dataArray,
         }
     }
 
+    m_textureUvs = uvs;
     if (uvs.size() > 0) {
-        glBindBuffer(GL_ARRAY_BUFFER, m_uvTextureBuffer);
-        glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(QVector2D),
-                     &uvs.at(0), GL_STATIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-
+        uploadTextureUvs(uvs);
         m_returnTextureBuffer = true;
     }
 }
 
-void SurfaceObject::updateSmoothRow(const QSurfaceDataArray &dataArray, int rowIndex, bool polar)
+void SurfaceObject::updateSmoothRow(const SurfaceDataView &data, int rowIndex, bool polar)
 {
-    // Update vertices
-    int p = rowIndex * m_columns;
-    const QSurfaceDataRow &dataRow = *dataArray.at(rowIndex);
+    resetScrollWindow();
 
-    for (int j = 0; j < m_columns; j++)
-        getNormalizedVertex(dataRow.at(j), m_vertices[p++], polar, false);
+    // Update vertices
+    getNormalizedRow(data, rowIndex, m_vertices.data() + rowIndex * m_columns, polar, false);
 
     // Create normals
     bool upwards = (m_dataDimension == BothAscending) || (m_dataDimension == XDescending);
@@ -373,13 +387,17 @@ void SurfaceObject::updateSmoothRow(const QSurfaceDataArray &dataArray, int rowI
 
     if ((rowIndex == m_rows - 1) && upwards)
         createSmoothNormalUpperLine(totalIndex);
+
+    markDirty(qMax(rowIndex - 1, 0) * m_columns, qMin(rowIndex + 2, m_rows) * m_columns);
 }
 
-void SurfaceObject::updateSmoothItem(const QSurfaceDataArray &dataArray, int row, int column,
+void SurfaceObject::updateSmoothItem(const SurfaceDataView &data, int row, int column,
                                      bool polar)
 {
+    resetScrollWindow();
+
     // Update a vertice
-    getNormalizedVertex(dataArray.at(row)->at(column),
+    getNormalizedVertex(data.position(row, column),
                         m_vertices[row * m_columns + column], polar, false);
 
     // Create normals
@@ -411,8 +429,409 @@ void SurfaceObject::updateSmoothItem(const QSurfaceDataArray &dataArray, int row
                 m_normals[p] = createSmoothNormalBodyLineItem(j, i);
          }
     }
+
+    markDirty(startRow * m_columns + startCol, qMax(endRow, row) * m_columns + endCol + 1);
+}
+
+void SurfaceObject::scrollRows(const SurfaceDataView &data, int count, bool polar)
+{
+    if ((m_windowed && !polar) || setUpScrollWindow(polar))
+        scrollWindow(data, count, polar);
+    else
+        shiftRows(data, count, polar);
+}
+
+// Returns the rows in ring order for scrolling: a guard row holding the last row moved back
+// by the ring length, the rows, and a guard row holding the first row moved forward by it.
+template <typename T>
+static QList<T> ringRows(const QList<T> &values, int rowSize, const T &ringShift)
+{
+    const int size = int(values.size());
+    QList<T> ring(size + 2 * rowSize);
+    for (int i = 0; i < size; i++)
+        ring[i + rowSize] = values.at(i);
+    for (int j = 0; j < rowSize; j++) {
+        ring[j] = values.at(size - rowSize + j) - ringShift;
+        ring[size + rowSize + j] = values.at(j) + ringShift;
+    }
+    return ring;
 }
 
+// Lays the buffers out as a ring for scrolling. Data row i is kept in buffer row
+// 1 + (m_windowStart + i) % m_rows, so a scroll only writes the new rows over the oldest ones
+// and moves the window start. The rows are drawn in two parts split at the window start, each
+// translated back along the z-axis by the rows it has moved. Buffer rows 0 and m_rows + 1 are
+// guards copying the ring rows next to them across the wrap, so that the parts join and the
+// normals are found from adjacent rows. This requires the same x-values on every row and evenly
+// spaced rows.
+bool SurfaceObject::setUpScrollWindow(bool polar)
+{
+    const int rowSize = rowVertexCount();
+    if (polar || m_surfaceType == Undefined || m_rows < 2 || m_columns < 2
+            || m_vertices.size() < m_rows * rowSize) {
+        return false;
+    }
+
+    const float rowStep = m_vertices.at(rowSize).z() - m_vertices.at(0).z();
+    const float tolerance = qAbs(rowStep) * 0.01f;
+    if (!(tolerance > 0.0f))
+        return false;
+    for (int i = 0; i < m_rows; i++) {
+        const float z = m_vertices.at(0).z() + i * rowStep;
+        for (int j = 0; j < rowSize; j++) {
+            const QVector3D &vertex = m_vertices.at(i * rowSize + j);
+            if (vertex.x() != m_vertices.at(j).x() || !(qAbs(vertex.z() - z) <= tolerance))
+                return false;
+        }
+    }
+
+    // Texture coordinates are moved with the window as well
+    const bool textured = (m_textureUvs.size() == m_rows * rowSize);
+    float textureUvRowStep = 0.0f;
+    if (textured) {
+        textureUvRowStep = m_textureUvs.at(rowSize).y() - m_textureUvs.at(0).y();
+        const float uvTolerance = qAbs(textureUvRowStep) * 0.01f;
+        for (int i = 0; i < m_rows; i++) {
+            const float v = m_textureUvs.at(0).y() + i * textureUvRowStep;
+            for (int j = 0; j < rowSize; j++) {
+                const QVector2D &uv = m_textureUvs.at(i * rowSize + j);
+                if (uv.x() != m_textureUvs.at(j).x() || !(qAbs(uv.y() - v) <= uvTolerance))
+                    return false;
+            }
+        }
+    }
+
+    // Flat surfaces have room for two vertices per column, which the rows do not use up
+    const int rows = m_rows + 2;
+    m_vertices.resize(m_rows * rowSize);
+    m_vertices = ringRows(m_vertices, rowSize, QVector3D(0.0f, 0.0f, m_rows * rowStep));
+    if (m_surfaceType == SurfaceFlat) {
+        // Flat normals belong to the quads between a row and the next one
+        m_normals.resize((rows - 1) * rowSize);
+        int p = 0;
+        for (int row = 0; row < (rows - 1) * rowSize; row += rowSize) {
+            for (int j = 0; j < rowSize; j += 2)
+                createNormals(p, row, row + rowSize, j);
+        }
+    } else {
+        m_normals = ringRows(m_normals, rowSize, QVector3D());
+    }
+
+    m_rowStep = rowStep;
+    m_uvRowStep = 1.0f / GLfloat(m_rows - 1);
+    m_textureUvRowStep = textureUvRowStep;
+    m_windowed = true;
+    m_windowStart = 0;
+    m_rowMinY.resize(m_rows);
+    m_rowMaxY.resize(m_rows);
+    for (int row = 1; row <= m_rows; row++)
+        updateRowYLimits(row);
+
+    createRowIndices(rows);
+    if (textured) {
+        uploadTextureUvs(ringRows(m_textureUvs, rowSize,
+                                  QVector2D(0.0f, m_rows * textureUvRowStep)));
+    }
+    createBuffers(m_vertices, createSelectionUvs(rows, -1), m_normals, 0);
+    setDrawPart(0);
+    return true;
+}
+
+void SurfaceObject::scrollWindow(const SurfaceDataView &data, int count, bool polar)
+{
+    const bool flat = (m_surfaceType == SurfaceFlat);
+    const int rowSize = rowVertexCount();
+    const int colLimit = m_columns - 1;
+    m_windowStart = (m_windowStart + count) % m_rows;
+
+    // The x- and z-values stay in place, so only the y-values of the new rows are written
+    QVarLengthArray<QVector3D, 256> rowVertices(m_columns);
+    for (int i = m_rows - count; i < m_rows; i++) {
+        getNormalizedRow(data, i, rowVertices.data(), polar, false);
+        const int row = windowRow(i);
+        for (int j = 0; j < m_columns; j++) {
+            const float y = rowVertices.at(j).y();
+            const int p = rowVertexIndex(row, j);
+            m_vertices[p].setY(y);
+            if (flat && j > 0 && j < colLimit)
+                m_vertices[p + 1].setY(y);
+        }
+        updateGuardRow(row);
+        updateRowYLimits(row);
+    }
+
+    m_minY = 10000000.0f;
+    m_maxY = -10000000.0f;
+    for (int i = 0; i < m_rows; i++) {
+        m_minY = qMin(m_rowMinY.at(i), m_minY);
+        m_maxY = qMax(m_rowMaxY.at(i), m_maxY);
+    }
+
+    // Only the normals next to the new rows change
+    const int firstDirtyRow = qMax(m_rows - count - 1, 0);
+    if (flat) {
+        for (int i = firstDirtyRow; i < m_rows - 1; i++) {
+            const int row = windowRow(i) * rowSize;
+            int p = row;
+            for (int j = 0; j < rowSize; j += 2)
+                createNormals(p, row, row + rowSize, j);
+        }
+        markRowsDirty(firstDirtyRow, m_rows - 1);
+    } else {
+        // The first row in data order takes its normals from the previous row when the other
+        // rows take them from the next one, and vice versa
+        const bool upwards = (m_dataDimension == BothAscending)
+                || (m_dataDimension == XDescending);
+        auto updateRowNormals = [this, upwards](int i) {
+            const int row = windowRow(i);
+            const bool upperLine = upwards ? (i == m_rows - 1) : (i == 0);
+            for (int j = 0; j < m_columns; j++) {
+                m_normals[row * m_columns + j] = upperLine ? createSmoothNormalUpperLineItem(j, row)
+                                                           : createSmoothNormalBodyLineItem(j, row);
+            }
+            updateGuardRow(row);
+        };
+        for (int i = upwards ? firstDirtyRow : m_rows - count; i < m_rows; i++)
+            updateRowNormals(i);
+        markRowsDirty(firstDirtyRow, m_rows - 1);
+        if (!upwards) {
+            updateRowNormals(0);
+            markRowsDirty(0, 0);
+        }
+    }
+
+    setDrawPart(0);
+}
+
+// Copies a ring row next to the wrap to the guard row on the other side of it
+void SurfaceObject::updateGuardRow(int row)
+{
+    int guardRow;
+    float shift;
+    if (row == 1) {
+        guardRow = m_rows + 1;
+        shift = m_rows * m_rowStep;
+    } else if (row == m_rows) {
+        guardRow = 0;
+        shift = -m_rows * m_rowStep;
+    } else {
+        return;
+    }
+
+    const int rowSize = rowVertexCount();
+    const QVector3D ringShift(0.0f, 0.0f, shift);
+    for (int j = 0; j < rowSize; j++)
+        m_vertices[guardRow * rowSize + j] = m_vertices.at(row * rowSize + j) + ringShift;
+    // Flat normals of the guard rows belong to quads that are not drawn
+    if (m_surfaceType == SurfaceSmooth) {
+        for (int j = 0; j < rowSize; j++)
+            m_normals[guardRow * rowSize + j] = m_normals.at(row * rowSize + j);
+    }
+    markDirty(guardRow * rowSize, (guardRow + 1) * rowSize);
+}
+
+// Lays the rows out in data order again for the updates that are not scrolls
+void SurfaceObject::resetScrollWindow()
+{
+    if (!m_windowed)
+        return;
+
+    const bool flat = (m_surfaceType == SurfaceFlat);
+    const int rowSize = rowVertexCount();
+    QList<QVector3D> vertices(m_rows * rowSize);
+    QList<QVector3D> normals((flat ? m_rows - 1 : m_rows) * rowSize);
+    for (int i = 0; i < m_rows; i++) {
+        const int row = windowRow(i) * rowSize;
+        const QVector3D translation(0.0f, 0.0f, -windowRowOffset(i) * m_rowStep);
+        for (int j = 0; j < rowSize; j++)
+            vertices[i * rowSize + j] = m_vertices.at(row + j) + translation;
+        if (!flat || i < m_rows - 1) {
+            for (int j = 0; j < rowSize; j++)
+                normals[i * rowSize + j] = m_normals.at(row + j);
+        }
+    }
+    m_vertices = vertices;
+    m_normals = normals;
+
+    m_windowed = false;
+    m_windowStart = 0;
+    m_partRowOffset = 0;
+    createRowIndices(m_rows);
+    if (m_textureUvs.size() == m_rows * rowSize)
+        uploadTextureUvs(m_textureUvs);
+    createBuffers(m_vertices, createSelectionUvs(m_rows, 0), m_normals, 0);
+}
+
+// Stores the y-value limits of a ring row
+void SurfaceObject::updateRowYLimits(int row)
+{
+    float minY = 10000000.0f;
+    float maxY = -10000000.0f;
+    for (int j = 0; j < m_columns; j++) {
+        const float y = m_vertices.at(rowVertexIndex(row, j)).y();
+        minY = qMin(y, minY);
+        if (!qIsNaN(y) && !qIsInf(y))
+            maxY = qMax(y, maxY);
+    }
+    m_rowMinY[row - 1] = minY;
+    m_rowMaxY[row - 1] = maxY;
+}
+
+// Creates the triangle and grid line indices for the given number of rows. The grid lines are
+// ordered row by row, so that any range of consecutive rows can be drawn.
+void SurfaceObject::createRowIndices(int rows)
+{
+    const int rowSize = rowVertexCount();
+    const int columnStep = (m_surfaceType == SurfaceFlat) ? 2 : 1;
+
+    GLint *indices = new GLint[6 * (m_columns - 1) * (rows - 1)];
+    int p = 0;
+    for (int row = 0; row < (rows - 1) * rowSize; row += rowSize) {
+        for (int j = 0; j < rowSize - 1; j += columnStep)
+            createCoarseIndices(indices, p, row, row + rowSize, j);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_elementbuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, p * sizeof(GLint), indices, GL_STATIC_DRAW);
+    delete[] indices;
+    m_indexCount = p;
+
+    GLint *gridIndices = new GLint[(4 * m_columns - 2) * (rows - 1) + 2 * (m_columns - 1)];
+    p = 0;
+    for (int i = 0; i < rows; i++) {
+        const int row = i * rowSize;
+        for (int j = 0; j < m_columns - 1; j++) {
+            gridIndices[p++] = row + j * columnStep;
+            gridIndices[p++] = row + j * columnStep + 1;
+        }
+        if (i < rows - 1) {
+            for (int j = 0; j < m_columns; j++) {
+                gridIndices[p++] = rowVertexIndex(i, j);
+                gridIndices[p++] = rowVertexIndex(i + 1, j);
+            }
+        }
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_gridElementbuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, p * sizeof(GLint), gridIndices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    delete[] gridIndices;
+    m_gridIndexCount = p;
+
+    m_indexOffset = 0;
+    m_gridIndexOffset = 0;
+}
+
+QList<QVector2D> SurfaceObject::createSelectionUvs(int rows, int firstRow) const
+{
+    const GLfloat uvX = 1.0f / GLfloat(m_columns - 1);
+    const GLfloat uvY = 1.0f / GLfloat(m_rows - 1);
+    const int colLimit = m_columns - 1;
+    QList<QVector2D> uvs;
+    uvs.reserve(rows * rowVertexCount());
+    for (int i = firstRow; i < firstRow + rows; i++) {
+        for (int j = 0; j < m_columns; j++) {
+            const QVector2D uv(GLfloat(j) * uvX, GLfloat(i) * uvY);
+            uvs.append(uv);
+            if (m_surfaceType == SurfaceFlat && j > 0 && j < colLimit)
+                uvs.append(uv);
+        }
+    }
+    return uvs;
+}
+
+void SurfaceObject::uploadTextureUvs(const QList<QVector2D> &uvs)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, m_uvTextureBuffer);
+    glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(QVector2D), &uvs.at(0), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+int SurfaceObject::drawPartCount() const
+{
+    return (m_windowed && m_windowStart > 1) ? 2 : 1;
+}
+
+// Chooses the rows that are drawn next while rows are scrolled. The first part runs from the
+// window start to the end of the ring and on to the high guard row, which joins it to the
+// second part running from the start of the ring to the window start.
+void SurfaceObject::setDrawPart(int part)
+{
+    if (!m_windowed)
+        return;
+
+    const int quadRowIndexCount = 6 * (m_columns - 1);
+    const int lineRowIndexCount = 4 * m_columns - 2;
+    const int rowLineIndexCount = 2 * (m_columns - 1);
+    if (part == 0) {
+        const int quadRows = m_windowStart ? m_rows - m_windowStart : m_rows - 1;
+        m_indexOffset = (m_windowStart + 1) * quadRowIndexCount;
+        m_indexCount = quadRows * quadRowIndexCount;
+        m_gridIndexOffset = (m_windowStart + 1) * lineRowIndexCount;
+        m_gridIndexCount = quadRows * lineRowIndexCount + rowLineIndexCount;
+        m_partRowOffset = m_windowStart;
+    } else {
+        // The lines of the first row are drawn with the first part
+        m_indexOffset = quadRowIndexCount;
+        m_indexCount = (m_windowStart - 1) * quadRowIndexCount;
+        m_gridIndexOffset = lineRowIndexCount + rowLineIndexCount;
+        m_gridIndexCount = (m_windowStart - 1) * lineRowIndexCount;
+        m_partRowOffset = m_windowStart - m_rows;
+    }
+}
+
+QVector2D SurfaceObject::uvOffset() const
+{
+    const float rowStep = m_returnTextureBuffer ? m_textureUvRowStep : m_uvRowStep;
+    return QVector2D(0.0f, m_partRowOffset * rowStep);
+}
+
+void SurfaceObject::shiftRows(const SurfaceDataView &data, int count, bool polar)
+{
+    // Rows keep their positions, so the normalized y-values can be moved as they are
+    const bool flat = (m_surfaceType == SurfaceFlat);
+    const int rowSize = flat ? m_columns * 2 - 2 : m_columns;
+    const int shift = count * rowSize;
+    const int firstNewVertex = (m_rows - count) * rowSize;
+
+    m_minY = 10000000.0f;
+    m_maxY = -10000000.0f;
+    for (int i = 0; i < firstNewVertex; i++) {
+        float y = m_vertices.at(i + shift).y();
+        m_vertices[i].setY(y);
+        m_minY = qMin(y, m_minY);
+        if (!qIsNaN(y) && !qIsInf(y))
+            m_maxY = qMax(y, m_maxY);
+    }
+
+    int colLimit = m_columns - 1;
+    int p = firstNewVertex;
+    QVarLengthArray<QVector3D, 256> rowVertices(m_columns);
+    for (int i = m_rows - count; i < m_rows; i++) {
+        getNormalizedRow(data, i, rowVertices.data(), polar, false);
+        for (int j = 0; j < m_columns; j++) {
+            m_vertices[p++] = rowVertices.at(j);
+            if (flat && j > 0 && j < colLimit) {
+                m_vertices[p] = m_vertices[p - 1];
+                p++;
+            }
+        }
+    }
+
+    // Row spacing may vary, so normals cannot be moved along with the values
+    if (flat) {
+        int rowColLimit = (m_rows - 1) * rowSize;
+        p = 0;
+        for (int row = 0, upperRow = rowSize;
+             row < rowColLimit;
+             row += rowSize, upperRow += rowSize) {
+            for (int j = 0; j < rowSize; j += 2)
+                createNormals(p, row, upperRow, j);
+        }
+    } else {
+        createSmoothNormals();
+    }
+
+    markDirty(0, m_rows * rowSize);
+}
 
 void SurfaceObject::createSmoothIndices(int x, int y, int endX, int endY)
 {
@@ -513,16 +932,26 @@ void SurfaceObject::createSmoothGridlineIndices(int x, int y, int endX, int endY
     delete[] gridIndices;
 }
 
-void SurfaceObject::setUpData(const QSurfaceDataArray &dataArray, const QRect &space,
+void SurfaceObject::setUpData(const SurfaceDataView &data, const QRect &space,
                               bool changeGeometry, bool polar, bool flipXZ)
 {
+    if (m_windowed) {
+        // The buffers are laid out for scrolling, so they are created again
+        m_windowed = false;
+        m_windowStart = 0;
+        m_partRowOffset = 0;
+        m_indexOffset = 0;
+        m_gridIndexOffset = 0;
+        changeGeometry = true;
+    }
+    m_textureUvs.clear();
     m_columns = space.width();
     m_rows = space.height();
     int totalSize = m_rows * m_columns * 2;
     GLfloat uvX = 1.0f / GLfloat(m_columns - 1);
     GLfloat uvY = 1.0f / GLfloat(m_rows - 1);
 
-    checkDirections(dataArray);
+    checkDirections(data);
     bool indicesDirty = false;
     if (m_dataDimension != m_oldDataDimension)
         indicesDirty = true;
@@ -548,10 +977,11 @@ void SurfaceObject::setUpData(const QSurfaceDataArray &dataArray, const QRect &s
     m_minY = 10000000.0;
     m_maxY = -10000000.0f;
 
+    QVarLengthArray<QVector3D, 256> rowVertices(m_columns);
     for (int i = 0; i < m_rows; i++) {
-        const QSurfaceDataRow &row = *dataArray.at(i);
+        getNormalizedRow(data, i, rowVertices.data(), polar, flipXZ);
         for (int j = 0; j < m_columns; j++) {
-            getNormalizedVertex(row.at(j), m_vertices[totalIndex], polar, flipXZ);
+            m_vertices[totalIndex] = rowVertices.at(j);
             if (changeGeometry)
                 uvs[totalIndex] = QVector2D(GLfloat(j) * uvX, GLfloat(i) * uvY);
 
@@ -605,32 +1035,32 @@ void SurfaceObject::setUpData(const QSurfaceDataArray &dataArray, const QRect &s
     delete[] indices;
 }
 
-void SurfaceObject::coarseUVs(const QSurfaceDataArray &dataArray,
-                              const QSurfaceDataArray &modelArray)
+void SurfaceObject::coarseUVs(const SurfaceDataView &data, const SurfaceDataView &model)
 {
-    if (dataArray.size() == 0 || modelArray.size() == 0)
+    if (data.rowCount() == 0 || model.rowCount() == 0)
         return;
 
-    int columns = dataArray.at(0)->size();
-    int rows = dataArray.size();
-    float xRangeNormalizer = dataArray.at(0)->at(columns - 1).x() - dataArray.at(0)->at(0).x();
-    float zRangeNormalizer = dataArray.at(rows - 1)->at(0).z() - dataArray.at(0)->at(0).z();
-    float xMin = dataArray.at(0)->at(0).x();
-    float zMin = dataArray.at(0)->at(0).z();
+    resetScrollWindow();
+
+    int columns = data.columnCount();
+    int rows = data.rowCount();
+    float xRangeNormalizer = data.position(0, columns - 1).x() - data.position(0, 0).x();
+    float zRangeNormalizer = data.position(rows - 1, 0).z() - data.position(0, 0).z();
+    float xMin = data.position(0, 0).x();
+    float zMin = data.position(0, 0).z();
     const bool zDescending = m_dataDimension.testFlag(SurfaceObject::ZDescending);
     const bool xDescending = m_dataDimension.testFlag(SurfaceObject::XDescending);
 
     QList<QVector2D> uvs;
-    uvs.resize(m_rows * m_columns * 2);
+    uvs.resize(m_rows * (m_columns * 2 - 2));
     int index = 0;
     int colLimit = m_columns - 1;
     for (int i = 0; i < m_rows; i++) {
-        float y = (modelArray.at(i)->at(0).z() - zMin) / zRangeNormalizer;
+        float y = (model.position(i, 0).z() - zMin) / zRangeNormalizer;
         if (zDescending)
             y = 1.0f - y;
-        const QSurfaceDataRow &p = *modelArray.at(i);
         for (int j = 0; j < m_columns; j++) {
-            float x = (p.at(j).x() - xMin) / xRangeNormalizer;
+            float x = (model.position(i, j).x() - xMin) / xRangeNormalizer;
             if (xDescending)
                 x = 1.0f - x;
             uvs[index] = QVector2D(x, y);
@@ -642,26 +1072,26 @@ void SurfaceObject::coarseUVs(const QSurfaceDataArray &dataArray,
         }
     }
 
+    m_textureUvs = uvs;
     if (uvs.size() > 0) {
-        glBindBuffer(GL_ARRAY_BUFFER, m_uvTextureBuffer);
-        glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(QVector2D),
-                     &uvs.at(0), GL_STATIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-
+        uploadTextureUvs(uvs);
         m_returnTextureBuffer = true;
     }
 }
 
-void SurfaceObject::updateCoarseRow(const QSurfaceDataArray &dataArray, int rowIndex, bool polar)
+void SurfaceObject::updateCoarseRow(const SurfaceDataView &data, int rowIndex, bool polar)
 {
+    resetScrollWindow();
+
     int colLimit = m_columns - 1;
     int doubleColumns = m_columns * 2 - 2;
 
     int p = rowIndex * doubleColumns;
-    const QSurfaceDataRow &dataRow = *dataArray.at(rowIndex);
 
+    QVarLengthArray<QVector3D, 256> rowVertices(m_columns);
+    getNormalizedRow(data, rowIndex, rowVertices.data(), polar, false);
     for (int j = 0; j < m_columns; j++) {
-        getNormalizedVertex(dataRow.at(j), m_vertices[p++], polar, false);
+        m_vertices[p++] = rowVertices.at(j);
         if (j > 0 && j < colLimit) {
             m_vertices[p] = m_vertices[p - 1];
             p++;
@@ -681,20 +1111,25 @@ void SurfaceObject::updateCoarseRow(const QSurfaceDataArray &dataArray, int rowI
         for (int j = 0; j < doubleColumns; j += 2)
             createNormals(p, row, upperRow, j);
     }
+
+    markDirty(qMax(rowIndex - 1, 0) * doubleColumns, (rowIndex + 1) * doubleColumns);
 }
 
-void SurfaceObject::updateCoarseItem(const QSurfaceDataArray &dataArray, int row, int column,
+void SurfaceObject::updateCoarseItem(const SurfaceDataView &data, int row, int column,
                                      bool polar)
 {
+    resetScrollWindow();
+
     int colLimit = m_columns - 1;
     int doubleColumns = m_columns * 2 - 2;
 
     // Update a vertice
     int p = row * doubleColumns + column * 2 - (column > 0);
-    getNormalizedVertex(dataArray.at(row)->at(column), m_vertices[p++], polar, false);
+    getNormalizedVertex(data.position(row, column), m_vertices[p++], polar, false);
 
     if (column > 0 && column < colLimit)
         m_vertices[p] = m_vertices[p - 1];
+    markDirty(p - 1, p + 1);
 
     // Create normals
     int startRow = row;
@@ -714,6 +1149,7 @@ void SurfaceObject::updateCoarseItem(const QSurfaceDataArray &dataArray, int row
             createNormals(p, i * doubleColumns, (i + 1) * doubleColumns, j * 2);
         }
     }
+    markDirty(startRow * doubleColumns + startCol * 2, row * doubleColumns + column * 2 + 2);
 }
 
 void SurfaceObject::createCoarseSubSection(int x, int y, int columns, int rows)
@@ -802,13 +1238,70 @@ void SurfaceObject::createCoarseGridlineIndices(int x, int y, int endX, int endY
 
 void SurfaceObject::uploadBuffers()
 {
-    QList<QVector2D> uvs; // Empty dummy
-    createBuffers(m_vertices, uvs, m_normals, 0);
+    if (m_uploadedVertexCount != m_vertices.size() || m_uploadedNormalCount != m_normals.size()) {
+        QList<QVector2D> uvs; // Empty dummy
+        createBuffers(m_vertices, uvs, m_normals, 0);
+        return;
+    }
+
+    // Buffers are already allocated, so only replace the ranges touched by the updates.
+    // Overlapping and adjacent ranges are merged.
+    if (!m_dirtyRanges.isEmpty()) {
+        std::sort(m_dirtyRanges.begin(), m_dirtyRanges.end());
+        int start = m_dirtyRanges.at(0).first;
+        int end = m_dirtyRanges.at(0).second;
+        for (int i = 1; i < m_dirtyRanges.size(); i++) {
+            const QPair<int, int> &range = m_dirtyRanges.at(i);
+            if (range.first <= end) {
+                end = qMax(range.second, end);
+            } else {
+                uploadRange(start, end);
+                start = range.first;
+                end = range.second;
+            }
+        }
+        uploadRange(start, end);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    m_dirtyRanges.clear();
+}
+
+void SurfaceObject::uploadRange(int start, int end)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexbuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, start * sizeof(QVector3D),
+                    (end - start) * sizeof(QVector3D), &m_vertices.at(start));
+
+    // Flat surfaces have no normals for the topmost row
+    int normalEnd = qMin(end, int(m_normals.size()));
+    if (start < normalEnd) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_normalbuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, start * sizeof(QVector3D),
+                        (normalEnd - start) * sizeof(QVector3D), &m_normals.at(start));
+    }
+}
+
+void SurfaceObject::markDirty(int start, int end)
+{
+    m_pickBoundsDirty = true;
+    if (start < end)
+        m_dirtyRanges.append(qMakePair(start, end));
+}
+
+// Marks rows in data order dirty at their places in the ring while rows are scrolled
+void SurfaceObject::markRowsDirty(int firstRow, int lastRow)
+{
+    const int rowSize = rowVertexCount();
+    for (int i = firstRow; i <= lastRow; i++) {
+        const int row = windowRow(i);
+        markDirty(row * rowSize, (row + 1) * rowSize);
+    }
 }
 
 void SurfaceObject::createBuffers(const QList<QVector3D> &vertices, const QList<QVector2D> &uvs,
                                   const QList<QVector3D> &normals, const GLint *indices)
 {
+    m_pickBoundsDirty = true;
     // Move to buffers
     glBindBuffer(GL_ARRAY_BUFFER, m_vertexbuffer);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(QVector3D),
@@ -833,42 +1326,45 @@ void SurfaceObject::createBuffers(const QList<QVector3D> &vertices, const QList<
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+    m_uploadedVertexCount = vertices.size();
+    m_uploadedNormalCount = normals.size();
+    m_dirtyRanges.clear();
     m_meshDataLoaded = true;
 }
 
-void SurfaceObject::checkDirections(const QSurfaceDataArray &array)
+void SurfaceObject::checkDirections(const SurfaceDataView &data)
 {
     m_dataDimension = BothAscending;
 
-    if (array.at(0)->at(0).x() > array.at(0)->at(array.at(0)->size() - 1).x())
+    if (data.position(0, 0).x() > data.position(0, data.columnCount() - 1).x())
         m_dataDimension |= XDescending;
     if (m_axisCacheX.reversed())
         m_dataDimension ^= XDescending;
 
-    if (array.at(0)->at(0).z() > array.at(array.size() - 1)->at(0).z())
+    if (data.position(0, 0).z() > data.position(data.rowCount() - 1, 0).z())
         m_dataDimension |= ZDescending;
     if (m_axisCacheZ.reversed())
         m_dataDimension ^= ZDescending;
 }
 
-void SurfaceObject::getNormalizedVertex(const QSurfaceDataItem &data, QVector3D &vertex,
+void SurfaceObject::getNormalizedVertex(const QVector3D &position, QVector3D &vertex,
                                         bool polar, bool flipXZ)
 {
     float normalizedX;
     float normalizedZ;
     if (polar) {
         // Slice don't use polar, so don't care about flip
-        m_renderer->calculatePolarXZ(data.position(), normalizedX, normalizedZ);
+        m_renderer->calculatePolarXZ(position, normalizedX, normalizedZ);
     } else {
         if (flipXZ) {
-            normalizedX = m_axisCacheZ.positionAt(data.x());
-            normalizedZ = m_axisCacheX.positionAt(data.z());
+            normalizedX = m_axisCacheZ.positionAt(position.x());
+            normalizedZ = m_axisCacheX.positionAt(position.z());
         } else {
-            normalizedX = m_axisCacheX.positionAt(data.x());
-            normalizedZ = m_axisCacheZ.positionAt(data.z());
+            normalizedX = m_axisCacheX.positionAt(position.x());
+            normalizedZ = m_axisCacheZ.positionAt(position.z());
         }
     }
-    float normalizedY = m_axisCacheY.positionAt(data.y());
+    float normalizedY = m_axisCacheY.positionAt(position.y());
     m_minY = qMin(normalizedY, m_minY);
     if (!qIsNaN(normalizedY) && !qIsInf(normalizedY))
         m_maxY = qMax(normalizedY, m_maxY);
@@ -877,6 +1373,48 @@ void SurfaceObject::getNormalizedVertex(const QSurfaceDataItem &data, QVector3D
     vertex.setZ(normalizedZ);
 }
 
+// Same as getNormalizedVertex() for each item of the row, but the axis positions of the whole
+// row are resolved at once
+void SurfaceObject::getNormalizedRow(const SurfaceDataView &data, int row, QVector3D *vertices,
+                                     bool polar, bool flipXZ)
+{
+    QVarLengthArray<float, 256> xValues(m_columns);
+    QVarLengthArray<float, 256> yValues(m_columns);
+    QVarLengthArray<float, 256> zValues(m_columns);
+    QVarLengthArray<float, 256> normalizedX(m_columns);
+    QVarLengthArray<float, 256> normalizedY(m_columns);
+    QVarLengthArray<float, 256> normalizedZ(m_columns);
+    for (int j = 0; j < m_columns; j++) {
+        const QVector3D position = data.position(row, j);
+        xValues[j] = position.x();
+        yValues[j] = position.y();
+        zValues[j] = position.z();
+    }
+
+    if (!polar) {
+        if (flipXZ) {
+            m_axisCacheZ.positionsAt(xValues.constData(), normalizedX.data(), m_columns);
+            m_axisCacheX.positionsAt(zValues.constData(), normalizedZ.data(), m_columns);
+        } else {
+            m_axisCacheX.positionsAt(xValues.constData(), normalizedX.data(), m_columns);
+            m_axisCacheZ.positionsAt(zValues.constData(), normalizedZ.data(), m_columns);
+        }
+    }
+    m_axisCacheY.positionsAt(yValues.constData(), normalizedY.data(), m_columns);
+
+    for (int j = 0; j < m_columns; j++) {
+        if (polar) {
+            m_renderer->calculatePolarXZ(QVector3D(xValues.at(j), yValues.at(j), zValues.at(j)),
+                                         normalizedX[j], normalizedZ[j]);
+        }
+        const float y = normalizedY.at(j);
+        m_minY = qMin(y, m_minY);
+        if (!qIsNaN(y) && !qIsInf(y))
+            m_maxY = qMax(y, m_maxY);
+        vertices[j] = QVector3D(normalizedX.at(j), y, normalizedZ.at(j));
+    }
+}
+
 GLuint SurfaceObject::gridElementBuf()
 {
     if (!m_meshDataLoaded)
@@ -902,15 +1440,160 @@ GLuint SurfaceObject::gridIndexCount()
 
 QVector3D SurfaceObject::vertexAt(int column, int row)
 {
-    int pos = 0;
     if (m_surfaceType == Undefined || !m_vertices.size())
         return zeroVector;
 
-    if (m_surfaceType == SurfaceFlat)
-        pos = row * (m_columns * 2 - 2) + column * 2 - (column > 0);
-    else
-        pos = row * m_columns + column;
-    return m_vertices.at(pos);
+    if (m_windowed) {
+        return m_vertices.at(rowVertexIndex(windowRow(row), column))
+                - QVector3D(0.0f, 0.0f, windowRowOffset(row) * m_rowStep);
+    }
+    return m_vertices.at(rowVertexIndex(row, column));
+}
+
+// Finds the vertex closest to where the ray hits the surface. The cells are searched through
+// a hierarchy of cell bounds, which is rebuilt after the vertices change.
+bool SurfaceObject::pick(const RayPicker::Ray &ray, int &row, int &column, float &distance)
+{
+    if (m_surfaceType == Undefined || m_columns < 2 || m_rows < 2)
+        return false;
+
+    if (m_pickBoundsDirty)
+        updatePickBounds();
+
+    struct Block
+    {
+        int level;
+        int x;
+        int y;
+    };
+
+    const int topLevel = m_pickMinimums.size() - 1;
+    QVarLengthArray<Block, 64> stack;
+    stack.append({topLevel, 0, 0});
+    distance = std::numeric_limits<float>::max();
+    int hitColumn = -1;
+    int hitRow = -1;
+    while (!stack.isEmpty()) {
+        const Block block = stack.takeLast();
+        const int index = block.y * m_pickLevelWidths.at(block.level) + block.x;
+        float tNear;
+        float tFar;
+        if (!RayPicker::intersectBox(ray, m_pickMinimums.at(block.level).at(index),
+                                     m_pickMaximums.at(block.level).at(index), tNear, tFar)
+                || tNear > distance) {
+            continue;
+        }
+
+        if (block.level) {
+            const int childLevel = block.level - 1;
+            const int childWidth = m_pickLevelWidths.at(childLevel);
+            const int childHeight = m_pickMinimums.at(childLevel).size() / childWidth;
+            for (int y = block.y * 2; y < qMin(block.y * 2 + 2, childHeight); y++) {
+                for (int x = block.x * 2; x < qMin(block.x * 2 + 2, childWidth); x++)
+                    stack.append({childLevel, x, y});
+            }
+            continue;
+        }
+
+        const QVector3D a = vertexAt(block.x, block.y);
+        const QVector3D b = vertexAt(block.x + 1, block.y);
+        const QVector3D c = vertexAt(block.x + 1, block.y + 1);
+        const QVector3D d = vertexAt(block.x, block.y + 1);
+        const float triangleHits[2] = {RayPicker::intersectTriangle(ray, a, b, c),
+                                       RayPicker::intersectTriangle(ray, a, c, d)};
+        for (float t : triangleHits) {
+            if (t >= 0.0f && t < distance) {
+                distance = t;
+                hitColumn = block.x;
+                hitRow = block.y;
+            }
+        }
+    }
+
+    if (hitColumn < 0)
+        return false;
+
+    // Select the corner of the hit cell closest to the hit point
+    const QVector3D hitPoint = ray.origin + distance * ray.direction;
+    float closest = std::numeric_limits<float>::max();
+    for (int y = hitRow; y <= hitRow + 1; y++) {
+        for (int x = hitColumn; x <= hitColumn + 1; x++) {
+            const float cornerDistance = (vertexAt(x, y) - hitPoint).lengthSquared();
+            if (cornerDistance < closest) {
+                closest = cornerDistance;
+                column = x;
+                row = y;
+            }
+        }
+    }
+    return true;
+}
+
+void SurfaceObject::updatePickBounds()
+{
+    int width = m_columns - 1;
+    int height = m_rows - 1;
+    m_pickMinimums.resize(1);
+    m_pickMaximums.resize(1);
+    m_pickLevelWidths.resize(1);
+    m_pickMinimums[0].resize(width * height);
+    m_pickMaximums[0].resize(width * height);
+    m_pickLevelWidths[0] = width;
+
+    QVector3D *minimums = m_pickMinimums[0].data();
+    QVector3D *maximums = m_pickMaximums[0].data();
+    Utils::parallelFor(height, [this, width, minimums, maximums](int begin, int end) {
+        for (int row = begin; row < end; row++) {
+            for (int column = 0; column < width; column++) {
+                QVector3D minimum = vertexAt(column, row);
+                QVector3D maximum = minimum;
+                for (int corner = 1; corner < 4; corner++) {
+                    const QVector3D vertex = vertexAt(column + (corner & 1),
+                                                      row + (corner >> 1));
+                    for (int axis = 0; axis < 3; axis++) {
+                        minimum[axis] = qMin(minimum[axis], vertex[axis]);
+                        maximum[axis] = qMax(maximum[axis], vertex[axis]);
+                    }
+                }
+                minimums[row * width + column] = minimum;
+                maximums[row * width + column] = maximum;
+            }
+        }
+    }, width);
+
+    while (width > 1 || height > 1) {
+        const int level = m_pickMinimums.size();
+        const int childWidth = width;
+        const int childHeight = height;
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+        m_pickMinimums.append(QList<QVector3D>(width * height));
+        m_pickMaximums.append(QList<QVector3D>(width * height));
+        m_pickLevelWidths.append(width);
+        const QList<QVector3D> &childMinimums = m_pickMinimums.at(level - 1);
+        const QList<QVector3D> &childMaximums = m_pickMaximums.at(level - 1);
+        QList<QVector3D> &levelMinimums = m_pickMinimums[level];
+        QList<QVector3D> &levelMaximums = m_pickMaximums[level];
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                const int firstChild = y * 2 * childWidth + x * 2;
+                QVector3D minimum = childMinimums.at(firstChild);
+                QVector3D maximum = childMaximums.at(firstChild);
+                for (int childY = y * 2; childY < qMin(y * 2 + 2, childHeight); childY++) {
+                    for (int childX = x * 2; childX < qMin(x * 2 + 2, childWidth); childX++) {
+                        const int child = childY * childWidth + childX;
+                        for (int axis = 0; axis < 3; axis++) {
+                            minimum[axis] = qMin(minimum[axis], childMinimums.at(child)[axis]);
+                            maximum[axis] = qMax(maximum[axis], childMaximums.at(child)[axis]);
+                        }
+                    }
+                }
+                levelMinimums[y * width + x] = minimum;
+                levelMaximums[y * width + x] = maximum;
+            }
+        }
+    }
+    m_pickBoundsDirty = false;
 }
 
 void SurfaceObject::clear()
@@ -920,6 +1603,70 @@ void SurfaceObject::clear()
     m_surfaceType = Undefined;
     m_vertices.clear();
     m_normals.clear();
+    m_uploadedVertexCount = 0;
+    m_uploadedNormalCount = 0;
+    m_dirtyRanges.clear();
+    m_textureUvs.clear();
+    m_windowed = false;
+    m_windowStart = 0;
+    m_partRowOffset = 0;
+    m_indexOffset = 0;
+    m_gridIndexOffset = 0;
+    m_pickBoundsDirty = true;
+}
+
+// Returns the data at half resolution, always keeping the first and the last row and column.
+// Each sample takes the value deviating most from the mean of its neighborhood, preferring the
+// original sample, so that local minima and maxima survive decimation even when sampled.
+SurfaceDataGrid SurfaceObject::createLevelOfDetail(const SurfaceDataView &data)
+{
+    const int columns = data.columnCount();
+    const int rows = data.rowCount();
+    const int lodColumns = columns > 2 ? columns / 2 + 1 : columns;
+    const int lodRows = rows > 2 ? rows / 2 + 1 : rows;
+    auto sourceIndex = [](int index, int count, int lodCount) {
+        return count == lodCount ? index : qMin(index * 2, count - 1);
+    };
+
+    SurfaceDataGrid grid;
+    grid.columnValues.resize(lodColumns);
+    grid.rowValues.resize(lodRows);
+    grid.heights.resize(lodColumns * lodRows);
+    for (int j = 0; j < lodColumns; j++)
+        grid.columnValues[j] = data.position(0, sourceIndex(j, columns, lodColumns)).x();
+    for (int i = 0; i < lodRows; i++)
+        grid.rowValues[i] = data.position(sourceIndex(i, rows, lodRows), 0).z();
+
+    float *heights = grid.heights.data();
+    for (int i = 0; i < lodRows; i++) {
+        const int row = sourceIndex(i, rows, lodRows);
+        const int firstRow = qMax(row - 1, 0);
+        const int lastRow = qMin(row + 1, rows - 1);
+        for (int j = 0; j < lodColumns; j++) {
+            const int column = sourceIndex(j, columns, lodColumns);
+            const int firstColumn = qMax(column - 1, 0);
+            const int lastColumn = qMin(column + 1, columns - 1);
+            float mean = 0.0f;
+            for (int r = firstRow; r <= lastRow; r++) {
+                for (int c = firstColumn; c <= lastColumn; c++)
+                    mean += data.position(r, c).y();
+            }
+            mean /= float((lastRow - firstRow + 1) * (lastColumn - firstColumn + 1));
+            float value = data.position(row, column).y();
+            float deviation = qAbs(value - mean);
+            for (int r = firstRow; r <= lastRow; r++) {
+                for (int c = firstColumn; c <= lastColumn; c++) {
+                    const float y = data.position(r, c).y();
+                    if (qAbs(y - mean) > deviation) {
+                        deviation = qAbs(y - mean);
+                        value = y;
+                    }
+                }
+            }
+            *heights++ = value;
+        }
+    }
+    return grid;
 }
 
 void SurfaceObject::createCoarseIndices(GLint *indices, int &p, int row, int upperRow, int j)
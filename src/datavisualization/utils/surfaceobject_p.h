@@ -42,17 +42,20 @@
 
 #include "datavisualizationglobal_p.h"
 #include "abstractobjecthelper_p.h"
-#include "qsurfacedataproxy.h"
+#include "qsurfacedataproxy_p.h"
+#include "raypicker_p.h"
 
+#include <QtCore/QPair>
 #include <QtCore/QRect>
 #include <QtGui/QColor>
+#include <QtGui/QVector2D>
 
 QT_BEGIN_NAMESPACE
 
 class Surface3DRenderer;
 class AxisRenderCache;
 
-class SurfaceObject : public AbstractObjectHelper
+class Q_AUTOTEST_EXPORT SurfaceObject : public AbstractObjectHelper
 {
 public:
     enum SurfaceType {
@@ -73,16 +76,17 @@ public:
     SurfaceObject(Surface3DRenderer *renderer);
     virtual ~SurfaceObject();
 
-    void setUpData(const QSurfaceDataArray &dataArray, const QRect &space,
+    void setUpData(const SurfaceDataView &data, const QRect &space,
                    bool changeGeometry, bool polar, bool flipXZ = false);
-    void setUpSmoothData(const QSurfaceDataArray &dataArray, const QRect &space,
+    void setUpSmoothData(const SurfaceDataView &data, const QRect &space,
                          bool changeGeometry, bool polar, bool flipXZ = false);
-    void smoothUVs(const QSurfaceDataArray &dataArray, const QSurfaceDataArray &modelArray);
-    void coarseUVs(const QSurfaceDataArray &dataArray, const QSurfaceDataArray &modelArray);
-    void updateCoarseRow(const QSurfaceDataArray &dataArray, int rowIndex, bool polar);
-    void updateSmoothRow(const QSurfaceDataArray &dataArray, int startRow, bool polar);
-    void updateSmoothItem(const QSurfaceDataArray &dataArray, int row, int column, bool polar);
-    void updateCoarseItem(const QSurfaceDataArray &dataArray, int row, int column, bool polar);
+    void smoothUVs(const SurfaceDataView &data, const SurfaceDataView &model);
+    void coarseUVs(const SurfaceDataView &data, const SurfaceDataView &model);
+    void updateCoarseRow(const SurfaceDataView &data, int rowIndex, bool polar);
+    void updateSmoothRow(const SurfaceDataView &data, int startRow, bool polar);
+    void updateSmoothItem(const SurfaceDataView &data, int row, int column, bool polar);
+    void updateCoarseItem(const SurfaceDataView &data, int row, int column, bool polar);
+    void scrollRows(const SurfaceDataView &data, int count, bool polar);
     void createSmoothIndices(int x, int y, int endX, int endY);
     void createCoarseSubSection(int x, int y, int columns, int rows);
     void createSmoothGridlineIndices(int x, int y, int endX, int endY);
@@ -91,7 +95,18 @@ public:
     GLuint gridElementBuf();
     GLuint uvBuf() override;
     GLuint gridIndexCount();
+    inline GLuint gridIndexOffset() const { return m_gridIndexOffset; }
+    int drawPartCount() const;
+    void setDrawPart(int part);
+    // The model translation and the texture coordinate offset that place the scrolled rows of
+    // the current draw part
+    inline QVector3D scrollTranslation() const
+    {
+        return QVector3D(0.0f, 0.0f, -m_partRowOffset * m_rowStep);
+    }
+    QVector2D uvOffset() const;
     QVector3D vertexAt(int column, int row);
+    bool pick(const RayPicker::Ray &ray, int &row, int &column, float &distance);
     void clear();
     float minYValue() const { return m_minY; }
     float maxYValue() const { return m_maxY; }
@@ -99,9 +114,12 @@ public:
     inline void setLineColor(const QColor &color) { m_wireframeColor = color; }
     inline const QColor &wireframeColor() const { return m_wireframeColor; }
 
+    static SurfaceDataGrid createLevelOfDetail(const SurfaceDataView &data);
+
 private:
     void createCoarseIndices(GLint *indices, int &p, int row, int upperRow, int j);
     void createNormals(int &p, int row, int upperRow, int j);
+    void createSmoothNormals();
     void createSmoothNormalBodyLine(int &totalIndex, int column);
     void createSmoothNormalUpperLine(int &totalIndex);
     QVector3D createSmoothNormalBodyLineItem(int x, int y);
@@ -109,9 +127,40 @@ private:
     QVector3D normal(const QVector3D &a, const QVector3D &b, const QVector3D &c);
     void createBuffers(const QList<QVector3D> &vertices, const QList<QVector2D> &uvs,
                        const QList<QVector3D> &normals, const GLint *indices);
-    void checkDirections(const QSurfaceDataArray &array);
-    inline void getNormalizedVertex(const QSurfaceDataItem &data, QVector3D &vertex, bool polar,
+    void checkDirections(const SurfaceDataView &data);
+    inline void getNormalizedVertex(const QVector3D &position, QVector3D &vertex, bool polar,
                                     bool flipXZ);
+    void getNormalizedRow(const SurfaceDataView &data, int row, QVector3D *vertices, bool polar,
+                          bool flipXZ);
+    void markDirty(int start, int end);
+    void markRowsDirty(int firstRow, int lastRow);
+    void uploadRange(int start, int end);
+    void updatePickBounds();
+    inline int rowVertexCount() const
+    {
+        return m_surfaceType == SurfaceFlat ? m_columns * 2 - 2 : m_columns;
+    }
+    inline int rowVertexIndex(int row, int column) const
+    {
+        if (m_surfaceType == SurfaceFlat)
+            return row * (m_columns * 2 - 2) + column * 2 - (column > 0);
+        return row * m_columns + column;
+    }
+    void shiftRows(const SurfaceDataView &data, int count, bool polar);
+    bool setUpScrollWindow(bool polar);
+    void scrollWindow(const SurfaceDataView &data, int count, bool polar);
+    void resetScrollWindow();
+    void updateGuardRow(int row);
+    void updateRowYLimits(int row);
+    // Buffer row of a row in data order, and the rows it is drawn moved back, while scrolled
+    inline int windowRow(int row) const { return 1 + (m_windowStart + row) % m_rows; }
+    inline int windowRowOffset(int row) const
+    {
+        return (m_windowStart + row < m_rows) ? m_windowStart : m_windowStart - m_rows;
+    }
+    void createRowIndices(int rows);
+    QList<QVector2D> createSelectionUvs(int rows, int firstRow) const;
+    void uploadTextureUvs(const QList<QVector2D> &uvs);
 
 private:
     SurfaceType m_surfaceType = Undefined;
@@ -119,8 +168,13 @@ private:
     int m_rows = 0;
     GLuint m_gridElementbuffer;
     GLuint m_gridIndexCount = 0;
+    GLuint m_gridIndexOffset = 0;
     QList<QVector3D> m_vertices;
     QList<QVector3D> m_normals;
+    // Vertex and normal index ranges changed since the last upload
+    QList<QPair<int, int>> m_dirtyRanges;
+    qsizetype m_uploadedVertexCount = 0;
+    qsizetype m_uploadedNormalCount = 0;
     // Caches are not owned
     AxisRenderCache &m_axisCacheX;
     AxisRenderCache &m_axisCacheY;
@@ -129,10 +183,26 @@ private:
     float m_minY;
     float m_maxY;
     GLuint m_uvTextureBuffer;
+    QList<QVector2D> m_textureUvs;
     bool m_returnTextureBuffer = false;
+    // Once rows are scrolled, the buffers hold the rows as a ring starting at m_windowStart,
+    // so that scrolling only writes the new rows. See setUpScrollWindow().
+    bool m_windowed = false;
+    int m_windowStart = 0;
+    int m_partRowOffset = 0;
+    float m_rowStep = 0.0f;
+    float m_uvRowStep = 0.0f;
+    float m_textureUvRowStep = 0.0f;
+    QList<float> m_rowMinY;
+    QList<float> m_rowMaxY;
     SurfaceObject::DataDimensions m_dataDimension;
     SurfaceObject::DataDimensions m_oldDataDimension = DataDimensions(-1);
     QColor m_wireframeColor;
+    // Bounds of the grid cells for picking. Each level merges 2x2 blocks of the previous one.
+    QList<QList<QVector3D>> m_pickMinimums;
+    QList<QList<QVector3D>> m_pickMaximums;
+    QList<int> m_pickLevelWidths;
+    bool m_pickBoundsDirty = true;
 };
 
 QT_END_NAMESPACE
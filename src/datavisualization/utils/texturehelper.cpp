@@ -36,6 +36,29 @@
 
 QT_BEGIN_NAMESPACE
 
+#if !QT_CONFIG(opengles2)
+// Single channel formats of OpenGL 3.0 and ARB_texture_rg, and luminance formats of
+// ARB_texture_float
+#ifndef GL_R16
+#define GL_R16 0x822A
+#endif
+#ifndef GL_R16F
+#define GL_R16F 0x822D
+#endif
+#ifndef GL_R32F
+#define GL_R32F 0x822E
+#endif
+#ifndef GL_LUMINANCE16F_ARB
+#define GL_LUMINANCE16F_ARB 0x881E
+#endif
+#ifndef GL_LUMINANCE32F_ARB
+#define GL_LUMINANCE32F_ARB 0x8818
+#endif
+#ifndef GL_HALF_FLOAT
+#define GL_HALF_FLOAT 0x140B
+#endif
+#endif
+
 // Defined in shaderhelper.cpp
 extern void discardDebugMsgs(QtMsgType type, const QMessageLogContext &context, const QString &msg);
 
@@ -56,6 +79,13 @@ TextureHelper::TextureHelper()
 
         if (!m_openGlFunctions_2_1)
             qFatal("OpenGL version is too low, at least 2.1 is required");
+
+        QOpenGLContext *context = QOpenGLContext::currentContext();
+        bool openGL3 = context->format().majorVersion() >= 3;
+        m_textureRgSupported = openGL3 || context->hasExtension("GL_ARB_texture_rg");
+        m_textureFloatSupported = openGL3 || context->hasExtension("GL_ARB_texture_float");
+        m_halfFloatPixelSupported = openGL3
+                || context->hasExtension("GL_ARB_half_float_pixel");
     }
 #endif
 }
@@ -110,8 +140,29 @@ GLuint TextureHelper::create2DTexture(const QImage &image, bool useTrilinearFilt
     return textureId;
 }
 
+void TextureHelper::update2DTexture(GLuint textureId, const QPoint &offset, const QImage &image)
+{
+    if (!textureId || image.isNull())
+        return;
+
+    QImage texImage = convertToGLFormat(image);
+    glBindTexture(GL_TEXTURE_2D, textureId);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, offset.x(), offset.y(), texImage.width(),
+                    texImage.height(), GL_RGBA, GL_UNSIGNED_BYTE, texImage.bits());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 GLuint TextureHelper::create3DTexture(const QList<uchar> *data, int width, int height, int depth,
-                                      QImage::Format dataFormat)
+                                      QImage::Format dataFormat,
+                                      QCustom3DVolume::TextureValueType valueType)
+{
+    return create3DTexture(data ? data->constData() : 0, width, height, depth, dataFormat,
+                           valueType);
+}
+
+GLuint TextureHelper::create3DTexture(const uchar *data, int width, int height, int depth,
+                                      QImage::Format dataFormat,
+                                      QCustom3DVolume::TextureValueType valueType)
 {
     if (Utils::isOpenGLES() || !width || !height || !depth)
         return 0;
@@ -119,8 +170,17 @@ GLuint TextureHelper::create3DTexture(const QList<uchar> *data, int width, int h
     GLuint textureId = 0;
 #if QT_CONFIG(opengles2)
     Q_UNUSED(dataFormat);
+    Q_UNUSED(valueType);
     Q_UNUSED(data);
 #else
+    GLint internalFormat;
+    GLenum format;
+    GLenum type;
+    if (!volumeTextureFormat(dataFormat, valueType, internalFormat, format, type)) {
+        qWarning() << __FUNCTION__ << "The texture format and value type are not supported.";
+        return 0;
+    }
+
     glEnable(GL_TEXTURE_3D);
 
     glGenTextures(1, &textureId);
@@ -136,16 +196,9 @@ GLuint TextureHelper::create3DTexture(const QList<uchar> *data, int width, int h
     while (status)
         status = glGetError();
 
-    GLint internalFormat = 4;
-    GLint format = GL_BGRA;
-    if (dataFormat == QImage::Format_Indexed8) {
-        internalFormat = 1;
-        format = GL_RED;
-        // Align width to 32bits
-        width = width + width % 4;
-    }
-    m_openGlFunctions_2_1->glTexImage3D(GL_TEXTURE_3D, 0, internalFormat, width, height, depth, 0,
-                                        format, GL_UNSIGNED_BYTE, data->constData());
+    m_openGlFunctions_2_1->glTexImage3D(GL_TEXTURE_3D, 0, internalFormat,
+                                        volumeDataWidth(width, dataFormat), height,
+                                        depth, 0, format, type, data);
     status = glGetError();
     if (status)
         qWarning() << __FUNCTION__ << "3D texture creation failed:" << status;
@@ -156,6 +209,131 @@ GLuint TextureHelper::create3DTexture(const QList<uchar> *data, int width, int h
     return textureId;
 }
 
+void TextureHelper::update3DTextureSlice(GLuint textureId, const QList<uchar> *data, int width,
+                                         int height, int depth, QImage::Format dataFormat,
+                                         Qt::Axis axis, int index,
+                                         QCustom3DVolume::TextureValueType valueType)
+{
+    if (Utils::isOpenGLES() || !textureId || !data)
+        return;
+
+#if QT_CONFIG(opengles2)
+    Q_UNUSED(width);
+    Q_UNUSED(height);
+    Q_UNUSED(depth);
+    Q_UNUSED(dataFormat);
+    Q_UNUSED(axis);
+    Q_UNUSED(index);
+    Q_UNUSED(valueType);
+#else
+    GLint internalFormat;
+    GLenum format;
+    GLenum type;
+    if (!volumeTextureFormat(dataFormat, valueType, internalFormat, format, type))
+        return;
+    // Align width to 32bits, same as when creating the texture
+    width = volumeDataWidth(width, dataFormat);
+
+    int x = 0;
+    int y = 0;
+    int z = 0;
+    int subWidth = width;
+    int subHeight = height;
+    int subDepth = depth;
+    if (axis == Qt::XAxis) {
+        x = index;
+        subWidth = 1;
+    } else if (axis == Qt::YAxis) {
+        y = index;
+        subHeight = 1;
+    } else {
+        z = index;
+        subDepth = 1;
+    }
+
+    // The slice is read directly from the whole volume data
+    glEnable(GL_TEXTURE_3D);
+    glBindTexture(GL_TEXTURE_3D, textureId);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, x);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, y);
+    m_openGlFunctions_2_1->glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, height);
+    m_openGlFunctions_2_1->glPixelStorei(GL_UNPACK_SKIP_IMAGES, z);
+    m_openGlFunctions_2_1->glTexSubImage3D(GL_TEXTURE_3D, 0, x, y, z, subWidth, subHeight,
+                                           subDepth, format, type, data->constData());
+    m_openGlFunctions_2_1->glPixelStorei(GL_UNPACK_SKIP_IMAGES, 0);
+    m_openGlFunctions_2_1->glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glDisable(GL_TEXTURE_3D);
+#endif
+}
+
+void TextureHelper::update3DTexture(GLuint textureId, const uchar *data, int dataWidth,
+                                    int dataHeight, QImage::Format dataFormat, int x, int y, int z,
+                                    int width, int height, int depth,
+                                    QCustom3DVolume::TextureValueType valueType)
+{
+    if (Utils::isOpenGLES() || !textureId || !data)
+        return;
+
+#if QT_CONFIG(opengles2)
+    Q_UNUSED(dataWidth);
+    Q_UNUSED(dataHeight);
+    Q_UNUSED(dataFormat);
+    Q_UNUSED(x);
+    Q_UNUSED(y);
+    Q_UNUSED(z);
+    Q_UNUSED(width);
+    Q_UNUSED(height);
+    Q_UNUSED(depth);
+    Q_UNUSED(valueType);
+#else
+    GLint internalFormat;
+    GLenum format;
+    GLenum type;
+    if (!volumeTextureFormat(dataFormat, valueType, internalFormat, format, type))
+        return;
+
+    glEnable(GL_TEXTURE_3D);
+    glBindTexture(GL_TEXTURE_3D, textureId);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, dataWidth);
+    m_openGlFunctions_2_1->glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, dataHeight);
+    m_openGlFunctions_2_1->glTexSubImage3D(GL_TEXTURE_3D, 0, x, y, z, width, height, depth,
+                                           format, type, data);
+    m_openGlFunctions_2_1->glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, 0);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glDisable(GL_TEXTURE_3D);
+#endif
+}
+
+void TextureHelper::read3DTexture(GLuint textureId, QImage::Format dataFormat, uchar *data,
+                                  QCustom3DVolume::TextureValueType valueType)
+{
+    if (Utils::isOpenGLES() || !textureId || !data)
+        return;
+
+#if QT_CONFIG(opengles2)
+    Q_UNUSED(dataFormat);
+    Q_UNUSED(valueType);
+#else
+    GLint internalFormat;
+    GLenum format;
+    GLenum type;
+    if (!volumeTextureFormat(dataFormat, valueType, internalFormat, format, type))
+        return;
+
+    glEnable(GL_TEXTURE_3D);
+    glBindTexture(GL_TEXTURE_3D, textureId);
+    m_openGlFunctions_2_1->glGetTexImage(GL_TEXTURE_3D, 0, format, type, data);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glDisable(GL_TEXTURE_3D);
+#endif
+}
+
 GLuint TextureHelper::createCubeMapTexture(const QImage &image, bool useTrilinearFiltering)
 {
     if (image.isNull())
@@ -357,6 +535,63 @@ void TextureHelper::deleteTexture(GLuint *texture)
     }
 }
 
+bool TextureHelper::volumeTextureFormat(QImage::Format dataFormat,
+                                        QCustom3DVolume::TextureValueType valueType,
+                                        GLint &internalFormat, GLenum &format,
+                                        GLenum &type) const
+{
+#if QT_CONFIG(opengles2)
+    Q_UNUSED(dataFormat);
+    Q_UNUSED(valueType);
+    Q_UNUSED(internalFormat);
+    Q_UNUSED(format);
+    Q_UNUSED(type);
+    return false;
+#else
+    if (dataFormat == QImage::Format_Indexed8) {
+        internalFormat = 1;
+        format = GL_RED;
+        type = GL_UNSIGNED_BYTE;
+    } else if (dataFormat == QImage::Format_Grayscale16) {
+        // Single channel with full precision, colors are looked up in the shader. Luminance
+        // textures are sampled with the value in the red channel as well.
+        format = m_textureRgSupported ? GL_RED : GL_LUMINANCE;
+        if (valueType == QCustom3DVolume::TextureValueHalfFloat) {
+            if (!m_textureFloatSupported || !m_halfFloatPixelSupported)
+                return false;
+            internalFormat = m_textureRgSupported ? GL_R16F : GL_LUMINANCE16F_ARB;
+            type = GL_HALF_FLOAT;
+        } else if (valueType == QCustom3DVolume::TextureValueUnsigned) {
+            internalFormat = m_textureRgSupported ? GL_R16 : GL_LUMINANCE16;
+            type = GL_UNSIGNED_SHORT;
+        } else {
+            return false;
+        }
+    } else if (dataFormat == QImage::Format_Invalid) {
+        // Float volumes have no QImage format
+        if (valueType != QCustom3DVolume::TextureValueFloat || !m_textureFloatSupported)
+            return false;
+        format = m_textureRgSupported ? GL_RED : GL_LUMINANCE;
+        internalFormat = m_textureRgSupported ? GL_R32F : GL_LUMINANCE32F_ARB;
+        type = GL_FLOAT;
+    } else {
+        internalFormat = 4;
+        format = GL_BGRA;
+        type = GL_UNSIGNED_BYTE;
+    }
+    return true;
+#endif
+}
+
+int TextureHelper::volumeDataWidth(int width, QImage::Format dataFormat)
+{
+    if (dataFormat == QImage::Format_Indexed8)
+        return width + width % 4;
+    if (dataFormat == QImage::Format_Grayscale16)
+        return width + width % 2;
+    return width;
+}
+
 QImage TextureHelper::convertToGLFormat(const QImage &srcImage)
 {
     QImage res(srcImage.size(), QImage::Format_ARGB32);
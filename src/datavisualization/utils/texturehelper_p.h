@@ -41,6 +41,7 @@
 #define TEXTUREHELPER_P_H
 
 #include "datavisualizationglobal_p.h"
+#include "qcustom3dvolume.h"
 #include <QtGui/QRgb>
 #include <QtGui/QLinearGradient>
 #if !QT_CONFIG(opengles2)
@@ -59,8 +60,35 @@ class TextureHelper : protected QOpenGLFunctions
     // Ownership of created texture is transferred to caller
     GLuint create2DTexture(const QImage &image, bool useTrilinearFiltering = false,
                            bool convert = true, bool smoothScale = true, bool clampY = false);
+    // Replaces the area of the texture starting at offset with the image, mipmaps are not updated
+    void update2DTexture(GLuint textureId, const QPoint &offset, const QImage &image);
+    // The value type applies to single channel QImage::Format_Grayscale16 data and to float
+    // data, which is marked with QImage::Format_Invalid.
+    // Returns 0 if the texture cannot be created for the data.
     GLuint create3DTexture(const QList<uchar> *data, int width, int height, int depth,
-                           QImage::Format dataFormat);
+                           QImage::Format dataFormat,
+                           QCustom3DVolume::TextureValueType valueType
+                           = QCustom3DVolume::TextureValueUnsigned);
+    // Creates an uninitialized texture if data is null
+    GLuint create3DTexture(const uchar *data, int width, int height, int depth,
+                           QImage::Format dataFormat,
+                           QCustom3DVolume::TextureValueType valueType
+                           = QCustom3DVolume::TextureValueUnsigned);
+    // Uploads a box of data to the texture at x, y, z. The rows of the data are dataWidth pixels
+    // long and its images are dataHeight rows high.
+    void update3DTexture(GLuint textureId, const uchar *data, int dataWidth, int dataHeight,
+                         QImage::Format dataFormat, int x, int y, int z, int width, int height,
+                         int depth, QCustom3DVolume::TextureValueType valueType
+                         = QCustom3DVolume::TextureValueUnsigned);
+    // Reads the whole texture into data, which must be large enough for it
+    void read3DTexture(GLuint textureId, QImage::Format dataFormat, uchar *data,
+                       QCustom3DVolume::TextureValueType valueType
+                       = QCustom3DVolume::TextureValueUnsigned);
+    // Uploads one slice of the data to a texture created with create3DTexture()
+    void update3DTextureSlice(GLuint textureId, const QList<uchar> *data, int width, int height,
+                              int depth, QImage::Format dataFormat, Qt::Axis axis, int index,
+                              QCustom3DVolume::TextureValueType valueType
+                              = QCustom3DVolume::TextureValueUnsigned);
     GLuint createCubeMapTexture(const QImage &image, bool useTrilinearFiltering = false);
     // Returns selection texture and inserts generated framebuffers to framebuffer parameters
     GLuint createSelectionTexture(const QSize &size, GLuint &frameBuffer, GLuint &depthBuffer);
@@ -71,8 +99,15 @@ class TextureHelper : protected QOpenGLFunctions
     // Returns depth texture and inserts generated framebuffer to parameter
     GLuint createDepthTextureFrameBuffer(const QSize &size, GLuint &frameBuffer, GLuint textureSize);
     void deleteTexture(GLuint *texture);
+    // Width of the data rows in pixels, which are aligned to 32 bits
+    static int volumeDataWidth(int width, QImage::Format dataFormat);
 
     private:
+    // Finds the formats of a 3D texture for the data. Returns false if the data cannot be
+    // stored in a texture.
+    bool volumeTextureFormat(QImage::Format dataFormat,
+                             QCustom3DVolume::TextureValueType valueType, GLint &internalFormat,
+                             GLenum &format, GLenum &type) const;
     QImage convertToGLFormat(const QImage &srcImage);
     void convertToGLFormatHelper(QImage &dstImage, const QImage &srcImage, GLenum texture_format);
     QRgb qt_gl_convertToGLFormatHelper(QRgb src_pixel, GLenum texture_format);
@@ -80,6 +115,10 @@ class TextureHelper : protected QOpenGLFunctions
 #if !QT_CONFIG(opengles2)
     QOpenGLFunctions_2_1 *m_openGlFunctions_2_1 = nullptr;
 #endif
+    // Single channel textures need ARB_texture_rg, luminance textures are used without it
+    bool m_textureRgSupported = false;
+    bool m_textureFloatSupported = false;
+    bool m_halfFloatPixelSupported = false;
     friend class Bars3DRenderer;
     friend class Surface3DRenderer;
     friend class Scatter3DRenderer;
@@ -34,6 +34,9 @@
 #include <QtGui/QOffscreenSurface>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QRegularExpression>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
 #include <QLocale>
 
 QT_BEGIN_NAMESPACE
@@ -46,6 +49,10 @@ static bool staticsResolved = false;
 static GLint maxTextureSize = 0;
 static bool isES = false;
 
+// Minimum count of data items for updating them in parallel. Can be overridden with
+// QT_DATAVIS_PARALLEL_THRESHOLD environment variable, zero or less disables parallel updates.
+static const int defaultParallelItemThreshold = 50000;
+
 GLuint Utils::getNearestPowerOfTwo(GLuint value)
 {
     GLuint powOfTwoValue = MIN_POWER;
@@ -389,4 +396,51 @@ void Utils::resolveStatics()
     staticsResolved = true;
 }
 
+int Utils::parallelItemThreshold()
+{
+    static const int threshold = qEnvironmentVariableIsSet("QT_DATAVIS_PARALLEL_THRESHOLD")
+            ? qEnvironmentVariableIntValue("QT_DATAVIS_PARALLEL_THRESHOLD")
+            : defaultParallelItemThreshold;
+    return threshold;
+}
+
+// Calls function for consecutive index ranges [begin, end) covering [0, count). If the count of
+// data items reaches the parallel threshold, the ranges are processed concurrently in a thread
+// pool of the module, so function must only touch data that belongs to its own range. The pool
+// is not the global one, so that callers running in the global pool cannot take the threads
+// they wait for. Calls made from the threads of the pool are processed in the calling thread.
+void Utils::parallelFor(int count, const std::function<void(int, int)> &function,
+                        int itemsPerIndex)
+{
+    static QThreadPool pool;
+    const int threshold = parallelItemThreshold();
+    int rangeCount = 1;
+    if (threshold > 0 && qint64(count) * itemsPerIndex >= threshold
+            && !pool.contains(QThread::currentThread())) {
+        rangeCount = qMin(pool.maxThreadCount(), count);
+    }
+
+    if (rangeCount <= 1) {
+        if (count > 0)
+            function(0, count);
+        return;
+    }
+
+    const int rangeSize = (count + rangeCount - 1) / rangeCount;
+    QSemaphore finished;
+    int startedCount = 0;
+    for (int begin = rangeSize; begin < count; begin += rangeSize) {
+        const int end = qMin(begin + rangeSize, count);
+        pool.start([&function, &finished, begin, end]() {
+            function(begin, end);
+            finished.release();
+        });
+        startedCount++;
+    }
+
+    // The first range is processed in the calling thread
+    function(0, rangeSize);
+    finished.acquire(startedCount);
+}
+
 QT_END_NAMESPACE
@@ -41,6 +41,7 @@
 #define UTILS_P_H
 
 #include "datavisualizationglobal_p.h"
+#include <functional>
 
 QT_FORWARD_DECLARE_CLASS(QLinearGradient)
 
@@ -82,6 +83,9 @@ public:
     static QQuaternion calculateRotation(const QVector3D &xyzRotations);
     static bool isOpenGLES();
     static void resolveStatics();
+    static int parallelItemThreshold();
+    static void parallelFor(int count, const std::function<void(int, int)> &function,
+                            int itemsPerIndex = 1);
 
 private:
     static ParamType mapFormatCharToParamType(char formatSpec);
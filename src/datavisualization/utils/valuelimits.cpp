@@ -0,0 +1,175 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "valuelimits_p.h"
+
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+static const float infinity = std::numeric_limits<float>::infinity();
+
+ValueLimits::ValueLimits()
+    : min(infinity),
+      minNonNegative(infinity),
+      minPositive(infinity),
+      max(-infinity)
+{
+}
+
+#if defined(__SSE2__)
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline float horizontalMin(__m128 values)
+{
+    float lanes[4];
+    _mm_storeu_ps(lanes, values);
+    return qMin(qMin(lanes[0], lanes[1]), qMin(lanes[2], lanes[3]));
+}
+
+static inline float horizontalMax(__m128 values)
+{
+    float lanes[4];
+    _mm_storeu_ps(lanes, values);
+    return qMax(qMax(lanes[0], lanes[1]), qMax(lanes[2], lanes[3]));
+}
+#endif
+
+void ValueLimits::add(const float *values, qsizetype count)
+{
+    qsizetype i = 0;
+
+#if defined(__SSE2__)
+    if (count >= 4) {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 inf = _mm_set1_ps(infinity);
+        const __m128 negInf = _mm_set1_ps(-infinity);
+        __m128 minAll = inf;
+        __m128 minNonNeg = inf;
+        __m128 minPos = inf;
+        __m128 maxAll = negInf;
+        for (; i + 4 <= count; i += 4) {
+            const __m128 v = _mm_loadu_ps(values + i);
+            // Infinite and NaN values give NaN when subtracted from themselves
+            const __m128 finite = _mm_cmpeq_ps(_mm_sub_ps(v, v), zero);
+            const __m128 nonNegative = _mm_and_ps(finite, _mm_cmpge_ps(v, zero));
+            const __m128 positive = _mm_and_ps(finite, _mm_cmpgt_ps(v, zero));
+            minAll = _mm_min_ps(minAll, select(finite, v, inf));
+            minNonNeg = _mm_min_ps(minNonNeg, select(nonNegative, v, inf));
+            minPos = _mm_min_ps(minPos, select(positive, v, inf));
+            maxAll = _mm_max_ps(maxAll, select(finite, v, negInf));
+        }
+        min = qMin(min, horizontalMin(minAll));
+        minNonNegative = qMin(minNonNegative, horizontalMin(minNonNeg));
+        minPositive = qMin(minPositive, horizontalMin(minPos));
+        max = qMax(max, horizontalMax(maxAll));
+    }
+#endif
+
+    for (; i < count; i++) {
+        const float value = values[i];
+        if (qIsNaN(value) || qIsInf(value))
+            continue;
+        min = qMin(min, value);
+        max = qMax(max, value);
+        if (value >= 0.0f) {
+            minNonNegative = qMin(minNonNegative, value);
+            if (value > 0.0f)
+                minPositive = qMin(minPositive, value);
+        }
+    }
+}
+
+void ValueLimits::add(const ValueLimits &other)
+{
+    min = qMin(min, other.min);
+    minNonNegative = qMin(minNonNegative, other.minNonNegative);
+    minPositive = qMin(minPositive, other.minPositive);
+    max = qMax(max, other.max);
+}
+
+// Returns the smallest value the axis accepts, or infinity if there is none
+float ValueLimits::validMin(bool allowZero, bool allowNegatives) const
+{
+    if (allowNegatives)
+        return (allowZero || min != 0.0f) ? min : minPositive;
+    return allowZero ? minNonNegative : minPositive;
+}
+
+void RowLimitsCache::clear()
+{
+    m_rows.clear();
+}
+
+void RowLimitsCache::resize(int rowCount)
+{
+    if (m_rows.size() != rowCount) {
+        // Rows have been changed without notifying the cache, so scan everything again
+        m_rows.clear();
+        m_rows.resize(rowCount);
+    }
+}
+
+void RowLimitsCache::markDirty(int startIndex, int count)
+{
+    const int endIndex = qMin(startIndex + count, int(m_rows.size()));
+    for (int i = qMax(startIndex, 0); i < endIndex; i++)
+        m_rows[i].dirty = true;
+}
+
+void RowLimitsCache::insertRows(int startIndex, int count)
+{
+    if (startIndex < 0 || startIndex > m_rows.size() || count <= 0)
+        clear();
+    else
+        m_rows.insert(startIndex, count, RowLimits());
+}
+
+void RowLimitsCache::removeRows(int startIndex, int count)
+{
+    if (startIndex < 0 || startIndex >= m_rows.size() || count <= 0)
+        return;
+    m_rows.remove(startIndex, qMin(count, int(m_rows.size()) - startIndex));
+}
+
+void RowLimitsCache::setLimits(int rowIndex, const ValueLimits &limits)
+{
+    RowLimits &row = m_rows[rowIndex];
+    row.limits = limits;
+    row.dirty = false;
+}
+
+QT_END_NAMESPACE
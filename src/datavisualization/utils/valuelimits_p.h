@@ -0,0 +1,109 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QtDataVisualization API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+#ifndef VALUELIMITS_P_H
+#define VALUELIMITS_P_H
+
+#include "datavisualizationglobal_p.h"
+#include <QtCore/QList>
+
+QT_BEGIN_NAMESPACE
+
+// Extents of a set of values for autoscaling the axes. Infinite and NaN values are ignored.
+// Separate minimums are kept for the non-negative and positive values, so that the extents
+// can be combined without knowing which values the axis accepts.
+struct ValueLimits
+{
+    ValueLimits();
+
+    void add(const float *values, qsizetype count);
+    void add(const ValueLimits &other);
+
+    // Collects the values in blocks, so that they can be processed with add()
+    template <typename ValueAt>
+    void addGathered(qsizetype count, ValueAt valueAt)
+    {
+        float block[blockSize];
+        for (qsizetype i = 0; i < count; i += blockSize) {
+            const qsizetype blockCount = qMin(qsizetype(blockSize), count - i);
+            for (qsizetype j = 0; j < blockCount; j++)
+                block[j] = valueAt(i + j);
+            add(block, blockCount);
+        }
+    }
+
+    inline bool isEmpty() const { return max < min; }
+    float validMin(bool allowZero, bool allowNegatives) const;
+
+    static constexpr int blockSize = 256;
+
+    float min;
+    float minNonNegative;
+    float minPositive;
+    float max;
+};
+
+// Caches the value limits of each data row, so that only the changed rows need to be scanned
+// again when the axis ranges are adjusted.
+class RowLimitsCache
+{
+public:
+    void clear();
+    void resize(int rowCount);
+    void markDirty(int startIndex, int count);
+    void insertRows(int startIndex, int count);
+    void removeRows(int startIndex, int count);
+
+    inline bool isDirty(int rowIndex) const { return m_rows.at(rowIndex).dirty; }
+    inline const ValueLimits &limits(int rowIndex) const { return m_rows.at(rowIndex).limits; }
+    void setLimits(int rowIndex, const ValueLimits &limits);
+
+private:
+    struct RowLimits
+    {
+        ValueLimits limits;
+        bool dirty = true;
+    };
+
+    QList<RowLimits> m_rows;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -28,54 +28,72 @@
 ****************************************************************************/
 
 #include "vertexindexer_p.h"
+#include "utils_p.h"
 
-#include <QtCore/qmath.h>
-#include <QtCore/qmap.h>
+#include <QtCore/qhashfunctions.h>
 
 QT_BEGIN_NAMESPACE
 
-int unique_vertices = 0;
-
-bool VertexIndexer::getSimilarVertexIndex_fast(const PackedVertex &packed,
-                                               QMap<PackedVertex, GLuint> &VertexToOutIndex,
-                                               GLuint &result)
-{
-    QMap<PackedVertex, GLuint>::iterator it = VertexToOutIndex.find(packed);
-    if (it == VertexToOutIndex.end()) {
-        return false;
-    } else {
-        result = it.value();
-        return true;
-    }
-}
+static const GLuint emptySlot = GLuint(-1);
 
 void VertexIndexer::indexVBO(const QList<QVector3D> &in_vertices, const QList<QVector2D> &in_uvs,
                              const QList<QVector3D> &in_normals, QList<GLuint> &out_indices,
                              QList<QVector3D> &out_vertices, QList<QVector2D> &out_uvs,
                              QList<QVector3D> &out_normals)
 {
-    unique_vertices = 0;
-    QMap<PackedVertex, GLuint> VertexToOutIndex;
+    const int vertexCount = in_vertices.size();
+    if (!vertexCount)
+        return;
+
+    // Pack and hash the input vertices first, in parallel for large meshes
+    QList<PackedVertex> packedVertices(vertexCount);
+    QList<size_t> hashes(vertexCount);
+    PackedVertex *packed = packedVertices.data();
+    size_t *packedHashes = hashes.data();
+    Utils::parallelFor(vertexCount, [&, packed, packedHashes](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            packed[i] = {in_vertices.at(i), in_uvs.at(i), in_normals.at(i)};
+            packedHashes[i] = qHashBits(&packed[i], sizeof(PackedVertex));
+        }
+    });
 
-    // For each input vertex
-    for (int i = 0; i < in_vertices.size(); i++) {
-        PackedVertex packed = {in_vertices[i], in_uvs[i], in_normals[i]};
+    // Open addressing table of unique vertex numbers, kept at most half full
+    int slotCount = 16;
+    while (slotCount < vertexCount * 2)
+        slotCount <<= 1;
+    const size_t slotMask = size_t(slotCount - 1);
+    QList<GLuint> slots(slotCount, emptySlot);
+    QList<int> uniqueVertices;
+    uniqueVertices.reserve(vertexCount);
 
+    const GLuint firstIndex = GLuint(out_vertices.size());
+    out_indices.reserve(out_indices.size() + vertexCount);
+    for (int i = 0; i < vertexCount; i++) {
         // Try to find a similar vertex in out_XXXX
-        GLuint index;
-        bool found = getSimilarVertexIndex_fast(packed, VertexToOutIndex, index);
-
-        if (found) {
-            out_indices.append(index);
-        } else {
-            unique_vertices++;
-            out_vertices.append(in_vertices[i]);
-            out_uvs.append(in_uvs[i]);
-            out_normals.append(in_normals[i]);
-            GLuint newindex = (GLuint)out_vertices.size() - 1;
-            out_indices.append(newindex);
-            VertexToOutIndex[packed] = newindex;
+        size_t slot = packedHashes[i] & slotMask;
+        GLuint unique = slots.at(slot);
+        while (unique != emptySlot && !(packed[uniqueVertices.at(unique)] == packed[i])) {
+            slot = (slot + 1) & slotMask;
+            unique = slots.at(slot);
+        }
+        if (unique == emptySlot) {
+            unique = GLuint(uniqueVertices.size());
+            slots[slot] = unique;
+            uniqueVertices.append(i);
         }
+        out_indices.append(firstIndex + unique);
+    }
+
+    // The new unique vertices are appended after any existing output
+    const int uniqueCount = uniqueVertices.size();
+    out_vertices.reserve(out_vertices.size() + uniqueCount);
+    out_uvs.reserve(out_uvs.size() + uniqueCount);
+    out_normals.reserve(out_normals.size() + uniqueCount);
+    for (int i = 0; i < uniqueCount; i++) {
+        const int vertex = uniqueVertices.at(i);
+        out_vertices.append(in_vertices.at(vertex));
+        out_uvs.append(in_uvs.at(vertex));
+        out_normals.append(in_normals.at(vertex));
     }
 }
 
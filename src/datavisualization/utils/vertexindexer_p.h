@@ -47,15 +47,15 @@
 
 QT_BEGIN_NAMESPACE
 
-class VertexIndexer
+class Q_AUTOTEST_EXPORT VertexIndexer
 {
 public:
     struct PackedVertex {
         QVector3D position;
         QVector2D uv;
         QVector3D normal;
-        bool operator<(const PackedVertex that) const {
-            return memcmp((void*)this, (void*)&that, sizeof(PackedVertex)) > 0;
+        bool operator==(const PackedVertex &that) const {
+            return memcmp((void*)this, (void*)&that, sizeof(PackedVertex)) == 0;
         }
     };
 
@@ -63,11 +63,6 @@ public:
                          const QList<QVector3D> &in_normals, QList<GLuint> &out_indices,
                          QList<QVector3D> &out_vertices, QList<QVector2D> &out_uvs,
                          QList<QVector3D> &out_normals);
-
-private:
-    static bool getSimilarVertexIndex_fast(const PackedVertex &packed,
-                                           QMap<PackedVertex, GLuint> &VertexToOutIndex,
-                                           GLuint &result);
 };
 
 QT_END_NAMESPACE
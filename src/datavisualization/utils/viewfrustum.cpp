@@ -0,0 +1,61 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "viewfrustum_p.h"
+
+QT_BEGIN_NAMESPACE
+
+ViewFrustum::ViewFrustum(const QMatrix4x4 &projectionViewMatrix)
+{
+    // A point is inside when -w <= x, y, z <= w in clip space, which gives the planes as sums
+    // and differences of the last row and the other rows of the matrix.
+    const QVector4D w = projectionViewMatrix.row(3);
+    for (int i = 0; i < 3; i++) {
+        const QVector4D row = projectionViewMatrix.row(i);
+        m_planes[i * 2] = w + row;
+        m_planes[i * 2 + 1] = w - row;
+    }
+}
+
+// Conservative test, which can accept boxes that are just outside the corners of the frustum
+bool ViewFrustum::intersectsBox(const QVector3D &minimum, const QVector3D &maximum) const
+{
+    for (const QVector4D &plane : m_planes) {
+        // Test the corner that is furthest along the plane normal
+        const QVector4D corner(plane.x() >= 0.0f ? maximum.x() : minimum.x(),
+                               plane.y() >= 0.0f ? maximum.y() : minimum.y(),
+                               plane.z() >= 0.0f ? maximum.z() : minimum.z(),
+                               1.0f);
+        if (QVector4D::dotProduct(plane, corner) < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+QT_END_NAMESPACE
@@ -51,6 +51,8 @@ private slots:
     void initializeProperties();
 
     void multiMatch();
+    void addModelAsynchronously();
+    void deleteDuringResolve();
 
 private:
     QItemModelBarDataProxy *m_proxy;
@@ -162,6 +164,7 @@ void tst_proxy::initialProperties()
     QCOMPARE(m_proxy->valueRole(), QString());
     QCOMPARE(m_proxy->valueRolePattern(), QRegularExpression());
     QCOMPARE(m_proxy->valueRoleReplace(), QString());
+    QCOMPARE(m_proxy->asynchronousResolve(), false);
 
     QCOMPARE(m_proxy->columnLabels().count(), 0);
     QCOMPARE(m_proxy->rowCount(), 0);
@@ -196,6 +199,7 @@ void tst_proxy::initializeProperties()
     m_proxy->setValueRole("value");
     m_proxy->setValueRolePattern(QRegularExpression("/-/"));
     m_proxy->setValueRoleReplace("\\\\1");
+    m_proxy->setAsynchronousResolve(true);
 
     QCOMPARE(m_proxy->autoColumnCategories(), false);
     QCOMPARE(m_proxy->autoRowCategories(), false);
@@ -216,6 +220,7 @@ void tst_proxy::initializeProperties()
     QCOMPARE(m_proxy->valueRole(), QString("value"));
     QCOMPARE(m_proxy->valueRolePattern(), QRegularExpression("/-/"));
     QCOMPARE(m_proxy->valueRoleReplace(), QString("\\\\1"));
+    QCOMPARE(m_proxy->asynchronousResolve(), true);
 }
 
 void tst_proxy::multiMatch()
@@ -280,5 +285,54 @@ void tst_proxy::multiMatch()
     m_proxy = 0; // Proxy gets deleted as graph gets deleted
 }
 
+void tst_proxy::addModelAsynchronously()
+{
+    QTableWidget table;
+    table.setRowCount(2);
+    table.setColumnCount(3);
+    for (int row = 0; row < 2; row++) {
+        for (int col = 0; col < 3; col++)
+            table.model()->setData(table.model()->index(row, col), QString::number(row * 3 + col));
+    }
+
+    QSignalSpy resolvedSpy(m_proxy, &QItemModelBarDataProxy::modelResolved);
+    m_proxy->setAsynchronousResolve(true);
+    m_proxy->setUseModelCategories(true);
+    m_proxy->setItemModel(table.model());
+
+    QTRY_COMPARE(resolvedSpy.count(), 1);
+    QCOMPARE(m_proxy->rowCount(), 2);
+    QCOMPARE(m_proxy->rowLabels().count(), 2);
+    QCOMPARE(m_proxy->columnLabels().count(), 3);
+    QCOMPARE(m_proxy->itemAt(1, 2)->value(), 5.0f);
+
+    // Single item changes are still applied directly
+    table.model()->setData(table.model()->index(1, 2), QStringLiteral("10"));
+    QCOMPARE(m_proxy->itemAt(1, 2)->value(), 10.0f);
+
+    // Mapping changes resolve the whole model again
+    m_proxy->setRotationRole(table.model()->roleNames().value(Qt::DisplayRole));
+    QTRY_COMPARE(resolvedSpy.count(), 2);
+    QCOMPARE(m_proxy->rowCount(), 2);
+    QCOMPARE(m_proxy->itemAt(1, 2)->rotation(), 10.0f);
+}
+
+void tst_proxy::deleteDuringResolve()
+{
+    QTableWidget table;
+    table.setRowCount(200);
+    table.setColumnCount(200);
+
+    m_proxy->setAsynchronousResolve(true);
+    m_proxy->setUseModelCategories(true);
+    m_proxy->setItemModel(table.model());
+
+    // Deleting the proxy waits for the running resolve, and drops its result
+    QCoreApplication::processEvents();
+    delete m_proxy;
+    m_proxy = 0;
+    QCoreApplication::processEvents();
+}
+
 QTEST_MAIN(tst_proxy)
 #include "tst_proxy.moc"
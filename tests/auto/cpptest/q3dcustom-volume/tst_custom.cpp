@@ -30,6 +30,9 @@
 #include <QtTest/QtTest>
 
 #include <QtDataVisualization/QCustom3DVolume>
+#include <QtDataVisualization/Q3DScatter>
+
+#include "cpptestutil.h"
 
 class tst_custom: public QObject
 {
@@ -47,6 +50,15 @@ private slots:
     void initializeProperties();
     void invalidProperties();
 
+    void grayscale16Data();
+    void floatData();
+    void xSliceArgb32AlphaMultiplier();
+    void xSliceIndexed8OddWidth();
+    void renderSliceBenchmark_data();
+    void renderSliceBenchmark();
+    void textureDataFile();
+    void renderTextureDataFile();
+
 private:
     QCustom3DVolume *m_custom;
 };
@@ -130,6 +142,8 @@ void tst_custom::initialProperties()
     QCOMPARE(m_custom->sliceIndexY(), -1);
     QCOMPARE(m_custom->sliceIndexZ(), -1);
     QCOMPARE(m_custom->useHighDefShader(), true);
+    QCOMPARE(m_custom->textureMemoryLimit(), 512);
+    QCOMPARE(m_custom->textureDataFile(), QString());
 
     // Common (from QCustom3DVolume)
     QCOMPARE(m_custom->meshFile(), QString(":/defaultMeshes/barFull"));
@@ -159,6 +173,7 @@ void tst_custom::initializeProperties()
     m_custom->setSliceIndexY(0);
     m_custom->setSliceIndexZ(0);
     m_custom->setUseHighDefShader(false);
+    m_custom->setTextureMemoryLimit(64);
 
     QCOMPARE(m_custom->alphaMultiplier(), 0.1f);
     QCOMPARE(m_custom->drawSliceFrames(), true);
@@ -172,6 +187,7 @@ void tst_custom::initializeProperties()
     QCOMPARE(m_custom->sliceIndexY(), 0);
     QCOMPARE(m_custom->sliceIndexZ(), 0);
     QCOMPARE(m_custom->useHighDefShader(), false);
+    QCOMPARE(m_custom->textureMemoryLimit(), 64);
 
     // Common (from QCustom3DVolume)
     m_custom->setPosition(QVector3D(1.0f, 1.0f, 1.0f));
@@ -207,6 +223,280 @@ void tst_custom::invalidProperties()
 
     m_custom->setTextureFormat(QImage::Format_ARGB8555_Premultiplied);
     QCOMPARE(m_custom->textureFormat(), QImage::Format_ARGB32);
+
+    m_custom->setTextureMemoryLimit(0);
+    QCOMPARE(m_custom->textureMemoryLimit(), 512);
+
+    QCOMPARE(m_custom->setTextureDataFile(QStringLiteral("nonexistent.raw")), false);
+    QCOMPARE(m_custom->textureDataFile(), QString());
+}
+
+void tst_custom::grayscale16Data()
+{
+    QList<QImage *> images;
+    for (int i = 0; i < 3; i++) {
+        QImage *image = new QImage(3, 2, QImage::Format_Grayscale16);
+        for (int y = 0; y < image->height(); y++) {
+            quint16 *line = reinterpret_cast<quint16 *>(image->scanLine(y));
+            for (int x = 0; x < image->width(); x++)
+                line[x] = quint16(i * 10000 + y * 1000 + x);
+        }
+        images.append(image);
+    }
+
+    m_custom->createTextureData(images);
+    QCOMPARE(m_custom->textureFormat(), QImage::Format_Grayscale16);
+    QCOMPARE(m_custom->textureWidth(), 3);
+    QCOMPARE(m_custom->textureHeight(), 2);
+    QCOMPARE(m_custom->textureDepth(), 3);
+    QCOMPARE(m_custom->textureDataWidth(), 8);
+
+    QImage slice = m_custom->renderSlice(Qt::ZAxis, 1);
+    QCOMPARE(slice.format(), QImage::Format_Grayscale16);
+    QCOMPARE(reinterpret_cast<const quint16 *>(slice.constScanLine(1))[2], quint16(11002));
+    slice = m_custom->renderSlice(Qt::XAxis, 2);
+    QCOMPARE(slice.size(), QSize(3, 2));
+    QCOMPARE(reinterpret_cast<const quint16 *>(slice.constScanLine(1))[2], quint16(21002));
+    slice = m_custom->renderSlice(Qt::YAxis, 1);
+    QCOMPARE(slice.size(), QSize(3, 3));
+    QCOMPARE(reinterpret_cast<const quint16 *>(slice.constScanLine(0))[1], quint16(21001));
+
+    QImage newSlice(3, 2, QImage::Format_Grayscale16);
+    newSlice.fill(0);
+    reinterpret_cast<quint16 *>(newSlice.scanLine(0))[1] = 54321;
+    m_custom->setSubTextureData(Qt::ZAxis, 2, newSlice);
+    slice = m_custom->renderSlice(Qt::ZAxis, 2);
+    QCOMPARE(reinterpret_cast<const quint16 *>(slice.constScanLine(0))[1], quint16(54321));
+    QCOMPARE(reinterpret_cast<const quint16 *>(slice.constScanLine(1))[2], quint16(0));
+
+    qDeleteAll(images);
+}
+
+void tst_custom::floatData()
+{
+    m_custom->setTextureDimensions(3, 2, 2);
+
+    // Half floats keep the 16-bit layout of QImage::Format_Grayscale16
+    m_custom->setTextureFormat(QImage::Format_Grayscale16);
+    m_custom->setTextureValueType(QCustom3DVolume::TextureValueHalfFloat);
+    QCOMPARE(m_custom->textureDataWidth(), 8);
+
+    // Float volumes are the QImage::Format_Invalid and TextureValueFloat pair
+    m_custom->setTextureFormat(QImage::Format_Invalid);
+    QCOMPARE(m_custom->textureFormat(), QImage::Format_Invalid);
+    QCOMPARE(m_custom->textureDataWidth(), 12);
+    m_custom->setTextureValueType(QCustom3DVolume::TextureValueFloat);
+    QCOMPARE(m_custom->textureValueType(), QCustom3DVolume::TextureValueFloat);
+    QCOMPARE(m_custom->textureDataWidth(), 12);
+
+    QList<uchar> *data = new QList<uchar>(3 * 2 * 2 * sizeof(float));
+    float *values = reinterpret_cast<float *>(data->data());
+    for (int i = 0; i < 3 * 2 * 2; i++)
+        values[i] = float(i) / 12.0f;
+    m_custom->setTextureData(data);
+
+    // Setting a float slice copies four bytes per texel
+    const float slice[] = { 1.0f, 0.5f, 0.25f, 0.75f };
+    m_custom->setSubTextureData(Qt::XAxis, 2, reinterpret_cast<const uchar *>(slice));
+    QCOMPARE(values[2], 1.0f);
+    QCOMPARE(values[8], 0.5f);
+    QCOMPARE(values[5], 0.25f);
+    QCOMPARE(values[11], 0.75f);
+    QCOMPARE(values[4], 4.0f / 12.0f);
+
+    // Images cannot hold float values
+    QVERIFY(m_custom->renderSlice(Qt::ZAxis, 0).isNull());
+
+    // Grayscale16 data is still 16-bit with the float value type
+    m_custom->setTextureFormat(QImage::Format_Grayscale16);
+    QCOMPARE(m_custom->textureDataWidth(), 8);
+}
+
+void tst_custom::xSliceArgb32AlphaMultiplier()
+{
+    // Volume of 3 x 4 x 5 voxels, each voxel encoding its own coordinates. Every other voxel
+    // is opaque, so that both preserved and multiplied alpha values are tested.
+    const int width = 3;
+    const int height = 4;
+    const int depth = 5;
+    QList<uchar> *data = new QList<uchar>(width * height * depth * 4);
+    QRgb *texels = reinterpret_cast<QRgb *>(data->data());
+    for (int z = 0; z < depth; z++) {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int alpha = ((x + y + z) % 2) ? 255 : 200;
+                texels[(z * height + y) * width + x] = qRgba(x * 10, y * 10, z * 10, alpha);
+            }
+        }
+    }
+
+    m_custom->setTextureFormat(QImage::Format_ARGB32);
+    m_custom->setTextureDimensions(width, height, depth);
+    m_custom->setTextureData(data);
+    m_custom->setAlphaMultiplier(0.5f);
+    QCOMPARE(m_custom->textureDataWidth(), width * 4);
+
+    const int index = 1;
+    QImage slice = m_custom->renderSlice(Qt::XAxis, index);
+    QCOMPARE(slice.format(), QImage::Format_ARGB32);
+    QCOMPARE(slice.size(), QSize(depth, height));
+    for (int y = 0; y < height; y++) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(slice.constScanLine(y));
+        for (int z = 0; z < depth; z++) {
+            int alpha = ((index + y + z) % 2) ? 255 : 100;
+            QCOMPARE(line[z], qRgba(index * 10, y * 10, z * 10, alpha));
+        }
+    }
+
+    // Opacity is not preserved for opaque voxels when asked not to
+    m_custom->setPreserveOpacity(false);
+    slice = m_custom->renderSlice(Qt::XAxis, index);
+    QCOMPARE(qAlpha(reinterpret_cast<const QRgb *>(slice.constScanLine(0))[0]), 127);
+    QCOMPARE(qAlpha(reinterpret_cast<const QRgb *>(slice.constScanLine(0))[1]), 100);
+
+    // The data itself is not modified
+    QCOMPARE(qAlpha(texels[index]), 255);
+}
+
+void tst_custom::xSliceIndexed8OddWidth()
+{
+    // Odd width and depth make both the data lines and the X axis slice lines padded
+    const int width = 5;
+    const int height = 3;
+    const int depth = 7;
+    m_custom->setTextureFormat(QImage::Format_Indexed8);
+    m_custom->setTextureDimensions(width, height, depth);
+    const int dataWidth = m_custom->textureDataWidth();
+    QVERIFY(dataWidth != width);
+
+    QList<uchar> *data = new QList<uchar>(dataWidth * height * depth, uchar(255));
+    for (int z = 0; z < depth; z++) {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++)
+                (*data)[(z * height + y) * dataWidth + x] = uchar(z * 16 + y * 5 + x);
+        }
+    }
+    QList<QRgb> colorTable;
+    for (int i = 0; i < 256; i++)
+        colorTable.append(qRgba(i, 0, 0, 255));
+    m_custom->setColorTable(colorTable);
+    m_custom->setTextureData(data);
+
+    for (int index = 0; index < width; index++) {
+        QImage slice = m_custom->renderSlice(Qt::XAxis, index);
+        QCOMPARE(slice.format(), QImage::Format_Indexed8);
+        QCOMPARE(slice.size(), QSize(depth, height));
+        QVERIFY(slice.bytesPerLine() != depth);
+        QCOMPARE(slice.colorTable(), colorTable);
+        for (int y = 0; y < height; y++) {
+            const uchar *line = slice.constScanLine(y);
+            for (int z = 0; z < depth; z++)
+                QCOMPARE(int(line[z]), z * 16 + y * 5 + index);
+        }
+    }
+    QVERIFY(m_custom->renderSlice(Qt::XAxis, width).isNull());
+}
+
+void tst_custom::renderSliceBenchmark_data()
+{
+    QTest::addColumn<int>("axis");
+
+    QTest::newRow("X axis") << int(Qt::XAxis);
+    QTest::newRow("Y axis") << int(Qt::YAxis);
+    QTest::newRow("Z axis") << int(Qt::ZAxis);
+}
+
+void tst_custom::renderSliceBenchmark()
+{
+    QFETCH(int, axis);
+
+    const int size = 256;
+    m_custom->setTextureFormat(QImage::Format_ARGB32);
+    m_custom->setTextureDimensions(size, size, size);
+    m_custom->setTextureData(new QList<uchar>(qsizetype(size) * size * size * 4, uchar(128)));
+    m_custom->setAlphaMultiplier(0.5f);
+
+    QImage slice;
+    QBENCHMARK {
+        slice = m_custom->renderSlice(Qt::Axis(axis), size / 2);
+    }
+    QCOMPARE(slice.size(), QSize(size, size));
+}
+
+void tst_custom::textureDataFile()
+{
+    // Raw 8-bit volume of 4 x 2 x 2 voxels after a header of 4 bytes
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QByteArray bytes(4, 'h');
+    for (int i = 0; i < 16; i++)
+        bytes.append(char(i));
+    file.write(bytes);
+    file.flush();
+
+    m_custom->setTextureFormat(QImage::Format_Indexed8);
+    m_custom->setTextureWidth(4);
+    m_custom->setTextureHeight(2);
+    m_custom->setTextureDepth(2);
+    QCOMPARE(m_custom->setTextureDataFile(file.fileName(), 4), true);
+    QCOMPARE(m_custom->textureDataFile(), file.fileName());
+    QVERIFY(!m_custom->textureData());
+
+    QImage slice = m_custom->renderSlice(Qt::ZAxis, 1);
+    QCOMPARE(slice.format(), QImage::Format_Indexed8);
+    QCOMPARE(int(slice.constScanLine(1)[3]), 15);
+
+    // Setting the data array releases the file
+    m_custom->setTextureData(new QList<uchar>(16, 1));
+    QCOMPARE(m_custom->textureDataFile(), QString());
+    slice = m_custom->renderSlice(Qt::ZAxis, 1);
+    QCOMPARE(int(slice.constScanLine(1)[3]), 1);
+}
+
+void tst_custom::renderTextureDataFile()
+{
+    if (!CpptestUtil::isOpenGLSupported())
+        QSKIP("OpenGL not supported on this platform");
+
+    // Raw 8-bit volume of 32 x 32 x 32 voxels, which is 2 x 2 x 2 bricks. The bricks
+    // in the front half are transparent and the ones in the back half opaque.
+    const int size = 32;
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QByteArray bytes(size * size * size / 2, char(0));
+    bytes.append(QByteArray(size * size * size / 2, char(1)));
+    file.write(bytes);
+    file.flush();
+
+    QList<QRgb> colorTable;
+    colorTable << qRgba(0, 0, 0, 0) << qRgba(255, 0, 0, 255);
+    m_custom->setTextureFormat(QImage::Format_Indexed8);
+    m_custom->setColorTable(colorTable);
+    m_custom->setTextureDimensions(size, size, size);
+    QCOMPARE(m_custom->setTextureDataFile(file.fileName()), true);
+    m_custom->setTextureMemoryLimit(1);
+
+    Q3DScatter graph;
+    graph.setOrthoProjection(true);
+    QImage emptyImage = graph.renderToImage(0, QSize(200, 200));
+    QCOMPARE(emptyImage.size(), QSize(200, 200));
+
+    // The graph takes the ownership of the volume
+    QCustom3DVolume *volume = m_custom;
+    m_custom = new QCustom3DVolume();
+    graph.addCustomItem(volume);
+    QImage image = graph.renderToImage(0, QSize(200, 200));
+    QCOMPARE(image.size(), QSize(200, 200));
+    QVERIFY(image != emptyImage);
+
+    // Changing the limit keeps the loaded bricks, so the volume renders the same
+    volume->setTextureMemoryLimit(2);
+    QCOMPARE(graph.renderToImage(0, QSize(200, 200)), image);
+    QCOMPARE(volume->textureDataFile(), file.fileName());
+
+    // Drawing a slice of the file backed volume
+    volume->setSliceIndexZ(size - 1);
+    QVERIFY(!graph.renderToImage(0, QSize(200, 200)).isNull());
 }
 
 QTEST_MAIN(tst_custom)
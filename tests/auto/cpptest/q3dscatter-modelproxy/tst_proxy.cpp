@@ -49,6 +49,8 @@ private slots:
     void initializeProperties();
 
     void addModel();
+    void addModelAsynchronously();
+    void insertAndRemoveRows();
 
 private:
     QItemModelScatterDataProxy *m_proxy;
@@ -118,6 +120,7 @@ void tst_proxy::initialProperties()
     QCOMPARE(m_proxy->zPosRole(), QString());
     QCOMPARE(m_proxy->zPosRolePattern(), QRegularExpression());
     QCOMPARE(m_proxy->zPosRoleReplace(), QString());
+    QCOMPARE(m_proxy->asynchronousResolve(), false);
 
     QCOMPARE(m_proxy->itemCount(), 0);
     QVERIFY(!m_proxy->series());
@@ -144,6 +147,7 @@ void tst_proxy::initializeProperties()
     m_proxy->setZPosRole("Z");
     m_proxy->setZPosRolePattern(QRegularExpression("/-/"));
     m_proxy->setZPosRoleReplace("\\\\1");
+    m_proxy->setAsynchronousResolve(true);
 
     QVERIFY(m_proxy->itemModel());
     QCOMPARE(m_proxy->rotationRole(), QString("rotation"));
@@ -158,6 +162,7 @@ void tst_proxy::initializeProperties()
     QCOMPARE(m_proxy->zPosRole(), QString("Z"));
     QCOMPARE(m_proxy->zPosRolePattern(), QRegularExpression("/-/"));
     QCOMPARE(m_proxy->zPosRoleReplace(), QString("\\\\1"));
+    QCOMPARE(m_proxy->asynchronousResolve(), true);
 }
 
 void tst_proxy::addModel()
@@ -202,5 +207,64 @@ void tst_proxy::addModel()
     m_proxy = 0; // proxy gets deleted with series
 }
 
+void tst_proxy::addModelAsynchronously()
+{
+    QTableWidget table;
+    table.setRowCount(3);
+    table.setColumnCount(1);
+    for (int row = 0; row < 3; row++)
+        table.model()->setData(table.model()->index(row, 0), QString::number(row + 1));
+
+    QSignalSpy resolvedSpy(m_proxy, &QItemModelScatterDataProxy::modelResolved);
+    m_proxy->setAsynchronousResolve(true);
+    m_proxy->setItemModel(table.model());
+    m_proxy->setYPosRole(table.model()->roleNames().value(Qt::DisplayRole));
+
+    QTRY_COMPARE(resolvedSpy.count(), 1);
+    QCOMPARE(m_proxy->itemCount(), 3);
+    QCOMPARE(m_proxy->itemAt(2)->y(), 3.0f);
+
+    // Single item changes are still applied directly
+    table.model()->setData(table.model()->index(2, 0), QStringLiteral("10"));
+    QCOMPARE(m_proxy->itemAt(2)->y(), 10.0f);
+
+    // Mapping changes resolve the whole model again
+    m_proxy->setXPosRole(table.model()->roleNames().value(Qt::DisplayRole));
+    QTRY_COMPARE(resolvedSpy.count(), 2);
+    QCOMPARE(m_proxy->itemCount(), 3);
+    QCOMPARE(m_proxy->itemAt(2)->x(), 10.0f);
+}
+
+void tst_proxy::insertAndRemoveRows()
+{
+    QTableWidget table;
+    table.setRowCount(2);
+    table.setColumnCount(2);
+    for (int row = 0; row < 2; row++) {
+        for (int col = 0; col < 2; col++)
+            table.model()->setData(table.model()->index(row, col), QString::number(row * 2 + col));
+    }
+
+    m_proxy->setItemModel(table.model());
+    m_proxy->setYPosRole(table.model()->roleNames().value(Qt::DisplayRole));
+    QCoreApplication::processEvents();
+    QCOMPARE(m_proxy->itemCount(), 4);
+
+    // Row changes of a multi-column model are applied without resolving the whole model
+    QSignalSpy resetSpy(m_proxy, &QScatterDataProxy::arrayReset);
+    table.insertRow(1);
+    QCOMPARE(m_proxy->itemCount(), 6);
+    table.model()->setData(table.model()->index(1, 1), QStringLiteral("10"));
+    QCOMPARE(m_proxy->itemAt(3)->y(), 10.0f);
+    QCOMPARE(m_proxy->itemAt(5)->y(), 3.0f);
+
+    table.removeRow(0);
+    QCOMPARE(m_proxy->itemCount(), 4);
+    QCOMPARE(m_proxy->itemAt(1)->y(), 10.0f);
+
+    QCoreApplication::processEvents();
+    QCOMPARE(resetSpy.count(), 0);
+}
+
 QTEST_MAIN(tst_proxy)
 #include "tst_proxy.moc"
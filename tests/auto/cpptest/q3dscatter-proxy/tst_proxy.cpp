@@ -46,6 +46,8 @@ private slots:
     void initialProperties();
     void initializeProperties();
 
+    void borrowArray();
+
 private:
     QScatterDataProxy *m_proxy;
 };
@@ -96,5 +98,49 @@ void tst_proxy::initializeProperties()
     QCOMPARE(m_proxy->itemCount(), 2);
 }
 
+void tst_proxy::borrowArray()
+{
+    QVERIFY(m_proxy);
+
+    struct Point {
+        float position[3];
+        float intensity;
+    };
+    Point points[3] = { { { 0.5f, 0.5f, 0.5f }, 1.0f },
+                        { { -0.3f, -0.5f, -0.4f }, 2.0f },
+                        { { 0.1f, 0.2f, 0.3f }, 3.0f } };
+    int releaseCount = 0;
+
+    QSignalSpy resetSpy(m_proxy, &QScatterDataProxy::arrayReset);
+    m_proxy->borrowArray(points[0].position, 3, sizeof(Point), nullptr, 0,
+                         [&releaseCount]() { releaseCount++; });
+
+    QCOMPARE(resetSpy.size(), 1);
+    QVERIFY(m_proxy->isArrayBorrowed());
+    QCOMPARE(m_proxy->itemCount(), 3);
+    QCOMPARE(m_proxy->array()->size(), 0);
+    QCOMPARE(m_proxy->itemAt(1)->position(), QVector3D(-0.3f, -0.5f, -0.4f));
+    QVERIFY(m_proxy->itemAt(2)->rotation().isIdentity());
+    QCOMPARE(releaseCount, 0);
+
+    // Modifying the data copies it into an owned array and releases the buffers
+    m_proxy->addItem(QScatterDataItem(QVector3D(1.0f, 1.0f, 1.0f)));
+    QVERIFY(!m_proxy->isArrayBorrowed());
+    QCOMPARE(releaseCount, 1);
+    QCOMPARE(m_proxy->itemCount(), 4);
+    QCOMPARE(m_proxy->array()->at(2).position(), QVector3D(0.1f, 0.2f, 0.3f));
+
+    float rotations[4] = { 0.0f, 1.0f, 0.0f, 0.0f };
+    m_proxy->borrowArray(points[0].position, 1, sizeof(Point), rotations, 0,
+                         [&releaseCount]() { releaseCount++; });
+    QCOMPARE(m_proxy->itemCount(), 1);
+    QCOMPARE(m_proxy->itemAt(0)->rotation(), QQuaternion(0.0f, 1.0f, 0.0f, 0.0f));
+
+    m_proxy->resetArray(0);
+    QVERIFY(!m_proxy->isArrayBorrowed());
+    QCOMPARE(releaseCount, 2);
+    QCOMPARE(m_proxy->itemCount(), 0);
+}
+
 QTEST_MAIN(tst_proxy)
 #include "tst_proxy.moc"
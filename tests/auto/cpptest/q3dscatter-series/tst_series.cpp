@@ -46,6 +46,9 @@ private slots:
     void initialProperties();
     void initializeProperties();
 
+    void spatialQueries();
+    void spatialIndexUpdates();
+
 private:
     QScatter3DSeries *m_series;
 };
@@ -89,6 +92,7 @@ void tst_series::initialProperties()
     QVERIFY(m_series->dataProxy());
     QCOMPARE(m_series->itemSize(), 0.0f);
     QCOMPARE(m_series->selectedItem(), m_series->invalidSelectionIndex());
+    QCOMPARE(m_series->isSpatialIndexEnabled(), false);
 
     // Common properties. The ones identical between different series are tested in QBar3DSeries tests
     QCOMPARE(m_series->itemLabelFormat(), QString("@xLabel, @yLabel, @zLabel"));
@@ -103,9 +107,11 @@ void tst_series::initializeProperties()
     m_series->setDataProxy(new QScatterDataProxy());
     m_series->setItemSize(0.5f);
     m_series->setSelectedItem(0);
+    m_series->setSpatialIndexEnabled(true);
 
     QCOMPARE(m_series->itemSize(), 0.5f);
     QCOMPARE(m_series->selectedItem(), 0);
+    QCOMPARE(m_series->isSpatialIndexEnabled(), true);
 
     // Common properties. The ones identical between different series are tested in QBar3DSeries tests
     m_series->setMesh(QAbstract3DSeries::MeshPoint);
@@ -115,5 +121,69 @@ void tst_series::initializeProperties()
     QCOMPARE(m_series->meshRotation(), QQuaternion(1, 1, 10, 20));
 }
 
+static QScatterDataArray *createGrid(int size)
+{
+    QScatterDataArray *array = new QScatterDataArray;
+    for (int x = 0; x < size; x++) {
+        for (int y = 0; y < size; y++) {
+            for (int z = 0; z < size; z++)
+                array->append(QScatterDataItem(QVector3D(x, y, z)));
+        }
+    }
+    return array;
+}
+
+void tst_series::spatialQueries()
+{
+    QVERIFY(m_series);
+
+    QCOMPARE(m_series->nearestItem(QVector3D()), -1);
+    QVERIFY(m_series->itemsInBox(QVector3D(-1, -1, -1), QVector3D(1, 1, 1)).isEmpty());
+
+    m_series->dataProxy()->resetArray(createGrid(10));
+
+    for (int i = 0; i < 2; i++) {
+        // Same results with and without the index
+        m_series->setSpatialIndexEnabled(i == 1);
+
+        QCOMPARE(m_series->nearestItem(QVector3D(2.1f, 3.2f, 4.3f)), 2 * 100 + 3 * 10 + 4);
+        QCOMPARE(m_series->nearestItem(QVector3D(-50.0f, -50.0f, -50.0f)), 0);
+        QCOMPARE(m_series->nearestItem(QVector3D(50.0f, 50.0f, 50.0f)), 999);
+
+        QList<int> items = m_series->itemsInBox(QVector3D(0.5f, 0.5f, 0.5f),
+                                                QVector3D(2.5f, 1.5f, 1.5f));
+        QCOMPARE(items, QList<int>({111, 211}));
+
+        items = m_series->itemsInSphere(QVector3D(5.0f, 5.0f, 5.0f), 1.0f);
+        QCOMPARE(items, QList<int>({455, 545, 554, 555, 556, 565, 655}));
+        QCOMPARE(m_series->itemsInSphere(QVector3D(), 100.0f).size(), 1000);
+    }
+}
+
+void tst_series::spatialIndexUpdates()
+{
+    QVERIFY(m_series);
+
+    QScatterDataProxy *proxy = m_series->dataProxy();
+    proxy->resetArray(createGrid(10));
+    m_series->setSpatialIndexEnabled(true);
+    QCOMPARE(m_series->nearestItem(QVector3D(20.0f, 20.0f, 20.0f)), 999);
+
+    // Outside the current bounds of the index
+    proxy->addItem(QScatterDataItem(QVector3D(30.0f, 30.0f, 30.0f)));
+    QCOMPARE(m_series->nearestItem(QVector3D(20.0f, 20.0f, 20.0f)), 1000);
+
+    proxy->setItem(0, QScatterDataItem(QVector3D(4.5f, 4.5f, 4.5f)));
+    QCOMPARE(m_series->itemsInSphere(QVector3D(4.5f, 4.5f, 4.5f), 0.1f), QList<int>({0}));
+    QVERIFY(m_series->itemsInSphere(QVector3D(), 0.1f).isEmpty());
+
+    proxy->removeItems(0, 1);
+    QCOMPARE(m_series->nearestItem(QVector3D(20.0f, 20.0f, 20.0f)), 999);
+    QCOMPARE(m_series->nearestItem(QVector3D(0.0f, 0.0f, 0.9f)), 0);
+
+    m_series->setDataProxy(new QScatterDataProxy());
+    QCOMPARE(m_series->nearestItem(QVector3D()), -1);
+}
+
 QTEST_MAIN(tst_series)
 #include "tst_series.moc"
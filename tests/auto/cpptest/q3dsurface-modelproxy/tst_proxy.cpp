@@ -35,6 +35,73 @@
 
 #include "cpptestutil.h"
 
+// Table of numbers that reimplements multiData(), and counts how it is read
+class NumberModel : public QAbstractTableModel
+{
+public:
+    NumberModel(int rowCount, int columnCount)
+        : dataCalls(0),
+          multiDataCalls(0),
+          m_rowCount(rowCount),
+          m_columnCount(columnCount)
+    {
+    }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : m_rowCount;
+    }
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : m_columnCount;
+    }
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override
+    {
+        dataCalls++;
+        return value(index, role);
+    }
+
+    void multiData(const QModelIndex &index, QModelRoleDataSpan roleDataSpan) const override
+    {
+        multiDataCalls++;
+        for (QModelRoleData &roleData : roleDataSpan)
+            roleData.setData(value(index, roleData.role()));
+    }
+
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override
+    {
+        if (role != Qt::DisplayRole)
+            return QVariant();
+        return (orientation == Qt::Horizontal) ? section * 10 : section * 100;
+    }
+
+    QHash<int, QByteArray> roleNames() const override
+    {
+        QHash<int, QByteArray> roles = QAbstractTableModel::roleNames();
+        roles.insert(Qt::UserRole, "x");
+        return roles;
+    }
+
+    mutable int dataCalls;
+    mutable int multiDataCalls;
+
+private:
+    QVariant value(const QModelIndex &index, int role) const
+    {
+        if (role == Qt::DisplayRole)
+            return float(index.row() * m_columnCount + index.column());
+        if (role == Qt::UserRole)
+            return float(index.column()) * 0.5f;
+        return QVariant();
+    }
+
+    int m_rowCount;
+    int m_columnCount;
+};
+
 class tst_proxy: public QObject
 {
     Q_OBJECT
@@ -51,6 +118,9 @@ private slots:
     void initializeProperties();
 
     void multiMatch();
+    void addModelAsynchronously();
+    void deleteDuringResolve();
+    void multiData();
 
 private:
     QItemModelSurfaceDataProxy *m_proxy;
@@ -171,6 +241,7 @@ void tst_proxy::initialProperties()
     QCOMPARE(m_proxy->zPosRole(), QString());
     QCOMPARE(m_proxy->zPosRolePattern(), QRegularExpression());
     QCOMPARE(m_proxy->zPosRoleReplace(), QString());
+    QCOMPARE(m_proxy->asynchronousResolve(), false);
 
     QCOMPARE(m_proxy->columnCount(), 0);
     QCOMPARE(m_proxy->rowCount(), 0);
@@ -207,6 +278,7 @@ void tst_proxy::initializeProperties()
     m_proxy->setZPosRole("Z");
     m_proxy->setZPosRolePattern(QRegularExpression("/-/"));
     m_proxy->setZPosRoleReplace("\\\\1");
+    m_proxy->setAsynchronousResolve(true);
 
     QCOMPARE(m_proxy->autoColumnCategories(), false);
     QCOMPARE(m_proxy->autoRowCategories(), false);
@@ -230,6 +302,7 @@ void tst_proxy::initializeProperties()
     QCOMPARE(m_proxy->zPosRole(), QString("Z"));
     QCOMPARE(m_proxy->zPosRolePattern(), QRegularExpression("/-/"));
     QCOMPARE(m_proxy->zPosRoleReplace(), QString("\\\\1"));
+    QCOMPARE(m_proxy->asynchronousResolve(), true);
 }
 
 void tst_proxy::multiMatch()
@@ -296,5 +369,87 @@ void tst_proxy::multiMatch()
     m_proxy = 0; // Graph deletes proxy
 }
 
+void tst_proxy::addModelAsynchronously()
+{
+    QTableWidget table;
+    table.setRowCount(2);
+    table.setColumnCount(3);
+    for (int row = 0; row < 2; row++) {
+        for (int col = 0; col < 3; col++)
+            table.model()->setData(table.model()->index(row, col), QString::number(row * 3 + col));
+    }
+
+    QSignalSpy resolvedSpy(m_proxy, &QItemModelSurfaceDataProxy::modelResolved);
+    m_proxy->setAsynchronousResolve(true);
+    m_proxy->setUseModelCategories(true);
+    m_proxy->setItemModel(table.model());
+
+    QTRY_COMPARE(resolvedSpy.count(), 1);
+    QCOMPARE(m_proxy->rowCount(), 2);
+    QCOMPARE(m_proxy->columnCount(), 3);
+    QCOMPARE(m_proxy->itemAt(1, 2)->y(), 5.0f);
+
+    // Single item changes are still applied directly
+    table.model()->setData(table.model()->index(1, 2), QStringLiteral("10"));
+    QCOMPARE(m_proxy->itemAt(1, 2)->y(), 10.0f);
+
+    // Mapping changes resolve the whole model again
+    m_proxy->setXPosRole(table.model()->roleNames().value(Qt::DisplayRole));
+    QTRY_COMPARE(resolvedSpy.count(), 2);
+    QCOMPARE(m_proxy->rowCount(), 2);
+    QCOMPARE(m_proxy->itemAt(1, 2)->x(), 10.0f);
+}
+
+void tst_proxy::deleteDuringResolve()
+{
+    QTableWidget table;
+    table.setRowCount(200);
+    table.setColumnCount(200);
+
+    m_proxy->setAsynchronousResolve(true);
+    m_proxy->setUseModelCategories(true);
+    m_proxy->setItemModel(table.model());
+
+    // Deleting the proxy waits for the running resolve, and drops its result
+    QCoreApplication::processEvents();
+    delete m_proxy;
+    m_proxy = 0;
+    QCoreApplication::processEvents();
+}
+
+void tst_proxy::multiData()
+{
+    const int rowCount = 3;
+    const int columnCount = 4;
+    NumberModel model(rowCount, columnCount);
+
+    m_proxy->setUseModelCategories(true);
+    m_proxy->setItemModel(&model);
+    model.dataCalls = 0;
+    model.multiDataCalls = 0;
+    QCoreApplication::processEvents();
+
+    // Each item is read with a single call, and unmapped positions come from the headers
+    QCOMPARE(m_proxy->rowCount(), rowCount);
+    QCOMPARE(m_proxy->columnCount(), columnCount);
+    QCOMPARE(model.multiDataCalls, rowCount * columnCount);
+    QCOMPARE(model.dataCalls, 0);
+    QCOMPARE(m_proxy->itemAt(1, 2)->position(), QVector3D(20.0f, 6.0f, 100.0f));
+
+    m_proxy->setXPosRole(QStringLiteral("x"));
+    model.dataCalls = 0;
+    model.multiDataCalls = 0;
+    QCoreApplication::processEvents();
+    QCOMPARE(model.multiDataCalls, rowCount * columnCount);
+    QCOMPARE(model.dataCalls, 0);
+    QCOMPARE(m_proxy->itemAt(1, 2)->position(), QVector3D(1.0f, 6.0f, 100.0f));
+
+    // Patterns apply to the numbers returned by the model as well
+    m_proxy->setYPosRolePattern(QRegularExpression(QStringLiteral("^(\\d+)$")));
+    m_proxy->setYPosRoleReplace(QStringLiteral("1\\1"));
+    QCoreApplication::processEvents();
+    QCOMPARE(m_proxy->itemAt(1, 2)->y(), 16.0f);
+}
+
 QTEST_MAIN(tst_proxy)
 #include "tst_proxy.moc"
@@ -46,6 +46,8 @@ private slots:
     void initialProperties();
     void initializeProperties();
     void initialRow();
+    void resetGrid();
+    void scrollRows();
 
 private:
     QSurfaceDataProxy *m_proxy;
@@ -113,5 +115,86 @@ void tst_proxy::initialRow()
     proxy.addRow(new QSurfaceDataRow(row));
 }
 
+void tst_proxy::resetGrid()
+{
+    QVERIFY(m_proxy);
+
+    QList<float> columns = {0.0f, 1.0f, 2.0f};
+    QList<float> rows = {0.5f, 1.0f};
+    QList<float> heights = {0.1f, 0.5f, 0.3f,
+                            1.8f, 1.2f, 0.7f};
+
+    m_proxy->resetGrid(columns, rows, heights);
+
+    QVERIFY(m_proxy->isGrid());
+    QCOMPARE(m_proxy->columnCount(), 3);
+    QCOMPARE(m_proxy->rowCount(), 2);
+    QCOMPARE(m_proxy->array()->size(), 0);
+    QCOMPARE(m_proxy->itemAt(1, 2)->position(), QVector3D(2.0f, 0.7f, 1.0f));
+
+    // Modifying the data converts the grid into an array
+    m_proxy->setItem(0, 0, QSurfaceDataItem(QVector3D(0.0f, 0.2f, 0.5f)));
+
+    QVERIFY(!m_proxy->isGrid());
+    QCOMPARE(m_proxy->array()->size(), 2);
+    QCOMPARE(m_proxy->itemAt(0, 0)->position(), QVector3D(0.0f, 0.2f, 0.5f));
+    QCOMPARE(m_proxy->itemAt(1, 2)->position(), QVector3D(2.0f, 0.7f, 1.0f));
+
+    m_proxy->resetArray(0);
+    QCOMPARE(m_proxy->rowCount(), 0);
+}
+
+void tst_proxy::scrollRows()
+{
+    QVERIFY(m_proxy);
+
+    QSignalSpy spy(m_proxy, &QSurfaceDataProxy::rowsScrolled);
+
+    m_proxy->resetGrid({0.0f, 1.0f}, {0.0f, 1.0f, 2.0f},
+                       {1.0f, 2.0f,
+                        3.0f, 4.0f,
+                        5.0f, 6.0f});
+    QCOMPARE(m_proxy->scrollRows({7.0f, 8.0f}), 1);
+
+    QVERIFY(m_proxy->isGrid());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toInt(), 1);
+    QCOMPARE(m_proxy->rowCount(), 3);
+    QCOMPARE(m_proxy->itemAt(0, 0)->position(), QVector3D(0.0f, 3.0f, 0.0f));
+    QCOMPARE(m_proxy->itemAt(2, 1)->position(), QVector3D(1.0f, 8.0f, 2.0f));
+
+    // Data arrays stay in place, and only their y-values move
+    m_proxy->setItem(0, 0, QSurfaceDataItem(QVector3D(0.0f, 3.0f, 0.0f)));
+    QVERIFY(!m_proxy->isGrid());
+    const QSurfaceDataArray *array = m_proxy->array();
+    const QSurfaceDataRow *firstRow = array->at(0);
+    QCOMPARE(m_proxy->scrollRows({9.0f, 10.0f, 11.0f, 12.0f}), 2);
+
+    QVERIFY(!m_proxy->isGrid());
+    QCOMPARE(m_proxy->array(), array);
+    QCOMPARE(m_proxy->array()->at(0), firstRow);
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(m_proxy->rowCount(), 3);
+    QCOMPARE(m_proxy->itemAt(0, 1)->position(), QVector3D(1.0f, 8.0f, 0.0f));
+    QCOMPARE(m_proxy->itemAt(1, 0)->position(), QVector3D(0.0f, 9.0f, 1.0f));
+    QCOMPARE(m_proxy->itemAt(2, 1)->position(), QVector3D(1.0f, 12.0f, 2.0f));
+
+    // Items keep their x- and z-values
+    m_proxy->setItem(1, 1, QSurfaceDataItem(QVector3D(1.5f, 10.0f, 1.0f)));
+    QVERIFY(!m_proxy->isGrid());
+    QCOMPARE(m_proxy->scrollRows({13.0f, 14.0f}), 1);
+
+    QVERIFY(!m_proxy->isGrid());
+    QCOMPARE(spy.count(), 3);
+    QCOMPARE(m_proxy->rowCount(), 3);
+    QCOMPARE(m_proxy->itemAt(0, 1)->position(), QVector3D(1.0f, 10.0f, 0.0f));
+    QCOMPARE(m_proxy->itemAt(1, 1)->position(), QVector3D(1.5f, 12.0f, 1.0f));
+    QCOMPARE(m_proxy->itemAt(2, 0)->position(), QVector3D(0.0f, 13.0f, 2.0f));
+
+    m_proxy->resetArray(0);
+    QCOMPARE(m_proxy->scrollRows({1.0f, 2.0f}), 0);
+    QCOMPARE(spy.count(), 3);
+}
+
 QTEST_MAIN(tst_proxy)
 #include "tst_proxy.moc"
@@ -55,6 +55,7 @@ private slots:
     void removeSeries();
     void removeMultipleSeries();
     void hasSeries();
+    void adjustAxisRanges();
 
 private:
     Q3DSurface *m_graph;
@@ -273,5 +274,26 @@ void tst_surface::hasSeries()
     QCOMPARE(m_graph->hasSeries(series2), false);
 }
 
+void tst_surface::adjustAxisRanges()
+{
+    QSurface3DSeries *series = newSeries();
+    m_graph->addSeries(series);
+
+    QCOMPARE(m_graph->axisY()->min(), 0.1f);
+    QCOMPARE(m_graph->axisY()->max(), 1.8f);
+
+    // Changed rows must update the cached row limits
+    QSurfaceDataRow *row = new QSurfaceDataRow;
+    *row << QVector3D(0.0f, -2.0f, 1.0f) << QVector3D(1.0f, qQNaN(), 1.0f);
+    series->dataProxy()->setRow(1, row);
+
+    QCOMPARE(m_graph->axisY()->min(), -2.0f);
+    QCOMPARE(m_graph->axisY()->max(), 0.5f);
+
+    series->dataProxy()->removeRows(1, 1);
+    QCOMPARE(m_graph->axisY()->min(), 0.1f);
+    QCOMPARE(m_graph->axisY()->max(), 0.5f);
+}
+
 QTEST_MAIN(tst_surface)
 #include "tst_surface.moc"
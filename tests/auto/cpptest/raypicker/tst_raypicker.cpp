@@ -0,0 +1,452 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include <private/raypicker_p.h>
+
+#include <limits>
+
+static RayPicker::Ray createRay(const QVector3D &origin, const QVector3D &direction)
+{
+    RayPicker::Ray ray;
+    ray.origin = origin;
+    ray.direction = direction.normalized();
+    return ray;
+}
+
+static bool fuzzyEqual(float a, float b)
+{
+    return qAbs(a - b) <= 1e-4f * qMax(1.0f, qMax(qAbs(a), qAbs(b)));
+}
+
+// Boxes of varying sizes scattered over a volume, the same on every run
+static void createBoxes(int count, QList<QVector3D> &minimums, QList<QVector3D> &maximums)
+{
+    for (int i = 0; i < count; i++) {
+        QVector3D center(float((i * 37) % 101) - 50.0f,
+                         float((i * 53) % 89) - 44.0f,
+                         float((i * 71) % 97) - 48.0f);
+        QVector3D halfSize(0.2f + float(i % 5) * 0.3f,
+                           0.2f + float(i % 3) * 0.4f,
+                           0.2f + float(i % 7) * 0.1f);
+        minimums.append(center - halfSize);
+        maximums.append(center + halfSize);
+    }
+}
+
+// Rays from around the volume towards points inside it
+static QList<RayPicker::Ray> createRays(int count)
+{
+    QList<RayPicker::Ray> rays;
+    for (int i = 0; i < count; i++) {
+        const float angle = float(i) * 0.37f;
+        QVector3D origin(qCos(angle) * 120.0f, float(i % 11) * 10.0f - 50.0f,
+                         qSin(angle) * 120.0f);
+        QVector3D target(float((i * 13) % 41) - 20.0f, float((i * 7) % 31) - 15.0f,
+                         float((i * 17) % 37) - 18.0f);
+        rays.append(createRay(origin, target - origin));
+    }
+    return rays;
+}
+
+static float boxDistance(const RayPicker::Ray &ray, const QVector3D &minimum,
+                         const QVector3D &maximum)
+{
+    float tNear;
+    float tFar;
+    if (!RayPicker::intersectBox(ray, minimum, maximum, tNear, tFar))
+        return -1.0f;
+    return tNear;
+}
+
+class tst_raypicker: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void selectionRay();
+    void selectionRayPerspective();
+    void selectionRayOutside_data();
+    void selectionRayOutside();
+    void intersectBox_data();
+    void intersectBox();
+    void intersectTriangle_data();
+    void intersectTriangle();
+    void intersectQuad_data();
+    void intersectQuad();
+
+    void emptyHierarchy();
+    void closestHit_data();
+    void closestHit();
+    void closestHitMargin();
+    void closestHitPrunes();
+};
+
+void tst_raypicker::selectionRay()
+{
+    // With an identity matrix, the ray goes along z through the normalized device coordinates
+    // of the pixel center. The y-coordinate of the position grows downwards.
+    RayPicker::Ray ray;
+    QVERIFY(RayPicker::selectionRay(QPoint(0, 100), QSize(100, 100), 100, QMatrix4x4(), ray));
+    QVERIFY(fuzzyEqual(ray.origin.x(), -0.99f));
+    QVERIFY(fuzzyEqual(ray.origin.y(), -0.99f));
+    QVERIFY(fuzzyEqual(ray.origin.z(), -1.0f));
+    QCOMPARE(ray.direction, QVector3D(0.0f, 0.0f, 1.0f));
+
+    QVERIFY(RayPicker::selectionRay(QPoint(99, 1), QSize(100, 100), 100, QMatrix4x4(), ray));
+    QVERIFY(fuzzyEqual(ray.origin.x(), 0.99f));
+    QVERIFY(fuzzyEqual(ray.origin.y(), 0.99f));
+}
+
+void tst_raypicker::selectionRayPerspective()
+{
+    QMatrix4x4 projectionMatrix;
+    projectionMatrix.perspective(45.0f, 1.0f, 0.1f, 100.0f);
+    QMatrix4x4 viewMatrix;
+    viewMatrix.lookAt(QVector3D(0.0f, 0.0f, 5.0f), QVector3D(), QVector3D(0.0f, 1.0f, 0.0f));
+
+    // The center pixel of an odd sized viewport looks at the camera target
+    RayPicker::Ray ray;
+    QVERIFY(RayPicker::selectionRay(QPoint(50, 51), QSize(101, 101), 101,
+                                    projectionMatrix * viewMatrix, ray));
+    QVERIFY(fuzzyEqual(ray.origin.z(), 4.9f));
+    QVERIFY(qAbs(ray.origin.x()) < 1e-4f);
+    QVERIFY(qAbs(ray.origin.y()) < 1e-4f);
+    QVERIFY(qAbs(ray.direction.x()) < 1e-4f);
+    QVERIFY(qAbs(ray.direction.y()) < 1e-4f);
+    QVERIFY(fuzzyEqual(ray.direction.z(), -1.0f));
+
+    // Pixels left of the center look to the left
+    QVERIFY(RayPicker::selectionRay(QPoint(10, 51), QSize(101, 101), 101,
+                                    projectionMatrix * viewMatrix, ray));
+    QVERIFY(ray.direction.x() < 0.0f);
+    QVERIFY(fuzzyEqual(ray.direction.length(), 1.0f));
+}
+
+void tst_raypicker::selectionRayOutside_data()
+{
+    QTest::addColumn<QPoint>("position");
+
+    QTest::newRow("left") << QPoint(-1, 50);
+    QTest::newRow("right") << QPoint(100, 50);
+    QTest::newRow("above") << QPoint(50, 0);
+    QTest::newRow("below") << QPoint(50, 101);
+}
+
+void tst_raypicker::selectionRayOutside()
+{
+    QFETCH(QPoint, position);
+
+    RayPicker::Ray ray;
+    QVERIFY(!RayPicker::selectionRay(position, QSize(100, 100), 100, QMatrix4x4(), ray));
+
+    // A matrix that cannot be inverted does not give a ray either
+    QMatrix4x4 flat;
+    flat.scale(1.0f, 1.0f, 0.0f);
+    QVERIFY(!RayPicker::selectionRay(QPoint(50, 50), QSize(100, 100), 100, flat, ray));
+}
+
+void tst_raypicker::intersectBox_data()
+{
+    QTest::addColumn<QVector3D>("origin");
+    QTest::addColumn<QVector3D>("direction");
+    QTest::addColumn<bool>("hit");
+    QTest::addColumn<float>("expectedNear");
+    QTest::addColumn<float>("expectedFar");
+
+    QTest::newRow("through") << QVector3D(-5.0f, 0.0f, 0.0f) << QVector3D(1.0f, 0.0f, 0.0f)
+                             << true << 4.0f << 6.0f;
+    QTest::newRow("diagonal") << QVector3D(-3.0f, -3.0f, 0.0f) << QVector3D(1.0f, 1.0f, 0.0f)
+                              << true << float(2.0 * M_SQRT2) << float(4.0 * M_SQRT2);
+    QTest::newRow("from inside") << QVector3D(0.5f, 0.0f, 0.0f) << QVector3D(1.0f, 0.0f, 0.0f)
+                                 << true << 0.0f << 0.5f;
+    QTest::newRow("on face") << QVector3D(-5.0f, 1.0f, 0.0f) << QVector3D(1.0f, 0.0f, 0.0f)
+                             << true << 4.0f << 6.0f;
+    QTest::newRow("behind") << QVector3D(5.0f, 0.0f, 0.0f) << QVector3D(1.0f, 0.0f, 0.0f)
+                            << false << 0.0f << 0.0f;
+    QTest::newRow("beside") << QVector3D(-5.0f, 2.0f, 0.0f) << QVector3D(1.0f, 0.0f, 0.0f)
+                            << false << 0.0f << 0.0f;
+    QTest::newRow("missing corner") << QVector3D(-3.0f, -1.0f, 0.0f)
+                                    << QVector3D(1.0f, 2.0f, 0.0f)
+                                    << false << 0.0f << 0.0f;
+}
+
+void tst_raypicker::intersectBox()
+{
+    QFETCH(QVector3D, origin);
+    QFETCH(QVector3D, direction);
+    QFETCH(bool, hit);
+    QFETCH(float, expectedNear);
+    QFETCH(float, expectedFar);
+
+    float tNear;
+    float tFar;
+    QCOMPARE(RayPicker::intersectBox(createRay(origin, direction), QVector3D(-1.0f, -1.0f, -1.0f),
+                                     QVector3D(1.0f, 1.0f, 1.0f), tNear, tFar), hit);
+    if (hit) {
+        QVERIFY(fuzzyEqual(tNear, expectedNear));
+        QVERIFY(fuzzyEqual(tFar, expectedFar));
+    }
+}
+
+void tst_raypicker::intersectTriangle_data()
+{
+    QTest::addColumn<QVector3D>("origin");
+    QTest::addColumn<QVector3D>("direction");
+    QTest::addColumn<float>("distance");
+
+    // The triangle is on the plane z = 2
+    QTest::newRow("front face") << QVector3D(0.2f, 0.2f, 0.0f) << QVector3D(0.0f, 0.0f, 1.0f)
+                                << 2.0f;
+    QTest::newRow("back face") << QVector3D(0.2f, 0.2f, 4.0f) << QVector3D(0.0f, 0.0f, -1.0f)
+                               << 2.0f;
+    QTest::newRow("slanted") << QVector3D(0.0f, 0.0f, 0.0f) << QVector3D(0.3f, 0.4f, 2.0f)
+                             << float(qSqrt(0.3 * 0.3 + 0.4 * 0.4 + 4.0));
+    QTest::newRow("outside") << QVector3D(0.8f, 0.8f, 0.0f) << QVector3D(0.0f, 0.0f, 1.0f)
+                             << -1.0f;
+    QTest::newRow("parallel") << QVector3D(0.2f, 0.2f, 0.0f) << QVector3D(1.0f, 0.0f, 0.0f)
+                              << -1.0f;
+}
+
+void tst_raypicker::intersectTriangle()
+{
+    QFETCH(QVector3D, origin);
+    QFETCH(QVector3D, direction);
+    QFETCH(float, distance);
+
+    const float t = RayPicker::intersectTriangle(createRay(origin, direction),
+                                                 QVector3D(0.0f, 0.0f, 2.0f),
+                                                 QVector3D(1.0f, 0.0f, 2.0f),
+                                                 QVector3D(0.0f, 1.0f, 2.0f));
+    if (distance < 0.0f)
+        QVERIFY(t < 0.0f);
+    else
+        QVERIFY(fuzzyEqual(t, distance));
+}
+
+void tst_raypicker::intersectQuad_data()
+{
+    QTest::addColumn<QMatrix4x4>("modelMatrix");
+    QTest::addColumn<QVector3D>("origin");
+    QTest::addColumn<QVector3D>("direction");
+    QTest::addColumn<float>("distance");
+
+    // Labels are scaled flat, like the renderers draw them
+    QMatrix4x4 label;
+    label.translate(1.0f, 2.0f, 3.0f);
+    label.scale(2.0f, 0.5f, 0.0f);
+    QTest::newRow("upper triangle") << label << QVector3D(2.5f, 2.3f, 10.0f)
+                           << QVector3D(0.0f, 0.0f, -1.0f) << 7.0f;
+    QTest::newRow("lower triangle") << label << QVector3D(-0.5f, 1.7f, 10.0f)
+                                    << QVector3D(0.0f, 0.0f, -1.0f) << 7.0f;
+    QTest::newRow("beside label") << label << QVector3D(3.5f, 2.0f, 10.0f)
+                                  << QVector3D(0.0f, 0.0f, -1.0f) << -1.0f;
+    QTest::newRow("above label") << label << QVector3D(1.0f, 2.6f, 10.0f)
+                                 << QVector3D(0.0f, 0.0f, -1.0f) << -1.0f;
+    QTest::newRow("behind ray") << label << QVector3D(1.0f, 2.0f, 10.0f)
+                                << QVector3D(0.0f, 0.0f, 1.0f) << -1.0f;
+
+    QMatrix4x4 rotated;
+    rotated.translate(0.0f, 0.0f, -4.0f);
+    rotated.rotate(90.0f, 0.0f, 1.0f, 0.0f);
+    rotated.scale(1.0f, 1.0f, 0.0f);
+    QTest::newRow("rotated") << rotated << QVector3D(5.0f, 0.5f, -4.5f)
+                             << QVector3D(-1.0f, 0.0f, 0.0f) << 5.0f;
+    QTest::newRow("rotated edge on") << rotated << QVector3D(0.0f, 0.0f, 5.0f)
+                                     << QVector3D(0.0f, 0.0f, -1.0f) << -1.0f;
+}
+
+void tst_raypicker::intersectQuad()
+{
+    QFETCH(QMatrix4x4, modelMatrix);
+    QFETCH(QVector3D, origin);
+    QFETCH(QVector3D, direction);
+    QFETCH(float, distance);
+
+    const float t = RayPicker::intersectQuad(createRay(origin, direction), modelMatrix);
+    if (distance < 0.0f)
+        QVERIFY(t < 0.0f);
+    else
+        QVERIFY(fuzzyEqual(t, distance));
+}
+
+void tst_raypicker::emptyHierarchy()
+{
+    BoundingVolumeHierarchy hierarchy;
+    QVERIFY(hierarchy.isEmpty());
+
+    float distance = 0.0f;
+    int tests = 0;
+    const int hit = hierarchy.closestHit(createRay(QVector3D(), QVector3D(1.0f, 0.0f, 0.0f)),
+                                         0.0f, [&tests](int) {
+        tests++;
+        return 0.0f;
+    }, distance);
+    QCOMPARE(hit, -1);
+    QCOMPARE(tests, 0);
+
+    // Clearing a built hierarchy empties it
+    QList<QVector3D> minimums;
+    QList<QVector3D> maximums;
+    createBoxes(10, minimums, maximums);
+    hierarchy.build(minimums, maximums);
+    QVERIFY(!hierarchy.isEmpty());
+    hierarchy.clear();
+    QVERIFY(hierarchy.isEmpty());
+}
+
+void tst_raypicker::closestHit_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("single box") << 1;
+    QTest::newRow("single leaf") << 4;
+    QTest::newRow("odd count") << 37;
+    QTest::newRow("many boxes") << 2000;
+}
+
+void tst_raypicker::closestHit()
+{
+    QFETCH(int, count);
+
+    QList<QVector3D> minimums;
+    QList<QVector3D> maximums;
+    createBoxes(count, minimums, maximums);
+    BoundingVolumeHierarchy hierarchy;
+    hierarchy.build(minimums, maximums);
+
+    // The hierarchy finds the same closest box as testing every box
+    int hits = 0;
+    foreach (const RayPicker::Ray &ray, createRays(200)) {
+        int expected = -1;
+        float expectedDistance = std::numeric_limits<float>::max();
+        for (int i = 0; i < count; i++) {
+            const float t = boxDistance(ray, minimums.at(i), maximums.at(i));
+            if (t >= 0.0f && t < expectedDistance) {
+                expectedDistance = t;
+                expected = i;
+            }
+        }
+
+        float distance;
+        const int hit = hierarchy.closestHit(ray, 0.0f, [&](int primitive) {
+            return boxDistance(ray, minimums.at(primitive), maximums.at(primitive));
+        }, distance);
+        QCOMPARE(hit >= 0, expected >= 0);
+        if (expected >= 0) {
+            // Boxes may touch, in which case either one is the closest
+            QVERIFY(fuzzyEqual(distance, expectedDistance));
+            hits++;
+        }
+    }
+    if (count > 100)
+        QVERIFY(hits > 0);
+}
+
+void tst_raypicker::closestHitMargin()
+{
+    // Points have empty boxes, and are found within the margin of the ray
+    QList<QVector3D> points;
+    for (int i = 0; i < 500; i++) {
+        points.append(QVector3D(float((i * 37) % 101) - 50.0f, float((i * 53) % 89) - 44.0f,
+                                float((i * 71) % 97) - 48.0f));
+    }
+    BoundingVolumeHierarchy hierarchy;
+    hierarchy.build(points, points);
+
+    const float radius = 1.5f;
+    auto pointDistance = [radius](const RayPicker::Ray &ray, const QVector3D &point) {
+        const QVector3D toPoint = point - ray.origin;
+        const float along = QVector3D::dotProduct(toPoint, ray.direction);
+        if (along < 0.0f || (toPoint - along * ray.direction).lengthSquared() > radius * radius)
+            return -1.0f;
+        return along;
+    };
+
+    int hits = 0;
+    foreach (const RayPicker::Ray &ray, createRays(200)) {
+        int expected = -1;
+        float expectedDistance = std::numeric_limits<float>::max();
+        for (int i = 0; i < points.size(); i++) {
+            const float t = pointDistance(ray, points.at(i));
+            if (t >= 0.0f && t < expectedDistance) {
+                expectedDistance = t;
+                expected = i;
+            }
+        }
+
+        float distance;
+        const int hit = hierarchy.closestHit(ray, radius, [&](int primitive) {
+            return pointDistance(ray, points.at(primitive));
+        }, distance);
+        QCOMPARE(hit >= 0, expected >= 0);
+        if (expected >= 0) {
+            QVERIFY(fuzzyEqual(distance, expectedDistance));
+            hits++;
+        }
+    }
+    QVERIFY(hits > 0);
+
+    // Without the margin, the empty boxes are practically never hit
+    int marginlessHits = 0;
+    foreach (const RayPicker::Ray &ray, createRays(200)) {
+        float distance;
+        if (hierarchy.closestHit(ray, 0.0f, [&](int primitive) {
+            return pointDistance(ray, points.at(primitive));
+        }, distance) >= 0) {
+            marginlessHits++;
+        }
+    }
+    QVERIFY(marginlessHits < hits);
+}
+
+void tst_raypicker::closestHitPrunes()
+{
+    // A ray through a large set of boxes tests only a small part of them
+    const int count = 10000;
+    QList<QVector3D> minimums;
+    QList<QVector3D> maximums;
+    createBoxes(count, minimums, maximums);
+    BoundingVolumeHierarchy hierarchy;
+    hierarchy.build(minimums, maximums);
+
+    foreach (const RayPicker::Ray &ray, createRays(20)) {
+        int tests = 0;
+        float distance;
+        hierarchy.closestHit(ray, 0.0f, [&](int primitive) {
+            tests++;
+            return boxDistance(ray, minimums.at(primitive), maximums.at(primitive));
+        }, distance);
+        QVERIFY2(tests < count / 10, qPrintable(QString::number(tests)));
+    }
+}
+
+QTEST_MAIN(tst_raypicker)
+#include "tst_raypicker.moc"
@@ -0,0 +1,220 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtCore/qmath.h>
+
+#include <private/surfaceobject_p.h>
+
+static const float spikeHeight = 10.0f;
+
+// Grid with unique column and row values, so that the source of each sample can be told
+static SurfaceDataGrid createGrid(int columns, int rows, float height = 0.0f)
+{
+    SurfaceDataGrid grid;
+    for (int j = 0; j < columns; j++)
+        grid.columnValues.append(float(j) * 0.5f + 1.0f);
+    for (int i = 0; i < rows; i++)
+        grid.rowValues.append(float(i) * 2.0f - 3.0f);
+    grid.heights.fill(height, columns * rows);
+    return grid;
+}
+
+class tst_surfaceobject: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void levelOfDetailSize_data();
+    void levelOfDetailSize();
+    void levelOfDetailEdges_data();
+    void levelOfDetailEdges();
+    void levelOfDetailFlat();
+    void levelOfDetailKeepsExtremes_data();
+    void levelOfDetailKeepsExtremes();
+    void levelOfDetailArray();
+    void levelOfDetailChain();
+};
+
+void tst_surfaceobject::levelOfDetailSize_data()
+{
+    QTest::addColumn<int>("columns");
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<int>("lodColumns");
+    QTest::addColumn<int>("lodRows");
+
+    QTest::newRow("single item") << 1 << 1 << 1 << 1;
+    QTest::newRow("two by two") << 2 << 2 << 2 << 2;
+    QTest::newRow("single row") << 9 << 1 << 5 << 1;
+    QTest::newRow("two columns") << 2 << 9 << 2 << 5;
+    QTest::newRow("three by three") << 3 << 3 << 2 << 2;
+    QTest::newRow("even") << 4 << 6 << 3 << 4;
+    QTest::newRow("odd") << 5 << 7 << 3 << 4;
+    QTest::newRow("large") << 1000 << 1001 << 501 << 501;
+}
+
+void tst_surfaceobject::levelOfDetailSize()
+{
+    QFETCH(int, columns);
+    QFETCH(int, rows);
+    QFETCH(int, lodColumns);
+    QFETCH(int, lodRows);
+
+    const SurfaceDataGrid grid = createGrid(columns, rows);
+    const SurfaceDataGrid lod = SurfaceObject::createLevelOfDetail(SurfaceDataView(grid));
+    QCOMPARE(lod.columnCount(), lodColumns);
+    QCOMPARE(lod.rowCount(), lodRows);
+    QCOMPARE(lod.heights.size(), lodColumns * lodRows);
+}
+
+void tst_surfaceobject::levelOfDetailEdges_data()
+{
+    QTest::addColumn<int>("columns");
+    QTest::addColumn<int>("rows");
+
+    QTest::newRow("two by two") << 2 << 2;
+    QTest::newRow("even") << 4 << 6;
+    QTest::newRow("odd") << 5 << 7;
+    QTest::newRow("mixed") << 10 << 11;
+}
+
+void tst_surfaceobject::levelOfDetailEdges()
+{
+    QFETCH(int, columns);
+    QFETCH(int, rows);
+
+    // The first and the last row and column are kept, and every other one in between
+    const SurfaceDataGrid grid = createGrid(columns, rows);
+    const SurfaceDataGrid lod = SurfaceObject::createLevelOfDetail(SurfaceDataView(grid));
+    QCOMPARE(lod.columnValues.first(), grid.columnValues.first());
+    QCOMPARE(lod.columnValues.last(), grid.columnValues.last());
+    QCOMPARE(lod.rowValues.first(), grid.rowValues.first());
+    QCOMPARE(lod.rowValues.last(), grid.rowValues.last());
+    for (int j = 0; j < lod.columnCount() - 1; j++)
+        QCOMPARE(lod.columnValues.at(j), grid.columnValues.at(j * 2));
+    for (int i = 0; i < lod.rowCount() - 1; i++)
+        QCOMPARE(lod.rowValues.at(i), grid.rowValues.at(i * 2));
+}
+
+void tst_surfaceobject::levelOfDetailFlat()
+{
+    const SurfaceDataGrid grid = createGrid(17, 12, 3.5f);
+    const SurfaceDataGrid lod = SurfaceObject::createLevelOfDetail(SurfaceDataView(grid));
+    foreach (float height, lod.heights)
+        QCOMPARE(height, 3.5f);
+}
+
+void tst_surfaceobject::levelOfDetailKeepsExtremes_data()
+{
+    QTest::addColumn<int>("row");
+    QTest::addColumn<int>("column");
+    QTest::addColumn<float>("height");
+
+    QTest::newRow("maximum between samples") << 3 << 5 << spikeHeight;
+    QTest::newRow("minimum between samples") << 3 << 5 << -spikeHeight;
+    QTest::newRow("maximum on sample") << 4 << 6 << spikeHeight;
+    QTest::newRow("maximum on edge") << 0 << 9 << spikeHeight;
+}
+
+void tst_surfaceobject::levelOfDetailKeepsExtremes()
+{
+    QFETCH(int, row);
+    QFETCH(int, column);
+    QFETCH(float, height);
+
+    // A single spike that is not itself sampled still shows in the samples next to it
+    const int columns = 10;
+    const int rows = 9;
+    SurfaceDataGrid grid = createGrid(columns, rows);
+    grid.heights[row * columns + column] = height;
+    const SurfaceDataGrid lod = SurfaceObject::createLevelOfDetail(SurfaceDataView(grid));
+
+    int spikes = 0;
+    for (int i = 0; i < lod.rowCount(); i++) {
+        const int sourceRow = qMin(i * 2, rows - 1);
+        for (int j = 0; j < lod.columnCount(); j++) {
+            const int sourceColumn = qMin(j * 2, columns - 1);
+            const bool neighbor = qAbs(sourceRow - row) <= 1 && qAbs(sourceColumn - column) <= 1;
+            const float value = lod.position(i, j).y();
+            QCOMPARE(value, neighbor ? height : 0.0f);
+            if (neighbor)
+                spikes++;
+        }
+    }
+    QVERIFY(spikes > 0);
+}
+
+void tst_surfaceobject::levelOfDetailArray()
+{
+    // Data arrays and grids give the same result
+    const int columns = 13;
+    const int rows = 8;
+    SurfaceDataGrid grid = createGrid(columns, rows);
+    QSurfaceDataArray array;
+    for (int i = 0; i < rows; i++) {
+        QSurfaceDataRow *dataRow = new QSurfaceDataRow(columns);
+        for (int j = 0; j < columns; j++) {
+            const float y = qSin(float(j) * 0.7f) * qCos(float(i) * 0.4f);
+            grid.heights[i * columns + j] = y;
+            (*dataRow)[j].setPosition(QVector3D(grid.columnValues.at(j), y,
+                                                grid.rowValues.at(i)));
+        }
+        array.append(dataRow);
+    }
+
+    const SurfaceDataGrid gridLod = SurfaceObject::createLevelOfDetail(SurfaceDataView(grid));
+    const SurfaceDataGrid arrayLod = SurfaceObject::createLevelOfDetail(SurfaceDataView(array));
+    QCOMPARE(arrayLod.columnValues, gridLod.columnValues);
+    QCOMPARE(arrayLod.rowValues, gridLod.rowValues);
+    QCOMPARE(arrayLod.heights, gridLod.heights);
+    qDeleteAll(array);
+}
+
+void tst_surfaceobject::levelOfDetailChain()
+{
+    // Levels are created from the previous level, down to the corners of the data
+    const SurfaceDataGrid grid = createGrid(300, 200);
+    SurfaceDataGrid lod = grid;
+    int levels = 0;
+    while (lod.columnCount() > 2 || lod.rowCount() > 2) {
+        const SurfaceDataGrid next = SurfaceObject::createLevelOfDetail(SurfaceDataView(lod));
+        QVERIFY(next.columnCount() < lod.columnCount() || lod.columnCount() <= 2);
+        QVERIFY(next.rowCount() < lod.rowCount() || lod.rowCount() <= 2);
+        lod = next;
+        levels++;
+    }
+    QVERIFY(levels > 1);
+    QCOMPARE(lod.columnValues.first(), grid.columnValues.first());
+    QCOMPARE(lod.columnValues.last(), grid.columnValues.last());
+    QCOMPARE(lod.rowValues.first(), grid.rowValues.first());
+    QCOMPARE(lod.rowValues.last(), grid.rowValues.last());
+}
+
+QTEST_MAIN(tst_surfaceobject)
+#include "tst_surfaceobject.moc"
@@ -0,0 +1,230 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtCore/qmath.h>
+
+#include <private/vertexindexer_p.h>
+
+// The map based indexer VertexIndexer used before, as a reference for the results
+struct ReferenceVertex {
+    QVector3D position;
+    QVector2D uv;
+    QVector3D normal;
+    bool operator<(const ReferenceVertex that) const {
+        return memcmp((void*)this, (void*)&that, sizeof(ReferenceVertex)) > 0;
+    }
+};
+
+static void referenceIndexVBO(const QList<QVector3D> &in_vertices, const QList<QVector2D> &in_uvs,
+                              const QList<QVector3D> &in_normals, QList<GLuint> &out_indices,
+                              QList<QVector3D> &out_vertices, QList<QVector2D> &out_uvs,
+                              QList<QVector3D> &out_normals)
+{
+    QMap<ReferenceVertex, GLuint> vertexToOutIndex;
+    for (int i = 0; i < in_vertices.size(); i++) {
+        ReferenceVertex packed = {in_vertices[i], in_uvs[i], in_normals[i]};
+        QMap<ReferenceVertex, GLuint>::iterator it = vertexToOutIndex.find(packed);
+        if (it != vertexToOutIndex.end()) {
+            out_indices.append(it.value());
+        } else {
+            out_vertices.append(in_vertices[i]);
+            out_uvs.append(in_uvs[i]);
+            out_normals.append(in_normals[i]);
+            GLuint newIndex = (GLuint)out_vertices.size() - 1;
+            out_indices.append(newIndex);
+            vertexToOutIndex[packed] = newIndex;
+        }
+    }
+}
+
+// Triangle soup of a grid like the mesh loader produces, with every triangle corner stored
+// separately. Every fourth cell has a flat normal, so that not all shared corners merge.
+static void createGridMesh(int size, QList<QVector3D> &vertices, QList<QVector2D> &uvs,
+                           QList<QVector3D> &normals)
+{
+    static const int cellCorners[] = {0, 1, 2, 2, 1, 3};
+    for (int row = 0; row < size; row++) {
+        for (int column = 0; column < size; column++) {
+            bool flat = !((row * size + column) % 4);
+            for (int i = 0; i < 6; i++) {
+                int x = column + (cellCorners[i] & 1);
+                int z = row + (cellCorners[i] >> 1);
+                float y = qSin(float(x) * 0.3f) * qCos(float(z) * 0.2f);
+                vertices.append(QVector3D(float(x), y, float(z)));
+                uvs.append(QVector2D(float(x) / float(size), float(z) / float(size)));
+                if (flat)
+                    normals.append(QVector3D(0.0f, 1.0f, 0.0f));
+                else
+                    normals.append(QVector3D(-qCos(float(x) * 0.3f), 1.0f,
+                                             qSin(float(z) * 0.2f)).normalized());
+            }
+        }
+    }
+}
+
+class tst_vertexindexer: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void empty();
+    void indexVBO_data();
+    void indexVBO();
+    void appendToOutput();
+    void benchmark_data();
+    void benchmark();
+};
+
+void tst_vertexindexer::empty()
+{
+    QList<QVector3D> vertices;
+    QList<QVector2D> uvs;
+    QList<QVector3D> normals;
+    QList<GLuint> indices;
+    QList<QVector3D> outVertices;
+    QList<QVector2D> outUvs;
+    QList<QVector3D> outNormals;
+    VertexIndexer::indexVBO(vertices, uvs, normals, indices, outVertices, outUvs, outNormals);
+    QVERIFY(indices.isEmpty());
+    QVERIFY(outVertices.isEmpty());
+    QVERIFY(outUvs.isEmpty());
+    QVERIFY(outNormals.isEmpty());
+}
+
+void tst_vertexindexer::indexVBO_data()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("single cell") << 1;
+    QTest::newRow("small grid") << 10;
+    // Large enough to pack the vertices in parallel
+    QTest::newRow("large grid") << 200;
+}
+
+void tst_vertexindexer::indexVBO()
+{
+    QFETCH(int, size);
+
+    QList<QVector3D> vertices;
+    QList<QVector2D> uvs;
+    QList<QVector3D> normals;
+    createGridMesh(size, vertices, uvs, normals);
+
+    QList<GLuint> indices;
+    QList<QVector3D> outVertices;
+    QList<QVector2D> outUvs;
+    QList<QVector3D> outNormals;
+    VertexIndexer::indexVBO(vertices, uvs, normals, indices, outVertices, outUvs, outNormals);
+
+    QList<GLuint> referenceIndices;
+    QList<QVector3D> referenceVertices;
+    QList<QVector2D> referenceUvs;
+    QList<QVector3D> referenceNormals;
+    referenceIndexVBO(vertices, uvs, normals, referenceIndices, referenceVertices, referenceUvs,
+                      referenceNormals);
+
+    QVERIFY(outVertices.size() < vertices.size());
+    QCOMPARE(outVertices.size(), referenceVertices.size());
+    QCOMPARE(outVertices, referenceVertices);
+    QCOMPARE(outUvs, referenceUvs);
+    QCOMPARE(outNormals, referenceNormals);
+    QCOMPARE(indices, referenceIndices);
+
+    // Every index refers to a vertex identical to the input vertex
+    QCOMPARE(indices.size(), vertices.size());
+    for (int i = 0; i < indices.size(); i++) {
+        QCOMPARE(outVertices.at(indices.at(i)), vertices.at(i));
+        QCOMPARE(outUvs.at(indices.at(i)), uvs.at(i));
+        QCOMPARE(outNormals.at(indices.at(i)), normals.at(i));
+    }
+}
+
+void tst_vertexindexer::appendToOutput()
+{
+    QList<QVector3D> vertices;
+    QList<QVector2D> uvs;
+    QList<QVector3D> normals;
+    createGridMesh(5, vertices, uvs, normals);
+
+    // Indexing the same mesh twice into the same output appends a second copy of it
+    QList<GLuint> indices;
+    QList<QVector3D> outVertices;
+    QList<QVector2D> outUvs;
+    QList<QVector3D> outNormals;
+    VertexIndexer::indexVBO(vertices, uvs, normals, indices, outVertices, outUvs, outNormals);
+    const int uniqueCount = outVertices.size();
+    const int indexCount = indices.size();
+    VertexIndexer::indexVBO(vertices, uvs, normals, indices, outVertices, outUvs, outNormals);
+
+    QCOMPARE(outVertices.size(), uniqueCount * 2);
+    QCOMPARE(indices.size(), indexCount * 2);
+    for (int i = 0; i < indexCount; i++)
+        QCOMPARE(indices.at(indexCount + i), indices.at(i) + GLuint(uniqueCount));
+    QCOMPARE(outVertices.mid(uniqueCount), outVertices.mid(0, uniqueCount));
+}
+
+void tst_vertexindexer::benchmark_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<bool>("reference");
+
+    QTest::newRow("hash table, 100x100 grid") << 100 << false;
+    QTest::newRow("map, 100x100 grid") << 100 << true;
+    QTest::newRow("hash table, 400x400 grid") << 400 << false;
+    QTest::newRow("map, 400x400 grid") << 400 << true;
+}
+
+void tst_vertexindexer::benchmark()
+{
+    QFETCH(int, size);
+    QFETCH(bool, reference);
+
+    QList<QVector3D> vertices;
+    QList<QVector2D> uvs;
+    QList<QVector3D> normals;
+    createGridMesh(size, vertices, uvs, normals);
+
+    QBENCHMARK {
+        QList<GLuint> indices;
+        QList<QVector3D> outVertices;
+        QList<QVector2D> outUvs;
+        QList<QVector3D> outNormals;
+        if (reference) {
+            referenceIndexVBO(vertices, uvs, normals, indices, outVertices, outUvs,
+                              outNormals);
+        } else {
+            VertexIndexer::indexVBO(vertices, uvs, normals, indices, outVertices, outUvs,
+                                    outNormals);
+        }
+    }
+}
+
+QTEST_MAIN(tst_vertexindexer)
+#include "tst_vertexindexer.moc"